@@ -0,0 +1,595 @@
+/*-------------------------------------------------------------------------
+ *
+ * hdfs_cache.c
+ * 		On-disk cache of remote query results.
+ *
+ * Portions Copyright (c) 2012-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 2004-2025, EnterpriseDB Corporation.
+ *
+ * IDENTIFICATION
+ * 		hdfs_cache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common/hashfn.h"
+#include "executor/tuptable.h"
+#include "foreign/foreign.h"
+#include "hdfs_fdw.h"
+#include "miscadmin.h"
+#include "storage/fd.h"
+#include "utils/lsyscache.h"
+
+/* Directory holding the cached results, relative to the data directory. */
+#define HDFS_CACHE_DIR			"hdfs_fdw_cache"
+
+/* Identifies a cached result file, and its format. */
+#define HDFS_CACHE_MAGIC		0x48444631
+
+/*
+ * Files being written are named with this prefix until they are complete,
+ * followed by the process ID and a counter, as several results may be
+ * written at once by the same backend.  Such files left behind by a failed
+ * query are removed after an hour.
+ */
+#define HDFS_CACHE_TMP_PREFIX	"tmp."
+#define HDFS_CACHE_TMP_MAX_AGE	3600
+
+/* Maximum total size of the cached results, in kilobytes. */
+int			hdfs_result_cache_size = 1024 * 1024;
+
+/* Number of results written by this backend, naming their files. */
+static uint32 hdfs_cache_writes = 0;
+
+/*
+ * Every cached result file starts with this header, followed by the
+ * transient_lastDdlTime of each remote table the query reads, and by the
+ * cache key.  The rows follow as length-prefixed minimal tuples, terminated
+ * by a zero length.
+ */
+typedef struct hdfsCacheHeader
+{
+	uint32		magic;
+	int32		nddl_times;		/* number of DDL times following */
+	int64		created;		/* creation time, in seconds since epoch */
+	uint32		keylen;			/* length of the key following */
+} hdfsCacheHeader;
+
+struct hdfsCacheFile
+{
+	FILE	   *file;
+	char	   *path;			/* path of the cached result */
+	char	   *tmppath;		/* path written to, NULL when reading */
+	Size		size;			/* bytes written so far */
+};
+
+typedef struct hdfsCacheDirEntry
+{
+	char	   *path;
+	time_t		mtime;
+	off_t		size;
+} hdfsCacheDirEntry;
+
+static char *hdfs_cache_path(const char *key);
+static void hdfs_cache_abandon(hdfsCacheFile *cf);
+static void hdfs_cache_enforce_limit(void);
+static int	hdfs_cache_entry_cmp(const void *a, const void *b);
+
+/*
+ * hdfs_cache_key
+ * 		Build the key identifying the result of the given remote query.
+ *
+ * Besides the query itself, the key covers the server, the user mapping of
+ * the local user the scan checks permissions as, the remote user the query
+ * runs as, the types of the rows stored and the values bound to the
+ * parameters of the query.  A result is thus only served to the users the
+ * remote server would give it to.
+ */
+char *
+hdfs_cache_key(Oid serverid, Oid userid, const char *username,
+			   const char *query, TupleDesc tupdesc, int nparams,
+			   Oid *param_types, Datum *param_values, bool *param_nulls)
+{
+	UserMapping *user = GetUserMapping(userid, serverid);
+	StringInfoData key;
+	int			i;
+
+	initStringInfo(&key);
+	appendStringInfo(&key, "%u %u %u %zu:%s\n%s\n", MyDatabaseId, serverid,
+					 user->umid, username ? strlen(username) : 0,
+					 username ? username : "", query);
+
+	for (i = 0; i < tupdesc->natts; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+
+		appendStringInfo(&key, "%u %d;", attr->atttypid, attr->atttypmod);
+	}
+	appendStringInfoChar(&key, '\n');
+
+	for (i = 0; i < nparams; i++)
+	{
+		if (param_nulls[i])
+			appendStringInfoString(&key, "-1:");
+		else
+		{
+			Oid			typefnoid;
+			bool		isvarlena;
+			char	   *value;
+
+			getTypeOutputInfo(param_types[i], &typefnoid, &isvarlena);
+			value = OidOutputFunctionCall(typefnoid, param_values[i]);
+			appendStringInfo(&key, "%zu:%s", strlen(value), value);
+		}
+	}
+
+	return key.data;
+}
+
+/*
+ * hdfs_cache_path
+ * 		Path of the file caching the result for the given key.
+ */
+static char *
+hdfs_cache_path(const char *key)
+{
+	uint64		hash;
+
+	hash = hash_bytes_extended((const unsigned char *) key, strlen(key), 0);
+
+	return psprintf("%s/%08x%08x", HDFS_CACHE_DIR,
+					(uint32) (hash >> 32), (uint32) hash);
+}
+
+/*
+ * hdfs_cache_lookup
+ * 		Open the cached result for the given key for reading.
+ *
+ * Returns NULL if there is no such result, if it is older than ttl seconds,
+ * or if it was produced before the remote tables were last changed.  Pass
+ * NULL ddl_times to skip the last check.
+ */
+hdfsCacheFile *
+hdfs_cache_lookup(const char *key, int ttl, int64 *ddl_times, int nddl_times)
+{
+	hdfsCacheFile *cf;
+	hdfsCacheHeader header;
+	char	   *path;
+	FILE	   *file;
+	int64	   *stored_ddl_times = NULL;
+	char	   *stored_key = NULL;
+	bool		valid = false;
+	bool		stale = false;
+
+	path = hdfs_cache_path(key);
+	file = AllocateFile(path, PG_BINARY_R);
+	if (file == NULL)
+	{
+		if (errno != ENOENT)
+			ereport(WARNING,
+					(errcode_for_file_access(),
+					 errmsg("could not open file \"%s\": %m", path)));
+		pfree(path);
+		return NULL;
+	}
+
+	if (fread(&header, sizeof(header), 1, file) == 1 &&
+		header.magic == HDFS_CACHE_MAGIC &&
+		header.nddl_times == nddl_times &&
+		header.keylen == strlen(key))
+	{
+		stored_ddl_times = (int64 *) palloc(sizeof(int64) * (nddl_times + 1));
+		stored_key = (char *) palloc(header.keylen + 1);
+
+		if (fread(stored_ddl_times, sizeof(int64), nddl_times, file) == nddl_times &&
+			fread(stored_key, 1, header.keylen, file) == header.keylen)
+		{
+			stored_key[header.keylen] = '\0';
+
+			/* Different keys may hash to the same file name. */
+			if (strcmp(stored_key, key) == 0)
+			{
+				if ((int64) time(NULL) - header.created >= ttl)
+					stale = true;
+				else if (ddl_times != NULL &&
+						 memcmp(stored_ddl_times, ddl_times,
+								sizeof(int64) * nddl_times) != 0)
+					stale = true;
+				else
+					valid = true;
+			}
+		}
+	}
+
+	if (stored_ddl_times)
+		pfree(stored_ddl_times);
+	if (stored_key)
+		pfree(stored_key);
+
+	if (!valid)
+	{
+		FreeFile(file);
+
+		/* Nobody can make use of an outdated result anymore. */
+		if (stale)
+			unlink(path);
+
+		pfree(path);
+		return NULL;
+	}
+
+	cf = (hdfsCacheFile *) palloc0(sizeof(hdfsCacheFile));
+	cf->file = file;
+	cf->path = path;
+
+	return cf;
+}
+
+/*
+ * hdfs_cache_read
+ * 		Store the next cached row in the given slot, which must be able to
+ * 		hold a minimal tuple.
+ *
+ * Returns false at the end of the cached result.
+ */
+bool
+hdfs_cache_read(hdfsCacheFile *cf, TupleTableSlot *slot)
+{
+	return hdfs_read_row(cf->file, cf->path, slot);
+}
+
+/*
+ * hdfs_cache_begin_write
+ * 		Start caching the result for the given key.
+ *
+ * Returns NULL if the result can't be cached.  Problems with the cache
+ * directory are reported as warnings only, the query itself can go on
+ * without the cache.
+ */
+hdfsCacheFile *
+hdfs_cache_begin_write(const char *key, int64 *ddl_times, int nddl_times)
+{
+	hdfsCacheFile *cf;
+	hdfsCacheHeader header;
+	char	   *path;
+	char	   *tmppath;
+	FILE	   *file;
+
+	if (hdfs_result_cache_size <= 0)
+		return NULL;
+
+	if (MakePGDirectory(HDFS_CACHE_DIR) < 0 && errno != EEXIST)
+	{
+		ereport(WARNING,
+				(errcode_for_file_access(),
+				 errmsg("could not create directory \"%s\": %m",
+						HDFS_CACHE_DIR)));
+		return NULL;
+	}
+
+	path = hdfs_cache_path(key);
+	tmppath = psprintf("%s/%s%d.%u.%s", HDFS_CACHE_DIR, HDFS_CACHE_TMP_PREFIX,
+					   MyProcPid, ++hdfs_cache_writes,
+					   path + strlen(HDFS_CACHE_DIR) + 1);
+
+	file = AllocateFile(tmppath, PG_BINARY_W);
+	if (file == NULL)
+	{
+		ereport(WARNING,
+				(errcode_for_file_access(),
+				 errmsg("could not create file \"%s\": %m", tmppath)));
+		pfree(path);
+		pfree(tmppath);
+		return NULL;
+	}
+
+	cf = (hdfsCacheFile *) palloc0(sizeof(hdfsCacheFile));
+	cf->file = file;
+	cf->path = path;
+	cf->tmppath = tmppath;
+
+	memset(&header, 0, sizeof(header));
+	header.magic = HDFS_CACHE_MAGIC;
+	header.nddl_times = nddl_times;
+	header.created = (int64) time(NULL);
+	header.keylen = strlen(key);
+
+	if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+		fwrite(ddl_times, sizeof(int64), nddl_times, file) != nddl_times ||
+		fwrite(key, 1, header.keylen, file) != header.keylen)
+	{
+		ereport(WARNING,
+				(errcode_for_file_access(),
+				 errmsg("could not write file \"%s\": %m", tmppath)));
+		hdfs_cache_abandon(cf);
+		return NULL;
+	}
+
+	cf->size = sizeof(header) + sizeof(int64) * nddl_times + header.keylen;
+
+	return cf;
+}
+
+/*
+ * hdfs_cache_write
+ * 		Append the row held by the given slot to the result being cached.
+ *
+ * Returns false if the result had to be abandoned, because it grew beyond
+ * the size of the whole cache or it couldn't be written.  The caller must
+ * not use cf anymore in that case.
+ */
+bool
+hdfs_cache_write(hdfsCacheFile *cf, TupleTableSlot *slot)
+{
+	uint32		len;
+	bool		ok = true;
+
+	if (!hdfs_write_row(cf->file, slot, &len))
+	{
+		ereport(WARNING,
+				(errcode_for_file_access(),
+				 errmsg("could not write file \"%s\": %m", cf->tmppath)));
+		ok = false;
+	}
+	else
+	{
+		cf->size += sizeof(len) + len;
+		if (cf->size > (Size) hdfs_result_cache_size * 1024)
+			ok = false;
+	}
+
+	if (!ok)
+		hdfs_cache_abandon(cf);
+
+	return ok;
+}
+
+/*
+ * hdfs_cache_finish_write
+ * 		Complete the result being cached and make it visible to lookups.
+ */
+void
+hdfs_cache_finish_write(hdfsCacheFile *cf)
+{
+	if (!hdfs_write_row(cf->file, NULL, NULL))
+	{
+		ereport(WARNING,
+				(errcode_for_file_access(),
+				 errmsg("could not write file \"%s\": %m", cf->tmppath)));
+		hdfs_cache_abandon(cf);
+		return;
+	}
+
+	if (FreeFile(cf->file) != 0)
+	{
+		ereport(WARNING,
+				(errcode_for_file_access(),
+				 errmsg("could not close file \"%s\": %m", cf->tmppath)));
+		cf->file = NULL;
+		hdfs_cache_abandon(cf);
+		return;
+	}
+	cf->file = NULL;
+
+	/* An existing result for the same key is replaced atomically. */
+	if (rename(cf->tmppath, cf->path) != 0)
+	{
+		ereport(WARNING,
+				(errcode_for_file_access(),
+				 errmsg("could not rename file \"%s\" to \"%s\": %m",
+						cf->tmppath, cf->path)));
+		hdfs_cache_abandon(cf);
+		return;
+	}
+
+	pfree(cf->tmppath);
+	pfree(cf->path);
+	pfree(cf);
+
+	hdfs_cache_enforce_limit();
+}
+
+/*
+ * hdfs_cache_close
+ * 		Close a cached result opened for reading, or abandon one which was
+ * 		being written.
+ */
+void
+hdfs_cache_close(hdfsCacheFile *cf)
+{
+	if (cf->tmppath)
+	{
+		hdfs_cache_abandon(cf);
+		return;
+	}
+
+	FreeFile(cf->file);
+	pfree(cf->path);
+	pfree(cf);
+}
+
+/*
+ * hdfs_cache_abandon
+ * 		Remove the partially written result and free cf.
+ */
+static void
+hdfs_cache_abandon(hdfsCacheFile *cf)
+{
+	if (cf->file)
+		FreeFile(cf->file);
+	unlink(cf->tmppath);
+
+	pfree(cf->tmppath);
+	pfree(cf->path);
+	pfree(cf);
+}
+
+/*
+ * hdfs_cache_enforce_limit
+ * 		Remove the oldest cached results until the cache fits in
+ * 		hdfs_fdw.result_cache_size.
+ */
+static void
+hdfs_cache_enforce_limit(void)
+{
+	DIR		   *dir;
+	struct dirent *de;
+	hdfsCacheDirEntry *entries;
+	int			nentries = 0;
+	int			maxentries = 64;
+	int64		total = 0;
+	int64		limit = (int64) hdfs_result_cache_size * 1024;
+	time_t		now = time(NULL);
+	int			i;
+
+	entries = (hdfsCacheDirEntry *) palloc(sizeof(hdfsCacheDirEntry) * maxentries);
+
+	dir = AllocateDir(HDFS_CACHE_DIR);
+	while ((de = ReadDir(dir, HDFS_CACHE_DIR)) != NULL)
+	{
+		struct stat st;
+		char	   *path;
+
+		if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+			continue;
+
+		path = psprintf("%s/%s", HDFS_CACHE_DIR, de->d_name);
+		if (stat(path, &st) != 0)
+		{
+			/* Removed concurrently. */
+			pfree(path);
+			continue;
+		}
+
+		/* Results still being written don't count, unless left behind. */
+		if (strncmp(de->d_name, HDFS_CACHE_TMP_PREFIX,
+					strlen(HDFS_CACHE_TMP_PREFIX)) == 0)
+		{
+			if (now - st.st_mtime > HDFS_CACHE_TMP_MAX_AGE)
+				unlink(path);
+			pfree(path);
+			continue;
+		}
+
+		if (nentries >= maxentries)
+		{
+			maxentries *= 2;
+			entries = (hdfsCacheDirEntry *)
+				repalloc(entries, sizeof(hdfsCacheDirEntry) * maxentries);
+		}
+
+		entries[nentries].path = path;
+		entries[nentries].mtime = st.st_mtime;
+		entries[nentries].size = st.st_size;
+		nentries++;
+		total += st.st_size;
+	}
+	FreeDir(dir);
+
+	if (total > limit)
+	{
+		qsort(entries, nentries, sizeof(hdfsCacheDirEntry),
+			  hdfs_cache_entry_cmp);
+
+		for (i = 0; i < nentries && total > limit; i++)
+		{
+			if (unlink(entries[i].path) == 0)
+				total -= entries[i].size;
+		}
+	}
+
+	for (i = 0; i < nentries; i++)
+		pfree(entries[i].path);
+	pfree(entries);
+}
+
+/*
+ * hdfs_cache_entry_cmp
+ * 		qsort comparator ordering cached results from the oldest one.
+ */
+static int
+hdfs_cache_entry_cmp(const void *a, const void *b)
+{
+	const hdfsCacheDirEntry *ea = (const hdfsCacheDirEntry *) a;
+	const hdfsCacheDirEntry *eb = (const hdfsCacheDirEntry *) b;
+
+	if (ea->mtime < eb->mtime)
+		return -1;
+	if (ea->mtime > eb->mtime)
+		return 1;
+	return 0;
+}
+
+/*
+ * hdfs_write_row
+ * 		Append the row held by the given slot to a file of rows, as a
+ * 		length-prefixed minimal tuple.  A NULL slot appends the zero length
+ * 		terminating the rows.
+ *
+ * The length of the tuple is returned to *len, if not NULL.  Returns false,
+ * with errno set, if the row couldn't be written.
+ */
+bool
+hdfs_write_row(FILE *file, TupleTableSlot *slot, uint32 *len)
+{
+	MinimalTuple tuple;
+	bool		shouldFree;
+	uint32		tuplen = 0;
+	bool		ok;
+
+	if (slot == NULL)
+		return fwrite(&tuplen, sizeof(tuplen), 1, file) == 1;
+
+	tuple = ExecFetchSlotMinimalTuple(slot, &shouldFree);
+	tuplen = tuple->t_len;
+
+	ok = (fwrite(&tuplen, sizeof(tuplen), 1, file) == 1 &&
+		  fwrite(tuple, 1, tuplen, file) == tuplen);
+
+	if (shouldFree)
+		pfree(tuple);
+
+	if (len)
+		*len = tuplen;
+
+	return ok;
+}
+
+/*
+ * hdfs_read_row
+ * 		Store the next row of a file written by hdfs_write_row() in the given
+ * 		slot, which must be able to hold a minimal tuple.
+ *
+ * Returns false at the end of the rows.  path is used in error messages.
+ */
+bool
+hdfs_read_row(FILE *file, const char *path, TupleTableSlot *slot)
+{
+	uint32		len;
+	MinimalTuple tuple;
+
+	if (fread(&len, sizeof(len), 1, file) != 1)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read file \"%s\": %m", path)));
+
+	if (len == 0)
+		return false;
+
+	/* The slot frees the tuple when it is cleared. */
+	tuple = (MinimalTuple) MemoryContextAlloc(slot->tts_mcxt, len);
+	if (fread(tuple, 1, len, file) != len)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read file \"%s\": %m", path)));
+
+	ExecStoreMinimalTuple(tuple, slot, true);
+
+	return true;
+}
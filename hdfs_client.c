@@ -93,10 +93,15 @@ hdfs_get_value(int con_index, hdfs_opt *opt, Oid pgtyp, int pgtypmod, int idx,
 		case BPCHAROID:
 		case VARCHAROID:
 		case NUMERICOID:
+		case INT8ARRAYOID:
+		case FLOAT8ARRAYOID:
+		case JSONOID:
+		case JSONBOID:
 			{
 				regproc		typeinput;
 				HeapTuple	tuple;
 				int			typemod;
+				Oid			typioparam;
 				char	   *value;
 
 				/* Get the type's output functions */
@@ -106,6 +111,7 @@ hdfs_get_value(int con_index, hdfs_opt *opt, Oid pgtyp, int pgtypmod, int idx,
 
 				typeinput = ((Form_pg_type) GETSTRUCT(tuple))->typinput;
 				typemod = ((Form_pg_type) GETSTRUCT(tuple))->typtypmod;
+				typioparam = getTypeIOParam(tuple);
 				ReleaseSysCache(tuple);
 
 				value = hdfs_get_field_as_cstring(con_index, idx, is_null);
@@ -115,7 +121,7 @@ hdfs_get_value(int con_index, hdfs_opt *opt, Oid pgtyp, int pgtypmod, int idx,
 				else
 					value_datum = OidFunctionCall3(typeinput,
 												   CStringGetDatum(value),
-												   ObjectIdGetDatum(pgtyp),
+												   ObjectIdGetDatum(typioparam),
 												   Int32GetDatum(typemod));
 			}
 			break;
@@ -128,7 +134,7 @@ hdfs_get_value(int con_index, hdfs_opt *opt, Oid pgtyp, int pgtypmod, int idx,
 				ereport(ERROR,
 						(errcode(ERRCODE_FDW_INVALID_DATA_TYPE),
 						 errmsg("unsupported PostgreSQL data type"),
-						 errhint("Supported data types are BOOL, INT, DATE, TIME, TIMESTAMP, FLOAT, BYTEA, SERIAL, REAL, DOUBLE, CHAR, TEXT, STRING, NUMERIC, DECIMAL and VARCHAR.")));
+						 errhint("Supported data types are BOOL, INT, DATE, TIME, TIMESTAMP, FLOAT, BYTEA, SERIAL, REAL, DOUBLE, CHAR, TEXT, STRING, NUMERIC, DECIMAL, VARCHAR, JSON and JSONB.")));
 			}
 			break;
 	}
@@ -252,16 +258,13 @@ hdfs_bind_var(int con_index, int param_index, Oid type, Datum value,
 	char	   *err_buf = "unknown";
 	int			ret;
 
+	/*
+	 * A null value doesn't need any conversion; the driver substitutes a NULL
+	 * literal for the placeholder, whatever the parameter type.
+	 */
 	if (*isnull)
-	{
-		/* TODO: Bind null as a param value yet to handle */
-		ereport(ERROR,
-				(errcode(ERRCODE_FDW_INVALID_DATA_TYPE),
-				 errmsg("cannot bind null parameter"),
-				 errhint("Parameter type: %u", type)));
-	}
-
-	switch (type)
+		ret = DBBindVar(con_index, param_index, type, NULL, isnull, &err_buf);
+	else switch (type)
 	{
 		case INT2OID:
 			{
@@ -354,7 +357,7 @@ hdfs_bind_var(int con_index, int param_index, Oid type, Datum value,
 							 errmsg("error binding parameter"),
 							 errhint("Parameter type: %u", type)));
 
-				snprintf(buf, 50, "%d-%d-%d",
+				snprintf(buf, 50, "%04d-%02d-%02d",
 						 tm->tm_year, tm->tm_mon, tm->tm_mday);
 				ret = DBBindVar(con_index, param_index, type, buf, isnull,
 								&err_buf);
@@ -397,9 +400,10 @@ hdfs_bind_var(int con_index, int param_index, Oid type, Datum value,
 							 errmsg("error binding parameter"),
 							 errhint("Parameter type: %u", type)));
 
-				snprintf(buf, 100, "%d-%d-%d %d:%d:%d.%d",
+				/* Hive casts the string to the parameter type */
+				snprintf(buf, 100, "%04d-%02d-%02d %02d:%02d:%02d.%06d",
 						 tm->tm_year, tm->tm_mon, tm->tm_mday,
-						 tm->tm_hour, tm->tm_min, tm->tm_sec, fsec);
+						 tm->tm_hour, tm->tm_min, tm->tm_sec, (int) fsec);
 				ret = DBBindVar(con_index, param_index, type, buf, isnull,
 								&err_buf);
 			}
@@ -436,6 +440,38 @@ hdfs_bind_var(int con_index, int param_index, Oid type, Datum value,
 	return true;
 }
 
+/*
+ * hdfs_is_bindable_type
+ * 		Returns true if hdfs_bind_var() can bind values of the given type.
+ */
+bool
+hdfs_is_bindable_type(Oid type)
+{
+	switch (type)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case FLOAT4OID:
+		case FLOAT8OID:
+		case NUMERICOID:
+		case BOOLOID:
+		case BPCHAROID:
+		case VARCHAROID:
+		case TEXTOID:
+		case JSONOID:
+		case NAMEOID:
+		case DATEOID:
+		case TIMEOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+		case BITOID:
+			return true;
+		default:
+			return false;
+	}
+}
+
 /*
  * hdfs_close_result_set
  * 		Closes the active result set.
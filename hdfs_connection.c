@@ -69,6 +69,9 @@ hdfs_get_connection(ForeignServer *server, hdfs_opt *opt)
 			(errmsg("hdfs_fdw: new connection(%d) opened for server \"%s\"",
 					conn, server->servername)));
 
+	/* The first connection to a server tells what SQL it understands. */
+	hdfs_probe_server_version(conn, server, opt);
+
 	return conn;
 }
 
@@ -0,0 +1,236 @@
+/*-------------------------------------------------------------------------
+ *
+ * hdfs_costs.c
+ * 		Bookkeeping of remote execution timings used for costing.
+ *
+ * Portions Copyright (c) 2012-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 2004-2025, EnterpriseDB Corporation.
+ *
+ * IDENTIFICATION
+ * 		hdfs_costs.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "hdfs_fdw.h"
+#include "miscadmin.h"
+#if PG_VERSION_NUM >= 170000
+#include "storage/dsm_registry.h"
+#endif
+#include "storage/lwlock.h"
+#include "utils/memutils.h"
+
+/* Number of foreign servers whose timings are remembered. */
+#define HDFS_COST_MAX_SERVERS	64
+
+/* Weight of a new sample in the exponentially decayed averages. */
+#define HDFS_COST_DECAY			0.2
+
+/*
+ * Remote timings which get the default costs.  The observed timings are
+ * scaled by the same ratios, so that the costs of a server with
+ * use_observed_costs stay comparable with those of the other servers and of
+ * the local plan nodes.  A single factor for both would not do: the default
+ * per-row cost is far higher, relative to the startup cost, than the time
+ * to fetch a row is relative to the time to start a query.
+ */
+#define HDFS_TYPICAL_STARTUP_MS	10000.0
+#define HDFS_TYPICAL_ROW_MS		0.01
+
+/*
+ * Decayed timings of one foreign server.  Server OIDs are only unique within
+ * a database, hence the database OID is part of the key.
+ */
+typedef struct hdfsCostEntry
+{
+	Oid			dbid;
+	Oid			serverid;
+	double		startup_ms;		/* time to the first row */
+	double		row_ms;			/* time to fetch each further row */
+	uint64		startup_samples;
+	uint64		row_samples;
+	uint64		last_used;		/* for evicting the least recent entry */
+} hdfsCostEntry;
+
+typedef struct hdfsCostState
+{
+	int			tranche_id;
+	LWLock		lock;
+	uint64		counter;
+	hdfsCostEntry entries[HDFS_COST_MAX_SERVERS];
+} hdfsCostState;
+
+static hdfsCostState *cost_state = NULL;
+
+/*
+ * True if cost_state lives in shared memory and needs locking, false if it is
+ * private to this backend.
+ */
+static bool cost_state_shared = false;
+
+static hdfsCostState *hdfs_get_cost_state(void);
+static hdfsCostEntry *hdfs_find_cost_entry(hdfsCostState *state,
+										   Oid serverid, bool create);
+
+#if PG_VERSION_NUM >= 170000
+/*
+ * hdfs_init_cost_state
+ * 		Initialize a freshly allocated named DSM segment.
+ */
+static void
+hdfs_init_cost_state(void *ptr)
+{
+	hdfsCostState *state = (hdfsCostState *) ptr;
+
+	memset(state, 0, sizeof(hdfsCostState));
+	state->tranche_id = LWLockNewTrancheId();
+	LWLockInitialize(&state->lock, state->tranche_id);
+}
+#endif
+
+/*
+ * hdfs_get_cost_state
+ * 		Attach to the timing statistics.
+ *
+ * From PostgreSQL 17 onwards, the statistics live in a named DSM segment and
+ * are shared by all the backends, without requiring the library to be
+ * preloaded.  With older servers, every backend keeps its own copy.
+ */
+static hdfsCostState *
+hdfs_get_cost_state(void)
+{
+	if (cost_state)
+		return cost_state;
+
+#if PG_VERSION_NUM >= 170000
+	{
+		bool		found;
+
+		cost_state = GetNamedDSMSegment("hdfs_fdw_costs",
+										sizeof(hdfsCostState),
+										hdfs_init_cost_state,
+										&found);
+		LWLockRegisterTranche(cost_state->tranche_id, "hdfs_fdw_costs");
+		cost_state_shared = true;
+	}
+#else
+	cost_state = (hdfsCostState *) MemoryContextAllocZero(TopMemoryContext,
+														  sizeof(hdfsCostState));
+	cost_state_shared = false;
+#endif
+
+	return cost_state;
+}
+
+/*
+ * hdfs_find_cost_entry
+ * 		Find the entry of the given server, optionally creating it.
+ *
+ * When all the slots are taken, the least recently used one is recycled.  The
+ * caller must hold the lock in exclusive mode if create is true.
+ */
+static hdfsCostEntry *
+hdfs_find_cost_entry(hdfsCostState *state, Oid serverid, bool create)
+{
+	hdfsCostEntry *victim = NULL;
+	int			i;
+
+	for (i = 0; i < HDFS_COST_MAX_SERVERS; i++)
+	{
+		hdfsCostEntry *entry = &state->entries[i];
+
+		if (entry->serverid == serverid && entry->dbid == MyDatabaseId)
+			return entry;
+
+		if (victim == NULL || entry->last_used < victim->last_used)
+			victim = entry;
+	}
+
+	if (!create)
+		return NULL;
+
+	memset(victim, 0, sizeof(hdfsCostEntry));
+	victim->dbid = MyDatabaseId;
+	victim->serverid = serverid;
+
+	return victim;
+}
+
+/*
+ * hdfs_record_remote_timing
+ * 		Fold the timings of one remote query execution into the decayed
+ * 		averages of the given server.
+ *
+ * startup_ms is the time from sending the query until the first row (or the
+ * end of the result set) arrived.  row_ms is the average time taken to fetch
+ * each further row, or a negative value if fewer than two rows were fetched.
+ */
+void
+hdfs_record_remote_timing(Oid serverid, double startup_ms, double row_ms)
+{
+	hdfsCostState *state = hdfs_get_cost_state();
+	hdfsCostEntry *entry;
+
+	if (cost_state_shared)
+		LWLockAcquire(&state->lock, LW_EXCLUSIVE);
+
+	entry = hdfs_find_cost_entry(state, serverid, true);
+	entry->last_used = ++state->counter;
+
+	if (entry->startup_samples == 0)
+		entry->startup_ms = startup_ms;
+	else
+		entry->startup_ms += HDFS_COST_DECAY * (startup_ms - entry->startup_ms);
+	entry->startup_samples++;
+
+	if (row_ms >= 0)
+	{
+		if (entry->row_samples == 0)
+			entry->row_ms = row_ms;
+		else
+			entry->row_ms += HDFS_COST_DECAY * (row_ms - entry->row_ms);
+		entry->row_samples++;
+	}
+
+	if (cost_state_shared)
+		LWLockRelease(&state->lock);
+
+	elog(DEBUG2, "hdfs_fdw: server %u timings: startup %.3f ms, per row %.6f ms",
+		 serverid, startup_ms, row_ms);
+}
+
+/*
+ * hdfs_get_observed_costs
+ * 		Convert the observed timings of the given server into planner costs.
+ *
+ * Returns false if nothing has been observed for the server yet.  The
+ * per-tuple cost is left untouched until enough rows have been seen.
+ */
+bool
+hdfs_get_observed_costs(Oid serverid, Cost *startup_cost, Cost *tuple_cost)
+{
+	hdfsCostState *state = hdfs_get_cost_state();
+	hdfsCostEntry *entry;
+	bool		found = false;
+
+	if (cost_state_shared)
+		LWLockAcquire(&state->lock, LW_SHARED);
+
+	entry = hdfs_find_cost_entry(state, serverid, false);
+	if (entry && entry->startup_samples > 0)
+	{
+		*startup_cost = entry->startup_ms *
+			(DEFAULT_FDW_STARTUP_COST / HDFS_TYPICAL_STARTUP_MS);
+		if (entry->row_samples > 0)
+			*tuple_cost = entry->row_ms *
+				(DEFAULT_FDW_TUPLE_COST / HDFS_TYPICAL_ROW_MS);
+		found = true;
+	}
+
+	if (cost_state_shared)
+		LWLockRelease(&state->lock);
+
+	return found;
+}
@@ -14,10 +14,13 @@
 
 #include "postgres.h"
 
+#include <ctype.h>
+
 #include "access/heapam.h"
 #include "access/htup_details.h"
 #include "access/sysattr.h"
 #include "access/transam.h"
+#include "catalog/pg_aggregate.h"
 #include "catalog/pg_collation.h"
 #include "catalog/pg_namespace.h"
 #include "catalog/pg_operator.h"
@@ -27,10 +30,15 @@
 #include "hdfs_fdw.h"
 #include "nodes/nodeFuncs.h"
 #include "optimizer/optimizer.h"
+#include "parser/parse_agg.h"
 #include "parser/parsetree.h"
+#include "utils/array.h"
 #include "utils/builtins.h"
+#include "utils/date.h"
+#include "utils/datetime.h"
 #include "utils/lsyscache.h"
 #include "utils/syscache.h"
+#include "utils/timestamp.h"
 #include "utils/typcache.h"
 
 
@@ -41,18 +49,265 @@ typedef struct foreign_glob_cxt
 {
 	PlannerInfo *root;			/* global planner state */
 	RelOptInfo *foreignrel;		/* the foreign relation we are planning for */
-
-	/*
-	 * For join pushdown, only a limited set of operators are allowed to be
-	 * pushed.  This flag helps us identify if we are walking through the list
-	 * of join conditions.  Also true for aggregate relations to restrict
-	 * aggregates for specified list.
-	 */
-	bool		is_remote_cond; /* true for join or aggregate relations */
 	Relids		relids;			/* relids of base relations in the underlying
 								 * scan */
 } foreign_glob_cxt;
 
+/*
+ * How an aggregate is computed on hive/spark.
+ */
+typedef enum hdfsAggKind
+{
+	HDFS_AGG_PLAIN,				/* an aggregate of the same semantics */
+	HDFS_AGG_BOOL,				/* min or max of the input cast to int */
+	HDFS_AGG_STRING,			/* concat_ws over collect_list */
+	HDFS_AGG_PERCENTILE			/* percentile, or percentile_approx */
+} hdfsAggKind;
+
+/*
+ * Aggregates which can be pushed down, identified by their name and number
+ * of aggregated arguments.
+ */
+typedef struct hdfsAggMapping
+{
+	const char *pg_name;
+	int			nargs;
+	const char *remote_name;
+	hdfsAggKind kind;
+	bool		float_only;		/* hive/spark compute it in double precision,
+								 * push it only if so does PostgreSQL */
+	bool		ignore_order;	/* result doesn't depend on the input order */
+} hdfsAggMapping;
+
+static const hdfsAggMapping hdfs_agg_mappings[] =
+{
+	{"count", 0, "count", HDFS_AGG_PLAIN, false, true},
+	{"count", 1, "count", HDFS_AGG_PLAIN, false, true},
+	{"min", 1, "min", HDFS_AGG_PLAIN, false, true},
+	{"max", 1, "max", HDFS_AGG_PLAIN, false, true},
+	{"sum", 1, "sum", HDFS_AGG_PLAIN, false, false},
+	{"avg", 1, "avg", HDFS_AGG_PLAIN, false, false},
+	{"stddev", 1, "stddev_samp", HDFS_AGG_PLAIN, true, false},
+	{"stddev_samp", 1, "stddev_samp", HDFS_AGG_PLAIN, true, false},
+	{"stddev_pop", 1, "stddev_pop", HDFS_AGG_PLAIN, true, false},
+	{"variance", 1, "var_samp", HDFS_AGG_PLAIN, true, false},
+	{"var_samp", 1, "var_samp", HDFS_AGG_PLAIN, true, false},
+	{"var_pop", 1, "var_pop", HDFS_AGG_PLAIN, true, false},
+	{"corr", 2, "corr", HDFS_AGG_PLAIN, true, false},
+	{"covar_pop", 2, "covar_pop", HDFS_AGG_PLAIN, true, false},
+	{"covar_samp", 2, "covar_samp", HDFS_AGG_PLAIN, true, false},
+	{"bool_and", 1, "min", HDFS_AGG_BOOL, false, true},
+	{"every", 1, "min", HDFS_AGG_BOOL, false, true},
+	{"bool_or", 1, "max", HDFS_AGG_BOOL, false, true},
+	{"string_agg", 2, "collect_list", HDFS_AGG_STRING, false, false},
+	{"percentile_cont", 1, "percentile_approx", HDFS_AGG_PERCENTILE, true, false},
+	{NULL, 0, NULL, HDFS_AGG_PLAIN, false, false}
+};
+
+/*
+ * Window functions, other than aggregates, which can be pushed down with the
+ * range of their number of arguments.
+ */
+typedef struct hdfsWindowFuncMapping
+{
+	const char *name;
+	int			min_args;
+	int			max_args;
+	bool		needs_order;	/* hive requires an ORDER BY for it */
+	bool		uses_frame;		/* the window frame changes its result */
+} hdfsWindowFuncMapping;
+
+static const hdfsWindowFuncMapping hdfs_window_func_mappings[] =
+{
+	{"row_number", 0, 0, false, false},
+	{"rank", 0, 0, true, false},
+	{"dense_rank", 0, 0, true, false},
+	{"percent_rank", 0, 0, true, false},
+	{"cume_dist", 0, 0, true, false},
+	{"ntile", 1, 1, true, false},
+	{"lag", 1, 3, true, false},
+	{"lead", 1, 3, true, false},
+	{"first_value", 1, 1, false, true},
+	{"last_value", 1, 1, false, true},
+	{NULL, 0, 0, false, false}
+};
+
+/*
+ * Functions which can be pushed down, identified by their name, number of
+ * arguments and type of the first argument.  The templates give the remote
+ * expression for each dialect, %n standing for the n-th argument; a NULL one
+ * means that the dialect has no equivalent.  A function computing the
+ * template from the call itself is used instead when given.
+ */
+typedef const char *(*hdfs_template_fn) (FuncExpr *node,
+										 CLIENT_TYPE client_type);
+
+typedef struct hdfsFuncMapping
+{
+	const char *pg_name;
+	int			nargs;
+	Oid			argtype;		/* InvalidOid for any type */
+	const char *hive_template;
+	const char *spark_template;
+	hdfs_template_fn get_template;
+} hdfsFuncMapping;
+
+/*
+ * Pattern-matching operators on strings, deparsed as LIKE or RLIKE.
+ */
+typedef struct hdfsPatternOperator
+{
+	const char *name;
+	bool		regex;			/* RLIKE rather than LIKE */
+	bool		case_insensitive;
+	bool		negate;
+} hdfsPatternOperator;
+
+static const hdfsPatternOperator hdfs_pattern_operators[] =
+{
+	{"~~", false, false, false},
+	{"!~~", false, false, true},
+	{"~~*", false, true, false},
+	{"!~~*", false, true, true},
+	{"~", true, false, false},
+	{"!~", true, false, true},
+	{"~*", true, true, false},
+	{"!~*", true, true, true},
+	{NULL, false, false, false}
+};
+
+static const char *hdfs_substr_template(FuncExpr *node,
+										CLIENT_TYPE client_type);
+static const char *hdfs_extract_template(FuncExpr *node,
+										 CLIENT_TYPE client_type);
+static const char *hdfs_date_trunc_template(FuncExpr *node,
+											CLIENT_TYPE client_type);
+
+static const hdfsFuncMapping hdfs_func_mappings[] =
+{
+	/* string functions */
+	{"upper", 1, TEXTOID, "upper(%1)", "upper(%1)", NULL},
+	{"lower", 1, TEXTOID, "lower(%1)", "lower(%1)", NULL},
+	{"length", 1, TEXTOID, "length(%1)", "length(%1)", NULL},
+	{"char_length", 1, TEXTOID, "length(%1)", "length(%1)", NULL},
+	{"character_length", 1, TEXTOID, "length(%1)", "length(%1)", NULL},
+	{"btrim", 1, TEXTOID, "trim(%1)", "trim(%1)", NULL},
+	{"ltrim", 1, TEXTOID, "ltrim(%1)", "ltrim(%1)", NULL},
+	{"rtrim", 1, TEXTOID, "rtrim(%1)", "rtrim(%1)", NULL},
+	{"btrim", 2, TEXTOID, NULL, "trim(BOTH %2 FROM %1)", NULL},
+	{"ltrim", 2, TEXTOID, NULL, "trim(LEADING %2 FROM %1)", NULL},
+	{"rtrim", 2, TEXTOID, NULL, "trim(TRAILING %2 FROM %1)", NULL},
+	{"position", 2, TEXTOID, "instr(%1, %2)", "instr(%1, %2)", NULL},
+	{"strpos", 2, TEXTOID, "instr(%1, %2)", "instr(%1, %2)", NULL},
+	{"substr", 2, TEXTOID, NULL, NULL, hdfs_substr_template},
+	{"substr", 3, TEXTOID, NULL, NULL, hdfs_substr_template},
+	{"substring", 2, TEXTOID, NULL, NULL, hdfs_substr_template},
+	{"substring", 3, TEXTOID, NULL, NULL, hdfs_substr_template},
+	{"replace", 3, TEXTOID, "replace(%1, %2, %3)", "replace(%1, %2, %3)", NULL},
+	{"reverse", 1, TEXTOID, "reverse(%1)", "reverse(%1)", NULL},
+	{"repeat", 2, TEXTOID, "repeat(%1, %2)", "repeat(%1, %2)", NULL},
+	{"lpad", 2, TEXTOID, "lpad(%1, %2, ' ')", "lpad(%1, %2, ' ')", NULL},
+	{"lpad", 3, TEXTOID, "lpad(%1, %2, %3)", "lpad(%1, %2, %3)", NULL},
+	{"rpad", 2, TEXTOID, "rpad(%1, %2, ' ')", "rpad(%1, %2, ' ')", NULL},
+	{"rpad", 3, TEXTOID, "rpad(%1, %2, %3)", "rpad(%1, %2, %3)", NULL},
+	{"ascii", 1, TEXTOID, "ascii(%1)", "ascii(%1)", NULL},
+	{"md5", 1, TEXTOID, "md5(%1)", "md5(%1)", NULL},
+
+	/* numeric functions */
+	{"abs", 1, InvalidOid, "abs(%1)", "abs(%1)", NULL},
+	{"ceil", 1, InvalidOid, "ceil(%1)", "ceil(%1)", NULL},
+	{"ceiling", 1, InvalidOid, "ceil(%1)", "ceil(%1)", NULL},
+	{"floor", 1, InvalidOid, "floor(%1)", "floor(%1)", NULL},
+	{"sign", 1, InvalidOid, "sign(%1)", "sign(%1)", NULL},
+	{"round", 1, NUMERICOID, "round(%1)", "round(%1)", NULL},
+	{"round", 2, NUMERICOID, "round(%1, %2)", "round(%1, %2)", NULL},
+	{"mod", 2, INT2OID, "(%1 %% %2)", "(%1 %% %2)", NULL},
+	{"mod", 2, INT4OID, "(%1 %% %2)", "(%1 %% %2)", NULL},
+	{"mod", 2, INT8OID, "(%1 %% %2)", "(%1 %% %2)", NULL},
+	{"sqrt", 1, FLOAT8OID, "sqrt(%1)", "sqrt(%1)", NULL},
+	{"cbrt", 1, FLOAT8OID, "cbrt(%1)", "cbrt(%1)", NULL},
+	{"exp", 1, FLOAT8OID, "exp(%1)", "exp(%1)", NULL},
+	{"ln", 1, FLOAT8OID, "ln(%1)", "ln(%1)", NULL},
+	{"log", 1, FLOAT8OID, "log10(%1)", "log10(%1)", NULL},
+	{"log10", 1, FLOAT8OID, "log10(%1)", "log10(%1)", NULL},
+	{"power", 2, FLOAT8OID, "pow(%1, %2)", "pow(%1, %2)", NULL},
+	{"pow", 2, FLOAT8OID, "pow(%1, %2)", "pow(%1, %2)", NULL},
+	{"degrees", 1, FLOAT8OID, "degrees(%1)", "degrees(%1)", NULL},
+	{"radians", 1, FLOAT8OID, "radians(%1)", "radians(%1)", NULL},
+	{"sin", 1, FLOAT8OID, "sin(%1)", "sin(%1)", NULL},
+	{"cos", 1, FLOAT8OID, "cos(%1)", "cos(%1)", NULL},
+	{"tan", 1, FLOAT8OID, "tan(%1)", "tan(%1)", NULL},
+	{"asin", 1, FLOAT8OID, "asin(%1)", "asin(%1)", NULL},
+	{"acos", 1, FLOAT8OID, "acos(%1)", "acos(%1)", NULL},
+	{"atan", 1, FLOAT8OID, "atan(%1)", "atan(%1)", NULL},
+
+	/* date and time functions */
+	{"date_part", 2, TEXTOID, NULL, NULL, hdfs_extract_template},
+	{"extract", 2, TEXTOID, NULL, NULL, hdfs_extract_template},
+	{"date_trunc", 2, TEXTOID, NULL, NULL, hdfs_date_trunc_template},
+
+	{NULL, 0, InvalidOid, NULL, NULL, NULL}
+};
+
+/*
+ * Operators which can be pushed down, identified by their name, number of
+ * operands and the types of these: exact ones when given, otherwise any
+ * type of the listed kinds, "N" for numbers, "I" for integers only, "S" for
+ * strings, "D" for dates and timestamps and "B" for booleans.  The first
+ * matching entry gives the templates, written as for functions.
+ */
+typedef struct hdfsOpMapping
+{
+	const char *pg_name;
+	int			nargs;
+	Oid			lefttype;
+	Oid			righttype;
+	const char *kinds;
+	const char *hive_template;
+	const char *spark_template;
+} hdfsOpMapping;
+
+static const hdfsOpMapping hdfs_op_mappings[] =
+{
+	/* comparisons */
+	{"=", 2, InvalidOid, InvalidOid, "NSDB", "(%1 = %2)", "(%1 = %2)"},
+	{"<>", 2, InvalidOid, InvalidOid, "NSDB", "(%1 <> %2)", "(%1 <> %2)"},
+	{"<", 2, InvalidOid, InvalidOid, "NSDB", "(%1 < %2)", "(%1 < %2)"},
+	{"<=", 2, InvalidOid, InvalidOid, "NSDB", "(%1 <= %2)", "(%1 <= %2)"},
+	{">", 2, InvalidOid, InvalidOid, "NSDB", "(%1 > %2)", "(%1 > %2)"},
+	{">=", 2, InvalidOid, InvalidOid, "NSDB", "(%1 >= %2)", "(%1 >= %2)"},
+
+	/* date arithmetic, in days */
+	{"+", 2, DATEOID, INT4OID, NULL, "date_add(%1, %2)", "date_add(%1, %2)"},
+	{"+", 2, INT4OID, DATEOID, NULL, "date_add(%2, %1)", "date_add(%2, %1)"},
+	{"-", 2, DATEOID, INT4OID, NULL, "date_sub(%1, %2)", "date_sub(%1, %2)"},
+	{"-", 2, DATEOID, DATEOID, NULL, "datediff(%1, %2)", "datediff(%1, %2)"},
+
+	/* timestamp arithmetic, with interval literals */
+	{"+", 2, TIMESTAMPOID, INTERVALOID, NULL, "(%1 + %2)", "(%1 + %2)"},
+	{"+", 2, INTERVALOID, TIMESTAMPOID, NULL, "(%2 + %1)", "(%2 + %1)"},
+	{"-", 2, TIMESTAMPOID, INTERVALOID, NULL, "(%1 - %2)", "(%1 - %2)"},
+	{"+", 2, DATEOID, INTERVALOID, NULL, "(CAST(%1 AS TIMESTAMP) + %2)",
+	"(CAST(%1 AS TIMESTAMP) + %2)"},
+	{"-", 2, DATEOID, INTERVALOID, NULL, "(CAST(%1 AS TIMESTAMP) - %2)",
+	"(CAST(%1 AS TIMESTAMP) - %2)"},
+
+	/* arithmetic, "/" always giving a double in hive */
+	{"/", 2, InvalidOid, InvalidOid, "I", "(%1 DIV %2)", "(%1 DIV %2)"},
+	{"+", 2, InvalidOid, InvalidOid, "N", "(%1 + %2)", "(%1 + %2)"},
+	{"-", 2, InvalidOid, InvalidOid, "N", "(%1 - %2)", "(%1 - %2)"},
+	{"*", 2, InvalidOid, InvalidOid, "N", "(%1 * %2)", "(%1 * %2)"},
+	{"/", 2, InvalidOid, InvalidOid, "N", "(%1 / %2)", "(%1 / %2)"},
+	{"%", 2, InvalidOid, InvalidOid, "N", "(%1 %% %2)", "(%1 %% %2)"},
+	{"-", 1, InvalidOid, InvalidOid, "N", "(- %1)", "(- %1)"},
+	{"+", 1, InvalidOid, InvalidOid, "N", "(+ %1)", "(+ %1)"},
+
+	/* string concatenation */
+	{"||", 2, TEXTOID, TEXTOID, NULL, "concat(%1, %2)", "concat(%1, %2)"},
+
+	{NULL, 0, InvalidOid, InvalidOid, NULL, NULL, NULL}
+};
+
 /*
  * Local (per-tree-level) context for hdfs_foreign_expr_walker's search.
  * This is concerned with identifying collations used in the expression.
@@ -92,6 +347,12 @@ typedef struct deparse_expr_cxt
 #define SUBQUERY_REL_ALIAS_PREFIX	"s"
 #define SUBQUERY_COL_ALIAS_PREFIX	"c"
 
+/*
+ * Maximum estimated size, in kB, of the side of a join hinted to be broadcast
+ * to all the tasks reading the other side, 0 to hint none.
+ */
+int			hdfs_join_hint_threshold = 10 * 1024;
+
 /*
  * Functions to determine whether an expression can be evaluated safely on
  * remote server.
@@ -113,6 +374,7 @@ static char *hdfs_quote_identifier(const char *str, char quotechar);
 static void hdfs_deparse_column_ref(StringInfo buf, int varno, int varattno,
 									PlannerInfo *root, bool qualify_col);
 static void hdfs_deparse_relation(StringInfo buf, Relation rel);
+static void hdfs_deparse_hive_string_literal(StringInfo buf, const char *val);
 static void hdfs_deparse_expr(Expr *expr, deparse_expr_cxt *context);
 static void hdfs_deparse_var(Var *node, deparse_expr_cxt *context);
 static void hdfs_deparse_const(Const *node, deparse_expr_cxt *context);
@@ -121,8 +383,23 @@ static void hdfs_deparse_subscripting_ref(SubscriptingRef *node,
 										  deparse_expr_cxt *context);
 static void hdfs_deparse_func_expr(FuncExpr *node, deparse_expr_cxt *context);
 static void hdfs_deparse_op_expr(OpExpr *node, deparse_expr_cxt *context);
-static void hdfs_deparse_operator_name(StringInfo buf,
-									   Form_pg_operator opform);
+static const char *hdfs_get_operator_template(Oid opno, Oid lefttype,
+											  Oid righttype,
+											  hdfs_dialect *dialect);
+static bool hdfs_is_operand_kind(Oid type, const char *kinds);
+static bool hdfs_are_interval_args_literals(List *args);
+static void hdfs_deparse_template(const char *remote_template, List *args,
+								  deparse_expr_cxt *context);
+static CLIENT_TYPE hdfs_get_client_type(RelOptInfo *foreignrel);
+static hdfs_dialect *hdfs_get_rel_dialect(RelOptInfo *foreignrel);
+static const hdfsPatternOperator *hdfs_get_pattern_operator(Oid opno);
+static bool hdfs_is_pattern_op_pushable(OpExpr *node,
+										const hdfsPatternOperator *patop);
+static char *hdfs_get_pattern_const(OpExpr *node);
+static char *hdfs_translate_regex(const char *pattern, bool case_insensitive);
+static void hdfs_deparse_pattern_op(OpExpr *node,
+									const hdfsPatternOperator *patop,
+									deparse_expr_cxt *context);
 static void hdfs_deparse_distinct_expr(DistinctExpr *node,
 									   deparse_expr_cxt *context);
 static void hdfs_deparse_scalar_array_op_expr(ScalarArrayOpExpr *node,
@@ -131,15 +408,34 @@ static void hdfs_deparse_relabel_type(RelabelType *node,
 									  deparse_expr_cxt *context);
 static void hdfs_deparse_bool_expr(BoolExpr *node, deparse_expr_cxt *context);
 static void hdfs_deparse_null_test(NullTest *node, deparse_expr_cxt *context);
-static void hdfs_deparse_array_expr(ArrayExpr *node,
-									deparse_expr_cxt *context);
-static void hdfs_deparse_string_literal(StringInfo buf, const char *val);
-static void hdfs_print_remote_param(deparse_expr_cxt *context);
-static void hdfs_print_remote_placeholder(deparse_expr_cxt *context);
+static void hdfs_deparse_boolean_test(BooleanTest *node,
+									  deparse_expr_cxt *context);
+static void hdfs_deparse_case_expr(CaseExpr *node, deparse_expr_cxt *context);
+static void hdfs_deparse_coalesce_expr(CoalesceExpr *node,
+									   deparse_expr_cxt *context);
+static void hdfs_deparse_nullif_expr(NullIfExpr *node,
+									 deparse_expr_cxt *context);
+static void hdfs_deparse_min_max_expr(MinMaxExpr *node,
+									  deparse_expr_cxt *context);
+static void hdfs_deparse_coerce_via_io(CoerceViaIO *node,
+									   deparse_expr_cxt *context);
+static const char *hdfs_get_coerce_type_name(CoerceViaIO *node);
+static void hdfs_print_remote_param(Oid paramtype, deparse_expr_cxt *context);
+static void hdfs_print_remote_placeholder(Oid paramtype,
+										  deparse_expr_cxt *context);
+static const char *hdfs_get_param_type_name(Oid type);
+static bool hdfs_is_const_pushable(Const *node);
+static bool hdfs_is_literal_pushable(Oid type, Datum value);
+static void hdfs_deparse_literal(Oid type, int32 typmod, Datum value,
+								 deparse_expr_cxt *context);
 static void hdfs_append_conditions(List *exprs, deparse_expr_cxt *context);
 static void hdfs_deparse_select_sql(List *tlist, bool is_subquery,
 									List **retrieved_attrs,
 									deparse_expr_cxt *context);
+static void hdfs_append_join_hints(deparse_expr_cxt *context);
+static List *hdfs_get_join_hint_aliases(RelOptInfo *joinrel,
+										HDFS_JOIN_HINTS join_hints,
+										List *aliases);
 static void hdfs_deparse_from_expr_for_rel(StringInfo buf, PlannerInfo *root,
 										   RelOptInfo *foreignrel,
 										   bool use_alias, List **params_list);
@@ -148,12 +444,40 @@ static void hdfs_deparse_from_expr(List *quals, deparse_expr_cxt *context,
 static void hdfs_deparse_rangeTblRef(StringInfo buf, PlannerInfo *root,
 									 RelOptInfo *foreignrel, bool make_subquery,
 									 List **params_list);
+static const char *hdfs_get_column_type_name(Form_pg_attribute attr);
+static const char *hdfs_get_remote_jointype_name(JoinType jointype,
+												 CLIENT_TYPE client_type);
 static void hdfs_deparse_explicit_target_list(List *tlist,
 											  List **retrieved_attrs,
 											  deparse_expr_cxt *context);
 static void hdfs_deparse_subquery_target_list(deparse_expr_cxt *context);
-static void hdfs_append_function_name(Oid funcid, deparse_expr_cxt *context);
+static const char *hdfs_get_function_template(FuncExpr *node,
+											  CLIENT_TYPE client_type);
+static const char *hdfs_get_cast_template(FuncExpr *node);
+static char *hdfs_get_const_field(Node *node);
 static void hdfs_deparse_aggref(Aggref *node, deparse_expr_cxt *context);
+static void hdfs_deparse_grouping_func(GroupingFunc *node,
+									   deparse_expr_cxt *context);
+static const hdfsAggMapping *hdfs_get_agg_mapping(Oid aggfnoid, int nargs);
+static bool hdfs_is_window_func_pushable(WindowFunc *wf,
+										 foreign_glob_cxt *glob_cxt);
+static bool hdfs_is_window_frame_pushable(WindowClause *wc);
+static WindowClause *hdfs_get_window_clause(PlannerInfo *root, Index winref);
+static const hdfsWindowFuncMapping *hdfs_get_window_func_mapping(Oid winfnoid);
+static void hdfs_deparse_window_func(WindowFunc *node,
+									 deparse_expr_cxt *context);
+static void hdfs_deparse_window_frame(WindowClause *wc,
+									  deparse_expr_cxt *context);
+static bool hdfs_is_agg_pushable(Aggref *agg, const hdfsAggMapping *mapping,
+								 foreign_glob_cxt *glob_cxt);
+static bool hdfs_is_partial_agg_pushable(Aggref *agg,
+										 const hdfsAggMapping *mapping);
+static void hdfs_deparse_avg_state(Aggref *node, deparse_expr_cxt *context);
+static bool hdfs_is_agg_order_pushable(Aggref *agg,
+									   const hdfsAggMapping *mapping);
+static Expr *hdfs_get_percentile_integral_arg(Aggref *agg);
+static void hdfs_deparse_agg_arg(Aggref *node, Expr *arg,
+								 deparse_expr_cxt *context);
 static void hdfs_append_groupby_clause(List *tlist, deparse_expr_cxt *context);
 static Node *hdfs_deparse_sort_group_clause(Index ref, List *tlist,
 											deparse_expr_cxt *context);
@@ -163,7 +487,7 @@ static void hdfs_append_orderby_suffix(const char *sortby_dir, Oid sortcoltype,
 									   bool nulls_first,
 									   deparse_expr_cxt *context);
 static void hdfs_append_limit_clause(deparse_expr_cxt *context,
-									 CLIENT_TYPE client_type);
+									 hdfs_dialect *dialect);
 
 /*
  * Helper functions
@@ -197,7 +521,7 @@ hdfs_classify_conditions(PlannerInfo *root,
 	{
 		RestrictInfo *ri = (RestrictInfo *) lfirst(lc);
 
-		if (hdfs_is_foreign_expr(root, baserel, ri->clause, false))
+		if (hdfs_is_foreign_expr(root, baserel, ri->clause))
 			*remote_conds = lappend(*remote_conds, ri);
 		else
 			*local_conds = lappend(*local_conds, ri);
@@ -208,8 +532,7 @@ hdfs_classify_conditions(PlannerInfo *root,
  * Returns true if given expr is safe to evaluate on the foreign server.
  */
 bool
-hdfs_is_foreign_expr(PlannerInfo *root, RelOptInfo *baserel, Expr *expr,
-					 bool is_remote_cond)
+hdfs_is_foreign_expr(PlannerInfo *root, RelOptInfo *baserel, Expr *expr)
 {
 	foreign_glob_cxt glob_cxt;
 	foreign_loc_cxt loc_cxt;
@@ -221,7 +544,6 @@ hdfs_is_foreign_expr(PlannerInfo *root, RelOptInfo *baserel, Expr *expr,
 	 */
 	glob_cxt.root = root;
 	glob_cxt.foreignrel = baserel;
-	glob_cxt.is_remote_cond = is_remote_cond;
 
 	/*
 	 * For an upper relation, use relids from its underneath scan relation,
@@ -301,20 +623,29 @@ hdfs_foreign_expr_walker(Node *node,
 			}
 			break;
 		case T_Const:
+			/* Some values have no literal in hive */
+			if (!hdfs_is_const_pushable((Const *) node))
+				return false;
+			break;
 		case T_Param:
 			break;
 		case T_SubscriptingRef:
 			{
-				SubscriptingRef *sbref = (SubscriptingRef *) node;;
-
-				/* Should not be in the join clauses of the Join-pushdown */
-				if (glob_cxt->is_remote_cond)
-					return false;
+				SubscriptingRef *sbref = (SubscriptingRef *) node;
 
 				/* Assignment should not be in restrictions. */
 				if (sbref->refassgnexpr != NULL)
 					return false;
 
+				/*
+				 * Hive only takes a single subscript of an array, with no
+				 * slices.
+				 */
+				if (!OidIsValid(get_element_type(sbref->refcontainertype)) ||
+					sbref->reflowerindexpr != NIL ||
+					list_length(sbref->refupperindexpr) != 1)
+					return false;
+
 				/*
 				 * Recurse to remaining subexpressions.  Since the array
 				 * subscripts must yield (noncollatable) integers, they won't
@@ -323,9 +654,6 @@ hdfs_foreign_expr_walker(Node *node,
 				if (!hdfs_foreign_expr_walker((Node *) sbref->refupperindexpr,
 											  glob_cxt, &inner_cxt))
 					return false;
-				if (!hdfs_foreign_expr_walker((Node *) sbref->reflowerindexpr,
-											  glob_cxt, &inner_cxt))
-					return false;
 				if (!hdfs_foreign_expr_walker((Node *) sbref->refexpr,
 											  glob_cxt, &inner_cxt))
 					return false;
@@ -335,18 +663,20 @@ hdfs_foreign_expr_walker(Node *node,
 			{
 				FuncExpr   *fe = (FuncExpr *) node;
 
-				/* Should not be in the join clauses of the Join-pushdown */
-				if (glob_cxt->is_remote_cond)
-					return false;
-
 				/*
 				 * If function used by the expression is not built-in, it
 				 * can't be sent to remote because it might have incompatible
-				 * semantics on remote side.
+				 * semantics on remote side.  Neither can a built-in one which
+				 * has no counterpart of the same semantics in the dialect of
+				 * the server.
 				 */
 				if (!hdfs_is_builtin(fe->funcid))
 					return false;
 
+				if (hdfs_get_function_template(fe,
+											   hdfs_get_client_type(glob_cxt->foreignrel)) == NULL)
+					return false;
+
 				/*
 				 * Recurse to input subexpressions.
 				 */
@@ -359,25 +689,7 @@ hdfs_foreign_expr_walker(Node *node,
 		case T_DistinctExpr:	/* struct-equivalent to OpExpr */
 			{
 				OpExpr	   *oe = (OpExpr *) node;
-				const char *operatorName = get_opname(oe->opno);
-
-				/*
-				 * Join-pushdown allows only a few operators to be pushed
-				 * down.
-				 */
-				if (glob_cxt->is_remote_cond &&
-					(!(strcmp(operatorName, "<") == 0 ||
-					   strcmp(operatorName, ">") == 0 ||
-					   strcmp(operatorName, "<=") == 0 ||
-					   strcmp(operatorName, ">=") == 0 ||
-					   strcmp(operatorName, "<>") == 0 ||
-					   strcmp(operatorName, "=") == 0 ||
-					   strcmp(operatorName, "+") == 0 ||
-					   strcmp(operatorName, "-") == 0 ||
-					   strcmp(operatorName, "*") == 0 ||
-					   strcmp(operatorName, "%") == 0 ||
-					   strcmp(operatorName, "/") == 0)))
-					return false;
+				const hdfsPatternOperator *patop;
 
 				/*
 				 * Similarly, only built-in operators can be sent to remote.
@@ -387,6 +699,30 @@ hdfs_foreign_expr_walker(Node *node,
 				if (!hdfs_is_builtin(oe->opno))
 					return false;
 
+				/*
+				 * Pattern-matching operators are translated to the dialect
+				 * of hive, which can't express every pattern.  The others
+				 * need a counterpart for the types of their operands.
+				 */
+				patop = hdfs_get_pattern_operator(oe->opno);
+				if (patop != NULL)
+				{
+					if (nodeTag(node) != T_OpExpr ||
+						!hdfs_is_pattern_op_pushable(oe, patop))
+						return false;
+				}
+				else if (hdfs_get_operator_template(oe->opno,
+													exprType(linitial(oe->args)),
+													list_length(oe->args) == 2 ?
+													exprType(lsecond(oe->args)) :
+													InvalidOid,
+													hdfs_get_rel_dialect(glob_cxt->foreignrel)) == NULL)
+					return false;
+
+				/* Intervals have no remote form other than literals */
+				if (!hdfs_are_interval_args_literals(oe->args))
+					return false;
+
 				/*
 				 * Recurse to input subexpressions.
 				 */
@@ -398,10 +734,8 @@ hdfs_foreign_expr_walker(Node *node,
 		case T_ScalarArrayOpExpr:
 			{
 				ScalarArrayOpExpr *oe = (ScalarArrayOpExpr *) node;
-
-				/* Should not be in the join clauses of the Join-pushdown */
-				if (glob_cxt->is_remote_cond)
-					return false;
+				Node	   *array = (Node *) lsecond(oe->args);
+				char	   *opname;
 
 				/*
 				 * Again, only built-in operators can be sent to remote.
@@ -410,11 +744,40 @@ hdfs_foreign_expr_walker(Node *node,
 					return false;
 
 				/*
-				 * Recurse to input subexpressions.
+				 * Only "= ANY" and "<> ALL" have a counterpart, as IN and
+				 * NOT IN lists of constants or expressions.
 				 */
-				if (!hdfs_foreign_expr_walker((Node *) oe->args,
+				opname = get_opname(oe->opno);
+				if (!((strcmp(opname, "=") == 0 && oe->useOr) ||
+					  (strcmp(opname, "<>") == 0 && !oe->useOr)))
+					return false;
+
+				if (!IsA(array, Const) && !IsA(array, ArrayExpr))
+					return false;
+
+				if (hdfs_get_operator_template(oe->opno,
+											   exprType(linitial(oe->args)),
+											   get_element_type(exprType(array)),
+											   hdfs_get_rel_dialect(glob_cxt->foreignrel)) == NULL)
+					return false;
+
+				/*
+				 * Recurse to input subexpressions, the elements of an
+				 * ArrayExpr standing for themselves.
+				 */
+				if (!hdfs_foreign_expr_walker((Node *) linitial(oe->args),
 											  glob_cxt, &inner_cxt))
 					return false;
+				if (IsA(array, ArrayExpr))
+				{
+					if (((ArrayExpr *) array)->multidims ||
+						!hdfs_foreign_expr_walker((Node *) ((ArrayExpr *) array)->elements,
+												  glob_cxt, &inner_cxt))
+						return false;
+				}
+				else if (!hdfs_foreign_expr_walker(array, glob_cxt,
+												   &inner_cxt))
+					return false;
 			}
 			break;
 		case T_RelabelType:
@@ -453,18 +816,123 @@ hdfs_foreign_expr_walker(Node *node,
 					return false;
 			}
 			break;
-		case T_ArrayExpr:
+		case T_BooleanTest:
+			{
+				BooleanTest *bt = (BooleanTest *) node;
+
+				/*
+				 * Recurse to input subexpressions.
+				 */
+				if (!hdfs_foreign_expr_walker((Node *) bt->arg,
+											  glob_cxt, &inner_cxt))
+					return false;
+			}
+			break;
+		case T_CaseExpr:
+			{
+				CaseExpr   *ce = (CaseExpr *) node;
+				ListCell   *lc;
+
+				if (!hdfs_foreign_expr_walker((Node *) ce->arg,
+											  glob_cxt, &inner_cxt))
+					return false;
+
+				foreach(lc, ce->args)
+				{
+					CaseWhen   *cw = lfirst_node(CaseWhen, lc);
+
+					/*
+					 * In the "CASE arg WHEN value" form, the WHEN clause is an
+					 * equality between a placeholder for arg and the value.
+					 * Only the value is deparsed, so make sure that it is
+					 * shaped so.
+					 */
+					if (ce->arg != NULL)
+					{
+						OpExpr	   *op = (OpExpr *) cw->expr;
+
+						if (!IsA(op, OpExpr) ||
+							list_length(op->args) != 2 ||
+							!IsA(strip_implicit_coercions(linitial(op->args)),
+								 CaseTestExpr))
+							return false;
+					}
+
+					if (!hdfs_foreign_expr_walker((Node *) cw->expr,
+												  glob_cxt, &inner_cxt))
+						return false;
+					if (!hdfs_foreign_expr_walker((Node *) cw->result,
+												  glob_cxt, &inner_cxt))
+						return false;
+				}
+
+				if (!hdfs_foreign_expr_walker((Node *) ce->defresult,
+											  glob_cxt, &inner_cxt))
+					return false;
+			}
+			break;
+		case T_CaseTestExpr:
+			/* Only reached from the WHEN clauses checked above */
+			break;
+		case T_CoalesceExpr:
+			{
+				CoalesceExpr *c = (CoalesceExpr *) node;
+
+				/*
+				 * Recurse to input subexpressions.
+				 */
+				if (!hdfs_foreign_expr_walker((Node *) c->args,
+											  glob_cxt, &inner_cxt))
+					return false;
+			}
+			break;
+		case T_NullIfExpr:
+			{
+				NullIfExpr *ni = (NullIfExpr *) node;
+
+				/*
+				 * It is deparsed as a CASE comparing its arguments, so its
+				 * operator must be a built-in equality.
+				 */
+				if (!hdfs_is_builtin(ni->opno) ||
+					strcmp(get_opname(ni->opno), "=") != 0)
+					return false;
+
+				/*
+				 * Recurse to input subexpressions.
+				 */
+				if (!hdfs_foreign_expr_walker((Node *) ni->args,
+											  glob_cxt, &inner_cxt))
+					return false;
+			}
+			break;
+		case T_MinMaxExpr:
+			{
+				MinMaxExpr *mm = (MinMaxExpr *) node;
+
+				/*
+				 * Recurse to input subexpressions.
+				 */
+				if (!hdfs_foreign_expr_walker((Node *) mm->args,
+											  glob_cxt, &inner_cxt))
+					return false;
+			}
+			break;
+		case T_CoerceViaIO:
 			{
-				ArrayExpr  *a = (ArrayExpr *) node;
+				CoerceViaIO *cio = (CoerceViaIO *) node;
 
-				/* Should not be in the join clauses of the Join-pushdown */
-				if (glob_cxt->is_remote_cond)
+				/*
+				 * Only the casts between a string and a type whose text form
+				 * is the same on both sides can be sent.
+				 */
+				if (hdfs_get_coerce_type_name(cio) == NULL)
 					return false;
 
 				/*
 				 * Recurse to input subexpressions.
 				 */
-				if (!hdfs_foreign_expr_walker((Node *) a->elements,
+				if (!hdfs_foreign_expr_walker((Node *) cio->arg,
 											  glob_cxt, &inner_cxt))
 					return false;
 			}
@@ -492,22 +960,18 @@ hdfs_foreign_expr_walker(Node *node,
 			{
 				Aggref	   *agg = (Aggref *) node;
 				ListCell   *lc;
-				const char *func_name;
+				const hdfsAggMapping *mapping;
 
 				/* Not safe to pushdown when not in grouping context */
 				if (!IS_UPPER_REL(glob_cxt->foreignrel))
 					return false;
 
-				/* Only non-split aggregates are pushable. */
-				if (agg->aggsplit != AGGSPLIT_SIMPLE)
-					return false;
-
-				/* Aggregates with order are not supported on hive/spark. */
-				if (agg->aggorder)
-					return false;
-
-				/* FILTER clause is not supported on hive/spark. */
-				if (agg->aggfilter)
+				/*
+				 * Only non-split aggregates, or the partial ones of
+				 * partitionwise aggregation, are pushable.
+				 */
+				if (agg->aggsplit != AGGSPLIT_SIMPLE &&
+					agg->aggsplit != AGGSPLIT_INITIAL_SERIAL)
 					return false;
 
 				/* VARIADIC not supported on hive/spark. */
@@ -518,12 +982,11 @@ hdfs_foreign_expr_walker(Node *node,
 				if (!hdfs_is_builtin(agg->aggfnoid))
 					return false;
 
-				func_name = get_func_name(agg->aggfnoid);
-				if (!(strcmp(func_name, "min") == 0 ||
-					  strcmp(func_name, "max") == 0 ||
-					  strcmp(func_name, "sum") == 0 ||
-					  strcmp(func_name, "avg") == 0 ||
-					  strcmp(func_name, "count") == 0))
+				/* And hive/spark must have a way to compute it. */
+				mapping = hdfs_get_agg_mapping(agg->aggfnoid,
+											   list_length(agg->args));
+				if (mapping == NULL ||
+					!hdfs_is_agg_pushable(agg, mapping, glob_cxt))
 					return false;
 
 				/*
@@ -546,6 +1009,61 @@ hdfs_foreign_expr_walker(Node *node,
 					if (!hdfs_foreign_expr_walker(n, glob_cxt, &inner_cxt))
 						return false;
 				}
+
+				/*
+				 * FILTER is deparsed as a CASE on the aggregated arguments,
+				 * so it must be shippable too.
+				 */
+				if (agg->aggfilter &&
+					!hdfs_foreign_expr_walker((Node *) agg->aggfilter,
+											  glob_cxt, &inner_cxt))
+					return false;
+			}
+			break;
+		case T_WindowFunc:
+			{
+				WindowFunc *wf = (WindowFunc *) node;
+
+				/* As usual, it must be shippable. */
+				if (!hdfs_is_builtin(wf->winfnoid))
+					return false;
+
+				/* Not before hive 0.11 and spark 1.4 */
+				if (!hdfs_get_rel_dialect(glob_cxt->foreignrel)->window_functions)
+					return false;
+
+				/*
+				 * Checks the function, and its window clause whose
+				 * expressions are walked too.
+				 */
+				if (!hdfs_is_window_func_pushable(wf, glob_cxt))
+					return false;
+
+				if (!hdfs_foreign_expr_walker((Node *) wf->args,
+											  glob_cxt, &inner_cxt))
+					return false;
+			}
+			break;
+		case T_GroupingFunc:
+			{
+				GroupingFunc *gf = (GroupingFunc *) node;
+
+				/* Only meaningful in grouping context */
+				if (!IS_UPPER_REL(glob_cxt->foreignrel) ||
+					gf->agglevelsup != 0)
+					return false;
+
+				/* Not before hive 2.3 and spark 2.0 */
+				if (!hdfs_get_rel_dialect(glob_cxt->foreignrel)->grouping_function)
+					return false;
+
+				/* Hive only takes it along with grouping sets */
+				if (glob_cxt->root->parse->groupingSets == NIL)
+					return false;
+
+				if (!hdfs_foreign_expr_walker((Node *) gf->args,
+											  glob_cxt, &inner_cxt))
+					return false;
 			}
 			break;
 		default:
@@ -592,23 +1110,40 @@ hdfs_is_builtin(Oid oid)
 	return (oid < FirstGenbkiObjectId);
 }
 
+/*
+ * hdfs_deparse_explain
+ * 		Deparse the EXPLAIN statement whose output gives the number of rows
+ * 		of the remote table.
+ *
+ * conds are remote conditions without parameters on the partition columns of
+ * the table.  Hive then only counts the rows of the partitions they select,
+ * along with the partition_predicate option of the table.
+ */
 void
-hdfs_deparse_explain(hdfs_opt *opt, StringInfo buf)
+hdfs_deparse_explain(hdfs_opt *opt, StringInfo buf, PlannerInfo *root,
+					 RelOptInfo *baserel, List *conds)
 {
 	appendStringInfo(buf, "EXPLAIN SELECT * FROM ");
 	appendStringInfo(buf, "%s.%s", hdfs_quote_identifier(opt->dbname, '`'),
 					 hdfs_quote_identifier(opt->table_name, '`'));
 
-	/*
-	 * For accurate row counts we should append where clauses with the
-	 * statement, but if where clause is parameterized we should handle it the
-	 * way postgres fdw does.
-	 * TODO:
-	 * 		if (fpinfo->remote_conds)
-	 * 			hdfs_append_where_clause(opt, buf, root, baserel,
-	 * 									 fpinfo->remote_conds, true,
-	 * 									 &params_list);
-	 */
+	if (opt->partition_predicate)
+		appendStringInfo(buf, " WHERE (%s)", opt->partition_predicate);
+
+	if (conds != NIL)
+	{
+		deparse_expr_cxt context;
+
+		context.buf = buf;
+		context.root = root;
+		context.foreignrel = baserel;
+		context.scanrel = baserel;
+		context.params_list = NULL;
+		context.is_limit_node = false;
+
+		appendStringInfoString(buf, opt->partition_predicate ? " AND " : " WHERE ");
+		hdfs_append_conditions(conds, &context);
+	}
 }
 
 void
@@ -618,58 +1153,468 @@ hdfs_deparse_describe(StringInfo buf, Relation rel)
 	hdfs_deparse_relation(buf, rel);
 }
 
+/*
+ * hdfs_deparse_analyze
+ * 		Deparse ANALYZE statement for the remote table, or for the given
+ * 		partitions of it if partition isn't NULL, which may be a partial
+ * 		specification like "year=2024" of "year=2024/month=01".
+ */
 void
-hdfs_deparse_analyze(StringInfo buf, Relation rel)
+hdfs_deparse_analyze(StringInfo buf, Relation rel, const char *partition)
 {
 	appendStringInfo(buf, "ANALYZE TABLE ");
 	hdfs_deparse_relation(buf, rel);
+	if (partition)
+	{
+		appendStringInfoString(buf, " PARTITION (");
+		hdfs_deparse_partition_spec(buf, partition, false);
+		appendStringInfoChar(buf, ')');
+	}
 	appendStringInfo(buf, " COMPUTE STATISTICS");
 }
 
 /*
- * hdfs_deparse_select_stmt_for_rel
- * 		Deparse SELECT statement for given relation into buf.
- *
- * tlist contains the list of desired columns to be fetched from foreign
- * server.  For a base relation fpinfo->attrs_used is used to construct
- * SELECT clause, hence the tlist is ignored for a base relation.
- *
- * remote_conds is the list of conditions to be deparsed into the WHERE clause.
- *
- * pathkeys is the list of pathkeys to order the result by.
- *
- * If params_list is not NULL, it receives a list of Params and other-relation
- * Vars used in the clauses; these values must be transmitted to the remote
- * server as parameter values.
- *
- * is_subquery is the flag to indicate whether to deparse the specified
- * relation as a subquery.
- *
- * List of columns selected is returned in retrieved_attrs.
+ * hdfs_deparse_describe_partition
+ * 		Deparse DESCRIBE statement for the given partition of the remote
+ * 		table, as listed by SHOW PARTITIONS.
  */
 void
-hdfs_deparse_select_stmt_for_rel(StringInfo buf, PlannerInfo *root,
-								 RelOptInfo *rel, List *tlist,
-								 List *remote_conds, bool is_subquery,
-								 List *pathkeys,
-								 bool has_final_sort, bool has_limit,
-								 List **retrieved_attrs,
-								 List **params_list)
+hdfs_deparse_describe_partition(StringInfo buf, Relation rel,
+								const char *partition)
 {
-	deparse_expr_cxt context;
-	List	   *quals;
-	HDFSFdwRelationInfo *fpinfo = (HDFSFdwRelationInfo *) rel->fdw_private;
+	appendStringInfo(buf, "DESCRIBE FORMATTED ");
+	hdfs_deparse_relation(buf, rel);
+	appendStringInfoString(buf, " PARTITION (");
+	hdfs_deparse_partition_spec(buf, partition, false);
+	appendStringInfoChar(buf, ')');
+}
 
-	/*
-	 * We handle relations for foreign tables and joins between those and
-	 * upper relations
-	 */
-	Assert(IS_JOIN_REL(rel) || IS_SIMPLE_REL(rel) || IS_UPPER_REL(rel));
+void
+hdfs_deparse_show_partitions(StringInfo buf, Relation rel)
+{
+	appendStringInfo(buf, "SHOW PARTITIONS ");
+	hdfs_deparse_relation(buf, rel);
+}
 
-	/* Fill portions of context common to base relation */
-	context.buf = buf;
-	context.root = root;
-	context.foreignrel = rel;
+void
+hdfs_deparse_show_tables(StringInfo buf, const char *dbname)
+{
+	appendStringInfo(buf, "SHOW TABLES IN %s",
+					 hdfs_quote_identifier(dbname, '`'));
+}
+
+/*
+ * hdfs_deparse_describe_table
+ * 		Deparse DESCRIBE statement for the given remote table, which needn't
+ * 		have a foreign table yet.
+ */
+void
+hdfs_deparse_describe_table(StringInfo buf, const char *dbname,
+							const char *table_name, bool formatted)
+{
+	appendStringInfo(buf, "DESCRIBE %s%s.%s", formatted ? "FORMATTED " : "",
+					 hdfs_quote_identifier(dbname, '`'),
+					 hdfs_quote_identifier(table_name, '`'));
+}
+
+/*
+ * hdfs_deparse_snapshot_select
+ * 		Deparse SELECT statement fetching all the columns of the remote table
+ * 		into a local snapshot, restricted to the given partition unless it's
+ * 		NULL.
+ *
+ * The columns are listed in the order of the attributes of the foreign
+ * table, skipping the dropped ones.
+ */
+void
+hdfs_deparse_snapshot_select(StringInfo buf, Relation rel,
+							 const char *partition)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	bool		first = true;
+	int			i;
+
+	appendStringInfoString(buf, "SELECT ");
+
+	for (i = 1; i <= tupdesc->natts; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, i - 1);
+
+		/* Ignore dropped attributes. */
+		if (attr->attisdropped)
+			continue;
+
+		if (!first)
+			appendStringInfoString(buf, ", ");
+		first = false;
+
+		appendStringInfoString(buf,
+							   hdfs_quote_identifier(hdfs_get_column_name(RelationGetRelid(rel), i),
+													 '`'));
+	}
+
+	/* Don't generate bad syntax if no undropped columns */
+	if (first)
+		appendStringInfoString(buf, "NULL");
+
+	appendStringInfoString(buf, " FROM ");
+	hdfs_deparse_relation(buf, rel);
+
+	if (partition)
+	{
+		appendStringInfoString(buf, " WHERE ");
+		hdfs_deparse_partition_spec(buf, partition, true);
+	}
+}
+
+/*
+ * hdfs_deparse_drop_table
+ * 		Deparse DROP TABLE statement for the remote table of the given
+ * 		foreign table.
+ */
+void
+hdfs_deparse_drop_table(StringInfo buf, Relation rel)
+{
+	appendStringInfoString(buf, "DROP TABLE IF EXISTS ");
+	hdfs_deparse_relation(buf, rel);
+}
+
+/*
+ * hdfs_deparse_create_table
+ * 		Deparse CREATE TABLE statement for a remote table having the columns
+ * 		of the given foreign table, to be filled by hdfs_fdw_stage().
+ */
+void
+hdfs_deparse_create_table(StringInfo buf, Relation rel)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	bool		first = true;
+	int			i;
+
+	appendStringInfoString(buf, "CREATE TABLE ");
+	hdfs_deparse_relation(buf, rel);
+	appendStringInfoString(buf, " (");
+
+	for (i = 1; i <= tupdesc->natts; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, i - 1);
+
+		/* Ignore dropped attributes. */
+		if (attr->attisdropped)
+			continue;
+
+		if (!first)
+			appendStringInfoString(buf, ", ");
+		first = false;
+
+		appendStringInfo(buf, "%s %s",
+						 hdfs_quote_identifier(hdfs_get_column_name(RelationGetRelid(rel), i),
+											   '`'),
+						 hdfs_get_column_type_name(attr));
+	}
+
+	appendStringInfoChar(buf, ')');
+}
+
+/*
+ * hdfs_get_column_type_name
+ * 		Hive type of the remote column created for the given attribute.
+ *
+ * Only the types whose values hdfs_deparse_literal() writes as literals of
+ * the same hive type are accepted.  Hive's DECIMAL defaults to no fractional
+ * digits, so a numeric column must have its precision given.
+ */
+static const char *
+hdfs_get_column_type_name(Form_pg_attribute attr)
+{
+	int32		typmod = attr->atttypmod;
+
+	switch (attr->atttypid)
+	{
+		case INT2OID:
+			return "SMALLINT";
+		case INT4OID:
+			return "INT";
+		case INT8OID:
+			return "BIGINT";
+		case FLOAT4OID:
+			return "FLOAT";
+		case FLOAT8OID:
+			return "DOUBLE";
+		case NUMERICOID:
+			if (typmod >= (int32) VARHDRSZ &&
+				(((typmod - VARHDRSZ) >> 16) & 0xffff) <= 38)
+				return psprintf("DECIMAL(%d,%d)",
+								((typmod - VARHDRSZ) >> 16) & 0xffff,
+								(typmod - VARHDRSZ) & 0xffff);
+			ereport(ERROR,
+					(errcode(ERRCODE_FDW_INVALID_DATA_TYPE),
+					 errmsg("numeric column \"%s\" must have a precision of at most 38",
+							NameStr(attr->attname))));
+			break;
+		case BOOLOID:
+			return "BOOLEAN";
+		case DATEOID:
+			return "DATE";
+		case TIMESTAMPOID:
+			return "TIMESTAMP";
+		case TEXTOID:
+			return "STRING";
+		case VARCHAROID:
+			if (typmod >= (int32) VARHDRSZ && typmod - VARHDRSZ <= 65535)
+				return psprintf("VARCHAR(%d)", typmod - VARHDRSZ);
+			return "STRING";
+		case BPCHAROID:
+			if (typmod >= (int32) VARHDRSZ && typmod - VARHDRSZ <= 255)
+				return psprintf("CHAR(%d)", typmod - VARHDRSZ);
+			return "STRING";
+		default:
+			ereport(ERROR,
+					(errcode(ERRCODE_FDW_INVALID_DATA_TYPE),
+					 errmsg("column \"%s\" of type %s can't be staged to the remote server",
+							NameStr(attr->attname),
+							format_type_be(attr->atttypid))));
+	}
+
+	/* Keep compiler happy */
+	return NULL;
+}
+
+/*
+ * hdfs_deparse_insert
+ * 		Deparse the beginning of INSERT statement for the remote table of the
+ * 		given foreign table, to be followed by rows deparsed by
+ * 		hdfs_deparse_values_row().
+ */
+void
+hdfs_deparse_insert(StringInfo buf, Relation rel)
+{
+	appendStringInfoString(buf, "INSERT INTO TABLE ");
+	hdfs_deparse_relation(buf, rel);
+	appendStringInfoString(buf, " VALUES ");
+}
+
+/*
+ * hdfs_deparse_values_row
+ * 		Deparse a row of the given foreign table as an element of a VALUES
+ * 		list, the values being given for each attribute of the table.
+ */
+void
+hdfs_deparse_values_row(StringInfo buf, Relation rel, Datum *values,
+						bool *nulls)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	deparse_expr_cxt context;
+	bool		first = true;
+	int			i;
+
+	memset(&context, 0, sizeof(context));
+	context.buf = buf;
+
+	appendStringInfoChar(buf, '(');
+
+	for (i = 0; i < tupdesc->natts; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+
+		/* Ignore dropped attributes. */
+		if (attr->attisdropped)
+			continue;
+
+		if (!first)
+			appendStringInfoString(buf, ", ");
+		first = false;
+
+		if (nulls[i])
+			appendStringInfoString(buf, "NULL");
+		else if (hdfs_is_literal_pushable(attr->atttypid, values[i]))
+			hdfs_deparse_literal(attr->atttypid, attr->atttypmod, values[i],
+								 &context);
+		else
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_EXCEPTION),
+					 errmsg("value of column \"%s\" is out of the range of the remote type",
+							NameStr(attr->attname))));
+	}
+
+	appendStringInfoChar(buf, ')');
+}
+
+/*
+ * hdfs_deparse_column_ref
+ * 		Deparse the remote name of the given column of a foreign table, as
+ * 		used in the query of a scan of that table.
+ */
+void
+hdfs_deparse_column_ref(StringInfo buf, Oid relid, int attnum)
+{
+	appendStringInfoString(buf,
+						   hdfs_quote_identifier(hdfs_get_column_name(relid, attnum),
+												 '`'));
+}
+
+/*
+ * hdfs_deparse_literal_list
+ * 		Deparse non-NULL values of the given type as a comma-separated list of
+ * 		literals, and return the number of values deparsed.
+ *
+ * The values out of the range of the hive type are left out: no remote value
+ * can be equal to them.
+ */
+int
+hdfs_deparse_literal_list(StringInfo buf, Oid type, Datum *values,
+						  int nvalues)
+{
+	deparse_expr_cxt context;
+	int			ndeparsed = 0;
+	int			i;
+
+	memset(&context, 0, sizeof(context));
+	context.buf = buf;
+
+	for (i = 0; i < nvalues; i++)
+	{
+		if (!hdfs_is_literal_pushable(type, values[i]))
+			continue;
+
+		if (ndeparsed > 0)
+			appendStringInfoString(buf, ", ");
+		hdfs_deparse_literal(type, -1, values[i], &context);
+		ndeparsed++;
+	}
+
+	return ndeparsed;
+}
+
+/*
+ * hdfs_deparse_partition_spec
+ * 		Deparse a partition listed by SHOW PARTITIONS, e.g.
+ * 		"year=2024/month=01", as a partition specification for DESCRIBE, or
+ * 		as a WHERE condition selecting the rows of the partition.
+ *
+ * Hive escapes the special characters of the names and values in such a
+ * listing the way it does in the HDFS path names of the partitions.  Rows
+ * with a NULL partition value are kept in a partition whose value is
+ * __HIVE_DEFAULT_PARTITION__.
+ */
+void
+hdfs_deparse_partition_spec(StringInfo buf, const char *partition,
+							bool as_condition)
+{
+	const char *pos = partition;
+	bool		first = true;
+
+	while (*pos)
+	{
+		const char *end = strchr(pos, '/');
+		const char *eq;
+		char	   *name;
+		char	   *value;
+
+		if (end == NULL)
+			end = pos + strlen(pos);
+
+		eq = memchr(pos, '=', end - pos);
+		if (eq == NULL)
+			ereport(ERROR,
+					(errcode(ERRCODE_FDW_ERROR),
+					 errmsg("unexpected partition \"%s\" reported by the remote server",
+							partition)));
+
+		name = hdfs_unescape_path_name(pos, eq - pos);
+		value = hdfs_unescape_path_name(eq + 1, end - eq - 1);
+
+		if (!first)
+			appendStringInfoString(buf, as_condition ? " AND " : ", ");
+		first = false;
+
+		appendStringInfoString(buf, hdfs_quote_identifier(name, '`'));
+		if (as_condition && strcmp(value, "__HIVE_DEFAULT_PARTITION__") == 0)
+			appendStringInfoString(buf, " IS NULL");
+		else
+		{
+			appendStringInfoString(buf, as_condition ? " = " : "=");
+			hdfs_deparse_hive_string_literal(buf, value);
+		}
+
+		pos = (*end == '/') ? end + 1 : end;
+	}
+}
+
+/*
+ * hdfs_unescape_path_name
+ * 		Decode the %XX escapes of the first len bytes of str.
+ */
+char *
+hdfs_unescape_path_name(const char *str, int len)
+{
+	char	   *result = palloc(len + 1);
+	char	   *res = result;
+	int			i;
+
+	for (i = 0; i < len; i++)
+	{
+		if (str[i] == '%' && i + 2 < len &&
+			isxdigit((unsigned char) str[i + 1]) &&
+			isxdigit((unsigned char) str[i + 2]))
+		{
+			char		hex[3] = {str[i + 1], str[i + 2], '\0'};
+
+			*res++ = (char) strtol(hex, NULL, 16);
+			i += 2;
+		}
+		else
+			*res++ = str[i];
+	}
+	*res = '\0';
+
+	return result;
+}
+
+/*
+ * hdfs_deparse_select_stmt_for_rel
+ * 		Deparse SELECT statement for given relation into buf.
+ *
+ * tlist contains the list of desired columns to be fetched from foreign
+ * server.  For a base relation fpinfo->attrs_used is used to construct
+ * SELECT clause, hence the tlist is ignored for a base relation.
+ *
+ * remote_conds is the list of conditions to be deparsed into the WHERE clause.
+ *
+ * pathkeys is the list of pathkeys to order the result by.
+ *
+ * If params_list is not NULL, it receives a list of Params and other-relation
+ * Vars used in the clauses; these values must be transmitted to the remote
+ * server as parameter values.
+ *
+ * is_subquery is the flag to indicate whether to deparse the specified
+ * relation as a subquery.
+ *
+ * List of columns selected is returned in retrieved_attrs.
+ */
+void
+hdfs_deparse_select_stmt_for_rel(StringInfo buf, PlannerInfo *root,
+								 RelOptInfo *rel, List *tlist,
+								 List *remote_conds, bool is_subquery,
+								 List *pathkeys,
+								 bool has_final_sort, bool has_limit,
+								 List **retrieved_attrs,
+								 List **params_list)
+{
+	deparse_expr_cxt context;
+	List	   *quals;
+	HDFSFdwRelationInfo *fpinfo = (HDFSFdwRelationInfo *) rel->fdw_private;
+
+	/*
+	 * We handle relations for foreign tables and joins between those and
+	 * upper relations
+	 */
+	Assert(IS_JOIN_REL(rel) || IS_SIMPLE_REL(rel) || IS_UPPER_REL(rel));
+
+	/* Fill portions of context common to base relation */
+	context.buf = buf;
+	context.root = root;
+	context.foreignrel = rel;
 	context.params_list = params_list;
 	context.scanrel = IS_UPPER_REL(rel) ? fpinfo->outerrel : rel;
 	context.is_limit_node = false;
@@ -714,7 +1659,7 @@ hdfs_deparse_select_stmt_for_rel(StringInfo buf, PlannerInfo *root,
 
 	/* Add LIMIT clause if necessary */
 	if (has_limit)
-		hdfs_append_limit_clause(&context, fpinfo->client_type);
+		hdfs_append_limit_clause(&context, fpinfo->dialect);
 }
 
 /*
@@ -741,6 +1686,14 @@ hdfs_deparse_select_sql(List *tlist, bool is_subquery, List **retrieved_attrs,
 
 	appendStringInfoString(buf, "SELECT ");
 
+	/* The hints of the joins in the FROM clause come first */
+	hdfs_append_join_hints(context);
+
+	if (IS_UPPER_REL(foreignrel) &&
+		((HDFSFdwRelationInfo *) foreignrel->fdw_private)->stage ==
+		UPPERREL_DISTINCT)
+		appendStringInfoString(buf, "DISTINCT ");
+
 	if (is_subquery)
 	{
 		/*
@@ -780,11 +1733,146 @@ hdfs_deparse_select_sql(List *tlist, bool is_subquery, List **retrieved_attrs,
 }
 
 /*
- * hdfs_deparse_from_expr
- * 		Construct a FROM clause and, if needed, a WHERE clause, and
- * 		append those to "buf".
+ * hdfs_append_join_hints
+ * 		Append the hint asking the remote server to broadcast the small sides
+ * 		of the joins deparsed in the FROM clause, instead of shuffling both
+ * 		sides of each join.
  *
- * quals is the list of clauses to be included in the WHERE clause.
+ * Hive is given a MAPJOIN hint, and spark a BROADCAST hint, naming the
+ * aliases of the relations to broadcast.  Hive only follows the hint with
+ * hive.ignore.mapjoin.hint set to false.  The joins deparsed within
+ * subqueries get their own hints.
+ *
+ * Without use_remote_estimate, the sizes of the tables are mere defaults
+ * telling nothing, and the hints are only given when forced.
+ */
+static void
+hdfs_append_join_hints(deparse_expr_cxt *context)
+{
+	StringInfo	buf = context->buf;
+	RelOptInfo *scanrel = context->scanrel;
+	RelOptInfo *baserel;
+	HDFSFdwRelationInfo *fpinfo;
+	List	   *aliases;
+	ListCell   *lc;
+
+	if (!IS_JOIN_REL(scanrel))
+		return;
+
+	fpinfo = (HDFSFdwRelationInfo *) scanrel->fdw_private;
+	if (fpinfo->join_hints == HDFS_JOIN_HINTS_OFF)
+		return;
+
+	/* All the tables of the join are on the same server */
+	baserel = scanrel;
+	while (IS_JOIN_REL(baserel))
+		baserel = ((HDFSFdwRelationInfo *) baserel->fdw_private)->outerrel;
+
+	if (fpinfo->join_hints == HDFS_JOIN_HINTS_AUTO &&
+		!((HDFSFdwRelationInfo *) baserel->fdw_private)->options->use_remote_estimate)
+		return;
+
+	aliases = hdfs_get_join_hint_aliases(scanrel, fpinfo->join_hints, NIL);
+	if (aliases == NIL)
+		return;
+
+	appendStringInfoString(buf, fpinfo->client_type == SPARKSERVER ?
+						   "/*+ BROADCAST(" : "/*+ MAPJOIN(");
+	foreach(lc, aliases)
+	{
+		if (lc != list_head(aliases))
+			appendStringInfoString(buf, ", ");
+		appendStringInfoString(buf, (char *) lfirst(lc));
+	}
+	appendStringInfoString(buf, ") */ ");
+}
+
+/*
+ * hdfs_get_join_hint_aliases
+ * 		Add to the given list the aliases of the sides to broadcast of the
+ * 		given join, and of the joins deparsed along with it.
+ *
+ * Only the inner side of a left, semi or anti join can be broadcast, and the
+ * outer side of a right join.  Of an inner join, the smaller side is.  The
+ * side is broadcast when its estimated size is below
+ * hdfs_fdw.join_hint_threshold, or whatever its size with the join_hints
+ * option set to force.  A side which is a join deparsed without a subquery
+ * has no alias, and can't be hinted.
+ */
+static List *
+hdfs_get_join_hint_aliases(RelOptInfo *joinrel, HDFS_JOIN_HINTS join_hints,
+						   List *aliases)
+{
+	HDFSFdwRelationInfo *fpinfo = (HDFSFdwRelationInfo *) joinrel->fdw_private;
+	RelOptInfo *outerrel = fpinfo->outerrel;
+	RelOptInfo *innerrel = fpinfo->innerrel;
+	double		outer_size = outerrel->rows * outerrel->reltarget->width;
+	double		inner_size = innerrel->rows * innerrel->reltarget->width;
+	RelOptInfo *side = NULL;
+	bool		side_is_subquery = false;
+	double		side_size = 0;
+
+	switch (fpinfo->jointype)
+	{
+		case JOIN_INNER:
+			if (inner_size <= outer_size)
+			{
+				side = innerrel;
+				side_is_subquery = fpinfo->make_innerrel_subquery;
+				side_size = inner_size;
+			}
+			else
+			{
+				side = outerrel;
+				side_is_subquery = fpinfo->make_outerrel_subquery;
+				side_size = outer_size;
+			}
+			break;
+		case JOIN_LEFT:
+		case JOIN_SEMI:
+		case JOIN_ANTI:
+			side = innerrel;
+			side_is_subquery = fpinfo->make_innerrel_subquery;
+			side_size = inner_size;
+			break;
+		case JOIN_RIGHT:
+			side = outerrel;
+			side_is_subquery = fpinfo->make_outerrel_subquery;
+			side_size = outer_size;
+			break;
+		default:
+			break;
+	}
+
+	if (side != NULL &&
+		(join_hints == HDFS_JOIN_HINTS_FORCE ||
+		 (hdfs_join_hint_threshold > 0 &&
+		  side_size < hdfs_join_hint_threshold * 1024.0)))
+	{
+		if (side_is_subquery)
+			aliases = lappend(aliases,
+							  psprintf("%s%d", SUBQUERY_REL_ALIAS_PREFIX,
+									   ((HDFSFdwRelationInfo *) side->fdw_private)->relation_index));
+		else if (IS_SIMPLE_REL(side))
+			aliases = lappend(aliases, psprintf("%s%d", REL_ALIAS_PREFIX,
+												side->relid));
+	}
+
+	/* The joins nested without a subquery are in the same FROM clause */
+	if (IS_JOIN_REL(outerrel) && !fpinfo->make_outerrel_subquery)
+		aliases = hdfs_get_join_hint_aliases(outerrel, join_hints, aliases);
+	if (IS_JOIN_REL(innerrel) && !fpinfo->make_innerrel_subquery)
+		aliases = hdfs_get_join_hint_aliases(innerrel, join_hints, aliases);
+
+	return aliases;
+}
+
+/*
+ * hdfs_deparse_from_expr
+ * 		Construct a FROM clause and, if needed, a WHERE clause, and
+ * 		append those to "buf".
+ *
+ * quals is the list of clauses to be included in the WHERE clause.
  */
 static void
 hdfs_deparse_from_expr(List *quals, deparse_expr_cxt *context, bool use_alias)
@@ -1028,9 +2116,7 @@ hdfs_deparse_column_ref(StringInfo buf, int varno, int varattno,
 						PlannerInfo *root, bool qualify_col)
 {
 	RangeTblEntry *rte;
-	char	   *colname = NULL;
-	List	   *options;
-	ListCell   *lc;
+	char	   *colname;
 
 	/* varno must not be any of OUTER_VAR, INNER_VAR and INDEX_VAR. */
 	Assert(!IS_SPECIAL_VARNO(varno));
@@ -1038,33 +2124,37 @@ hdfs_deparse_column_ref(StringInfo buf, int varno, int varattno,
 	/* Get RangeTblEntry from array in PlannerInfo. */
 	rte = planner_rt_fetch(varno, root);
 
-	/*
-	 * If it's a column of a foreign table, and it has the column_name FDW
-	 * option, use that value.
-	 */
-	options = GetForeignColumnOptions(rte->relid, varattno);
+	colname = hdfs_get_column_name(rte->relid, varattno);
+
+	if (qualify_col)
+		ADD_REL_QUALIFIER(buf, varno);
+
+	appendStringInfoString(buf, hdfs_quote_identifier(colname, '`'));
+}
+
+/*
+ * hdfs_get_column_name
+ * 		Get the remote name of the given column.
+ *
+ * If it's a column of a foreign table, and it has the column_name FDW option,
+ * use that value.  Otherwise use the attribute name.
+ */
+char *
+hdfs_get_column_name(Oid relid, int attnum)
+{
+	List	   *options;
+	ListCell   *lc;
+
+	options = GetForeignColumnOptions(relid, attnum);
 	foreach(lc, options)
 	{
 		DefElem    *def = (DefElem *) lfirst(lc);
 
 		if (strcmp(def->defname, "column_name") == 0)
-		{
-			colname = defGetString(def);
-			break;
-		}
+			return defGetString(def);
 	}
 
-	/*
-	 * If it's a column of a regular table or it doesn't have column_name FDW
-	 * option, use attribute name.
-	 */
-	if (colname == NULL)
-		colname = get_attname(rte->relid, varattno, false);
-
-	if (qualify_col)
-		ADD_REL_QUALIFIER(buf, varno);
-
-	appendStringInfoString(buf, hdfs_quote_identifier(colname, '`'));
+	return get_attname(relid, attnum, false);
 }
 
 /*
@@ -1104,7 +2194,8 @@ hdfs_deparse_from_expr_for_rel(StringInfo buf, PlannerInfo *root,
 		 * ((outer relation) <join type> (inner relation) ON (joinclauses)
 		 */
 		appendStringInfo(buf, "(%s %s JOIN %s ON ", join_sql_o.data,
-						 hdfs_get_jointype_name(fpinfo->jointype),
+						 hdfs_get_remote_jointype_name(fpinfo->jointype,
+													   fpinfo->client_type),
 						 join_sql_i.data);
 
 		/* Append join clause; (TRUE) if no join clause */
@@ -1138,15 +2229,28 @@ hdfs_deparse_from_expr_for_rel(StringInfo buf, PlannerInfo *root,
 		 * can use NoLock here.
 		 */
 		Relation	rel = table_open(rte->relid, NoLock);
+		char	   *predicate = fpinfo->options->partition_predicate;
 
-		hdfs_deparse_relation(buf, rel);
+		/*
+		 * A foreign table standing for a partition of the remote table reads
+		 * the rows of the partition only.  Hive requires an alias for such a
+		 * subquery, and column references needn't be qualified with it.
+		 */
+		if (predicate)
+		{
+			appendStringInfoString(buf, "(SELECT * FROM ");
+			hdfs_deparse_relation(buf, rel);
+			appendStringInfo(buf, " WHERE %s)", predicate);
+		}
+		else
+			hdfs_deparse_relation(buf, rel);
 
 		/*
 		 * Add a unique alias to avoid any conflict in relation names due to
 		 * pulled up subqueries in the query being built for a pushed down
 		 * join.
 		 */
-		if (use_alias)
+		if (use_alias || predicate)
 			appendStringInfo(buf, " %s%d", REL_ALIAS_PREFIX,
 							 foreignrel->relid);
 
@@ -1216,6 +2320,12 @@ hdfs_get_jointype_name(JoinType jointype)
 		case JOIN_FULL:
 			return "FULL";
 
+		case JOIN_SEMI:
+			return "SEMI";
+
+		case JOIN_ANTI:
+			return "ANTI";
+
 		default:
 			/* Shouldn't come here, but protect from buggy code. */
 			elog(ERROR, "unsupported join type %d", jointype);
@@ -1225,6 +2335,31 @@ hdfs_get_jointype_name(JoinType jointype)
 	return NULL;
 }
 
+/*
+ * hdfs_get_remote_jointype_name
+ * 		Output the remote join name for given join type.
+ *
+ * A semi join is sent as a LEFT SEMI JOIN.  An anti join is sent as a LEFT
+ * ANTI JOIN to Spark, and as a LEFT JOIN to Hive, for which
+ * hdfs_foreign_join_ok() has added a condition keeping only the
+ * null-extended rows.
+ */
+static const char *
+hdfs_get_remote_jointype_name(JoinType jointype, CLIENT_TYPE client_type)
+{
+	switch (jointype)
+	{
+		case JOIN_SEMI:
+			return "LEFT SEMI";
+
+		case JOIN_ANTI:
+			return client_type == SPARKSERVER ? "LEFT ANTI" : "LEFT";
+
+		default:
+			return hdfs_get_jointype_name(jointype);
+	}
+}
+
 /*
  * hdfs_deparse_relation
  *			Append remote name of specified foreign table to buf.
@@ -1266,30 +2401,22 @@ hdfs_deparse_relation(StringInfo buf, Relation rel)
 }
 
 /*
- * Append a SQL string literal representing "val" to buf.
+ * Append a Hive string literal representing "val" to buf.  Hive escapes
+ * quotes and backslashes with a backslash.
  */
 static void
-hdfs_deparse_string_literal(StringInfo buf, const char *val)
+hdfs_deparse_hive_string_literal(StringInfo buf, const char *val)
 {
 	const char *valptr;
 
-	/*
-	 * Rather than making assumptions about the remote server's value of
-	 * standard_conforming_strings, always use E'foo' syntax if there are any
-	 * backslashes.  This will fail on remote servers before 8.1, but those
-	 * are long out of support.
-	 */
-	if (strchr(val, '\\') != NULL)
-		appendStringInfoChar(buf, ESCAPE_STRING_SYNTAX);
-
 	appendStringInfoChar(buf, '\'');
 
 	for (valptr = val; *valptr; valptr++)
 	{
 		char		ch = *valptr;
 
-		if (SQL_STR_DOUBLE(ch, true))
-			appendStringInfoChar(buf, ch);
+		if (ch == '\'' || ch == '\\')
+			appendStringInfoChar(buf, '\\');
 
 		appendStringInfoChar(buf, ch);
 	}
@@ -1313,6 +2440,25 @@ hdfs_deparse_expr(Expr *node, deparse_expr_cxt *context)
 	if (node == NULL)
 		return;
 
+	/*
+	 * An expression not depending on the rows, but not immutable, is only
+	 * found in the partition conditions hdfs_plan_partition_conds() sends
+	 * with a parameter, which is evaluated when the scan starts.
+	 */
+	if (!IsA(node, Var) && !IsA(node, Const) && !IsA(node, Param) &&
+		!contain_var_clause((Node *) node) &&
+		contain_mutable_functions((Node *) node))
+	{
+		if (context->params_list)
+		{
+			*context->params_list = lappend(*context->params_list, node);
+			hdfs_print_remote_param(exprType((Node *) node), context);
+		}
+		else
+			hdfs_print_remote_placeholder(exprType((Node *) node), context);
+		return;
+	}
+
 	switch (nodeTag(node))
 	{
 		case T_Var:
@@ -1349,12 +2495,33 @@ hdfs_deparse_expr(Expr *node, deparse_expr_cxt *context)
 		case T_NullTest:
 			hdfs_deparse_null_test((NullTest *) node, context);
 			break;
-		case T_ArrayExpr:
-			hdfs_deparse_array_expr((ArrayExpr *) node, context);
+		case T_BooleanTest:
+			hdfs_deparse_boolean_test((BooleanTest *) node, context);
+			break;
+		case T_CaseExpr:
+			hdfs_deparse_case_expr((CaseExpr *) node, context);
+			break;
+		case T_CoalesceExpr:
+			hdfs_deparse_coalesce_expr((CoalesceExpr *) node, context);
+			break;
+		case T_NullIfExpr:
+			hdfs_deparse_nullif_expr((NullIfExpr *) node, context);
+			break;
+		case T_MinMaxExpr:
+			hdfs_deparse_min_max_expr((MinMaxExpr *) node, context);
+			break;
+		case T_CoerceViaIO:
+			hdfs_deparse_coerce_via_io((CoerceViaIO *) node, context);
 			break;
 		case T_Aggref:
 			hdfs_deparse_aggref((Aggref *) node, context);
 			break;
+		case T_GroupingFunc:
+			hdfs_deparse_grouping_func((GroupingFunc *) node, context);
+			break;
+		case T_WindowFunc:
+			hdfs_deparse_window_func((WindowFunc *) node, context);
+			break;
 		default:
 			ereport(ERROR,
 					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
@@ -1409,10 +2576,10 @@ hdfs_deparse_var(Var *node, deparse_expr_cxt *context)
 			int			pindex = list_length(*context->params_list) + 1;
 
 			*context->params_list = lappend(*context->params_list, node);
-			hdfs_print_remote_param(context);
+			hdfs_print_remote_param(node->vartype, context);
 		}
 		else
-			hdfs_print_remote_placeholder(context);
+			hdfs_print_remote_placeholder(node->vartype, context);
 	}
 }
 
@@ -1435,45 +2602,271 @@ hdfs_deparse_const(Const *node, deparse_expr_cxt *context)
 		return;
 	}
 
-	getTypeOutputInfo(node->consttype, &typoutput, &typIsVarlena);
-	extval = OidOutputFunctionCall(typoutput, node->constvalue);
+	/* LIMIT and OFFSET only take a bare number */
+	if (context->is_limit_node)
+	{
+		getTypeOutputInfo(node->consttype, &typoutput, &typIsVarlena);
+		extval = OidOutputFunctionCall(typoutput, node->constvalue);
+		appendStringInfoString(buf, extval);
+		return;
+	}
+
+	hdfs_deparse_literal(node->consttype, node->consttypmod,
+						 node->constvalue, context);
+}
+
+/*
+ * hdfs_deparse_literal
+ *		Deparse a non-NULL value as a literal of the matching hive type.
+ *
+ * Hive has to cast a value written as a string before comparing it with a
+ * column, which keeps it from pruning partitions on typed partition columns
+ * and from using vectorized comparisons, so the values are given as typed
+ * literals: integers with their S or L suffix, decimals with BD, and dates
+ * and timestamps with their keyword, always in the ISO format whatever the
+ * DateStyle.  Floats have no literal of their own in both dialects and are
+ * cast.  The types hive lacks are left as strings to its implicit casts.
+ */
+static void
+hdfs_deparse_literal(Oid type, int32 typmod, Datum value,
+					 deparse_expr_cxt *context)
+{
+	StringInfo	buf = context->buf;
+	Oid			typoutput;
+	bool		typIsVarlena;
+	char	   *extval;
 
-	switch (node->consttype)
+	switch (type)
 	{
-		case DATEOID:
-		case TIMEOID:
-		case TIMESTAMPOID:
-		case TIMESTAMPTZOID:
-		case INTERVALOID:
-		case TIMETZOID:
 		case INT2OID:
+			appendStringInfo(buf, "%dS", (int) DatumGetInt16(value));
+			break;
 		case INT4OID:
+			appendStringInfo(buf, "%d", DatumGetInt32(value));
+			break;
 		case INT8OID:
+			appendStringInfo(buf, INT64_FORMAT "L", DatumGetInt64(value));
+			break;
 		case OIDOID:
+			appendStringInfo(buf, "%uL", DatumGetObjectId(value));
+			break;
 		case FLOAT4OID:
 		case FLOAT8OID:
-		case NUMERICOID:
-			if (context->is_limit_node)
-				appendStringInfoString(buf, extval);
+			getTypeOutputInfo(type, &typoutput, &typIsVarlena);
+			extval = OidOutputFunctionCall(typoutput, value);
+
+			/* NaN and the infinities are only known as strings */
+			if (strspn(extval, "0123456789+-.e") == strlen(extval))
+				appendStringInfo(buf, "CAST(%s AS %s)", extval,
+								 type == FLOAT4OID ? "FLOAT" : "DOUBLE");
 			else
-				appendStringInfo(buf, "'%s'", extval);
+				appendStringInfo(buf, "CAST('%s' AS %s)", extval,
+								 type == FLOAT4OID ? "FLOAT" : "DOUBLE");
+			break;
+		case NUMERICOID:
+			extval = DatumGetCString(DirectFunctionCall1(numeric_out, value));
+
+			if (typmod >= (int32) VARHDRSZ)
+			{
+				int			precision = ((typmod - VARHDRSZ) >> 16) & 0xffff;
+				int			scale = (typmod - VARHDRSZ) & 0xffff;
+
+				/* The literal is as precise as its digits, keep the typmod */
+				if (precision <= 38 && scale <= precision)
+				{
+					appendStringInfo(buf, "CAST(%sBD AS DECIMAL(%d,%d))",
+									 extval, precision, scale);
+					break;
+				}
+			}
+			appendStringInfo(buf, "%sBD", extval);
+			break;
+		case DATEOID:
+			{
+				int			year;
+				int			month;
+				int			day;
+
+				j2date(DatumGetDateADT(value) + POSTGRES_EPOCH_JDATE,
+					   &year, &month, &day);
+				appendStringInfo(buf, "DATE '%04d-%02d-%02d'",
+								 year, month, day);
+			}
+			break;
+		case TIMESTAMPOID:
+			{
+				struct pg_tm tm;
+				fsec_t		fsec;
+
+				if (timestamp2tm(DatumGetTimestamp(value), NULL, &tm, &fsec,
+								 NULL, NULL) != 0)
+					ereport(ERROR,
+							(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+							 errmsg("timestamp out of range")));
+
+				appendStringInfo(buf, "TIMESTAMP '%04d-%02d-%02d %02d:%02d:%02d",
+								 tm.tm_year, tm.tm_mon, tm.tm_mday,
+								 tm.tm_hour, tm.tm_min, tm.tm_sec);
+				if (fsec != 0)
+					appendStringInfo(buf, ".%06d", (int) fsec);
+				appendStringInfoChar(buf, '\'');
+			}
+			break;
+		case INTERVALOID:
+			{
+				Interval   *span = DatumGetIntervalP(value);
+				int64		days = Abs((int64) span->day);
+				int64		time = Abs(span->time);
+
+				/* Only day-time intervals are pushable, with a single sign */
+				days += time / USECS_PER_DAY;
+				time %= USECS_PER_DAY;
+				appendStringInfo(buf, "INTERVAL '%s" INT64_FORMAT " %02d:%02d:%02d",
+								 (span->day < 0 || span->time < 0) ? "-" : "",
+								 days,
+								 (int) (time / USECS_PER_HOUR),
+								 (int) (time / USECS_PER_MINUTE % MINS_PER_HOUR),
+								 (int) (time / USECS_PER_SEC % SECS_PER_MINUTE));
+				if (time % USECS_PER_SEC != 0)
+					appendStringInfo(buf, ".%06d", (int) (time % USECS_PER_SEC));
+				appendStringInfoString(buf, "' DAY TO SECOND");
+			}
 			break;
 		case BITOID:
 		case VARBITOID:
+			getTypeOutputInfo(type, &typoutput, &typIsVarlena);
+			extval = OidOutputFunctionCall(typoutput, value);
 			appendStringInfo(buf, "B'%s'", extval);
 			break;
 		case BOOLOID:
-			if (strcmp(extval, "t") == 0)
+			if (DatumGetBool(value))
 				appendStringInfoString(buf, "true");
 			else
 				appendStringInfoString(buf, "false");
 			break;
 		default:
-			hdfs_deparse_string_literal(buf, extval);
+			getTypeOutputInfo(type, &typoutput, &typIsVarlena);
+			extval = OidOutputFunctionCall(typoutput, value);
+			hdfs_deparse_hive_string_literal(buf, extval);
 			break;
 	}
 }
 
+/*
+ * hdfs_is_const_pushable
+ *		Check whether the value of a constant, or every element of a constant
+ *		array, can be written as a hive literal.
+ */
+static bool
+hdfs_is_const_pushable(Const *node)
+{
+	Oid			elemtype;
+	int16		elmlen;
+	bool		elmbyval;
+	char		elmalign;
+	Datum	   *elems;
+	bool	   *nulls;
+	int			nelems;
+	int			i;
+
+	if (node->constisnull)
+		return true;
+
+	elemtype = get_element_type(node->consttype);
+	if (!OidIsValid(elemtype))
+		return hdfs_is_literal_pushable(node->consttype, node->constvalue);
+
+	get_typlenbyvalalign(elemtype, &elmlen, &elmbyval, &elmalign);
+	deconstruct_array(DatumGetArrayTypeP(node->constvalue),
+					  elemtype, elmlen, elmbyval, elmalign,
+					  &elems, &nulls, &nelems);
+
+	/* An empty array would make an empty IN list */
+	if (nelems == 0)
+		return false;
+
+	for (i = 0; i < nelems; i++)
+	{
+		if (!nulls[i] && !hdfs_is_literal_pushable(elemtype, elems[i]))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * hdfs_is_literal_pushable
+ *		Check whether a value is in the range of the hive type it is deparsed
+ *		as by hdfs_deparse_literal.
+ *
+ * Hive's decimals have no NaN nor infinity and at most 38 digits, and its
+ * dates and timestamps span the years 1 to 9999.
+ */
+static bool
+hdfs_is_literal_pushable(Oid type, Datum value)
+{
+	switch (type)
+	{
+		case NUMERICOID:
+			{
+				char	   *extval;
+				const char *p;
+				int			digits = 0;
+
+				extval = DatumGetCString(DirectFunctionCall1(numeric_out,
+															 value));
+				for (p = extval; *p; p++)
+				{
+					if (isdigit((unsigned char) *p))
+						digits++;
+					else if (*p != '-' && *p != '.')
+						return false;
+				}
+
+				return digits <= 38;
+			}
+		case DATEOID:
+			{
+				DateADT		date = DatumGetDateADT(value);
+				int			year;
+				int			month;
+				int			day;
+
+				if (DATE_NOT_FINITE(date))
+					return false;
+
+				j2date(date + POSTGRES_EPOCH_JDATE, &year, &month, &day);
+				return year >= 1 && year <= 9999;
+			}
+		case TIMESTAMPOID:
+			{
+				Timestamp	ts = DatumGetTimestamp(value);
+				struct pg_tm tm;
+				fsec_t		fsec;
+
+				if (TIMESTAMP_NOT_FINITE(ts) ||
+					timestamp2tm(ts, NULL, &tm, &fsec, NULL, NULL) != 0)
+					return false;
+
+				return tm.tm_year >= 1 && tm.tm_year <= 9999;
+			}
+		case INTERVALOID:
+			{
+				Interval   *span = DatumGetIntervalP(value);
+
+				/*
+				 * A month has no fixed number of days, and a day-time
+				 * interval literal has a single sign.
+				 */
+				return span->month == 0 &&
+					!(span->day < 0 && span->time > 0) &&
+					!(span->day > 0 && span->time < 0);
+			}
+		default:
+			return true;
+	}
+}
+
 /*
  * Deparse given Param node.
  *
@@ -1490,10 +2883,10 @@ hdfs_deparse_param(Param *node, deparse_expr_cxt *context)
 		int			pindex = list_length(*context->params_list) + 1;
 
 		*context->params_list = lappend(*context->params_list, node);
-		hdfs_print_remote_param(context);
+		hdfs_print_remote_param(node->paramtype, context);
 	}
 	else
-		hdfs_print_remote_placeholder(context);
+		hdfs_print_remote_placeholder(node->paramtype, context);
 }
 
 /*
@@ -1504,8 +2897,7 @@ hdfs_deparse_subscripting_ref(SubscriptingRef *node,
 							  deparse_expr_cxt *context)
 {
 	StringInfo	buf = context->buf;
-	ListCell   *lowlist_item;
-	ListCell   *uplist_item;
+	Const	   *index = (Const *) linitial(node->refupperindexpr);
 
 	/* Always parenthesize the expression. */
 	appendStringInfoChar(buf, '(');
@@ -1525,22 +2917,20 @@ hdfs_deparse_subscripting_ref(SubscriptingRef *node,
 		appendStringInfoChar(buf, ')');
 	}
 
-	/* Deparse subscript expressions. */
-	lowlist_item = list_head(node->reflowerindexpr);	/* could be NULL */
-	foreach(uplist_item, node->refupperindexpr)
+	/*
+	 * Deparse the subscript, hive counting the elements of an array from
+	 * 0 where PostgreSQL does from 1.
+	 */
+	appendStringInfoChar(buf, '[');
+	if (IsA(index, Const) && !index->constisnull &&
+		index->consttype == INT4OID)
+		appendStringInfo(buf, "%d", DatumGetInt32(index->constvalue) - 1);
+	else
 	{
-		appendStringInfoChar(buf, '[');
-
-		if (lowlist_item)
-		{
-			hdfs_deparse_expr(lfirst(lowlist_item), context);
-			appendStringInfoChar(buf, ':');
-			lowlist_item = lnext(node->reflowerindexpr, lowlist_item);
-		}
-
-		hdfs_deparse_expr(lfirst(uplist_item), context);
-		appendStringInfoChar(buf, ']');
+		hdfs_deparse_expr((Expr *) index, context);
+		appendStringInfoString(buf, " - 1");
 	}
+	appendStringInfoChar(buf, ']');
 
 	appendStringInfoChar(buf, ')');
 }
@@ -1551,588 +2941,2087 @@ hdfs_deparse_subscripting_ref(SubscriptingRef *node,
 static void
 hdfs_deparse_func_expr(FuncExpr *node, deparse_expr_cxt *context)
 {
-	StringInfo	buf = context->buf;
-	HeapTuple	proctup;
-	Form_pg_proc procform;
-	const char *proname;
-	bool		first;
-	ListCell   *arg;
-
-	/* Normal function: display as proname(args) */
-	hdfs_append_function_name(node->funcid, context);
+	const char *remote_template;
 
-	appendStringInfoChar(buf, '(');
-
-	/* Deparse all the arguments */
-	first = true;
-	foreach(arg, node->args)
-	{
-		if (!first)
-			appendStringInfoString(buf, ", ");
-
-		hdfs_deparse_expr((Expr *) lfirst(arg), context);
-		first = false;
-	}
+	remote_template = hdfs_get_function_template(node,
+												 hdfs_get_client_type(context->foreignrel));
+	if (remote_template == NULL)
+		elog(ERROR, "function %u can not be deparsed", node->funcid);
 
-	appendStringInfoChar(buf, ')');
+	hdfs_deparse_template(remote_template, node->args, context);
 }
 
 /*
- * hdfs_append_function_name
- *		Deparses function name from given function oid.
+ * hdfs_deparse_template
+ *		Deparse a remote template, %n standing for the n-th of the given
+ *		arguments and %% for a percent sign.
  */
 static void
-hdfs_append_function_name(Oid funcid, deparse_expr_cxt *context)
+hdfs_deparse_template(const char *remote_template, List *args,
+					  deparse_expr_cxt *context)
 {
 	StringInfo	buf = context->buf;
-	HeapTuple	proctup;
-	Form_pg_proc procform;
-	const char *proname;
-
-	proctup = SearchSysCache1(PROCOID, ObjectIdGetDatum(funcid));
-	if (!HeapTupleIsValid(proctup))
-		elog(ERROR, "cache lookup failed for function %u", funcid);
-
-	procform = (Form_pg_proc) GETSTRUCT(proctup);
+	const char *p;
 
-	/* Deparse the function name ... */
-	proname = NameStr(procform->proname);
-	appendStringInfoString(buf, proname);
-
-	ReleaseSysCache(proctup);
-}
+	for (p = remote_template; *p; p++)
+	{
+		if (*p == '%' && isdigit((unsigned char) p[1]))
+		{
+			int			argno = p[1] - '0';
+
+			Assert(argno >= 1 && argno <= list_length(args));
+			hdfs_deparse_expr((Expr *) list_nth(args, argno - 1), context);
+			p++;
+		}
+		else if (*p == '%' && p[1] == '%')
+		{
+			appendStringInfoChar(buf, '%');
+			p++;
+		}
+		else
+			appendStringInfoChar(buf, *p);
+	}
+}
 
 /*
- * Deparse given operator expression. To avoid problems around
- * priority of operations, we always parenthesize the arguments.
+ * hdfs_get_function_template
+ *		Get the template of the remote expression computing the given
+ *		function call, NULL if it has none in the given dialect.
+ *
+ * Casts are written as CAST() on the remote side, other functions are
+ * looked up in hdfs_func_mappings.
  */
-static void
-hdfs_deparse_op_expr(OpExpr *node, deparse_expr_cxt *context)
+static const char *
+hdfs_get_function_template(FuncExpr *node, CLIENT_TYPE client_type)
 {
-	StringInfo	buf = context->buf;
-	HeapTuple	tuple;
-	Form_pg_operator form;
-	char		oprkind;
-	ListCell   *arg;
+	const hdfsFuncMapping *mapping;
+	char	   *func_name;
+	int			nargs = list_length(node->args);
+	Oid			argtype;
 
-	/* Retrieve information about the operator from system catalog. */
-	tuple = SearchSysCache1(OPEROID, ObjectIdGetDatum(node->opno));
-	if (!HeapTupleIsValid(tuple))
-		elog(ERROR, "cache lookup failed for operator %u", node->opno);
-	form = (Form_pg_operator) GETSTRUCT(tuple);
-	oprkind = form->oprkind;
+	if (node->funcformat == COERCE_IMPLICIT_CAST ||
+		node->funcformat == COERCE_EXPLICIT_CAST)
+		return hdfs_get_cast_template(node);
 
-	/* Sanity check. */
-	Assert((oprkind == 'r' && list_length(node->args) == 1) ||
-		   (oprkind == 'l' && list_length(node->args) == 1) ||
-		   (oprkind == 'b' && list_length(node->args) == 2));
+	/* Variadic calls would need their arguments to be deparsed as such */
+	if (node->funcvariadic || node->funcretset)
+		return NULL;
 
-	/* Always parenthesize the expression. */
-	appendStringInfoChar(buf, '(');
+	func_name = get_func_name(node->funcid);
+	argtype = nargs > 0 ? exprType(linitial(node->args)) : InvalidOid;
 
-	/* Deparse left operand. */
-	if (oprkind == 'r' || oprkind == 'b')
+	for (mapping = hdfs_func_mappings; mapping->pg_name; mapping++)
 	{
-		arg = list_head(node->args);
-		hdfs_deparse_expr(lfirst(arg), context);
-		appendStringInfoChar(buf, ' ');
-	}
+		if (mapping->nargs != nargs ||
+			strcmp(mapping->pg_name, func_name) != 0 ||
+			(OidIsValid(mapping->argtype) && mapping->argtype != argtype))
+			continue;
 
-	/* Deparse operator name. */
-	hdfs_deparse_operator_name(buf, form);
+		if (mapping->get_template)
+			return mapping->get_template(node, client_type);
 
-	/* Deparse right operand. */
-	if (oprkind == 'l' || oprkind == 'b')
-	{
-		arg = list_tail(node->args);
-		appendStringInfoChar(buf, ' ');
-		hdfs_deparse_expr(lfirst(arg), context);
+		return client_type == SPARKSERVER ? mapping->spark_template :
+			mapping->hive_template;
 	}
 
-	appendStringInfoChar(buf, ')');
-
-	ReleaseSysCache(tuple);
+	return NULL;
 }
 
 /*
- * Print the name of an operator.
+ * hdfs_get_cast_template
+ *		Get the template of a cast between types which hive/spark convert
+ *		the same way as PostgreSQL does.
+ *
+ * Hive truncates where PostgreSQL rounds a fractional value cast to an
+ * integer, and wraps around where PostgreSQL fails on an overflow, so only
+ * casts to wider types are accepted.
  */
-static void
-hdfs_deparse_operator_name(StringInfo buf, Form_pg_operator opform)
+static const char *
+hdfs_get_cast_template(FuncExpr *node)
 {
-	char	   *opname;
-
-	/* opname is not a SQL identifier, so we should not quote it. */
-	opname = NameStr(opform->oprname);
+	Oid			source;
+	const char *target = NULL;
 
-	/* Print schema name only if it's not pg_catalog */
-	if (opform->oprnamespace != PG_CATALOG_NAMESPACE)
-	{
-		const char *opnspname;
+	/* Length coercions have more arguments */
+	if (list_length(node->args) != 1)
+		return NULL;
 
-		opnspname = get_namespace_name(opform->oprnamespace);
+	source = exprType(linitial(node->args));
 
-		/* Print fully qualified operator name. */
-		appendStringInfo(buf, "OPERATOR(%s.%s)",
-						 quote_identifier(opnspname), opname);
-	}
-	else
+	switch (node->funcresulttype)
 	{
-		if (strcmp(opname, "~~") == 0)
-			appendStringInfoString(buf, "LIKE");
-		else if (strcmp(opname, "~~*") == 0)
-			appendStringInfoString(buf, "LIKE");
-		else if (strcmp(opname, "!~~") == 0)
-			appendStringInfoString(buf, "NOT LIKE");
-		else if (strcmp(opname, "!~~*") == 0)
-			appendStringInfoString(buf, "NOT LIKE");
-		else if (strcmp(opname, "~") == 0)
-		{
-			/* TODO: use hive operator */
-		}
-		else if (strcmp(opname, "~*") == 0)
-		{
-			/* TODO: use hive operator */
-		}
-		else if (strcmp(opname, "!~") == 0)
-		{
-			/* TODO: use hive operator */
-		}
-		else if (strcmp(opname, "!~*") == 0)
-		{
-			/* TODO: use hive operator */
-		}
-		else
-		{
-			/* Just print operator name. */
-			appendStringInfoString(buf, opname);
-		}
+		case INT4OID:
+			if (source == INT2OID || source == BOOLOID)
+				target = "INT";
+			break;
+		case INT8OID:
+			if (source == INT2OID || source == INT4OID)
+				target = "BIGINT";
+			break;
+		case FLOAT4OID:
+			if (source == INT2OID || source == INT4OID || source == INT8OID)
+				target = "FLOAT";
+			break;
+		case FLOAT8OID:
+			if (source == INT2OID || source == INT4OID || source == INT8OID ||
+				source == FLOAT4OID || source == NUMERICOID)
+				target = "DOUBLE";
+			break;
+		case NUMERICOID:
+			/* Hive's DECIMAL defaults to DECIMAL(10,0) */
+			if (source == INT2OID || source == INT4OID || source == INT8OID)
+				target = "DECIMAL(20,0)";
+			break;
+		case DATEOID:
+			if (source == TIMESTAMPOID)
+				target = "DATE";
+			break;
+		case TIMESTAMPOID:
+			if (source == DATEOID)
+				target = "TIMESTAMP";
+			break;
+		default:
+			break;
 	}
+
+	if (target == NULL)
+		return NULL;
+
+	return psprintf("CAST(%%1 AS %s)", target);
 }
 
 /*
- * Deparse IS DISTINCT FROM.
+ * hdfs_get_const_field
+ *		Get the value of a text constant naming a field, like the first
+ *		argument of date_part(), or NULL if it's not such a constant.
  */
-static void
-hdfs_deparse_distinct_expr(DistinctExpr *node, deparse_expr_cxt *context)
+static char *
+hdfs_get_const_field(Node *node)
 {
-	StringInfo	buf = context->buf;
+	Const	   *c = (Const *) node;
 
-	Assert(list_length(node->args) == 2);
+	if (!IsA(c, Const) || c->constisnull || c->consttype != TEXTOID)
+		return NULL;
 
-	appendStringInfoChar(buf, '(');
-	hdfs_deparse_expr(linitial(node->args), context);
-	appendStringInfoString(buf, " IS DISTINCT FROM ");
-	hdfs_deparse_expr(lsecond(node->args), context);
-	appendStringInfoChar(buf, ')');
+	return TextDatumGetCString(c->constvalue);
 }
 
-static void
-hdfs_deparse_string(StringInfo buf, const char *val, bool isstr)
+/*
+ * hdfs_substr_template
+ *		substr() counts positions below 1 as part of the string, where hive
+ *		starts from its end for negative ones, so only a constant positive
+ *		start is pushed.
+ */
+static const char *
+hdfs_substr_template(FuncExpr *node, CLIENT_TYPE client_type)
 {
-	const char *valptr;
-	int			i;
+	Const	   *start = (Const *) lsecond(node->args);
+
+	/* substring(text, text) is the regular expression variant */
+	if (!IsA(start, Const) || start->consttype != INT4OID ||
+		start->constisnull || DatumGetInt32(start->constvalue) < 1)
+		return NULL;
+
+	if (list_length(node->args) == 3 &&
+		exprType(lthird(node->args)) != INT4OID)
+		return NULL;
+
+	return list_length(node->args) == 3 ? "substr(%1, %2, %3)" :
+		"substr(%1, %2)";
+}
+
+/*
+ * hdfs_extract_template
+ *		Map date_part() and extract() of the fields hive/spark compute alike
+ *		to their functions.
+ *
+ * Only for date and timestamp values, as the hive functions use the session
+ * time zone where timestamptz ones would use the local one.
+ */
+static const char *
+hdfs_extract_template(FuncExpr *node, CLIENT_TYPE client_type)
+{
+	char	   *field = hdfs_get_const_field(linitial(node->args));
+	Oid			argtype = exprType(lsecond(node->args));
+
+	if (field == NULL || (argtype != DATEOID && argtype != TIMESTAMPOID))
+		return NULL;
+
+	if (pg_strcasecmp(field, "year") == 0)
+		return "year(%2)";
+	if (pg_strcasecmp(field, "quarter") == 0)
+		return "quarter(%2)";
+	if (pg_strcasecmp(field, "month") == 0)
+		return "month(%2)";
+	if (pg_strcasecmp(field, "week") == 0)
+		return "weekofyear(%2)";
+	if (pg_strcasecmp(field, "day") == 0)
+		return "day(%2)";
+	/* PostgreSQL numbers Sunday 0, hive 1 */
+	if (pg_strcasecmp(field, "dow") == 0)
+		return "(dayofweek(%2) - 1)";
+	if (pg_strcasecmp(field, "doy") == 0)
+		return client_type == SPARKSERVER ? "dayofyear(%2)" : NULL;
+
+	/* Whole hours and minutes, seconds have a fractional part */
+	if (argtype != TIMESTAMPOID)
+		return NULL;
+	if (pg_strcasecmp(field, "hour") == 0)
+		return "hour(%2)";
+	if (pg_strcasecmp(field, "minute") == 0)
+		return "minute(%2)";
 
-	if (isstr)
-		appendStringInfoChar(buf, '\'');
+	return NULL;
+}
 
-	for (valptr = val, i = 0; *valptr; valptr++, i++)
+/*
+ * hdfs_date_trunc_template
+ *		Map date_trunc() of a timestamp.
+ *
+ * Spark has the same function.  Hive only truncates to a year or a month,
+ * with trunc() returning a date string, or to a day with to_date().
+ */
+static const char *
+hdfs_date_trunc_template(FuncExpr *node, CLIENT_TYPE client_type)
+{
+	static const char *const spark_fields[] =
 	{
-		char		ch = *valptr;
+		"year", "quarter", "month", "week", "day", "hour", "minute", "second",
+		NULL
+	};
+	char	   *field = hdfs_get_const_field(linitial(node->args));
+	int			i;
 
-		/*
-		 * Remove '{', '}' and \" character from the string. Because this
-		 * syntax is not recognize by the remote HiveServer.
-		 */
-		if ((ch == '{' && i == 0) ||
-			(ch == '}' && (i == (strlen(val) - 1))) || ch == '\"')
-			continue;
+	if (field == NULL || exprType(lsecond(node->args)) != TIMESTAMPOID)
+		return NULL;
 
-		if (ch == ',' && isstr)
-			appendStringInfoString(buf, "', '");
-		else
-			appendStringInfoChar(buf, ch);
+	if (client_type == SPARKSERVER)
+	{
+		for (i = 0; spark_fields[i]; i++)
+		{
+			if (pg_strcasecmp(field, spark_fields[i]) == 0)
+				return "date_trunc(%1, %2)";
+		}
+		return NULL;
 	}
 
-	if (isstr)
-		appendStringInfoChar(buf, '\'');
+	if (pg_strcasecmp(field, "year") == 0)
+		return "CAST(trunc(%2, 'YEAR') AS TIMESTAMP)";
+	if (pg_strcasecmp(field, "month") == 0)
+		return "CAST(trunc(%2, 'MM') AS TIMESTAMP)";
+	if (pg_strcasecmp(field, "day") == 0)
+		return "CAST(to_date(%2) AS TIMESTAMP)";
+
+	return NULL;
 }
 
 /*
- * Deparse given ScalarArrayOpExpr expression.  To avoid problems
- * around priority of operations, we always parenthesize the arguments.
+ * Deparse given operator expression.  The templates parenthesize it to
+ * avoid problems around priority of operations.
  */
 static void
-hdfs_deparse_scalar_array_op_expr(ScalarArrayOpExpr *node,
-								  deparse_expr_cxt *context)
+hdfs_deparse_op_expr(OpExpr *node, deparse_expr_cxt *context)
 {
-	StringInfo	buf = context->buf;
-	HeapTuple	tuple;
-	Expr	   *arg1;
-	Expr	   *arg2;
-	Form_pg_operator form;
-	char	   *opname;
-	Oid			typoutput;
-	bool		typIsVarlena;
-	char	   *extval;
+	const hdfsPatternOperator *patop;
+	const char *remote_template;
 
-	/* Retrieve information about the operator from system catalog. */
-	tuple = SearchSysCache1(OPEROID, ObjectIdGetDatum(node->opno));
-	if (!HeapTupleIsValid(tuple))
-		elog(ERROR, "cache lookup failed for operator %u", node->opno);
-	form = (Form_pg_operator) GETSTRUCT(tuple);
+	/* Pattern-matching operators have their own syntax in hive. */
+	patop = hdfs_get_pattern_operator(node->opno);
+	if (patop != NULL)
+	{
+		hdfs_deparse_pattern_op(node, patop, context);
+		return;
+	}
 
-	/* Sanity check. */
-	Assert(list_length(node->args) == 2);
+	remote_template = hdfs_get_operator_template(node->opno,
+												 exprType(linitial(node->args)),
+												 list_length(node->args) == 2 ?
+												 exprType(lsecond(node->args)) :
+												 InvalidOid,
+												 hdfs_get_rel_dialect(context->foreignrel));
+	if (remote_template == NULL)
+		elog(ERROR, "operator %u can not be deparsed", node->opno);
 
-	/* Deparse left operand. */
-	arg1 = linitial(node->args);
-	hdfs_deparse_expr(arg1, context);
-	appendStringInfoChar(buf, ' ');
+	hdfs_deparse_template(remote_template, node->args, context);
+}
 
-	opname = NameStr(form->oprname);
-	if (strcmp(opname, "<>") == 0)
-		appendStringInfoString(buf, " NOT ");
+/*
+ * hdfs_get_operator_template
+ *		Get the template of the remote expression computing the given
+ *		operator on operands of the given types, NULL if it has none in the
+ *		given dialect.  righttype is InvalidOid for a prefix operator.
+ *
+ * The same check applies to the conditions of a scan, of a join and of a
+ * grouping, so that a join clause is sent as soon as its operators and
+ * functions would be in a WHERE clause.
+ */
+static const char *
+hdfs_get_operator_template(Oid opno, Oid lefttype, Oid righttype,
+						   hdfs_dialect *dialect)
+{
+	const hdfsOpMapping *mapping;
+	char	   *opname;
+	int			nargs = OidIsValid(righttype) ? 2 : 1;
 
-	/* Deparse operator name plus decoration. */
-	appendStringInfoString(buf, " IN ");
-	appendStringInfoChar(buf, '(');
+	if (!hdfs_is_builtin(opno))
+		return NULL;
 
-	/* Deparse right operand. */
-	arg2 = lsecond(node->args);
-	switch (nodeTag((Node *) arg2))
+	opname = get_opname(opno);
+	if (opname == NULL)
+		return NULL;
+
+	lefttype = getBaseType(lefttype);
+	if (nargs == 2)
+		righttype = getBaseType(righttype);
+
+	for (mapping = hdfs_op_mappings; mapping->pg_name; mapping++)
 	{
-		case T_Const:
-			{
-				Const	   *c = (Const *) arg2;
+		if (mapping->nargs != nargs ||
+			strcmp(mapping->pg_name, opname) != 0)
+			continue;
 
-				if (c->constisnull)
-				{
-					appendStringInfoString(buf, " NULL");
-					ReleaseSysCache(tuple);
-					return;
-				}
+		if (mapping->kinds == NULL)
+		{
+			if (mapping->lefttype != lefttype ||
+				(nargs == 2 && mapping->righttype != righttype))
+				continue;
+		}
+		else if (!hdfs_is_operand_kind(lefttype, mapping->kinds) ||
+				 (nargs == 2 && !hdfs_is_operand_kind(righttype,
+													  mapping->kinds)))
+			continue;
 
-				getTypeOutputInfo(c->consttype, &typoutput, &typIsVarlena);
-				extval = OidOutputFunctionCall(typoutput, c->constvalue);
+		/* Older servers have no interval literals */
+		if ((lefttype == INTERVALOID || righttype == INTERVALOID) &&
+			!dialect->interval_literals)
+			return NULL;
 
-				switch (c->consttype)
-				{
-					case INT4ARRAYOID:
-					case OIDARRAYOID:
-						hdfs_deparse_string(buf, extval, false);
-						break;
-					default:
-						hdfs_deparse_string(buf, extval, true);
-						break;
-				}
-			}
-			break;
-		default:
-			hdfs_deparse_expr(arg2, context);
-			break;
+		return dialect->client_type == SPARKSERVER ? mapping->spark_template :
+			mapping->hive_template;
 	}
 
-	appendStringInfoChar(buf, ')');
-	ReleaseSysCache(tuple);
+	return NULL;
 }
 
 /*
- * Deparse a RelabelType (binary-compatible cast) node.
+ * hdfs_is_operand_kind
+ *		Check whether a type is one of the kinds of operands listed in an
+ *		entry of hdfs_op_mappings.
  */
-static void
-hdfs_deparse_relabel_type(RelabelType *node, deparse_expr_cxt *context)
+static bool
+hdfs_is_operand_kind(Oid type, const char *kinds)
 {
-	hdfs_deparse_expr(node->arg, context);
+	char		kind;
+
+	switch (type)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+			/* Integers are numbers too */
+			return strchr(kinds, 'I') != NULL || strchr(kinds, 'N') != NULL;
+		case FLOAT4OID:
+		case FLOAT8OID:
+		case NUMERICOID:
+			kind = 'N';
+			break;
+		case TEXTOID:
+		case VARCHAROID:
+		case BPCHAROID:
+			kind = 'S';
+			break;
+		case DATEOID:
+		case TIMESTAMPOID:
+			kind = 'D';
+			break;
+		case BOOLOID:
+			kind = 'B';
+			break;
+		default:
+			return false;
+	}
+
+	return strchr(kinds, kind) != NULL;
 }
 
 /*
- * Deparse a BoolExpr node.
+ * hdfs_are_interval_args_literals
+ *		Check that the interval operands of an operator are constants, which
+ *		are deparsed as interval literals.
  */
-static void
-hdfs_deparse_bool_expr(BoolExpr *node, deparse_expr_cxt *context)
+static bool
+hdfs_are_interval_args_literals(List *args)
 {
-	StringInfo	buf = context->buf;
-	const char *op = NULL;		/* keep compiler quiet */
-	bool		first;
 	ListCell   *lc;
 
-	switch (node->boolop)
+	foreach(lc, args)
 	{
-		case AND_EXPR:
-			op = "AND";
-			break;
-		case OR_EXPR:
-			op = "OR";
-			break;
-		case NOT_EXPR:
-			appendStringInfoChar(buf, '(');
-			appendStringInfoString(buf, "NOT ");
-			hdfs_deparse_expr(linitial(node->args), context);
-			appendStringInfoChar(buf, ')');
-			return;
-	}
+		Node	   *arg = (Node *) lfirst(lc);
 
-	appendStringInfoChar(buf, '(');
-	first = true;
-	foreach(lc, node->args)
-	{
-		if (!first)
-			appendStringInfo(buf, " %s ", op);
-		hdfs_deparse_expr((Expr *) lfirst(lc), context);
-		first = false;
+		if (exprType(arg) == INTERVALOID && !IsA(arg, Const))
+			return false;
 	}
-	appendStringInfoChar(buf, ')');
+
+	return true;
 }
 
 /*
- * Deparse IS [NOT] NULL expression.
+ * hdfs_get_client_type
+ *		Get the dialect of the server of a foreign relation.
  */
-static void
-hdfs_deparse_null_test(NullTest *node, deparse_expr_cxt *context)
+static CLIENT_TYPE
+hdfs_get_client_type(RelOptInfo *foreignrel)
 {
-	StringInfo	buf = context->buf;
-
-	appendStringInfoChar(buf, '(');
-	hdfs_deparse_expr(node->arg, context);
-
-	if (node->nulltesttype == IS_NULL)
-		appendStringInfoString(buf, " IS NULL");
-	else
-		appendStringInfoString(buf, " IS NOT NULL");
+	return ((HDFSFdwRelationInfo *) foreignrel->fdw_private)->client_type;
+}
 
-	appendStringInfoChar(buf, ')');
+/*
+ * hdfs_get_rel_dialect
+ *		Get the capabilities of the server of a foreign relation.
+ */
+static hdfs_dialect *
+hdfs_get_rel_dialect(RelOptInfo *foreignrel)
+{
+	return ((HDFSFdwRelationInfo *) foreignrel->fdw_private)->dialect;
 }
 
 /*
- * Deparse ARRAY[...] construct.
+ * hdfs_get_pattern_operator
+ *		Get the description of the given operator if it is one of the string
+ *		pattern-matching ones, or NULL otherwise.
  */
-static void
-hdfs_deparse_array_expr(ArrayExpr *node, deparse_expr_cxt *context)
+static const hdfsPatternOperator *
+hdfs_get_pattern_operator(Oid opno)
 {
-	StringInfo	buf = context->buf;
-	bool		first = true;
-	ListCell   *lc;
+	Oid			lefttype;
+	Oid			righttype;
+	char	   *opname;
+	const hdfsPatternOperator *patop;
+
+	if (!hdfs_is_builtin(opno))
+		return NULL;
+
+	/* Leave alone the variants for name and bytea */
+	op_input_types(opno, &lefttype, &righttype);
+	if (lefttype != TEXTOID && lefttype != BPCHAROID)
+		return NULL;
+
+	opname = get_opname(opno);
+	if (opname == NULL)
+		return NULL;
 
-	appendStringInfoString(buf, "ARRAY[");
-	foreach(lc, node->elements)
+	for (patop = hdfs_pattern_operators; patop->name != NULL; patop++)
 	{
-		if (!first)
-			appendStringInfoString(buf, ", ");
-		hdfs_deparse_expr(lfirst(lc), context);
-		first = false;
+		if (strcmp(patop->name, opname) == 0)
+			return patop;
 	}
-	appendStringInfoChar(buf, ']');
 
+	return NULL;
+}
+
+/*
+ * hdfs_get_pattern_const
+ *		Get the pattern of a pattern-matching operator if it is a constant,
+ *		or NULL otherwise.
+ */
+static char *
+hdfs_get_pattern_const(OpExpr *node)
+{
+	Node	   *pattern = (Node *) lsecond(node->args);
+	Const	   *c;
+
+	while (IsA(pattern, RelabelType))
+		pattern = (Node *) ((RelabelType *) pattern)->arg;
+
+	if (!IsA(pattern, Const))
+		return NULL;
+
+	c = (Const *) pattern;
+	if (c->constisnull || c->consttype != TEXTOID)
+		return NULL;
+
+	return TextDatumGetCString(c->constvalue);
+}
+
+/*
+ * hdfs_is_pattern_op_pushable
+ *		Check whether the pattern of a pattern-matching operator can be
+ *		expressed in hive.
+ *
+ * The pattern must be a constant to be checked.  In a LIKE pattern, hive
+ * treats a backslash as an escape only before "_", "%" and another
+ * backslash, and keeps it as is before anything else.
+ */
+static bool
+hdfs_is_pattern_op_pushable(OpExpr *node, const hdfsPatternOperator *patop)
+{
+	char	   *pattern = hdfs_get_pattern_const(node);
+	const char *p;
+
+	if (pattern == NULL)
+		return false;
+
+	if (patop->regex)
+		return hdfs_translate_regex(pattern, patop->case_insensitive) != NULL;
+
+	for (p = pattern; *p; p++)
+	{
+		if (*p != '\\')
+			continue;
+
+		p++;
+		if (*p != '_' && *p != '%' && *p != '\\')
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * hdfs_translate_regex
+ *		Translate a PostgreSQL regular expression into the java flavour used
+ *		by hive's RLIKE, or return NULL if it uses a feature that has no
+ *		equivalent or a different meaning there.
+ *
+ * The common subset of both flavours is kept as is: the atoms, quantifiers,
+ * groups, lookarounds and bracket expressions without character classes
+ * like [:alpha:].  "." matches a newline in PostgreSQL, and "$" only the end
+ * of the string, so the pattern is run in DOTALL mode and "$" becomes "\z".
+ * The escapes other than the punctuation ones and \d, \s, \w, \n and \t
+ * (like the \m and \y word boundaries or back-references) are refused, as
+ * are the ARE directors and the embedded options.
+ */
+static char *
+hdfs_translate_regex(const char *pattern, bool case_insensitive)
+{
+	StringInfoData buf;
+	const char *p;
+	bool		in_bracket = false;
+
+	if (strncmp(pattern, "***", 3) == 0)
+		return NULL;
+
+	initStringInfo(&buf);
+	appendStringInfoString(&buf, case_insensitive ? "(?siu)" : "(?s)");
+
+	for (p = pattern; *p; p++)
+	{
+		if (*p == '\\')
+		{
+			if (p[1] == '\0')
+				return NULL;
+			if (isalnum((unsigned char) p[1]) &&
+				strchr("dDsSwWnt", p[1]) == NULL)
+				return NULL;
+
+			appendStringInfoChar(&buf, *p++);
+			appendStringInfoChar(&buf, *p);
+			continue;
+		}
+
+		if (in_bracket)
+		{
+			/* java nests classes in brackets, and intersects them with && */
+			if (*p == '[' || (*p == '&' && p[1] == '&'))
+				return NULL;
+			if (*p == ']')
+				in_bracket = false;
+			appendStringInfoChar(&buf, *p);
+			continue;
+		}
+
+		switch (*p)
+		{
+			case '[':
+				in_bracket = true;
+				appendStringInfoChar(&buf, *p);
+				if (p[1] == '^')
+					appendStringInfoChar(&buf, *++p);
+				/* A leading ] is a literal only in PostgreSQL */
+				if (p[1] == ']')
+					return NULL;
+				break;
+			case '(':
+				if (p[1] == '?' &&
+					!(p[2] == ':' || p[2] == '=' || p[2] == '!' ||
+					  (p[2] == '<' && (p[3] == '=' || p[3] == '!'))))
+					return NULL;
+				appendStringInfoChar(&buf, *p);
+				break;
+			case '$':
+				appendStringInfoString(&buf, "\\z");
+				break;
+			default:
+				appendStringInfoChar(&buf, *p);
+				break;
+		}
+	}
+
+	if (in_bracket)
+		return NULL;
+
+	return buf.data;
+}
+
+/*
+ * Deparse a pattern-matching operator.
+ *
+ * LIKE is the same in hive, and ILIKE is done by LIKE on both operands
+ * converted to lowercase.  The regular expression operators become RLIKE on
+ * the translated pattern, with the case-insensitive mode set for ~* and !~*.
+ */
+static void
+hdfs_deparse_pattern_op(OpExpr *node, const hdfsPatternOperator *patop,
+						deparse_expr_cxt *context)
+{
+	StringInfo	buf = context->buf;
+	bool		lower = patop->case_insensitive && !patop->regex;
+
+	appendStringInfoChar(buf, '(');
+	if (patop->negate)
+		appendStringInfoString(buf, "NOT (");
+
+	if (lower)
+		appendStringInfoString(buf, "lower(");
+	hdfs_deparse_expr(linitial(node->args), context);
+	if (lower)
+		appendStringInfoChar(buf, ')');
+
+	if (patop->regex)
+	{
+		appendStringInfoString(buf, " RLIKE ");
+		hdfs_deparse_hive_string_literal(buf,
+										 hdfs_translate_regex(hdfs_get_pattern_const(node),
+															  patop->case_insensitive));
+	}
+	else
+	{
+		appendStringInfoString(buf, " LIKE ");
+		if (lower)
+			appendStringInfoString(buf, "lower(");
+		hdfs_deparse_expr(lsecond(node->args), context);
+		if (lower)
+			appendStringInfoChar(buf, ')');
+	}
+
+	if (patop->negate)
+		appendStringInfoChar(buf, ')');
+	appendStringInfoChar(buf, ')');
+}
+
+/*
+ * Deparse IS DISTINCT FROM, as the negation of the null-safe equality for
+ * the servers not knowing it.
+ */
+static void
+hdfs_deparse_distinct_expr(DistinctExpr *node, deparse_expr_cxt *context)
+{
+	StringInfo	buf = context->buf;
+	bool		is_distinct_from;
+
+	Assert(list_length(node->args) == 2);
+
+	is_distinct_from = hdfs_get_rel_dialect(context->foreignrel)->is_distinct_from;
+
+	appendStringInfoString(buf, is_distinct_from ? "(" : "(NOT (");
+	hdfs_deparse_expr(linitial(node->args), context);
+	appendStringInfoString(buf, is_distinct_from ? " IS DISTINCT FROM " :
+						   " <=> ");
+	hdfs_deparse_expr(lsecond(node->args), context);
+	appendStringInfoString(buf, is_distinct_from ? ")" : "))");
+}
+
+/*
+ * Deparse given ScalarArrayOpExpr expression.  To avoid problems
+ * around priority of operations, we always parenthesize the arguments.
+ */
+static void
+hdfs_deparse_scalar_array_op_expr(ScalarArrayOpExpr *node,
+								  deparse_expr_cxt *context)
+{
+	StringInfo	buf = context->buf;
+	HeapTuple	tuple;
+	Expr	   *arg1;
+	Expr	   *arg2;
+	Form_pg_operator form;
+	char	   *opname;
+
+	/* Retrieve information about the operator from system catalog. */
+	tuple = SearchSysCache1(OPEROID, ObjectIdGetDatum(node->opno));
+	if (!HeapTupleIsValid(tuple))
+		elog(ERROR, "cache lookup failed for operator %u", node->opno);
+	form = (Form_pg_operator) GETSTRUCT(tuple);
+
+	/* Sanity check. */
+	Assert(list_length(node->args) == 2);
+
+	/* Deparse left operand. */
+	arg1 = linitial(node->args);
+	hdfs_deparse_expr(arg1, context);
+
+	opname = NameStr(form->oprname);
+	if (strcmp(opname, "<>") == 0)
+		appendStringInfoString(buf, " NOT");
+
+	/* Deparse operator name plus decoration. */
+	appendStringInfoString(buf, " IN (");
+
+	/* Deparse right operand. */
+	arg2 = lsecond(node->args);
+	switch (nodeTag((Node *) arg2))
+	{
+		case T_Const:
+			{
+				Const	   *c = (Const *) arg2;
+				Oid			elemtype = get_element_type(c->consttype);
+				int16		elmlen;
+				bool		elmbyval;
+				char		elmalign;
+				Datum	   *elems;
+				bool	   *nulls;
+				int			nelems;
+				int			i;
+
+				if (c->constisnull)
+				{
+					appendStringInfoString(buf, "NULL");
+					break;
+				}
+
+				get_typlenbyvalalign(elemtype, &elmlen, &elmbyval, &elmalign);
+				deconstruct_array(DatumGetArrayTypeP(c->constvalue),
+								  elemtype, elmlen, elmbyval, elmalign,
+								  &elems, &nulls, &nelems);
+
+				for (i = 0; i < nelems; i++)
+				{
+					if (i > 0)
+						appendStringInfoString(buf, ", ");
+					if (nulls[i])
+						appendStringInfoString(buf, "NULL");
+					else
+						hdfs_deparse_literal(elemtype, c->consttypmod,
+											 elems[i], context);
+				}
+			}
+			break;
+		case T_ArrayExpr:
+			{
+				ListCell   *lc;
+				bool		first = true;
+
+				foreach(lc, ((ArrayExpr *) arg2)->elements)
+				{
+					if (!first)
+						appendStringInfoString(buf, ", ");
+					hdfs_deparse_expr(lfirst(lc), context);
+					first = false;
+				}
+			}
+			break;
+		default:
+			elog(ERROR, "unsupported array expression type for deparse: %d",
+				 (int) nodeTag(arg2));
+			break;
+	}
+
+	appendStringInfoChar(buf, ')');
+	ReleaseSysCache(tuple);
+}
+
+/*
+ * Deparse a RelabelType (binary-compatible cast) node.
+ */
+static void
+hdfs_deparse_relabel_type(RelabelType *node, deparse_expr_cxt *context)
+{
+	hdfs_deparse_expr(node->arg, context);
+}
+
+/*
+ * Deparse a BoolExpr node.
+ */
+static void
+hdfs_deparse_bool_expr(BoolExpr *node, deparse_expr_cxt *context)
+{
+	StringInfo	buf = context->buf;
+	const char *op = NULL;		/* keep compiler quiet */
+	bool		first;
+	ListCell   *lc;
+
+	switch (node->boolop)
+	{
+		case AND_EXPR:
+			op = "AND";
+			break;
+		case OR_EXPR:
+			op = "OR";
+			break;
+		case NOT_EXPR:
+			appendStringInfoChar(buf, '(');
+			appendStringInfoString(buf, "NOT ");
+			hdfs_deparse_expr(linitial(node->args), context);
+			appendStringInfoChar(buf, ')');
+			return;
+	}
+
+	appendStringInfoChar(buf, '(');
+	first = true;
+	foreach(lc, node->args)
+	{
+		if (!first)
+			appendStringInfo(buf, " %s ", op);
+		hdfs_deparse_expr((Expr *) lfirst(lc), context);
+		first = false;
+	}
+	appendStringInfoChar(buf, ')');
+}
+
+/*
+ * Deparse IS [NOT] NULL expression.
+ */
+static void
+hdfs_deparse_null_test(NullTest *node, deparse_expr_cxt *context)
+{
+	StringInfo	buf = context->buf;
+
+	appendStringInfoChar(buf, '(');
+	hdfs_deparse_expr(node->arg, context);
+
+	if (node->nulltesttype == IS_NULL)
+		appendStringInfoString(buf, " IS NULL");
+	else
+		appendStringInfoString(buf, " IS NOT NULL");
+
+	appendStringInfoChar(buf, ')');
+}
+
+/*
+ * Deparse IS [NOT] TRUE/FALSE/UNKNOWN expression.
+ *
+ * Older hive releases don't know these, so they are spelled out with
+ * coalesce() and IS [NOT] NULL.
+ */
+static void
+hdfs_deparse_boolean_test(BooleanTest *node, deparse_expr_cxt *context)
+{
+	StringInfo	buf = context->buf;
+
+	appendStringInfoChar(buf, '(');
+
+	switch (node->booltesttype)
+	{
+		case IS_TRUE:
+		case IS_NOT_FALSE:
+			appendStringInfoString(buf, "coalesce(");
+			hdfs_deparse_expr(node->arg, context);
+			appendStringInfo(buf, ", %s)",
+							 node->booltesttype == IS_TRUE ? "false" : "true");
+			break;
+		case IS_NOT_TRUE:
+		case IS_FALSE:
+			appendStringInfoString(buf, "NOT coalesce(");
+			hdfs_deparse_expr(node->arg, context);
+			appendStringInfo(buf, ", %s)",
+							 node->booltesttype == IS_NOT_TRUE ? "false" : "true");
+			break;
+		case IS_UNKNOWN:
+			hdfs_deparse_expr(node->arg, context);
+			appendStringInfoString(buf, " IS NULL");
+			break;
+		case IS_NOT_UNKNOWN:
+			hdfs_deparse_expr(node->arg, context);
+			appendStringInfoString(buf, " IS NOT NULL");
+			break;
+		default:
+			elog(ERROR, "unrecognized booltesttype: %d",
+				 (int) node->booltesttype);
+	}
+
+	appendStringInfoChar(buf, ')');
+}
+
+/*
+ * Deparse CASE expression, in either of its forms.
+ */
+static void
+hdfs_deparse_case_expr(CaseExpr *node, deparse_expr_cxt *context)
+{
+	StringInfo	buf = context->buf;
+	ListCell   *lc;
+
+	appendStringInfoString(buf, "(CASE");
+
+	if (node->arg != NULL)
+	{
+		appendStringInfoChar(buf, ' ');
+		hdfs_deparse_expr(node->arg, context);
+	}
+
+	foreach(lc, node->args)
+	{
+		CaseWhen   *cw = lfirst_node(CaseWhen, lc);
+
+		appendStringInfoString(buf, " WHEN ");
+		if (node->arg == NULL)
+			hdfs_deparse_expr(cw->expr, context);
+		else
+		{
+			/* Skip the placeholder and the equality operator */
+			hdfs_deparse_expr(lsecond(((OpExpr *) cw->expr)->args), context);
+		}
+		appendStringInfoString(buf, " THEN ");
+		hdfs_deparse_expr(cw->result, context);
+	}
+
+	if (node->defresult != NULL)
+	{
+		appendStringInfoString(buf, " ELSE ");
+		hdfs_deparse_expr(node->defresult, context);
+	}
+
+	appendStringInfoString(buf, " END)");
+}
+
+/*
+ * Deparse COALESCE expression.
+ */
+static void
+hdfs_deparse_coalesce_expr(CoalesceExpr *node, deparse_expr_cxt *context)
+{
+	StringInfo	buf = context->buf;
+	bool		first = true;
+	ListCell   *lc;
+
+	appendStringInfoString(buf, "coalesce(");
+	foreach(lc, node->args)
+	{
+		if (!first)
+			appendStringInfoString(buf, ", ");
+		hdfs_deparse_expr(lfirst(lc), context);
+		first = false;
+	}
+	appendStringInfoChar(buf, ')');
+}
+
+/*
+ * Deparse NULLIF expression.
+ *
+ * nullif() appeared only in hive 2.3, so use the equivalent CASE instead.
+ */
+static void
+hdfs_deparse_nullif_expr(NullIfExpr *node, deparse_expr_cxt *context)
+{
+	StringInfo	buf = context->buf;
+
+	appendStringInfoString(buf, "(CASE WHEN ");
+	hdfs_deparse_expr(linitial(node->args), context);
+	appendStringInfoString(buf, " = ");
+	hdfs_deparse_expr(lsecond(node->args), context);
+	appendStringInfoString(buf, " THEN NULL ELSE ");
+	hdfs_deparse_expr(linitial(node->args), context);
+	appendStringInfoString(buf, " END)");
+}
+
+/*
+ * Deparse GREATEST or LEAST expression.
+ *
+ * PostgreSQL ignores the NULL arguments, as spark does, but hive returns NULL
+ * as soon as one of them is.  For hive, each argument is replaced by the
+ * first non-NULL one starting from it, which leaves the result unchanged
+ * while no NULL remains unless all of them are.
+ */
+static void
+hdfs_deparse_min_max_expr(MinMaxExpr *node, deparse_expr_cxt *context)
+{
+	StringInfo	buf = context->buf;
+	HDFSFdwRelationInfo *fpinfo =
+		(HDFSFdwRelationInfo *) context->foreignrel->fdw_private;
+	int			nargs = list_length(node->args);
+	int			i;
+
+	appendStringInfoString(buf, node->op == IS_GREATEST ? "greatest(" :
+						   "least(");
+
+	for (i = 0; i < nargs; i++)
+	{
+		int			j;
+
+		if (i > 0)
+			appendStringInfoString(buf, ", ");
+
+		if (fpinfo->client_type == SPARKSERVER)
+		{
+			hdfs_deparse_expr(list_nth(node->args, i), context);
+			continue;
+		}
+
+		appendStringInfoString(buf, "coalesce(");
+		for (j = 0; j < nargs; j++)
+		{
+			if (j > 0)
+				appendStringInfoString(buf, ", ");
+			hdfs_deparse_expr(list_nth(node->args, (i + j) % nargs),
+							  context);
+		}
+		appendStringInfoChar(buf, ')');
+	}
+
+	appendStringInfoChar(buf, ')');
+}
+
+/*
+ * Deparse a cast done through the text representation of the value.
+ */
+static void
+hdfs_deparse_coerce_via_io(CoerceViaIO *node, deparse_expr_cxt *context)
+{
+	StringInfo	buf = context->buf;
+
+	appendStringInfoString(buf, "CAST(");
+	hdfs_deparse_expr(node->arg, context);
+	appendStringInfo(buf, " AS %s)", hdfs_get_coerce_type_name(node));
+}
+
+/*
+ * hdfs_get_coerce_type_name
+ *		Get the name of the hive type a CoerceViaIO casts to, or NULL if the
+ *		cast can't be sent.
+ *
+ * Integers and booleans are printed the same way by both sides, unlike
+ * floats, numerics, whose scale hive drops, and datetimes, which depend on
+ * DateStyle here.  No cast from a string is sent: hive returns NULL for a
+ * malformed string, where PostgreSQL raises an error, and parses dates and
+ * timestamps whatever the DateStyle.
+ */
+static const char *
+hdfs_get_coerce_type_name(CoerceViaIO *node)
+{
+	Oid			source = getBaseType(exprType((Node *) node->arg));
+
+	switch (node->resulttype)
+	{
+		case TEXTOID:
+		case VARCHAROID:
+			if (source == INT2OID || source == INT4OID ||
+				source == INT8OID || source == BOOLOID)
+				return "STRING";
+			return NULL;
+		default:
+			return NULL;
+	}
+}
+
+/*
+ * Print the representation of a parameter to be sent to the remote side.
+ *
+ * Note: we always label the Param's type explicitly rather than relying on
+ * transmitting a numeric type OID in PQexecParams().  This allows us to
+ * avoid assuming that types have the same OIDs on the remote side as they
+ * do locally --- they need only have the same names.
+ */
+static void
+hdfs_print_remote_param(Oid paramtype, deparse_expr_cxt *context)
+{
+	const char *type_name = hdfs_get_param_type_name(paramtype);
+
+	if (type_name != NULL)
+		appendStringInfo(context->buf, "CAST(? AS %s)", type_name);
+	else
+		appendStringInfoChar(context->buf, '?');
+}
+
+/*
+ * Print the representation of a placeholder for a parameter that will be
+ * sent to the remote side at execution time.
+ *
+ * This is used when we're just trying to EXPLAIN the remote query.
+ * We don't have the actual value of the runtime parameter yet, so we emit
+ * a NULL of the type the parameter would be cast to, which shows the same
+ * typed comparison as the query sent for real.
+ */
+static void
+hdfs_print_remote_placeholder(Oid paramtype, deparse_expr_cxt *context)
+{
+	const char *type_name = hdfs_get_param_type_name(paramtype);
+
+	if (type_name != NULL)
+		appendStringInfo(context->buf, "CAST(NULL AS %s)", type_name);
+	else
+		appendStringInfoString(context->buf, "(SELECT null)");
+}
+
+/*
+ * hdfs_get_param_type_name
+ *		Get the name of the hive type a parameter is cast to, or NULL for the
+ *		types bound as strings.
+ *
+ * The driver writes the bound values in the query as literals of its own
+ * choice, an INT for a small bigint or a string for a date, so the type is
+ * spelled out to let hive prune partitions on the parameter.
+ */
+static const char *
+hdfs_get_param_type_name(Oid type)
+{
+	switch (type)
+	{
+		case INT2OID:
+			return "SMALLINT";
+		case INT4OID:
+			return "INT";
+		case INT8OID:
+			return "BIGINT";
+		case FLOAT4OID:
+			return "FLOAT";
+		case FLOAT8OID:
+		case NUMERICOID:		/* bound as a float8 */
+			return "DOUBLE";
+		case BOOLOID:
+		case BITOID:
+			return "BOOLEAN";
+		case DATEOID:
+			return "DATE";
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return "TIMESTAMP";
+		default:
+			return NULL;
+	}
+}
+
+/*
+ * hdfs_is_subquery_var
+ *
+ * Returns true if given Var is deparsed as a subquery output column, in
+ * which case, *relno and *colno are set to the IDs for the relation and
+ * column alias to the Var provided by the subquery.
+ */
+static bool
+hdfs_is_subquery_var(Var *node, RelOptInfo *foreignrel, int *relno, int *colno,
+					 deparse_expr_cxt *context)
+{
+	HDFSFdwRelationInfo *fpinfo = (HDFSFdwRelationInfo *) foreignrel->fdw_private;
+	RelOptInfo *outerrel = fpinfo->outerrel;
+	RelOptInfo *innerrel = fpinfo->innerrel;
+
+	/* Should only be called in these cases. */
+	Assert(IS_SIMPLE_REL(foreignrel) || IS_JOIN_REL(foreignrel) ||
+		   IS_UPPER_REL(foreignrel));
+
+	/*
+	 * If the given relation isn't a join relation, it doesn't have any lower
+	 * subqueries, so the Var isn't a subquery output column.
+	 */
+	if (!IS_JOIN_REL(foreignrel))
+		return false;
+
+	/*
+	 * If the Var doesn't belong to any lower subqueries, it isn't a subquery
+	 * output column.
+	 */
+	if (!bms_is_member(node->varno, fpinfo->lower_subquery_rels))
+		return false;
+
+	if (bms_is_member(node->varno, outerrel->relids))
+	{
+		/*
+		 * If outer relation is deparsed as a subquery, the Var is an output
+		 * column of the subquery; get the IDs for the relation/column alias.
+		 */
+		if (fpinfo->make_outerrel_subquery)
+		{
+			hdfs_get_relation_column_alias_ids(node, outerrel, relno, colno,
+											   context);
+			return true;
+		}
+
+		/* Otherwise, recurse into the outer relation. */
+		return hdfs_is_subquery_var(node, outerrel, relno, colno, context);
+	}
+	else
+	{
+		Assert(bms_is_member(node->varno, innerrel->relids));
+
+		/*
+		 * If inner relation is deparsed as a subquery, the Var is an output
+		 * column of the subquery; get the IDs for the relation/column alias.
+		 */
+		if (fpinfo->make_innerrel_subquery)
+		{
+			hdfs_get_relation_column_alias_ids(node, innerrel, relno, colno,
+											   context);
+			return true;
+		}
+
+		/* Otherwise, recurse into the inner relation. */
+		return hdfs_is_subquery_var(node, innerrel, relno, colno, context);
+	}
 }
 
 /*
- * Print the representation of a parameter to be sent to the remote side.
+ * hdfs_get_relation_column_alias_ids
  *
- * Note: we always label the Param's type explicitly rather than relying on
- * transmitting a numeric type OID in PQexecParams().  This allows us to
- * avoid assuming that types have the same OIDs on the remote side as they
- * do locally --- they need only have the same names.
+ * Get the IDs for the relation and column alias to given Var belonging to
+ * given relation, which are returned into *relno and *colno.
+ */
+static void
+hdfs_get_relation_column_alias_ids(Var *node, RelOptInfo *foreignrel,
+								   int *relno, int *colno,
+								   deparse_expr_cxt *context)
+{
+	HDFSFdwRelationInfo *fpinfo = (HDFSFdwRelationInfo *) foreignrel->fdw_private;
+	int			i;
+	ListCell   *lc;
+	List	   *scan_var_list = NIL;
+	List	   *whole_row_lists = NIL;
+
+	scan_var_list = pull_var_clause((Node *) foreignrel->reltarget->exprs,
+									PVC_RECURSE_PLACEHOLDERS);
+
+	scan_var_list = hdfs_adjust_whole_row_ref(context->root, scan_var_list,
+											  &whole_row_lists,
+											  foreignrel->relids);
+	/* Get the relation alias ID */
+	*relno = fpinfo->relation_index;
+
+	/* Get the column alias ID */
+	i = 1;
+	foreach(lc, scan_var_list)
+	{
+#if PG_VERSION_NUM >= 160000
+		Var		   *tlvar = (Var *) lfirst(lc);
+
+		/*
+		 * Match reltarget entries only on varno/varattno.  Ideally there
+		 * would be some cross-check on varnullingrels, but it's unclear what
+		 * to do exactly; we don't have enough context to know what that value
+		 * should be.
+		 */
+		if (IsA(tlvar, Var) &&
+			tlvar->varno == node->varno &&
+			tlvar->varattno == node->varattno)
+#else
+		if (equal(lfirst(lc), (Node *) node))
+#endif
+		{
+			*colno = i;
+			return;
+		}
+		i++;
+	}
+
+	/* Shouldn't get here */
+	elog(ERROR, "unexpected expression in subquery output");
+}
+
+/*
+ * hdfs_get_agg_mapping
+ * 		Find how the given aggregate is computed on hive/spark, NULL if it
+ * 		can't be.
+ */
+static const hdfsAggMapping *
+hdfs_get_agg_mapping(Oid aggfnoid, int nargs)
+{
+	const hdfsAggMapping *mapping;
+	char	   *func_name = get_func_name(aggfnoid);
+
+	for (mapping = hdfs_agg_mappings; mapping->pg_name; mapping++)
+	{
+		if (mapping->nargs == nargs &&
+			strcmp(mapping->pg_name, func_name) == 0)
+			return mapping;
+	}
+
+	return NULL;
+}
+
+/*
+ * hdfs_is_agg_pushable
+ * 		Check that hive/spark compute the given aggregate with the semantics
+ * 		it has in PostgreSQL.
+ *
+ * The arguments themselves are checked by the caller.
+ */
+static bool
+hdfs_is_agg_pushable(Aggref *agg, const hdfsAggMapping *mapping,
+					 foreign_glob_cxt *glob_cxt)
+{
+	HDFSFdwRelationInfo *fpinfo =
+		(HDFSFdwRelationInfo *) glob_cxt->foreignrel->fdw_private;
+
+	if (agg->aggsplit != AGGSPLIT_SIMPLE)
+		return hdfs_is_partial_agg_pushable(agg, mapping);
+
+	/*
+	 * The statistical aggregates are computed in double precision on
+	 * hive/spark, even for integer and decimal inputs for which PostgreSQL
+	 * returns an exact numeric.
+	 */
+	if (mapping->float_only && agg->aggtype != FLOAT8OID)
+		return false;
+
+	/* Hive/spark have no ordered aggregates, see what can be done without. */
+	if (agg->aggorder && !hdfs_is_agg_order_pushable(agg, mapping))
+		return false;
+
+	switch (mapping->kind)
+	{
+		case HDFS_AGG_PLAIN:
+		case HDFS_AGG_BOOL:
+			break;
+
+		case HDFS_AGG_STRING:
+			{
+				TargetEntry *tle = (TargetEntry *) lsecond(agg->args);
+				Const	   *delim = (Const *) tle->expr;
+
+				/* Only the text variant, with a constant delimiter */
+				if (agg->aggtype != TEXTOID || !IsA(delim, Const) ||
+					delim->constisnull)
+					return false;
+			}
+			break;
+
+		case HDFS_AGG_PERCENTILE:
+			{
+				Const	   *fraction;
+
+				/*
+				 * Hive's percentile() is exact but takes integers only, so
+				 * other inputs need percentile_approx().
+				 */
+				if ((!fpinfo->allow_approximate_aggregates &&
+					 hdfs_get_percentile_integral_arg(agg) == NULL) ||
+					agg->aggkind != AGGKIND_ORDERED_SET ||
+					agg->aggdistinct ||
+					list_length(agg->aggdirectargs) != 1)
+					return false;
+
+				/*
+				 * Only a single constant fraction.  Leave the ones PostgreSQL
+				 * rejects for it to report.
+				 */
+				fraction = (Const *) linitial(agg->aggdirectargs);
+				if (!IsA(fraction, Const) || fraction->consttype != FLOAT8OID ||
+					fraction->constisnull ||
+					DatumGetFloat8(fraction->constvalue) < 0 ||
+					DatumGetFloat8(fraction->constvalue) > 1)
+					return false;
+			}
+			break;
+	}
+
+	return true;
+}
+
+/*
+ * hdfs_is_agg_order_pushable
+ * 		Check whether the given aggregate computes the same on hive/spark,
+ * 		ignoring its ORDER BY or using a sorted collection instead.
+ */
+static bool
+hdfs_is_agg_order_pushable(Aggref *agg, const hdfsAggMapping *mapping)
+{
+	SortGroupClause *sortcl;
+	Expr	   *sortexpr;
+	Oid			collid;
+	bool		reverse;
+
+	if (mapping->ignore_order)
+		return true;
+
+	if (list_length(agg->aggorder) != 1)
+		return false;
+
+	/* Only an ascending order is possible, for what follows. */
+	sortcl = (SortGroupClause *) linitial(agg->aggorder);
+	if (!OidIsValid(get_equality_op_for_ordering_op(sortcl->sortop,
+													&reverse)) ||
+		reverse)
+		return false;
+
+	sortexpr = (Expr *) get_sortgroupclause_expr(sortcl, agg->args);
+
+	switch (mapping->kind)
+	{
+		case HDFS_AGG_PERCENTILE:
+			/* The ORDER BY is the aggregated value of an ordered-set one */
+			return true;
+
+		case HDFS_AGG_STRING:
+
+			/*
+			 * sort_array() orders strings bytewise, which is the order of the
+			 * C collation only.  NULLs are skipped, so their place doesn't
+			 * matter.
+			 */
+			collid = exprCollation((Node *) sortexpr);
+			return (equal(sortexpr,
+						  ((TargetEntry *) linitial(agg->args))->expr) &&
+					exprType((Node *) sortexpr) == TEXTOID &&
+					(collid == C_COLLATION_OID ||
+					 collid == POSIX_COLLATION_OID));
+
+		default:
+			return false;
+	}
+}
+
+/*
+ * hdfs_get_percentile_integral_arg
+ * 		If the value of the given percentile_cont() is an integer cast to
+ * 		float8, return the integer expression, otherwise NULL.
+ */
+static Expr *
+hdfs_get_percentile_integral_arg(Aggref *agg)
+{
+	Expr	   *arg = ((TargetEntry *) linitial(agg->args))->expr;
+	FuncExpr   *func;
+	Oid			argtype;
+
+	if (!IsA(arg, FuncExpr))
+		return NULL;
+
+	func = (FuncExpr *) arg;
+	if (func->funcformat != COERCE_IMPLICIT_CAST &&
+		func->funcformat != COERCE_EXPLICIT_CAST)
+		return NULL;
+
+	argtype = exprType((Node *) linitial(func->args));
+	if (argtype != INT2OID && argtype != INT4OID && argtype != INT8OID)
+		return NULL;
+
+	return (Expr *) linitial(func->args);
+}
+
+/*
+ * hdfs_is_partial_agg_pushable
+ * 		Check that hive/spark can compute the transition state of the given
+ * 		partial aggregate.
+ *
+ * For count, min, max and sum the state is the aggregate's result, of a type
+ * fetched like any other.  The state of avg over integers is an int8 array
+ * {count, sum}, and over floats a float8 array {count, sum, sum of squared
+ * deviations}, both of which are built remotely.  Others, whose state is
+ * internal, are computed locally.
+ */
+static bool
+hdfs_is_partial_agg_pushable(Aggref *agg, const hdfsAggMapping *mapping)
+{
+	Oid			transtype = agg->aggtranstype;
+
+	Assert(agg->aggsplit == AGGSPLIT_INITIAL_SERIAL);
+
+	/* The planner doesn't split these, but don't take chances. */
+	if (agg->aggdistinct || agg->aggorder || mapping->kind != HDFS_AGG_PLAIN)
+		return false;
+
+	if (strcmp(mapping->pg_name, "count") == 0 ||
+		strcmp(mapping->pg_name, "min") == 0 ||
+		strcmp(mapping->pg_name, "max") == 0)
+		return transtype != INTERNALOID;
+
+	if (strcmp(mapping->pg_name, "sum") == 0)
+		return (transtype == INT8OID || transtype == FLOAT4OID ||
+				transtype == FLOAT8OID);
+
+	if (strcmp(mapping->pg_name, "avg") == 0)
+		return (transtype == INT8ARRAYOID || transtype == FLOAT8ARRAYOID);
+
+	return false;
+}
+
+/*
+ * hdfs_deparse_agg_arg
+ * 		Deparse an aggregated argument of the given aggregate, a NULL one
+ * 		standing for the row of count(*).
+ *
+ * Hive/spark have no FILTER clause, but aggregates skip NULL values, so the
+ * rows filtered out are made NULL instead.
+ */
+static void
+hdfs_deparse_agg_arg(Aggref *node, Expr *arg, deparse_expr_cxt *context)
+{
+	StringInfo	buf = context->buf;
+
+	if (node->aggfilter == NULL)
+	{
+		if (arg)
+			hdfs_deparse_expr(arg, context);
+		else
+			appendStringInfoChar(buf, '*');
+		return;
+	}
+
+	appendStringInfoString(buf, "CASE WHEN (");
+	hdfs_deparse_expr(node->aggfilter, context);
+	appendStringInfoString(buf, ") THEN ");
+	if (arg)
+		hdfs_deparse_expr(arg, context);
+	else
+		appendStringInfoChar(buf, '1');
+	appendStringInfoString(buf, " END");
+}
+
+/*
+ * hdfs_deparse_avg_state
+ * 		Deparse the transition state of a partial avg, as an array literal
+ * 		accepted by the array type's input function.
+ */
+static void
+hdfs_deparse_avg_state(Aggref *node, deparse_expr_cxt *context)
+{
+	StringInfo	buf = context->buf;
+	Expr	   *arg = ((TargetEntry *) linitial(node->args))->expr;
+
+	appendStringInfoString(buf, "concat('{', CAST(count(");
+	hdfs_deparse_agg_arg(node, arg, context);
+	appendStringInfoString(buf, ") AS STRING), ',', CAST(coalesce(sum(");
+	hdfs_deparse_agg_arg(node, arg, context);
+	appendStringInfoString(buf, "), 0) AS STRING)");
+
+	/* float8_combine() also needs the sum of squared deviations */
+	if (node->aggtranstype == FLOAT8ARRAYOID)
+	{
+		appendStringInfoString(buf, ", ',', CAST(coalesce(var_pop(");
+		hdfs_deparse_agg_arg(node, arg, context);
+		appendStringInfoString(buf, ") * count(");
+		hdfs_deparse_agg_arg(node, arg, context);
+		appendStringInfoString(buf, "), 0) AS STRING)");
+	}
+
+	appendStringInfoString(buf, ", '}')");
+}
+
+/*
+ * hdfs_deparse_aggref
+ *		Deparse an Aggref node.
+ *
+ * The aggregate is deparsed as its hive/spark counterpart, returning a value
+ * of the same type as in PostgreSQL.  A partial aggregate returns its
+ * transition state instead.
  */
 static void
-hdfs_print_remote_param(deparse_expr_cxt *context)
+hdfs_deparse_aggref(Aggref *node, deparse_expr_cxt *context)
+{
+	StringInfo	buf = context->buf;
+	const hdfsAggMapping *mapping;
+	const char *distinct;
+
+	/* Only basic or partial aggregation accepted. */
+	Assert(node->aggsplit == AGGSPLIT_SIMPLE ||
+		   node->aggsplit == AGGSPLIT_INITIAL_SERIAL);
+
+	mapping = hdfs_get_agg_mapping(node->aggfnoid, list_length(node->args));
+	Assert(mapping != NULL);
+
+	if (node->aggsplit != AGGSPLIT_SIMPLE &&
+		(node->aggtranstype == INT8ARRAYOID ||
+		 node->aggtranstype == FLOAT8ARRAYOID))
+	{
+		hdfs_deparse_avg_state(node, context);
+		return;
+	}
+
+	distinct = (node->aggdistinct != NIL) ? "DISTINCT " : "";
+
+	switch (mapping->kind)
+	{
+		case HDFS_AGG_PLAIN:
+			appendStringInfo(buf, "%s(%s", mapping->remote_name, distinct);
+
+			/* aggstar can be set only in zero-argument aggregates. */
+			if (node->aggstar)
+				hdfs_deparse_agg_arg(node, NULL, context);
+			else
+			{
+				ListCell   *arg;
+				bool		first = true;
+
+				/* Add all the arguments. */
+				foreach(arg, node->args)
+				{
+					TargetEntry *tle = (TargetEntry *) lfirst(arg);
+					Node	   *n = (Node *) tle->expr;
+
+					if (tle->resjunk)
+						continue;
+
+					if (!first)
+						appendStringInfoString(buf, ", ");
+					first = false;
+
+					hdfs_deparse_agg_arg(node, (Expr *) n, context);
+				}
+			}
+
+			appendStringInfoChar(buf, ')');
+			break;
+
+		case HDFS_AGG_BOOL:
+
+			/*
+			 * Booleans can't be compared on hive, so take the min or max of
+			 * their integer values and cast it back.
+			 */
+			appendStringInfo(buf, "CAST(%s(%sCAST(", mapping->remote_name,
+							 distinct);
+			hdfs_deparse_agg_arg(node,
+								 ((TargetEntry *) linitial(node->args))->expr,
+								 context);
+			appendStringInfoString(buf, " AS INT)) AS BOOLEAN)");
+			break;
+
+		case HDFS_AGG_STRING:
+			{
+				Expr	   *value = ((TargetEntry *) linitial(node->args))->expr;
+				Expr	   *delim = ((TargetEntry *) lsecond(node->args))->expr;
+
+				/*
+				 * concat_ws() returns an empty string for an empty list,
+				 * where string_agg() returns NULL.  collect_list() skips NULL
+				 * values, like string_agg() does.  An ORDER BY allowed by
+				 * hdfs_is_agg_order_pushable() sorts the collected values.
+				 */
+				appendStringInfo(buf, "CASE WHEN count(%s", distinct);
+				hdfs_deparse_agg_arg(node, value, context);
+				appendStringInfoString(buf, ") = 0 THEN NULL ELSE concat_ws(");
+				hdfs_deparse_expr(delim, context);
+				appendStringInfo(buf, ", %s%s(CAST(",
+								 node->aggorder ? "sort_array(" : "",
+								 node->aggdistinct ? "collect_set" :
+								 mapping->remote_name);
+				hdfs_deparse_agg_arg(node, value, context);
+				appendStringInfo(buf, " AS STRING))%s) END",
+								 node->aggorder ? ")" : "");
+			}
+			break;
+
+		case HDFS_AGG_PERCENTILE:
+			{
+				Expr	   *value = hdfs_get_percentile_integral_arg(node);
+				Const	   *fraction = (Const *) linitial(node->aggdirectargs);
+
+				/* Exact for integers, as percentile_cont() interpolates too */
+				if (value)
+				{
+					appendStringInfoString(buf, "percentile(CAST(");
+					hdfs_deparse_agg_arg(node, value, context);
+					appendStringInfoString(buf, " AS BIGINT), ");
+				}
+				else
+				{
+					appendStringInfo(buf, "%s(", mapping->remote_name);
+					hdfs_deparse_agg_arg(node,
+										 ((TargetEntry *) linitial(node->args))->expr,
+										 context);
+					appendStringInfoString(buf, ", ");
+				}
+
+				/*
+				 * Hive wants the fraction as a constant double, which a cast
+				 * isn't for the argument checks, so print the bare number.
+				 */
+				if (IsA(fraction, Const) && !fraction->constisnull)
+				{
+					char	   *extval;
+
+					extval = DatumGetCString(DirectFunctionCall1(float8out,
+																 fraction->constvalue));
+					appendStringInfoString(buf, extval);
+					if (strpbrk(extval, ".e") == NULL)
+						appendStringInfoString(buf, ".0");
+				}
+				else
+					hdfs_deparse_expr((Expr *) fraction, context);
+				appendStringInfoChar(buf, ')');
+			}
+			break;
+	}
+}
+
+/*
+ * hdfs_get_window_clause
+ * 		Find the window clause of the given winref.
+ */
+static WindowClause *
+hdfs_get_window_clause(PlannerInfo *root, Index winref)
 {
-	appendStringInfoChar(context->buf, '?');
+	ListCell   *lc;
+
+	foreach(lc, root->parse->windowClause)
+	{
+		WindowClause *wc = (WindowClause *) lfirst(lc);
+
+		if (wc->winref == winref)
+			return wc;
+	}
+
+	elog(ERROR, "could not find window clause for winref %u", winref);
+	return NULL;				/* keep compiler quiet */
 }
 
 /*
- * Print the representation of a placeholder for a parameter that will be
- * sent to the remote side at execution time.
- *
- * This is used when we're just trying to EXPLAIN the remote query.
- * We don't have the actual value of the runtime parameter yet, and we don't
- * want the remote planner to generate a plan that depends on such a value
- * anyway.  Thus, we can't do something simple like "$1::paramtype".
- * Instead, we emit "((SELECT null::paramtype)::paramtype)".
- * In all extant versions of Postgres, the planner will see that as an unknown
- * constant value, which is what we want.  This might need adjustment if we
- * ever make the planner flatten scalar subqueries.  Note: the reason for the
- * apparently useless outer cast is to ensure that the representation as a
- * whole will be parsed as an a_expr and not a select_with_parens; the latter
- * would do the wrong thing in the context "x = ANY(...)".
+ * hdfs_get_window_func_mapping
+ * 		Find the given window function, which is not an aggregate, in the
+ * 		pushable ones.  NULL if it's not there.
  */
-static void
-hdfs_print_remote_placeholder(deparse_expr_cxt *context)
+static const hdfsWindowFuncMapping *
+hdfs_get_window_func_mapping(Oid winfnoid)
 {
-	appendStringInfoString(context->buf, "(SELECT null)");
+	const hdfsWindowFuncMapping *mapping;
+	char	   *func_name = get_func_name(winfnoid);
+
+	for (mapping = hdfs_window_func_mappings; mapping->name; mapping++)
+	{
+		if (strcmp(mapping->name, func_name) == 0)
+			return mapping;
+	}
+
+	return NULL;
 }
 
 /*
- * hdfs_is_subquery_var
+ * hdfs_is_window_func_pushable
+ * 		Check that hive/spark compute the given window function, over its
+ * 		window, as PostgreSQL does.
  *
- * Returns true if given Var is deparsed as a subquery output column, in
- * which case, *relno and *colno are set to the IDs for the relation and
- * column alias to the Var provided by the subquery.
+ * Window functions are only computed remotely by the foreign scan of a
+ * window relation, directly over the scan or join.
  */
 static bool
-hdfs_is_subquery_var(Var *node, RelOptInfo *foreignrel, int *relno, int *colno,
-					 deparse_expr_cxt *context)
+hdfs_is_window_func_pushable(WindowFunc *wf, foreign_glob_cxt *glob_cxt)
 {
-	HDFSFdwRelationInfo *fpinfo = (HDFSFdwRelationInfo *) foreignrel->fdw_private;
-	RelOptInfo *outerrel = fpinfo->outerrel;
-	RelOptInfo *innerrel = fpinfo->innerrel;
-
-	/* Should only be called in these cases. */
-	Assert(IS_SIMPLE_REL(foreignrel) || IS_JOIN_REL(foreignrel) ||
-		   IS_UPPER_REL(foreignrel));
+	RelOptInfo *foreignrel = glob_cxt->foreignrel;
+	WindowClause *wc;
+	int			nargs = list_length(wf->args);
+	bool		uses_frame;
+	ListCell   *lc;
+	foreign_loc_cxt loc_cxt;
 
-	/*
-	 * If the given relation isn't a join relation, it doesn't have any lower
-	 * subqueries, so the Var isn't a subquery output column.
-	 */
-	if (!IS_JOIN_REL(foreignrel))
+	if (!IS_UPPER_REL(foreignrel) ||
+		((HDFSFdwRelationInfo *) foreignrel->fdw_private)->stage !=
+		UPPERREL_WINDOW)
 		return false;
 
-	/*
-	 * If the Var doesn't belong to any lower subqueries, it isn't a subquery
-	 * output column.
-	 */
-	if (!bms_is_member(node->varno, fpinfo->lower_subquery_rels))
+	/* FILTER is only for aggregates, which hive doesn't have either */
+	if (wf->aggfilter)
 		return false;
 
-	if (bms_is_member(node->varno, outerrel->relids))
+	wc = hdfs_get_window_clause(glob_cxt->root, wf->winref);
+
+	if (wf->winagg)
 	{
+		const hdfsAggMapping *mapping = hdfs_get_agg_mapping(wf->winfnoid,
+															 nargs);
+
+		/* Same aggregates as without a window */
+		if (mapping == NULL || mapping->kind != HDFS_AGG_PLAIN ||
+			mapping->float_only)
+			return false;
+
 		/*
-		 * If outer relation is deparsed as a subquery, the Var is an output
-		 * column of the subquery; get the IDs for the relation/column alias.
+		 * PostgreSQL returns a numeric for avg, and for sum over a bigint,
+		 * where hive returns a double or a bigint, so the results would
+		 * differ.
 		 */
-		if (fpinfo->make_outerrel_subquery)
-		{
-			hdfs_get_relation_column_alias_ids(node, outerrel, relno, colno,
-											   context);
-			return true;
-		}
+		if (wf->wintype == NUMERICOID)
+			return false;
 
-		/* Otherwise, recurse into the outer relation. */
-		return hdfs_is_subquery_var(node, outerrel, relno, colno, context);
+		uses_frame = true;
 	}
 	else
 	{
-		Assert(bms_is_member(node->varno, innerrel->relids));
+		const hdfsWindowFuncMapping *mapping;
 
-		/*
-		 * If inner relation is deparsed as a subquery, the Var is an output
-		 * column of the subquery; get the IDs for the relation/column alias.
-		 */
-		if (fpinfo->make_innerrel_subquery)
+		mapping = hdfs_get_window_func_mapping(wf->winfnoid);
+		if (mapping == NULL ||
+			nargs < mapping->min_args || nargs > mapping->max_args)
+			return false;
+
+		if (mapping->needs_order && wc->orderClause == NIL)
+			return false;
+
+		/* Hive takes constants only for the offset and the default */
+		if (strcmp(mapping->name, "ntile") == 0)
 		{
-			hdfs_get_relation_column_alias_ids(node, innerrel, relno, colno,
-											   context);
-			return true;
+			if (!IsA(linitial(wf->args), Const))
+				return false;
+		}
+		else if (nargs > 1)
+		{
+			for_each_cell(lc, wf->args, list_second_cell(wf->args))
+			{
+				if (!IsA(lfirst(lc), Const))
+					return false;
+			}
 		}
 
-		/* Otherwise, recurse into the inner relation. */
-		return hdfs_is_subquery_var(node, innerrel, relno, colno, context);
+		uses_frame = mapping->uses_frame;
+	}
+
+	/*
+	 * Other functions ignore the frame, and the frame is not deparsed for
+	 * them.
+	 */
+	if (uses_frame && !hdfs_is_window_frame_pushable(wc))
+		return false;
+
+	/* The partitioning and ordering expressions must be pushable too. */
+	loc_cxt.collation = InvalidOid;
+	loc_cxt.state = FDW_COLLATE_NONE;
+	foreach(lc, wc->partitionClause)
+	{
+		SortGroupClause *sgc = (SortGroupClause *) lfirst(lc);
+		Node	   *expr = get_sortgroupclause_expr(sgc,
+													glob_cxt->root->processed_tlist);
+
+		if (!hdfs_foreign_expr_walker(expr, glob_cxt, &loc_cxt))
+			return false;
+	}
+
+	foreach(lc, wc->orderClause)
+	{
+		SortGroupClause *sgc = (SortGroupClause *) lfirst(lc);
+		Node	   *expr = get_sortgroupclause_expr(sgc,
+													glob_cxt->root->processed_tlist);
+		TypeCacheEntry *typentry;
+
+		if (!hdfs_foreign_expr_walker(expr, glob_cxt, &loc_cxt))
+			return false;
+
+		/* Only the default ordering of the type, as for ORDER BY */
+		typentry = lookup_type_cache(exprType(expr),
+									 TYPECACHE_LT_OPR | TYPECACHE_GT_OPR);
+		if (sgc->sortop != typentry->lt_opr &&
+			sgc->sortop != typentry->gt_opr)
+			return false;
+
+		if (!hdfs_is_nulls_order_pushable(hdfs_get_rel_dialect(foreignrel),
+										  sgc->sortop == typentry->lt_opr ?
+										  "ASC" : "DESC",
+										  sgc->nulls_first))
+			return false;
 	}
+
+	return true;
 }
 
 /*
- * hdfs_get_relation_column_alias_ids
+ * hdfs_is_window_frame_pushable
+ * 		Check that hive supports the frame of the given window clause.
  *
- * Get the IDs for the relation and column alias to given Var belonging to
- * given relation, which are returned into *relno and *colno.
+ * That is a ROWS frame, or a RANGE frame without offsets, and no EXCLUDE.
+ */
+static bool
+hdfs_is_window_frame_pushable(WindowClause *wc)
+{
+	int			options = wc->frameOptions;
+
+	/* The default frame is the same on hive */
+	if (!(options & FRAMEOPTION_NONDEFAULT))
+		return true;
+
+	if (options & (FRAMEOPTION_GROUPS | FRAMEOPTION_EXCLUSION))
+		return false;
+
+	if (options & FRAMEOPTION_RANGE)
+		return !(options & (FRAMEOPTION_START_OFFSET | FRAMEOPTION_END_OFFSET));
+
+	/* Offsets of a ROWS frame must be non-negative constants. */
+	if ((options & FRAMEOPTION_START_OFFSET) &&
+		(!IsA(wc->startOffset, Const) ||
+		 ((Const *) wc->startOffset)->constisnull ||
+		 DatumGetInt64(((Const *) wc->startOffset)->constvalue) < 0))
+		return false;
+
+	if ((options & FRAMEOPTION_END_OFFSET) &&
+		(!IsA(wc->endOffset, Const) ||
+		 ((Const *) wc->endOffset)->constisnull ||
+		 DatumGetInt64(((Const *) wc->endOffset)->constvalue) < 0))
+		return false;
+
+	return true;
+}
+
+/*
+ * hdfs_deparse_window_func
+ *		Deparse a WindowFunc node, with its window inline.
  */
 static void
-hdfs_get_relation_column_alias_ids(Var *node, RelOptInfo *foreignrel,
-								   int *relno, int *colno,
-								   deparse_expr_cxt *context)
+hdfs_deparse_window_func(WindowFunc *node, deparse_expr_cxt *context)
 {
-	HDFSFdwRelationInfo *fpinfo = (HDFSFdwRelationInfo *) foreignrel->fdw_private;
-	int			i;
+	StringInfo	buf = context->buf;
+	PlannerInfo *root = context->root;
+	WindowClause *wc = hdfs_get_window_clause(root, node->winref);
 	ListCell   *lc;
-	List	   *scan_var_list = NIL;
-	List	   *whole_row_lists = NIL;
-
-	scan_var_list = pull_var_clause((Node *) foreignrel->reltarget->exprs,
-									PVC_RECURSE_PLACEHOLDERS);
+	bool		first;
 
-	scan_var_list = hdfs_adjust_whole_row_ref(context->root, scan_var_list,
-											  &whole_row_lists,
-											  foreignrel->relids);
-	/* Get the relation alias ID */
-	*relno = fpinfo->relation_index;
+	appendStringInfo(buf, "%s(", get_func_name(node->winfnoid));
+	if (node->winstar)
+		appendStringInfoChar(buf, '*');
+	else
+	{
+		first = true;
+		foreach(lc, node->args)
+		{
+			if (!first)
+				appendStringInfoString(buf, ", ");
+			first = false;
+			hdfs_deparse_expr((Expr *) lfirst(lc), context);
+		}
+	}
+	appendStringInfoString(buf, ") OVER (");
 
-	/* Get the column alias ID */
-	i = 1;
-	foreach(lc, scan_var_list)
+	if (wc->partitionClause)
 	{
-#if PG_VERSION_NUM >= 160000
-		Var		   *tlvar = (Var *) lfirst(lc);
+		appendStringInfoString(buf, "PARTITION BY ");
+		first = true;
+		foreach(lc, wc->partitionClause)
+		{
+			SortGroupClause *sgc = (SortGroupClause *) lfirst(lc);
 
-		/*
-		 * Match reltarget entries only on varno/varattno.  Ideally there
-		 * would be some cross-check on varnullingrels, but it's unclear what
-		 * to do exactly; we don't have enough context to know what that value
-		 * should be.
-		 */
-		if (IsA(tlvar, Var) &&
-			tlvar->varno == node->varno &&
-			tlvar->varattno == node->varattno)
-#else
-		if (equal(lfirst(lc), (Node *) node))
-#endif
+			if (!first)
+				appendStringInfoString(buf, ", ");
+			first = false;
+			hdfs_deparse_expr((Expr *) get_sortgroupclause_expr(sgc,
+																root->processed_tlist),
+							  context);
+		}
+	}
+
+	if (wc->orderClause)
+	{
+		appendStringInfoString(buf, wc->partitionClause ? " ORDER BY " :
+							   "ORDER BY ");
+		first = true;
+		foreach(lc, wc->orderClause)
 		{
-			*colno = i;
-			return;
+			SortGroupClause *sgc = (SortGroupClause *) lfirst(lc);
+			Expr	   *expr = (Expr *) get_sortgroupclause_expr(sgc,
+																 root->processed_tlist);
+			TypeCacheEntry *typentry;
+
+			if (!first)
+				appendStringInfoString(buf, ", ");
+			first = false;
+			hdfs_deparse_expr(expr, context);
+
+			typentry = lookup_type_cache(exprType((Node *) expr),
+										 TYPECACHE_LT_OPR | TYPECACHE_GT_OPR);
+			hdfs_append_orderby_suffix(sgc->sortop == typentry->lt_opr ?
+									   "ASC" : "DESC",
+									   exprType((Node *) expr),
+									   sgc->nulls_first, context);
 		}
-		i++;
 	}
 
-	/* Shouldn't get here */
-	elog(ERROR, "unexpected expression in subquery output");
+	/* Only for the functions it applies to, see above */
+	if ((wc->frameOptions & FRAMEOPTION_NONDEFAULT) &&
+		(node->winagg ||
+		 hdfs_get_window_func_mapping(node->winfnoid)->uses_frame))
+		hdfs_deparse_window_frame(wc, context);
+
+	appendStringInfoChar(buf, ')');
 }
 
 /*
- * hdfs_deparse_aggref
- *		Deparse an Aggref node.
+ * hdfs_deparse_window_frame
+ *		Deparse the frame of a window clause.
  */
 static void
-hdfs_deparse_aggref(Aggref *node, deparse_expr_cxt *context)
+hdfs_deparse_window_frame(WindowClause *wc, deparse_expr_cxt *context)
 {
 	StringInfo	buf = context->buf;
-	bool		use_variadic;
+	int			options = wc->frameOptions;
+
+	if (wc->partitionClause || wc->orderClause)
+		appendStringInfoChar(buf, ' ');
 
-	/* Only basic, non-split aggregation accepted. */
-	Assert(node->aggsplit == AGGSPLIT_SIMPLE);
+	appendStringInfoString(buf, (options & FRAMEOPTION_RANGE) ?
+						   "RANGE BETWEEN " : "ROWS BETWEEN ");
 
-	/* Find aggregate name from aggfnoid which is a pg_proc entry. */
-	hdfs_append_function_name(node->aggfnoid, context);
-	appendStringInfoChar(buf, '(');
+	if (options & FRAMEOPTION_START_UNBOUNDED_PRECEDING)
+		appendStringInfoString(buf, "UNBOUNDED PRECEDING");
+	else if (options & FRAMEOPTION_START_CURRENT_ROW)
+		appendStringInfoString(buf, "CURRENT ROW");
+	else
+		appendStringInfo(buf, INT64_FORMAT " %s",
+						 DatumGetInt64(((Const *) wc->startOffset)->constvalue),
+						 (options & FRAMEOPTION_START_OFFSET_PRECEDING) ?
+						 "PRECEDING" : "FOLLOWING");
 
-	/* Add DISTINCT */
-	appendStringInfoString(buf, (node->aggdistinct != NIL) ? "DISTINCT " : "");
+	appendStringInfoString(buf, " AND ");
 
-	/* aggstar can be set only in zero-argument aggregates. */
-	if (node->aggstar)
-		appendStringInfoChar(buf, '*');
+	if (options & FRAMEOPTION_END_UNBOUNDED_FOLLOWING)
+		appendStringInfoString(buf, "UNBOUNDED FOLLOWING");
+	else if (options & FRAMEOPTION_END_CURRENT_ROW)
+		appendStringInfoString(buf, "CURRENT ROW");
 	else
-	{
-		ListCell   *arg;
-		bool		first = true;
+		appendStringInfo(buf, INT64_FORMAT " %s",
+						 DatumGetInt64(((Const *) wc->endOffset)->constvalue),
+						 (options & FRAMEOPTION_END_OFFSET_PRECEDING) ?
+						 "PRECEDING" : "FOLLOWING");
+}
 
-		/* Add all the arguments. */
-		foreach(arg, node->args)
-		{
-			TargetEntry *tle = (TargetEntry *) lfirst(arg);
-			Node	   *n = (Node *) tle->expr;
+/*
+ * hdfs_get_grouping_sets
+ * 		Expand the grouping sets of the query into lists of sortgrouprefs.
+ */
+List *
+hdfs_get_grouping_sets(Query *query)
+{
+#if PG_VERSION_NUM >= 140000
+	return expand_grouping_sets(query->groupingSets, query->groupDistinct,
+								-1);
+#else
+	return expand_grouping_sets(query->groupingSets, -1);
+#endif
+}
 
-			if (tle->resjunk)
-				continue;
+/*
+ * hdfs_deparse_grouping_func
+ *		Deparse a GROUPING() function.
+ *
+ * Hive's grouping() takes a single expression, and its grouping__id numbers
+ * the sets differently across versions, so the bit mask is computed from
+ * grouping() of each argument, leftmost being the most significant bit.
+ */
+static void
+hdfs_deparse_grouping_func(GroupingFunc *node, deparse_expr_cxt *context)
+{
+	StringInfo	buf = context->buf;
+	ListCell   *lc;
+	int			bit = list_length(node->args);
 
-			if (!first)
-				appendStringInfoString(buf, ", ");
-			first = false;
+	if (bit > 1)
+		appendStringInfoChar(buf, '(');
+
+	foreach(lc, node->args)
+	{
+		Expr	   *arg = (Expr *) lfirst(lc);
 
-			hdfs_deparse_expr((Expr *) n, context);
+		bit--;
+		if (lc != list_head(node->args))
+			appendStringInfoString(buf, " + ");
+
+		appendStringInfoString(buf, "grouping(");
+		if (IsA(arg, Var) || IsA(arg, Const))
+			hdfs_deparse_expr(arg, context);
+		else
+		{
+			appendStringInfoChar(buf, '(');
+			hdfs_deparse_expr(arg, context);
+			appendStringInfoChar(buf, ')');
 		}
+		appendStringInfoChar(buf, ')');
+
+		if (bit > 0)
+			appendStringInfo(buf, " * %d", 1 << bit);
 	}
 
-	appendStringInfoChar(buf, ')');
+	if (list_length(node->args) > 1)
+		appendStringInfoChar(buf, ')');
 }
 
 /*
@@ -2154,11 +5043,9 @@ hdfs_append_groupby_clause(List *tlist, deparse_expr_cxt *context)
 	appendStringInfoString(buf, " GROUP BY ");
 
 	/*
-	 * Queries with grouping sets are not pushed down, so we don't expect
-	 * grouping sets here.
+	 * With grouping sets, groupClause holds all the grouping expressions,
+	 * which hive requires in the GROUP BY list too.
 	 */
-	Assert(!query->groupingSets);
-
 	foreach(lc, query->groupClause)
 	{
 		SortGroupClause *grp = (SortGroupClause *) lfirst(lc);
@@ -2170,6 +5057,40 @@ hdfs_append_groupby_clause(List *tlist, deparse_expr_cxt *context)
 		hdfs_deparse_sort_group_clause(grp->tleSortGroupRef, tlist,
 									   context);
 	}
+
+	if (query->groupingSets)
+	{
+		List	   *sets;
+		ListCell   *lc2;
+
+		/* ROLLUP and CUBE are spelled out as the sets they stand for. */
+		sets = hdfs_get_grouping_sets(query);
+
+		appendStringInfoString(buf, " GROUPING SETS (");
+		first = true;
+		foreach(lc, sets)
+		{
+			List	   *set = (List *) lfirst(lc);
+			bool		first_item = true;
+
+			if (!first)
+				appendStringInfoString(buf, ", ");
+			first = false;
+
+			appendStringInfoChar(buf, '(');
+			foreach(lc2, set)
+			{
+				if (!first_item)
+					appendStringInfoString(buf, ", ");
+				first_item = false;
+
+				hdfs_deparse_sort_group_clause(lfirst_int(lc2), tlist,
+											   context);
+			}
+			appendStringInfoChar(buf, ')');
+		}
+		appendStringInfoChar(buf, ')');
+	}
 }
 
 /*
@@ -2189,12 +5110,18 @@ hdfs_deparse_sort_group_clause(Index ref, List *tlist,
 
 	if (expr && IsA(expr, Const))
 	{
+		Const	   *c = (Const *) expr;
+
 		/*
 		 * Force a typecast here so that we don't emit something like "GROUP
 		 * BY 2", which will be misconstrued as a column position rather than
-		 * a constant.
+		 * a constant.  The literals of the other types don't look like one.
 		 */
-		hdfs_deparse_const((Const *) expr, context);
+		if (!c->constisnull && c->consttype == INT4OID)
+			appendStringInfo(buf, "CAST(%d AS INT)",
+							 DatumGetInt32(c->constvalue));
+		else
+			hdfs_deparse_const(c, context);
 	}
 	else if (!expr || IsA(expr, Var))
 		hdfs_deparse_expr(expr, context);
@@ -2326,7 +5253,7 @@ hdfs_append_orderby_clause(List *pathkeys, bool has_final_sort,
  * 		Deparse LIMIT OFFSET clause.
  */
 static void
-hdfs_append_limit_clause(deparse_expr_cxt *context, CLIENT_TYPE client_type)
+hdfs_append_limit_clause(deparse_expr_cxt *context, hdfs_dialect *dialect)
 {
 	PlannerInfo *root = context->root;
 	Const	   *c = (Const *) root->parse->limitOffset;
@@ -2339,7 +5266,7 @@ hdfs_append_limit_clause(deparse_expr_cxt *context, CLIENT_TYPE client_type)
 	{
 		appendStringInfoString(buf, " LIMIT ");
 
-		if (client_type == HIVESERVER2 && is_valid_offset)
+		if (dialect->client_type == HIVESERVER2 && is_valid_offset)
 		{
 			hdfs_deparse_expr((Expr *) c, context);
 			appendStringInfoString(buf, ", ");
@@ -2348,7 +5275,7 @@ hdfs_append_limit_clause(deparse_expr_cxt *context, CLIENT_TYPE client_type)
 		hdfs_deparse_expr((Expr *) root->parse->limitCount, context);
 	}
 
-	if (client_type == SPARKSERVER && is_valid_offset)
+	if (dialect->client_type == SPARKSERVER && is_valid_offset)
 	{
 		appendStringInfoString(buf, " OFFSET ");
 		hdfs_deparse_expr((Expr *) c, context);
@@ -2369,12 +5296,35 @@ hdfs_append_orderby_suffix(const char *sortby_dir, Oid sortcoltype,
 	Assert(sortby_dir != NULL);
 	appendStringInfo(buf, " %s", sortby_dir);
 
+	/* Otherwise the NULLs are where they're wanted anyway, see below */
+	if (!hdfs_get_rel_dialect(context->foreignrel)->nulls_ordering)
+		return;
+
 	if (nulls_first)
 		appendStringInfoString(buf, " NULLS FIRST");
 	else
 		appendStringInfoString(buf, " NULLS LAST");
 }
 
+/*
+ * hdfs_is_nulls_order_pushable
+ *		Check that the remote server puts the NULLs of a sort where asked,
+ *		either as told by NULLS FIRST/LAST, or by default for the servers not
+ *		knowing these.
+ *
+ * By default, hive and spark put the NULLs first in ascending order and last
+ * in descending order, unlike PostgreSQL.
+ */
+bool
+hdfs_is_nulls_order_pushable(hdfs_dialect *dialect, const char *sortby_dir,
+							 bool nulls_first)
+{
+	if (dialect->nulls_ordering)
+		return true;
+
+	return nulls_first == (strcmp(sortby_dir, "ASC") == 0);
+}
+
 /*
  * hdfs_is_foreign_pathkey
  *		Returns true if it's safe to push down the sort expression described by
@@ -2386,6 +5336,7 @@ hdfs_is_foreign_pathkey(PlannerInfo *root, RelOptInfo *baserel,
 {
 	EquivalenceMember *em = NULL;
 	EquivalenceClass *pathkey_ec = pathkey->pk_eclass;
+	const char *sortby_dir;
 
 	/*
 	 * hdfs_is_foreign_expr would detect volatile expressions as well, but
@@ -2397,8 +5348,10 @@ hdfs_is_foreign_pathkey(PlannerInfo *root, RelOptInfo *baserel,
 	/* can push if a suitable EC member exists */
 	em = hdfs_find_em_for_rel(root, pathkey_ec, baserel);
 
-	if (hdfs_get_sortby_direction_string(em, pathkey) == NULL)
+	sortby_dir = hdfs_get_sortby_direction_string(em, pathkey);
+	if (sortby_dir == NULL)
 		return false;
 
-	return true;
+	return hdfs_is_nulls_order_pushable(hdfs_get_rel_dialect(baserel),
+										sortby_dir, pathkey->pk_nulls_first);
 }
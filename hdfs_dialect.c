@@ -0,0 +1,214 @@
+/*-------------------------------------------------------------------------
+ *
+ * hdfs_dialect.c
+ * 		Capabilities of the remote servers, depending on their kind and
+ * 		version.
+ *
+ * The version of a server is given by its server_version option, or else
+ * asked to the server through the JDBC DatabaseMetaData of the first
+ * connection opened to it, and remembered by this backend until the server
+ * is altered.  As long as it's unknown, the SQL sent to the server is the one
+ * hdfs_fdw has always sent.
+ *
+ * Portions Copyright (c) 2012-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 2004-2025, EnterpriseDB Corporation.
+ *
+ * IDENTIFICATION
+ * 		hdfs_dialect.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <ctype.h>
+
+#include "hdfs_fdw.h"
+#include "utils/hsearch.h"
+#include "utils/inval.h"
+#include "utils/memutils.h"
+#include "utils/syscache.h"
+
+/* Version number of major.minor.patch */
+#define HDFS_VERSION(major, minor, patch) \
+	((major) * 10000 + (minor) * 100 + (patch))
+
+/* Probed version of a foreign server, 0 if the server couldn't tell. */
+typedef struct hdfsVersionEntry
+{
+	Oid			serverid;		/* hash key, must be first */
+	int			server_version;
+} hdfsVersionEntry;
+
+static HTAB *hdfs_version_cache = NULL;
+
+static void hdfs_init_version_cache(void);
+static void hdfs_invalidate_versions(Datum arg, int cacheid,
+									 uint32 hashvalue);
+
+/*
+ * hdfs_init_version_cache
+ * 		Create the cache of the probed server versions, which is reset when
+ * 		any foreign server changes, as its host or port may have.
+ */
+static void
+hdfs_init_version_cache(void)
+{
+	HASHCTL		ctl;
+
+	ctl.keysize = sizeof(Oid);
+	ctl.entrysize = sizeof(hdfsVersionEntry);
+	hdfs_version_cache = hash_create("hdfs_fdw server versions", 8, &ctl,
+									 HASH_ELEM | HASH_BLOBS);
+
+	CacheRegisterSyscacheCallback(FOREIGNSERVEROID, hdfs_invalidate_versions,
+								  (Datum) 0);
+}
+
+/*
+ * hdfs_invalidate_versions
+ * 		Forget all the probed server versions.
+ */
+static void
+hdfs_invalidate_versions(Datum arg, int cacheid, uint32 hashvalue)
+{
+	HASH_SEQ_STATUS status;
+	hdfsVersionEntry *entry;
+
+	hash_seq_init(&status, hdfs_version_cache);
+	while ((entry = (hdfsVersionEntry *) hash_seq_search(&status)) != NULL)
+		hash_search(hdfs_version_cache, &entry->serverid, HASH_REMOVE, NULL);
+}
+
+/*
+ * hdfs_parse_server_version
+ * 		Convert a version string like "3.1.3" into a number like 30103, or
+ * 		return 0 if it doesn't start with a version.
+ *
+ * Distributions append their own suffixes, like "3.1.3000.7.1.7.0-551",
+ * which are ignored, along with a patch level above 99.
+ */
+int
+hdfs_parse_server_version(const char *str)
+{
+	int			parts[3] = {0, 0, 0};
+	int			nparts = 0;
+	const char *p = str;
+
+	while (nparts < 3 && isdigit((unsigned char) *p))
+	{
+		long		part = strtol(p, (char **) &p, 10);
+
+		parts[nparts++] = (int) Min(part, 99);
+		if (*p != '.')
+			break;
+		p++;
+	}
+
+	if (nparts < 2)
+		return 0;
+
+	return HDFS_VERSION(parts[0], parts[1], parts[2]);
+}
+
+/*
+ * hdfs_probe_server_version
+ * 		Ask the server of a new connection for its version, unless it's given
+ * 		by the options or already known.
+ */
+void
+hdfs_probe_server_version(int con_index, ForeignServer *server,
+						  hdfs_opt *opt)
+{
+	hdfsVersionEntry *entry;
+	bool		found;
+	char	   *version = NULL;
+	char	   *err_buf = "unknown";
+
+	if (opt->server_version > 0)
+		return;
+
+	if (hdfs_version_cache == NULL)
+		hdfs_init_version_cache();
+
+	entry = (hdfsVersionEntry *) hash_search(hdfs_version_cache,
+											 &server->serverid, HASH_ENTER,
+											 &found);
+	if (found)
+		return;
+
+	/* An older driver not telling its version is no reason to fail. */
+	entry->server_version = 0;
+	if (DBGetServerVersion(con_index, &version, &err_buf) < 0)
+		ereport(DEBUG1,
+				(errmsg("hdfs_fdw: could not get the version of server \"%s\": %s",
+						server->servername, err_buf)));
+	else
+		entry->server_version = hdfs_parse_server_version(version);
+
+	ereport(DEBUG1,
+			(errmsg("hdfs_fdw: server \"%s\" has version %d",
+					server->servername, entry->server_version)));
+}
+
+/*
+ * hdfs_get_dialect
+ * 		Get the capabilities of the given server.
+ */
+hdfs_dialect *
+hdfs_get_dialect(Oid serverid, hdfs_opt *opt)
+{
+	hdfs_dialect *dialect = (hdfs_dialect *) palloc0(sizeof(hdfs_dialect));
+	int			version = opt->server_version;
+
+	if (version == 0 && hdfs_version_cache != NULL)
+	{
+		hdfsVersionEntry *entry;
+
+		entry = (hdfsVersionEntry *) hash_search(hdfs_version_cache,
+												 &serverid, HASH_FIND, NULL);
+		if (entry)
+			version = entry->server_version;
+	}
+
+	dialect->client_type = opt->client_type;
+	dialect->server_version = version;
+
+	/* Spark returns the result of ANALYZE TABLE as a result set. */
+	dialect->analyze_returns_rows = (opt->client_type == SPARKSERVER);
+
+	if (version == 0)
+	{
+		/*
+		 * Nothing that hdfs_fdw didn't use before the versions were known,
+		 * except grouping(), which the servers old enough not to tell their
+		 * version lack.
+		 */
+		dialect->limit_offset = true;
+		dialect->nulls_ordering = true;
+		dialect->window_functions = true;
+		dialect->grouping_function = false;
+		dialect->is_distinct_from = true;
+		dialect->interval_literals = false;
+	}
+	else if (opt->client_type == SPARKSERVER)
+	{
+		dialect->limit_offset = version >= HDFS_VERSION(3, 4, 0);
+		dialect->nulls_ordering = version >= HDFS_VERSION(2, 1, 0);
+		dialect->window_functions = version >= HDFS_VERSION(1, 4, 0);
+		dialect->grouping_function = version >= HDFS_VERSION(2, 0, 0);
+		dialect->is_distinct_from = version >= HDFS_VERSION(3, 0, 0);
+		dialect->interval_literals = version >= HDFS_VERSION(3, 0, 0);
+	}
+	else
+	{
+		dialect->limit_offset = version >= HDFS_VERSION(2, 0, 0);
+		dialect->nulls_ordering = version >= HDFS_VERSION(2, 1, 0);
+		dialect->window_functions = version >= HDFS_VERSION(0, 11, 0);
+		dialect->grouping_function = version >= HDFS_VERSION(2, 3, 0);
+		dialect->is_distinct_from = version >= HDFS_VERSION(3, 0, 0);
+		dialect->interval_literals = version >= HDFS_VERSION(1, 2, 0);
+	}
+
+	return dialect;
+}
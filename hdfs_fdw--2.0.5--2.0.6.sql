@@ -0,0 +1,9 @@
+/* hdfs_fdw/hdfs_fdw--2.0.5--2.0.6.sql */
+
+CREATE FUNCTION hdfs_fdw_snapshot(regclass)
+  RETURNS pg_catalog.int8 STRICT
+  AS 'MODULE_PATHNAME' LANGUAGE C;
+
+CREATE FUNCTION hdfs_fdw_drop_snapshot(regclass)
+  RETURNS pg_catalog.bool STRICT
+  AS 'MODULE_PATHNAME' LANGUAGE C;
@@ -0,0 +1,9 @@
+/* hdfs_fdw/hdfs_fdw--2.0.6--2.0.7.sql */
+
+CREATE FUNCTION hdfs_fdw_stage(regclass, text, pg_catalog.int4 DEFAULT 10000)
+  RETURNS pg_catalog.int8 STRICT
+  AS 'MODULE_PATHNAME' LANGUAGE C;
+
+CREATE FUNCTION hdfs_fdw_partition(regclass, text)
+  RETURNS pg_catalog.int4 STRICT
+  AS 'MODULE_PATHNAME' LANGUAGE C;
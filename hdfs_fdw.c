@@ -14,6 +14,8 @@
 
 #include "postgres.h"
 
+#include <math.h>
+
 #include "access/htup_details.h"
 #include "access/sysattr.h"
 #include "access/table.h"
@@ -30,6 +32,7 @@
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
 #include "nodes/nodeFuncs.h"
+#include "optimizer/cost.h"
 #include "optimizer/pathnode.h"
 #include "optimizer/paths.h"
 #include "optimizer/planmain.h"
@@ -37,33 +40,24 @@
 #include "optimizer/restrictinfo.h"
 #include "optimizer/tlist.h"
 #include "parser/parsetree.h"
+#include "portability/instr_time.h"
 #include "utils/builtins.h"
 #include "utils/guc.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/selfuncs.h"
+#include "utils/tuplestore.h"
 #include "utils/typcache.h"
 
 PG_MODULE_MAGIC;
 
-/* Default CPU cost to start up a foreign query. */
-#define DEFAULT_FDW_STARTUP_COST    100000.0
-
-/* Default CPU cost to process 1 row  */
-#define DEFAULT_FDW_TUPLE_COST      1000.0
-
 /*
  * In PG 9.5.1 the number will be 90501,
  * our version is 2.3.3 so number will be 20303
  */
 #define CODE_VERSION   20303
 
-/*
- * The number of rows in a foreign relation are estimated to be so less that
- * an in-memory sort on those many rows wouldn't cost noticeably higher than
- * the underlying scan. Hence for now, cost sorts same as underlying scans.
- */
-#define DEFAULT_HDFS_SORT_MULTIPLIER 1
+#define LOG2(x)  (log(x) / 0.693147180559945)
 
 /* GUC variables. */
 static bool enable_join_pushdown = true;
@@ -86,6 +80,32 @@ enum hdfsFdwScanPrivateIndex
 	/* Integer list of attribute numbers retrieved by the SELECT */
 	hdfsFdwScanPrivateRetrievedAttrs,
 
+	/*
+	 * Flag showing if the scan reads the local snapshot of the foreign table
+	 * (as an integer Value node).  The SELECT statement is then used only if
+	 * the snapshot was dropped after planning.
+	 */
+	hdfsFdwScanPrivateUseSnapshot,
+
+	/*
+	 * Runtime filter completing the SELECT statement before it's executed, as
+	 * planned by hdfs_plan_runtime_filter(), or NIL.
+	 */
+	hdfsFdwScanPrivateRuntimeFilter,
+
+	/*
+	 * Names of the partitioned tables read without any condition on their
+	 * partition columns (as a list of String nodes).
+	 */
+	hdfsFdwScanPrivateUnfilteredRels,
+
+	/*
+	 * Aggregates answered from the metadata of the remote table, as planned
+	 * by hdfs_plan_metadata_aggs(), or NIL.  The SELECT statement is then
+	 * used only if some of the statistics are missing.
+	 */
+	hdfsFdwScanPrivateMetadataAggs,
+
 	/*
 	 * String describing join i.e. names of relations being joined and types
 	 * of join, added when the scan is join.
@@ -147,12 +167,22 @@ typedef struct
 	bool	   *nulls;
 } hdfsWRState;
 
+/* Callback argument for hdfs_ec_member_matches_foreign */
+typedef struct
+{
+	Expr	   *current;		/* current expr, or NULL if not yet found */
+	List	   *already_used;	/* expressions already dealt with */
+} hdfs_ec_member_foreign_arg;
+
 typedef struct hdfsFdwExecutionState
 {
 	char	   *query;
 	MemoryContext batch_cxt;
 	bool		query_executed;
-	int			con_index;
+	int			con_index;		/* -1 until connected */
+	bool		query_prepared;
+	Oid			relid;			/* foreign table whose options are used */
+	hdfs_opt   *opt;
 	Relation	rel;			/* relcache entry for the foreign table */
 	List	   *retrieved_attrs;	/* list of retrieved attribute numbers */
 
@@ -160,10 +190,60 @@ typedef struct hdfsFdwExecutionState
 	int			numParams;		/* number of parameters passed to query */
 	List	   *param_exprs;	/* executable expressions for param values */
 	Oid		   *param_types;	/* type of query parameters */
+	Datum	   *param_values;	/* values of query parameters */
+	bool	   *param_nulls;	/* null flags of query parameters */
 
 	int			rescan_count;	/* number of times a foreign scan is restarted */
 	AttInMetadata *attinmeta;
 
+	/*
+	 * Rows of the current remote execution, kept when the scan may be
+	 * rescanned without any change of parameters, so that rescans can be
+	 * served locally instead of running the remote query again.
+	 */
+	Tuplestorestate *spool;		/* NULL if rows are not spooled */
+	TupleTableSlot *spool_slot; /* slot to read spooled rows into */
+	bool		spool_complete; /* does spool hold the whole result? */
+	bool		spool_replay;	/* are we returning rows from the spool? */
+
+	/* Local snapshot read instead of running the remote query, if any. */
+	hdfsSnapshotScan *snapshot;
+	TupleTableSlot *snapshot_slot;	/* slot to read snapshot rows into */
+
+	/*
+	 * Result cache, used if result_cache_ttl is set for all the foreign
+	 * tables read by the remote query.
+	 */
+	int			cache_ttl;		/* 0 if the result is not cached */
+	bool		cache_validate; /* check transient_lastDdlTime? */
+	List	   *cache_relids;	/* foreign tables read by the query */
+	hdfsCacheFile *cache_file;	/* result being read or written, if any */
+	bool		cache_hit;		/* is cache_file being read? */
+	TupleTableSlot *cache_slot; /* slot to read cached rows into */
+	uint64		cache_hits;
+	uint64		cache_misses;
+
+	/* Aggregates answered from the metadata of the remote table, if any. */
+	List	   *metadata_aggs;
+	bool		metadata_done;	/* was the row of aggregates returned? */
+
+	/* Runtime filter not applied to the query yet, if any. */
+	List	   *runtime_filter;
+	int64		runtime_filter_keys;	/* -1 if the filter wasn't applied */
+
+	/*
+	 * Timings of the current remote execution, folded into the per-server
+	 * statistics kept by hdfs_costs.c once the execution is over.
+	 */
+	Oid			serverid;		/* foreign server the query runs on */
+	Oid			userid;			/* user whose mapping the scan uses */
+	instr_time	exec_start;		/* when the query was sent */
+	bool		first_fetch_done;	/* has the first fetch returned? */
+	double		startup_ms;		/* time to the first row */
+	instr_time	fetch_time;		/* time spent fetching further rows */
+	uint64		rows_fetched;	/* number of rows fetched so far */
+	bool		timing_reported;	/* already handed to hdfs_costs.c? */
+
 	/*
 	 * Members used for constructing the ForeignScan result row when whole-row
 	 * references are involved in a pushed down join.
@@ -232,16 +312,39 @@ static void prepare_query_params(PlanState *node,
 								 List *fdw_exprs,
 								 List **param_exprs,
 								 Oid **param_types);
+static void hdfs_eval_query_params(ExprContext *econtext,
+								   List *param_exprs,
+								   Datum *param_values,
+								   bool *param_nulls);
 static void process_query_params(int index,
-								 ExprContext *econtext,
-								 List *param_exprs,
-								 Oid *param_types);
+								 int numParams,
+								 Oid *param_types,
+								 Datum *param_values,
+								 bool *param_nulls);
 static int	GetConnection(hdfs_opt *opt, Oid foreigntableid);
+static void hdfs_report_scan_timing(hdfsFdwExecutionState *festate);
+static void hdfs_setup_result_cache(ForeignScanState *node,
+									hdfsFdwExecutionState *festate);
+static void hdfs_start_remote_query(ForeignScanState *node,
+									hdfsFdwExecutionState *festate);
+static void hdfs_end_remote_query(hdfsFdwExecutionState *festate);
+static bool hdfs_is_param_clause_safe(PlannerInfo *root, RelOptInfo *baserel,
+									  Expr *clause);
+static void hdfs_add_param_path(PlannerInfo *root, RelOptInfo *baserel,
+								RestrictInfo *rinfo, List **ppi_list);
+static bool hdfs_ec_member_matches_foreign(PlannerInfo *root,
+										   RelOptInfo *rel,
+										   EquivalenceClass *ec,
+										   EquivalenceMember *em,
+										   void *arg);
 
 static bool hdfs_foreign_join_ok(PlannerInfo *root, RelOptInfo *joinrel,
 								 JoinType jointype, RelOptInfo *outerrel,
 								 RelOptInfo *innerrel,
 								 JoinPathExtraData *extra);
+static bool hdfs_semijoin_target_ok(RelOptInfo *joinrel,
+									RelOptInfo *innerrel);
+static Var *hdfs_get_antijoin_key(List *joinclauses, RelOptInfo *innerrel);
 
 static bool hdfs_foreign_grouping_ok(PlannerInfo *root,
 									 RelOptInfo *grouped_rel,
@@ -250,6 +353,20 @@ static void hdfs_add_foreign_grouping_paths(PlannerInfo *root,
 											RelOptInfo *input_rel,
 											RelOptInfo *grouped_rel,
 											GroupPathExtraData *extra);
+static bool hdfs_foreign_upper_target_ok(PlannerInfo *root,
+										 RelOptInfo *input_rel,
+										 RelOptInfo *upper_rel,
+										 PathTarget *target);
+static void hdfs_add_foreign_distinct_paths(PlannerInfo *root,
+											RelOptInfo *input_rel,
+											RelOptInfo *distinct_rel);
+static void hdfs_add_foreign_window_paths(PlannerInfo *root,
+										  RelOptInfo *input_rel,
+										  RelOptInfo *window_rel);
+static void hdfs_add_foreign_upper_path(PlannerInfo *root,
+										RelOptInfo *input_rel,
+										RelOptInfo *upper_rel,
+										PathTarget *target, double rows);
 
 #ifdef EDB_NATIVE_LANG
 #define XACT_CB_SIGNATURE XactEvent event, void *arg
@@ -277,19 +394,19 @@ static List *hdfs_get_useful_ecs_for_relation(PlannerInfo *root,
 											  RelOptInfo *rel);
 static List *hdfs_get_useful_pathkeys_for_relation(PlannerInfo *root,
 												   RelOptInfo *rel);
+static void hdfs_estimate_sort_cost(HDFSFdwRelationInfo *ifpinfo,
+									double limit_tuples, double *p_rows,
+									Cost *p_startup_cost,
+									Cost *p_total_cost);
 #if PG_VERSION_NUM >= 170000
 static void hdfs_add_paths_with_pathkeys(PlannerInfo *root,
 										 RelOptInfo *rel,
 										 Path *epq_path,
-										 Cost base_startup_cost,
-										 Cost base_total_cost,
 										 List *restrictlist);
 #else
 static void hdfs_add_paths_with_pathkeys(PlannerInfo *root,
 										 RelOptInfo *rel,
-										 Path *epq_path,
-										 Cost base_startup_cost,
-										 Cost base_total_cost);
+										 Path *epq_path);
 #endif
 static void hdfs_add_foreign_ordered_paths(PlannerInfo *root,
 										   RelOptInfo *input_rel,
@@ -360,8 +477,9 @@ _PG_init(void)
 							 NULL);
 
 	/*
-	 * ORDER BY is inefficient in Hive so it's disabled by default in
-	 * hdfs_fdw.
+	 * A full ORDER BY is inefficient in Hive, where a single reducer sorts
+	 * all the rows, so it's disabled by default in hdfs_fdw.  A sort followed
+	 * by a LIMIT is considered for push down whatever the setting.
 	 */
 	DefineCustomBoolVariable("hdfs_fdw.enable_order_by_pushdown",
 							 "Enable/Disable ORDER BY push down",
@@ -385,6 +503,45 @@ _PG_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomIntVariable("hdfs_fdw.runtime_filter_max_keys",
+							"Maximum number of local join keys sent to filter a remote scan",
+							"0 disables runtime filters.",
+							&hdfs_runtime_filter_max_keys,
+							1000,
+							0,
+							100000,
+							PGC_SUSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable("hdfs_fdw.join_hint_threshold",
+							"Maximum estimated size of the side of a remote join hinted to be broadcast",
+							"0 disables the hints, unless forced by the join_hints option.",
+							&hdfs_join_hint_threshold,
+							10 * 1024,
+							0,
+							MAX_KILOBYTES,
+							PGC_SUSET,
+							GUC_UNIT_KB,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable("hdfs_fdw.result_cache_size",
+							"Maximum total size of the cached remote query results",
+							NULL,
+							&hdfs_result_cache_size,
+							1024 * 1024,
+							0,
+							MAX_KILOBYTES,
+							PGC_SUSET,
+							GUC_UNIT_KB,
+							NULL,
+							NULL,
+							NULL);
+
 	rc = Initialize();
 
 	if (rc == -1)
@@ -459,11 +616,28 @@ hdfs_fdw_handler(PG_FUNCTION_ARGS)
 	/* Support functions for upper relation push-down */
 	routine->GetForeignUpperPaths = hdfsGetForeignUpperPaths;
 
+	/* Support functions for IMPORT FOREIGN SCHEMA */
+	routine->ImportForeignSchema = hdfs_import_foreign_schema;
+
 	RegisterXactCallback(hdfs_fdw_xact_callback, NULL);
 
 	PG_RETURN_POINTER(routine);
 }
 
+/*
+ * hdfs_is_hdfs_relation
+ * 		Check if the given relation is a foreign table managed by hdfs_fdw.
+ */
+bool
+hdfs_is_hdfs_relation(Relation rel)
+{
+	if (rel->rd_rel->relkind != RELKIND_FOREIGN_TABLE)
+		return false;
+
+	return GetFdwRoutineForRelation(rel, false)->GetForeignRelSize ==
+		hdfsGetForeignRelSize;
+}
+
 /*
  * GetConnection
  * 		Create a connection to Hive/Spark server.
@@ -497,6 +671,9 @@ hdfsGetForeignRelSize(PlannerInfo *root, RelOptInfo *baserel,
 	ListCell   *lc;
 	hdfs_opt   *options;
 	RangeTblEntry *rte = planner_rt_fetch(baserel->relid, root);
+	Relation	rel;
+	double		snapshot_rows = 0;
+	int			con_index = -1;
 	const char *database;
 	const char *relname;
 	const char *refname;
@@ -515,11 +692,59 @@ hdfsGetForeignRelSize(PlannerInfo *root, RelOptInfo *baserel,
 	fpinfo->fdw_tuple_cost = DEFAULT_FDW_TUPLE_COST;
 
 	/*
-	 * Identify which baserestrictinfo clauses can be sent to the remote
-	 * server and which can't.
+	 * If asked so, replace the default costs with the ones derived from the
+	 * timings observed for earlier queries sent to this server.
+	 */
+	options = hdfs_get_options(foreigntableid);
+
+	/* The dialect of the server decides which expressions are pushable. */
+	fpinfo->client_type = options->client_type;
+	fpinfo->dialect = options->dialect;
+
+	if (options->use_observed_costs)
+		(void) hdfs_get_observed_costs(GetForeignTable(foreigntableid)->serverid,
+									   &fpinfo->fdw_startup_cost,
+									   &fpinfo->fdw_tuple_cost);
+
+	/*
+	 * A foreign table with a local snapshot is scanned from the snapshot.
+	 * Nothing is pushed down to the remote server then, all the conditions
+	 * are evaluated locally, and reading the rows costs about as much as
+	 * reading them from a local table.
 	 */
-	hdfs_classify_conditions(root, baserel, baserel->baserestrictinfo,
-							 &fpinfo->remote_conds, &fpinfo->local_conds);
+	rel = table_open(foreigntableid, NoLock);
+	fpinfo->use_snapshot = hdfs_snapshot_exists(rel, options, &snapshot_rows);
+
+	if (fpinfo->use_snapshot)
+	{
+		fpinfo->pushdown_safe = false;
+		fpinfo->fdw_startup_cost = 0;
+		fpinfo->fdw_tuple_cost = cpu_tuple_cost;
+		fpinfo->remote_conds = NIL;
+		fpinfo->local_conds = baserel->baserestrictinfo;
+	}
+	else
+	{
+		/*
+		 * Identify which baserestrictinfo clauses can be sent to the remote
+		 * server and which can't.
+		 */
+		hdfs_classify_conditions(root, baserel, baserel->baserestrictinfo,
+								 &fpinfo->remote_conds, &fpinfo->local_conds);
+
+		/*
+		 * The conditions on the partition columns are sent whenever possible.
+		 * These columns are only asked to the server when it's asked for the
+		 * row count anyway, or when aggregates may be answered from the
+		 * metadata of the partitions.
+		 */
+		if (options->use_remote_estimate || options->trust_metastore_stats)
+			con_index = GetConnection(options, foreigntableid);
+
+		hdfs_plan_partition_conds(root, baserel, rel, options, con_index);
+	}
+
+	table_close(rel, NoLock);
 
 	/*
 	 * Identify which attributes will need to be retrieved from the remote
@@ -543,26 +768,47 @@ hdfsGetForeignRelSize(PlannerInfo *root, RelOptInfo *baserel,
 	}
 
 	/*
-	 * Get the actual number of rows from server if use_remote_estimate is
-	 * specified in options, if not, assume 1000.
+	 * The number of rows in a snapshot is known exactly.  Otherwise get the
+	 * actual number of rows from server if use_remote_estimate is specified
+	 * in options, if not, assume the row_estimate option, or 1000.
 	 */
-	options = hdfs_get_options(foreigntableid);
-	if (options->use_remote_estimate)
+	if (fpinfo->use_snapshot)
 	{
-		int			con_index;
-
-		/* Connect to HIVE server */
-		con_index = GetConnection(options, foreigntableid);
-
-		baserel->rows = hdfs_rowcount(con_index, options, root,
-									  baserel, fpinfo);
-
-		hdfs_rel_connection(con_index);
+		baserel->tuples = snapshot_rows;
+		baserel->rows = clamp_row_est(snapshot_rows *
+									  clauselist_selectivity(root,
+															 baserel->baserestrictinfo,
+															 0,
+															 JOIN_INNER,
+															 NULL));
+		fpinfo->rows = baserel->rows;
+	}
+	else if (options->use_remote_estimate)
+	{
+		baserel->tuples = hdfs_rowcount(con_index, options, root,
+										baserel, fpinfo);
+		baserel->rows = clamp_row_est(baserel->tuples);
+		fpinfo->rows = baserel->rows;
+	}
+	else if (options->row_estimate > 0)
+	{
+		baserel->tuples = options->row_estimate;
+		baserel->rows = clamp_row_est(options->row_estimate *
+									  clauselist_selectivity(root,
+															 baserel->baserestrictinfo,
+															 0,
+															 JOIN_INNER,
+															 NULL));
+		fpinfo->rows = baserel->rows;
 	}
 	else
+	{
 		baserel->rows = 1000;
+		fpinfo->rows = baserel->tuples = baserel->rows;
+	}
 
-	fpinfo->rows = baserel->tuples = baserel->rows;
+	if (con_index >= 0)
+		hdfs_rel_connection(con_index);
 
 	/* Also store the options in fpinfo for further use */
 	fpinfo->options = options;
@@ -572,7 +818,8 @@ hdfsGetForeignRelSize(PlannerInfo *root, RelOptInfo *baserel,
 
 	/* Set the flag enable_order_by_pushdown of the base relation */
 	fpinfo->enable_order_by_pushdown = options->enable_order_by_pushdown;
-	fpinfo->client_type = options->client_type;
+	fpinfo->allow_approximate_aggregates = options->allow_approximate_aggregates;
+	fpinfo->join_hints = options->join_hints;
 
 	/*
 	 * Set the name of relation in fpinfo, while we are constructing it here.
@@ -609,9 +856,20 @@ hdfsGetForeignPaths(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid)
 	HDFSFdwRelationInfo *fpinfo = (HDFSFdwRelationInfo *) baserel->fdw_private;
 	int			total_cost;
 	ForeignPath *path;
+	List	   *ppi_list;
+	ListCell   *lc;
+
+	/* All the rows of a snapshot are read, whatever the conditions. */
+	if (fpinfo->use_snapshot)
+		total_cost = fpinfo->fdw_startup_cost +
+			fpinfo->fdw_tuple_cost * baserel->tuples;
+	else
+		total_cost = fpinfo->fdw_startup_cost +
+			fpinfo->fdw_tuple_cost * baserel->rows;
 
-	total_cost = fpinfo->fdw_startup_cost +
-		fpinfo->fdw_tuple_cost * baserel->rows;
+	/* Remember the costs of the scan to cost the sorts made on top of it. */
+	fpinfo->startup_cost = fpinfo->fdw_startup_cost;
+	fpinfo->total_cost = total_cost;
 
 	/*
 	 * Create simplest ForeignScan path node and add it to baserel.  This path
@@ -657,14 +915,241 @@ hdfsGetForeignPaths(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid)
 
 	add_path(baserel, (Path *) path);
 
+	/*
+	 * Rows read from a snapshot come in no particular order, and the
+	 * snapshot can't be restricted to the rows matching join clauses.
+	 */
+	if (fpinfo->use_snapshot)
+		return;
+
 	/* Add paths with pathkeys */
 #if PG_VERSION_NUM >= 170000
-	hdfs_add_paths_with_pathkeys(root, baserel, NULL, fpinfo->fdw_startup_cost,
-								 total_cost, NIL);
+	hdfs_add_paths_with_pathkeys(root, baserel, NULL, NIL);
 #else
-	hdfs_add_paths_with_pathkeys(root, baserel, NULL, fpinfo->fdw_startup_cost,
-								 total_cost);
+	hdfs_add_paths_with_pathkeys(root, baserel, NULL);
 #endif
+
+	/*
+	 * Thumb through all join clauses for the rel to identify which outer
+	 * relations could supply one or more safe-to-send-to-remote join
+	 * clauses.  We'll build a parameterized path for each such outer
+	 * relation, so that a nested loop with a small outer side fetches only
+	 * the matching rows instead of the whole Hive table.
+	 */
+	ppi_list = NIL;
+	foreach(lc, baserel->joininfo)
+		hdfs_add_param_path(root, baserel, (RestrictInfo *) lfirst(lc),
+							&ppi_list);
+
+	/*
+	 * The above scan examined only "generic" join clauses, not those that
+	 * were absorbed into EquivalenceClauses.  See if we can make anything out
+	 * of EquivalenceClauses.
+	 */
+	if (baserel->has_eclass_joins)
+	{
+		/*
+		 * We repeatedly scan the eclass list looking for column references
+		 * (or expressions) belonging to the foreign rel.  Each time we find
+		 * one, we generate a list of equivalence joinclauses for it, and then
+		 * see if any are safe to send to the remote.  Repeat till there are
+		 * no more candidate EC members.
+		 */
+		hdfs_ec_member_foreign_arg arg;
+
+		arg.already_used = NIL;
+		for (;;)
+		{
+			List	   *clauses;
+
+			/* Make clauses, skipping any that join to lateral_referencers */
+			arg.current = NULL;
+			clauses = generate_implied_equalities_for_column(root,
+															 baserel,
+															 hdfs_ec_member_matches_foreign,
+															 (void *) &arg,
+															 baserel->lateral_referencers);
+
+			/* Done if there are no more expressions in the foreign rel */
+			if (arg.current == NULL)
+			{
+				Assert(clauses == NIL);
+				break;
+			}
+
+			foreach(lc, clauses)
+				hdfs_add_param_path(root, baserel, (RestrictInfo *) lfirst(lc),
+									&ppi_list);
+
+			/* Try again, now ignoring the expression we found this time */
+			arg.already_used = lappend(arg.already_used, arg.current);
+		}
+	}
+
+	/*
+	 * Now build a path for each useful outer relation.  Every rescan of such
+	 * a path binds the current outer values to the parameters of the
+	 * prepared remote query and executes it again.
+	 */
+	foreach(lc, ppi_list)
+	{
+		ParamPathInfo *param_info = (ParamPathInfo *) lfirst(lc);
+		double		rows;
+		Cost		startup_cost;
+		Cost		param_total_cost;
+
+		rows = get_parameterized_baserel_size(root, baserel,
+											  param_info->ppi_clauses);
+		startup_cost = fpinfo->fdw_startup_cost;
+		param_total_cost = startup_cost + fpinfo->fdw_tuple_cost * rows;
+
+#if PG_VERSION_NUM >= 180000
+		path = create_foreignscan_path(root, baserel,
+									   NULL,	/* default pathtarget */
+									   rows,
+									   0,
+									   startup_cost,
+									   param_total_cost,
+									   NIL, /* no pathkeys */
+									   param_info->ppi_req_outer,
+									   NULL,	/* no extra plan */
+									   NIL, /* no fdw_restrictinfo list */
+									   NIL);	/* no fdw_private data */
+#elif PG_VERSION_NUM >= 170000
+		path = create_foreignscan_path(root, baserel,
+									   NULL,	/* default pathtarget */
+									   rows,
+									   startup_cost,
+									   param_total_cost,
+									   NIL, /* no pathkeys */
+									   param_info->ppi_req_outer,
+									   NULL,	/* no extra plan */
+									   NIL, /* no fdw_restrictinfo list */
+									   NIL);	/* no fdw_private data */
+#else
+		path = create_foreignscan_path(root, baserel,
+									   NULL,	/* default pathtarget */
+									   rows,
+									   startup_cost,
+									   param_total_cost,
+									   NIL, /* no pathkeys */
+									   param_info->ppi_req_outer,
+									   NULL,	/* no extra plan */
+									   NIL);	/* no fdw_private data */
+#endif
+		add_path(baserel, (Path *) path);
+	}
+}
+
+/*
+ * hdfs_add_param_path
+ * 		Remember the parameterization needed to push the given join clause
+ * 		to the remote server, if the clause can be pushed at all.
+ */
+static void
+hdfs_add_param_path(PlannerInfo *root, RelOptInfo *baserel,
+					RestrictInfo *rinfo, List **ppi_list)
+{
+	Relids		required_outer;
+	ParamPathInfo *param_info;
+
+	/* Check if clause can be moved to this rel */
+	if (!join_clause_is_movable_to(rinfo, baserel))
+		return;
+
+	/* See if it is safe to send to remote */
+	if (!hdfs_is_param_clause_safe(root, baserel, rinfo->clause))
+		return;
+
+	/* Calculate required outer rels for the resulting path */
+	required_outer = bms_union(rinfo->clause_relids,
+							   baserel->lateral_relids);
+	/* We do not want the foreign rel itself listed in required_outer */
+	required_outer = bms_del_member(required_outer, baserel->relid);
+
+	/*
+	 * required_outer probably can't be empty here, but if it were, we
+	 * couldn't make a parameterized path.
+	 */
+	if (bms_is_empty(required_outer))
+		return;
+
+	/* Get the ParamPathInfo */
+	param_info = get_baserel_parampathinfo(root, baserel, required_outer);
+	Assert(param_info != NULL);
+
+	/*
+	 * Add it to list unless we already have it.  Testing pointer equality is
+	 * OK since get_baserel_parampathinfo won't make duplicates.
+	 */
+	*ppi_list = list_append_unique_ptr(*ppi_list, param_info);
+}
+
+/*
+ * hdfs_is_param_clause_safe
+ * 		Check if a join clause of a base relation can be evaluated on the
+ * 		remote server, with the columns of the other relations sent as
+ * 		parameters.
+ *
+ * Every such column must be of a type hdfs_bind_var() knows to bind.  Numeric
+ * values are bound as float8 and could make the join miss rows, so these are
+ * left for local evaluation too.
+ */
+static bool
+hdfs_is_param_clause_safe(PlannerInfo *root, RelOptInfo *baserel,
+						  Expr *clause)
+{
+	List	   *vars;
+	ListCell   *lc;
+
+	if (!hdfs_is_foreign_expr(root, baserel, clause))
+		return false;
+
+	vars = pull_var_clause((Node *) clause, PVC_RECURSE_PLACEHOLDERS);
+	foreach(lc, vars)
+	{
+		Var		   *var = (Var *) lfirst(lc);
+
+		if (bms_is_member(var->varno, baserel->relids))
+			continue;
+
+		if (var->vartype == NUMERICOID || !hdfs_is_bindable_type(var->vartype))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * hdfs_ec_member_matches_foreign
+ * 		Check whether the given EquivalenceMember is a candidate for building
+ * 		a parameterized path; callback for
+ * 		generate_implied_equalities_for_column.
+ */
+static bool
+hdfs_ec_member_matches_foreign(PlannerInfo *root, RelOptInfo *rel,
+							   EquivalenceClass *ec, EquivalenceMember *em,
+							   void *arg)
+{
+	hdfs_ec_member_foreign_arg *state = (hdfs_ec_member_foreign_arg *) arg;
+	Expr	   *expr = em->em_expr;
+
+	/*
+	 * If we've identified what we're processing in the current scan, we only
+	 * want to match that expression.
+	 */
+	if (state->current != NULL)
+		return equal(expr, state->current);
+
+	/*
+	 * Otherwise, ignore anything we've already processed.
+	 */
+	if (list_member(state->already_used, expr))
+		return false;
+
+	/* This is the new target to process. */
+	state->current = expr;
+	return true;
 }
 
 
@@ -694,6 +1179,7 @@ hdfsGetForeignPlan(PlannerInfo *root,
 	List	   *fdw_scan_tlist = NIL;
 	List	   *scan_var_list = NIL;
 	List	   *whole_row_lists = NIL;
+	List	   *runtime_filter = NIL;
 	bool		has_final_sort = false;
 	bool		has_limit = false;
 
@@ -749,9 +1235,10 @@ hdfsGetForeignPlan(PlannerInfo *root,
 			remote_conds = lappend(remote_conds, rinfo);
 			remote_exprs = lappend(remote_exprs, rinfo->clause);
 		}
-		else if (list_member_ptr(fpinfo->local_conds, rinfo))
+		else if (list_member_ptr(fpinfo->local_conds, rinfo) ||
+				 fpinfo->use_snapshot)
 			local_exprs = lappend(local_exprs, rinfo->clause);
-		else if (hdfs_is_foreign_expr(root, foreignrel, rinfo->clause, false))
+		else if (hdfs_is_param_clause_safe(root, foreignrel, rinfo->clause))
 		{
 			remote_conds = lappend(remote_conds, rinfo);
 			remote_exprs = lappend(remote_exprs, rinfo->clause);
@@ -866,8 +1353,22 @@ hdfsGetForeignPlan(PlannerInfo *root,
 	 * Build the fdw_private list that will be available to the executor.
 	 * Items in the list must match enum FdwScanPrivateIndex, above.
 	 */
-	fdw_private = list_make2(makeString(sql.data),
-							 retrieved_attrs);
+	/*
+	 * A scan of a foreign table joined with a small local table may get a
+	 * runtime filter.  The filter is appended to the query, which must then
+	 * end with its WHERE clause.
+	 */
+	if (scan_relid > 0 && !fpinfo->use_snapshot &&
+		best_path->path.pathkeys == NIL)
+		runtime_filter = hdfs_plan_runtime_filter(root, foreignrel,
+												  remote_conds != NIL);
+
+	fdw_private = list_make5(makeString(sql.data),
+							 retrieved_attrs,
+							 makeInteger(fpinfo->use_snapshot),
+							 runtime_filter,
+							 hdfs_get_unfiltered_partitioned_rels(foreignrel));
+	fdw_private = lappend(fdw_private, fpinfo->metadata_aggs);
 	if (IS_JOIN_REL(foreignrel) || IS_UPPER_REL(foreignrel))
 	{
 		fdw_private = lappend(fdw_private,
@@ -967,7 +1468,22 @@ hdfsBeginForeignScan(ForeignScanState *node, int eflags)
 #endif
 
 	opt = hdfs_get_options(rte->relid);
-	festate->con_index = GetConnection(opt, rte->relid);
+	festate->relid = rte->relid;
+	festate->opt = opt;
+	festate->con_index = -1;
+	festate->serverid = GetForeignTable(rte->relid)->serverid;
+
+	/*
+	 * Identify which user to do the remote access as.  This should match what
+	 * ExecCheckPermissions() does.
+	 */
+#if PG_VERSION_NUM >= 160000
+	festate->userid = OidIsValid(fsplan->checkAsUser) ?
+		fsplan->checkAsUser : GetUserId();
+#else
+	festate->userid = OidIsValid(rte->checkAsUser) ?
+		rte->checkAsUser : GetUserId();
+#endif
 
 	festate->batch_cxt = AllocSetContextCreate(estate->es_query_cxt,
 											   "hdfs_fdw tuple data",
@@ -979,12 +1495,56 @@ hdfsBeginForeignScan(ForeignScanState *node, int eflags)
 												 hdfsFdwScanPrivateRetrievedAttrs);
 	festate->rescan_count = 0;
 	festate->attinmeta = TupleDescGetAttInMetadata(tupleDescriptor);
+	festate->runtime_filter = (List *) list_nth(fdw_private,
+												hdfsFdwScanPrivateRuntimeFilter);
+	festate->runtime_filter_keys = -1;
+	festate->metadata_aggs = (List *) list_nth(fdw_private,
+											   hdfsFdwScanPrivateMetadataAggs);
+
+	/*
+	 * A scan planned to read the local snapshot of the foreign table reads
+	 * it as long as it's still there.  Otherwise, the remote query has no
+	 * condition pushed down, and its rows are filtered locally just like the
+	 * rows of the snapshot would have been.
+	 */
+	if (intVal(list_nth(fdw_private, hdfsFdwScanPrivateUseSnapshot)))
+		festate->snapshot = hdfs_snapshot_begin_scan(node->ss.ss_currentRelation,
+													 opt);
+	if (festate->snapshot)
+	{
+		festate->snapshot_slot = MakeSingleTupleTableSlot(tupleSlot->tts_tupleDescriptor,
+														  &TTSOpsMinimalTuple);
+		return;
+	}
+
+	/*
+	 * If the scan may be rescanned, spool the fetched rows.  Nested loops
+	 * don't ask for rewinding a parameterized inner scan, whose rows change
+	 * with every outer row anyway.
+	 */
+	if (eflags & EXEC_FLAG_REWIND)
+	{
+		festate->spool = tuplestore_begin_heap(false, false, work_mem);
+		festate->spool_slot = MakeSingleTupleTableSlot(tupleSlot->tts_tupleDescriptor,
+													   &TTSOpsMinimalTuple);
+	}
+
+	hdfs_setup_result_cache(node, festate);
 
 	/*
 	 * Prepare remote query and also prepare for processing of parameters used
-	 * in remote query, if any.
+	 * in remote query, if any.  If the result may be served from the cache,
+	 * don't connect to the remote server before it's needed.  A query with a
+	 * runtime filter is prepared once the filter is known, and a query whose
+	 * aggregates may be answered from the metadata only if they aren't.
 	 */
-	hdfs_query_prepare(festate->con_index, opt, festate->query);
+	if (festate->cache_ttl == 0 && festate->runtime_filter == NIL &&
+		festate->metadata_aggs == NIL)
+	{
+		festate->con_index = GetConnection(opt, rte->relid);
+		hdfs_query_prepare(festate->con_index, opt, festate->query);
+		festate->query_prepared = true;
+	}
 
 	festate->numParams = list_length(fsplan->fdw_exprs);
 	if (festate->numParams > 0)
@@ -993,7 +1553,210 @@ hdfsBeginForeignScan(ForeignScanState *node, int eflags)
 							 fsplan->fdw_exprs,
 							 &festate->param_exprs,
 							 &festate->param_types);
+		festate->param_values = (Datum *) palloc0(sizeof(Datum) * festate->numParams);
+		festate->param_nulls = (bool *) palloc0(sizeof(bool) * festate->numParams);
+	}
+}
+
+/*
+ * hdfs_setup_result_cache
+ * 		Decide whether the result of the remote query is cached.
+ *
+ * A query joining several foreign tables is cached only if all of them allow
+ * it, and then for the shortest of their TTLs.
+ */
+static void
+hdfs_setup_result_cache(ForeignScanState *node,
+						hdfsFdwExecutionState *festate)
+{
+	ForeignScan *fsplan = (ForeignScan *) node->ss.ps.plan;
+	EState	   *estate = node->ss.ps.state;
+	Bitmapset  *relids;
+	int			rtindex = -1;
+	int			ttl = -1;
+
+	if (fsplan->scan.scanrelid > 0)
+		relids = bms_make_singleton(fsplan->scan.scanrelid);
+	else
+#if PG_VERSION_NUM >= 160000
+		relids = fsplan->fs_base_relids;
+#else
+		relids = fsplan->fs_relids;
+#endif
+
+	while ((rtindex = bms_next_member(relids, rtindex)) >= 0)
+	{
+		RangeTblEntry *rte;
+		hdfs_opt   *opt;
+
+#if PG_VERSION_NUM >= 160000
+		rte = exec_rt_fetch(rtindex, estate);
+#else
+		rte = rt_fetch(rtindex, estate->es_range_table);
+#endif
+		opt = hdfs_get_options(rte->relid);
+
+		ttl = (ttl < 0) ? opt->result_cache_ttl : Min(ttl, opt->result_cache_ttl);
+		if (opt->result_cache_validate)
+			festate->cache_validate = true;
+		festate->cache_relids = lappend_oid(festate->cache_relids, rte->relid);
+	}
+
+	festate->cache_ttl = Max(ttl, 0);
+	if (festate->cache_ttl > 0)
+		festate->cache_slot = MakeSingleTupleTableSlot(node->ss.ss_ScanTupleSlot->tts_tupleDescriptor,
+													   &TTSOpsMinimalTuple);
+}
+
+/*
+ * hdfs_start_remote_query
+ * 		Get the result of the remote query for the current parameter values,
+ * 		from the cache if possible, otherwise by executing the prepared query.
+ */
+static void
+hdfs_start_remote_query(ForeignScanState *node,
+						hdfsFdwExecutionState *festate)
+{
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+	MemoryContext oldcontext;
+	char	   *cache_key = NULL;
+	int64	   *ddl_times = NULL;
+	int			nddl_times = 0;
+
+	/* Evaluate parameters */
+	if (festate->numParams > 0)
+		hdfs_eval_query_params(econtext, festate->param_exprs,
+							   festate->param_values, festate->param_nulls);
+
+	/*
+	 * Complete the query with the runtime filter on its first execution.  The
+	 * keys are read with the snapshot of the query, they are the same for
+	 * any rescan.
+	 */
+	if (festate->runtime_filter)
+	{
+		oldcontext = MemoryContextSwitchTo(node->ss.ps.state->es_query_cxt);
+		festate->query = hdfs_apply_runtime_filter(festate->query,
+												   festate->runtime_filter,
+												   &festate->runtime_filter_keys);
+		MemoryContextSwitchTo(oldcontext);
+		festate->runtime_filter = NIL;
+	}
+
+	if (festate->cache_ttl > 0)
+	{
+		bool		cacheable = true;
+
+		/*
+		 * A cached result is only valid as long as none of the remote tables
+		 * has changed.  Asking for their transient_lastDdlTime is a metadata
+		 * lookup, much cheaper than running the query.  Without it, changes
+		 * can't be noticed, and the result isn't cached at all.
+		 */
+		if (festate->cache_validate)
+		{
+			ListCell   *lc;
+
+			if (festate->con_index < 0)
+				festate->con_index = GetConnection(festate->opt, festate->relid);
+
+			ddl_times = (int64 *) palloc(sizeof(int64) *
+										 list_length(festate->cache_relids));
+			foreach(lc, festate->cache_relids)
+			{
+				Relation	rel = table_open(lfirst_oid(lc), NoLock);
+
+				ddl_times[nddl_times] = hdfs_get_last_ddl_time(festate->con_index,
+															   festate->opt,
+															   rel, NULL);
+				if (ddl_times[nddl_times++] == 0)
+					cacheable = false;
+				table_close(rel, NoLock);
+			}
+		}
+
+		if (cacheable)
+			cache_key = hdfs_cache_key(festate->serverid, festate->userid,
+									   festate->opt->username, festate->query,
+									   node->ss.ss_ScanTupleSlot->tts_tupleDescriptor,
+									   festate->numParams, festate->param_types,
+									   festate->param_values, festate->param_nulls);
+	}
+
+	if (cache_key)
+	{
+		/* The cached result is read from until the end of the query. */
+		oldcontext = MemoryContextSwitchTo(node->ss.ps.state->es_query_cxt);
+		festate->cache_file = hdfs_cache_lookup(cache_key, festate->cache_ttl,
+												ddl_times, nddl_times);
+		MemoryContextSwitchTo(oldcontext);
+		festate->cache_hit = (festate->cache_file != NULL);
+		if (festate->cache_hit)
+		{
+			festate->cache_hits++;
+			festate->query_executed = true;
+			return;
+		}
+		festate->cache_misses++;
+	}
+
+	if (festate->con_index < 0)
+		festate->con_index = GetConnection(festate->opt, festate->relid);
+	if (!festate->query_prepared)
+	{
+		hdfs_query_prepare(festate->con_index, festate->opt, festate->query);
+		festate->query_prepared = true;
+	}
+
+	/* Bind parameters */
+	if (festate->numParams > 0)
+		process_query_params(festate->con_index, festate->numParams,
+							 festate->param_types, festate->param_values,
+							 festate->param_nulls);
+
+	INSTR_TIME_SET_CURRENT(festate->exec_start);
+	festate->query_executed = hdfs_execute_prepared(festate->con_index);
+	festate->first_fetch_done = false;
+	festate->rows_fetched = 0;
+	INSTR_TIME_SET_ZERO(festate->fetch_time);
+	festate->timing_reported = false;
+
+	if (cache_key)
+	{
+		oldcontext = MemoryContextSwitchTo(node->ss.ps.state->es_query_cxt);
+		festate->cache_file = hdfs_cache_begin_write(cache_key, ddl_times,
+													 nddl_times);
+		MemoryContextSwitchTo(oldcontext);
+	}
+}
+
+/*
+ * hdfs_end_remote_query
+ * 		Release the result of the remote query, or the cached result.
+ *
+ * A result which was being cached but wasn't fetched completely is thrown
+ * away.
+ */
+static void
+hdfs_end_remote_query(hdfsFdwExecutionState *festate)
+{
+	if (!festate->query_executed)
+		return;
+
+	if (festate->cache_file)
+	{
+		hdfs_cache_close(festate->cache_file);
+		festate->cache_file = NULL;
 	}
+
+	if (!festate->cache_hit)
+	{
+		hdfs_report_scan_timing(festate);
+		hdfs_close_result_set(festate->con_index);
+	}
+
+	festate->cache_hit = false;
+	festate->query_executed = false;
 }
 
 /*
@@ -1014,13 +1777,38 @@ hdfsIterateForeignScan(ForeignScanState *node)
 	hdfsFdwExecutionState *festate = (hdfsFdwExecutionState *) node->fdw_state;
 	TupleTableSlot *slot = node->ss.ss_ScanTupleSlot;
 	MemoryContext oldcontext;
-	ExprContext *econtext = node->ss.ps.ps_ExprContext;
 	AttInMetadata *attinmeta = festate->attinmeta;
+	instr_time	fetch_start;
+	instr_time	fetch_end;
+	int			rc;
 
 	natts = attinmeta->tupdesc->natts;
 
 	ExecClearTuple(slot);
 
+	if (festate->snapshot)
+	{
+		if (hdfs_snapshot_read(festate->snapshot, festate->snapshot_slot))
+			ExecCopySlot(slot, festate->snapshot_slot);
+		return slot;
+	}
+
+	/*
+	 * After a rescan, return the spooled rows first.  If the previous
+	 * execution was stopped before reaching the end of its result set, go on
+	 * fetching the remaining rows from the still open remote result set.
+	 */
+	if (festate->spool_replay)
+	{
+		if (tuplestore_gettupleslot(festate->spool, true, false,
+									festate->spool_slot))
+			return ExecCopySlot(slot, festate->spool_slot);
+
+		festate->spool_replay = false;
+		if (festate->spool_complete)
+			return slot;
+	}
+
 	if (fsplan->scan.scanrelid > 0)
 		rtindex = fsplan->scan.scanrelid;
 	else
@@ -1044,17 +1832,53 @@ hdfsIterateForeignScan(ForeignScanState *node)
 	/* Initialize to nulls for any columns not present in result */
 	memset(nulls, true, natts * sizeof(bool));
 
+	/*
+	 * The single row of aggregates answered from the metadata.  If some of
+	 * the statistics are missing, run the remote query after all.
+	 */
+	if (festate->metadata_aggs)
+	{
+		if (!festate->metadata_done)
+		{
+			if (festate->con_index < 0)
+				festate->con_index = GetConnection(festate->opt, festate->relid);
+
+			if (hdfs_get_metadata_aggs(festate->con_index, festate->opt,
+									   festate->relid, festate->metadata_aggs,
+									   slot))
+				festate->metadata_done = true;
+			else
+				festate->metadata_aggs = NIL;
+		}
+
+		if (festate->metadata_aggs)
+		{
+			MemoryContextSwitchTo(oldcontext);
+			return slot;
+		}
+	}
+
 	if (!festate->query_executed)
+		hdfs_start_remote_query(node, festate);
+
+	if (festate->cache_hit)
 	{
-		/* Bind parameters */
-		if (festate->numParams > 0)
-			process_query_params(festate->con_index, econtext,
-								 festate->param_exprs, festate->param_types);
+		if (hdfs_cache_read(festate->cache_file, festate->cache_slot))
+		{
+			ExecCopySlot(slot, festate->cache_slot);
+			if (festate->spool)
+				tuplestore_puttupleslot(festate->spool, slot);
+		}
+		else if (festate->spool)
+			festate->spool_complete = true;
 
-		festate->query_executed = hdfs_execute_prepared(festate->con_index);
+		MemoryContextSwitchTo(oldcontext);
+		return slot;
 	}
 
-	if (hdfs_fetch(festate->con_index) == 0)
+	INSTR_TIME_SET_CURRENT(fetch_start);
+	rc = hdfs_fetch(festate->con_index);
+	if (rc == 0)
 	{
 		HeapTuple	tuple;
 		int			attid = 0;
@@ -1091,7 +1915,47 @@ hdfsIterateForeignScan(ForeignScanState *node)
 		}
 
 		ExecStoreHeapTuple(tuple, slot, true);
+		festate->rows_fetched++;
+
+		if (festate->spool)
+			tuplestore_puttupleslot(festate->spool, slot);
+
+		if (festate->cache_file &&
+			!hdfs_cache_write(festate->cache_file, slot))
+			festate->cache_file = NULL;
 	}
+	else
+	{
+		if (festate->spool)
+			festate->spool_complete = true;
+
+		if (festate->cache_file)
+		{
+			hdfs_cache_finish_write(festate->cache_file);
+			festate->cache_file = NULL;
+		}
+	}
+
+	/*
+	 * The first fetch waits for the remote query to produce its first row,
+	 * so account it to the startup time.  Later fetches make up the per-row
+	 * time.
+	 */
+	INSTR_TIME_SET_CURRENT(fetch_end);
+	if (!festate->first_fetch_done)
+	{
+		instr_time	startup = fetch_end;
+
+		INSTR_TIME_SUBTRACT(startup, festate->exec_start);
+		festate->startup_ms = INSTR_TIME_GET_MILLISEC(startup);
+		festate->first_fetch_done = true;
+	}
+	else
+		INSTR_TIME_ACCUM_DIFF(festate->fetch_time, fetch_end, fetch_start);
+
+	/* End of the result set, the timings of this execution are complete. */
+	if (rc != 0)
+		hdfs_report_scan_timing(festate);
 
 	MemoryContextSwitchTo(oldcontext);
 
@@ -1100,7 +1964,8 @@ hdfsIterateForeignScan(ForeignScanState *node)
 
 /*
  * hdfsReScanForeignScan
- * 		Restart the scan. Basically close the active resultset, and again
+ * 		Restart the scan.  Replay the spooled rows if the parameters of the
+ * 		scan didn't change, otherwise close the active resultset, and again
  * 		execute the remote query.
  */
 static void
@@ -1108,12 +1973,42 @@ hdfsReScanForeignScan(ForeignScanState *node)
 {
 	hdfsFdwExecutionState *festate = (hdfsFdwExecutionState *) node->fdw_state;
 
-	if (festate->query_executed)
+	if (festate->snapshot)
 	{
-		hdfs_close_result_set(festate->con_index);
-		festate->query_executed = false;
+		hdfs_snapshot_rescan(festate->snapshot);
+		return;
+	}
+
+	if (festate->metadata_aggs)
+	{
+		festate->metadata_done = false;
+		return;
 	}
 
+	if (festate->spool)
+	{
+		if (node->ss.ps.chgParam == NULL)
+		{
+			/*
+			 * The result set is of no use anymore once all of its rows are
+			 * in the spool.  Otherwise keep it open, the rows not fetched yet
+			 * are fetched after replaying the spooled ones.
+			 */
+			if (festate->spool_complete)
+				hdfs_end_remote_query(festate);
+
+			tuplestore_rescan(festate->spool);
+			festate->spool_replay = true;
+			return;
+		}
+
+		tuplestore_clear(festate->spool);
+		festate->spool_complete = false;
+		festate->spool_replay = false;
+	}
+
+	hdfs_end_remote_query(festate);
+
 	return;
 }
 
@@ -1128,6 +2023,9 @@ hdfsExplainForeignScan(ForeignScanState *node, ExplainState *es)
 {
 	ForeignScan *fsplan = (ForeignScan *) node->ss.ps.plan;
 	List	   *fdw_private = fsplan->fdw_private;
+	hdfsFdwExecutionState *festate = (hdfsFdwExecutionState *) node->fdw_state;
+	List	   *unfiltered_rels;
+	ListCell   *lc;
 
 	if (list_length(fdw_private) > hdfsFdwScanPrivateRelations)
 	{
@@ -1137,12 +2035,52 @@ hdfsExplainForeignScan(ForeignScanState *node, ExplainState *es)
 		ExplainPropertyText("Relations", relations, es);
 	}
 
+	if (intVal(list_nth(fdw_private, hdfsFdwScanPrivateUseSnapshot)))
+		ExplainPropertyBool("Local Snapshot", true, es);
+
+	if (list_nth(fdw_private, hdfsFdwScanPrivateMetadataAggs) != NIL)
+		ExplainPropertyBool("Metastore Statistics", true, es);
+
+	/* All the partitions of these tables are read */
+	unfiltered_rels = (List *) list_nth(fdw_private,
+										hdfsFdwScanPrivateUnfilteredRels);
+	if (unfiltered_rels)
+	{
+		StringInfoData names;
+
+		initStringInfo(&names);
+		foreach(lc, unfiltered_rels)
+			appendStringInfo(&names, "%s%s", names.len > 0 ? ", " : "",
+							 strVal(lfirst(lc)));
+		ExplainPropertyText("No Partition Filter", names.data, es);
+	}
+
 	if (es->verbose)
 	{
 		char	   *sql;
+		List	   *runtime_filter;
 
 		sql = strVal(list_nth(fdw_private, hdfsFdwScanPrivateSelectSql));
 		ExplainPropertyText("Remote SQL", sql, es);
+
+		runtime_filter = (List *) list_nth(fdw_private,
+										   hdfsFdwScanPrivateRuntimeFilter);
+		if (runtime_filter)
+			ExplainPropertyText("Runtime Filter",
+								hdfs_explain_runtime_filter(runtime_filter),
+								es);
+	}
+
+	if (es->analyze && festate && festate->runtime_filter_keys >= 0)
+		ExplainPropertyInteger("Runtime Filter Keys", NULL,
+							   festate->runtime_filter_keys, es);
+
+	if (es->analyze && festate && festate->cache_ttl > 0)
+	{
+		ExplainPropertyInteger("Result Cache Hits", NULL,
+							   festate->cache_hits, es);
+		ExplainPropertyInteger("Result Cache Misses", NULL,
+							   festate->cache_misses, es);
 	}
 }
 
@@ -1177,8 +2115,17 @@ hdfsAnalyzeForeignTable(Relation relation, AcquireSampleRowsFunc *func,
 	/* Connect to HIVE server */
 	con_index = GetConnection(options, foreigntableid);
 
-	hdfs_analyze(con_index, options, relation);
-	totalsize = hdfs_describe(con_index, options, relation);
+	/*
+	 * A foreign table standing for a partition only analyzes the remote
+	 * partitions it reads.
+	 */
+	if (options->partition_predicate)
+		totalsize = hdfs_analyze_partition(con_index, options, relation);
+	else
+	{
+		hdfs_analyze(con_index, options, relation, NULL);
+		totalsize = hdfs_describe(con_index, options, relation, NULL);
+	}
 
 	*totalpages = totalsize / BLCKSZ;
 	return true;
@@ -1193,16 +2140,54 @@ hdfsEndForeignScan(ForeignScanState *node)
 {
 	hdfsFdwExecutionState *festate = (hdfsFdwExecutionState *) node->fdw_state;
 
-	if (festate->query_executed)
+	if (festate->snapshot)
 	{
-		hdfs_close_result_set(festate->con_index);
-		festate->query_executed = false;
+		hdfs_snapshot_end_scan(festate->snapshot);
+		ExecDropSingleTupleTableSlot(festate->snapshot_slot);
+		return;
+	}
+
+	hdfs_end_remote_query(festate);
+
+	if (festate->spool)
+	{
+		ExecDropSingleTupleTableSlot(festate->spool_slot);
+		tuplestore_end(festate->spool);
+		festate->spool = NULL;
 	}
 
-	hdfs_rel_connection(festate->con_index);
+	if (festate->cache_slot)
+		ExecDropSingleTupleTableSlot(festate->cache_slot);
+
+	if (festate->con_index >= 0)
+		hdfs_rel_connection(festate->con_index);
 	return;
 }
 
+/*
+ * hdfs_report_scan_timing
+ * 		Hand the timings of the current remote execution over to the
+ * 		per-server statistics, at most once per execution.
+ *
+ * Executions which were stopped early, e.g. by a LIMIT, are reported as well
+ * since the rows fetched until then are still representative.
+ */
+static void
+hdfs_report_scan_timing(hdfsFdwExecutionState *festate)
+{
+	double		row_ms = -1;
+
+	if (festate->timing_reported || !festate->first_fetch_done)
+		return;
+
+	if (festate->rows_fetched > 1)
+		row_ms = INSTR_TIME_GET_MILLISEC(festate->fetch_time) /
+			(festate->rows_fetched - 1);
+
+	hdfs_record_remote_timing(festate->serverid, festate->startup_ms, row_ms);
+	festate->timing_reported = true;
+}
+
 /*
  * Prepare for processing of parameters used in remote query.
  */
@@ -1245,11 +2230,15 @@ prepare_query_params(PlanState *node,
 	*param_exprs = ExecInitExprList(fdw_exprs, node);
 }
 
+/*
+ * hdfs_eval_query_params
+ * 		Compute the values of the parameters of the remote query.
+ */
 static void
-process_query_params(int con_index,
-					 ExprContext *econtext,
-					 List *param_exprs,
-					 Oid *param_types)
+hdfs_eval_query_params(ExprContext *econtext,
+					   List *param_exprs,
+					   Datum *param_values,
+					   bool *param_nulls)
 {
 	int			param_index;
 	ListCell   *lc;
@@ -1258,18 +2247,28 @@ process_query_params(int con_index,
 	foreach(lc, param_exprs)
 	{
 		ExprState  *expr_state = (ExprState *) lfirst(lc);
-		Datum		expr_value;
-		bool		isNull;
 
 		/* Evaluate the parameter expression */
-		expr_value = ExecEvalExpr(expr_state, econtext, &isNull);
-
-		hdfs_bind_var(con_index, param_index + 1, param_types[param_index],
-					  expr_value, &isNull);
+		param_values[param_index] = ExecEvalExpr(expr_state, econtext,
+												 &param_nulls[param_index]);
 		param_index++;
 	}
 }
 
+static void
+process_query_params(int con_index,
+					 int numParams,
+					 Oid *param_types,
+					 Datum *param_values,
+					 bool *param_nulls)
+{
+	int			param_index;
+
+	for (param_index = 0; param_index < numParams; param_index++)
+		hdfs_bind_var(con_index, param_index + 1, param_types[param_index],
+					  param_values[param_index], &param_nulls[param_index]);
+}
+
 /*
  * hdfsGetForeignJoinPaths
  *		Add possible ForeignPath to joinrel, if join is safe to push down.
@@ -1314,20 +2313,6 @@ hdfsGetForeignJoinPaths(PlannerInfo *root, RelOptInfo *joinrel,
 	/* attrs_used is only for base relations. */
 	fpinfo->attrs_used = NULL;
 
-	if (!hdfs_foreign_join_ok(root, joinrel, jointype, outerrel, innerrel,
-							  extra))
-		return;
-
-	/* Set the flag enable_aggregate_pushdown of the join relation */
-	fpinfo->enable_aggregate_pushdown =
-		((HDFSFdwRelationInfo *) innerrel->fdw_private)->enable_aggregate_pushdown &&
-		((HDFSFdwRelationInfo *) outerrel->fdw_private)->enable_aggregate_pushdown;
-
-	/* Set the flag enable_order_by_pushdown of the join relation */
-	fpinfo->enable_order_by_pushdown =
-		((HDFSFdwRelationInfo *) innerrel->fdw_private)->enable_order_by_pushdown &&
-		((HDFSFdwRelationInfo *) outerrel->fdw_private)->enable_order_by_pushdown;
-
 	/*
 	 * It is possible that two foreign servers are setup, one with 'hiveserver2'
 	 * as the client_type and the other with 'spark'. More worse, it's possible
@@ -1339,13 +2324,42 @@ hdfsGetForeignJoinPaths(PlannerInfo *root, RelOptInfo *joinrel,
 		((HDFSFdwRelationInfo *) outerrel->fdw_private)->client_type)
 		elog(ERROR, "Multiple client_type server options not supported");
 
-	fpinfo->client_type =
-		((HDFSFdwRelationInfo *)innerrel->fdw_private)->client_type;
+	fpinfo->client_type =
+		((HDFSFdwRelationInfo *)innerrel->fdw_private)->client_type;
+	fpinfo->dialect = ((HDFSFdwRelationInfo *) innerrel->fdw_private)->dialect;
+	fpinfo->join_hints =
+		((HDFSFdwRelationInfo *) innerrel->fdw_private)->join_hints;
+
+	if (!hdfs_foreign_join_ok(root, joinrel, jointype, outerrel, innerrel,
+							  extra))
+		return;
+
+	/* Set the flag enable_aggregate_pushdown of the join relation */
+	fpinfo->enable_aggregate_pushdown =
+		((HDFSFdwRelationInfo *) innerrel->fdw_private)->enable_aggregate_pushdown &&
+		((HDFSFdwRelationInfo *) outerrel->fdw_private)->enable_aggregate_pushdown;
+
+	/* Set the flag enable_order_by_pushdown of the join relation */
+	fpinfo->enable_order_by_pushdown =
+		((HDFSFdwRelationInfo *) innerrel->fdw_private)->enable_order_by_pushdown &&
+		((HDFSFdwRelationInfo *) outerrel->fdw_private)->enable_order_by_pushdown;
+
+	/* Approximations are allowed only if all the tables allow them */
+	fpinfo->allow_approximate_aggregates =
+		((HDFSFdwRelationInfo *) innerrel->fdw_private)->allow_approximate_aggregates &&
+		((HDFSFdwRelationInfo *) outerrel->fdw_private)->allow_approximate_aggregates;
 
 	/* TODO: Put accurate estimates here */
 	startup_cost = 15.0;
 	total_cost = 20 + startup_cost;
 
+	/* Remember the costs of the join to cost the sorts made on top of it. */
+	fpinfo->rows = joinrel->rows;
+	fpinfo->startup_cost = startup_cost;
+	fpinfo->total_cost = total_cost;
+	fpinfo->fdw_tuple_cost =
+		((HDFSFdwRelationInfo *) outerrel->fdw_private)->fdw_tuple_cost;
+
 	/*
 	 * Create a new join path and add it to the joinrel which represents a
 	 * join between foreign tables.
@@ -1393,11 +2407,9 @@ hdfsGetForeignJoinPaths(PlannerInfo *root, RelOptInfo *joinrel,
 
 	/* Add paths with pathkeys */
 #if PG_VERSION_NUM >= 170000
-	hdfs_add_paths_with_pathkeys(root, joinrel, NULL, startup_cost,
-								 total_cost, extra->restrictlist);
+	hdfs_add_paths_with_pathkeys(root, joinrel, NULL, extra->restrictlist);
 #else
-	hdfs_add_paths_with_pathkeys(root, joinrel, NULL, startup_cost,
-								 total_cost);
+	hdfs_add_paths_with_pathkeys(root, joinrel, NULL);
 #endif
 
 	/* XXX Consider parameterized paths for the join relation */
@@ -1421,9 +2433,10 @@ hdfs_foreign_join_ok(PlannerInfo *root, RelOptInfo *joinrel,
 	ListCell   *lc;
 	List	   *joinclauses;
 
-	/* We support pushing down INNER, LEFT, RIGHT and FULL joins. */
+	/* We support pushing down INNER, LEFT, RIGHT, FULL, SEMI and ANTI joins. */
 	if (jointype != JOIN_INNER && jointype != JOIN_LEFT &&
-		jointype != JOIN_RIGHT && jointype != JOIN_FULL)
+		jointype != JOIN_RIGHT && jointype != JOIN_FULL &&
+		jointype != JOIN_SEMI && jointype != JOIN_ANTI)
 		return false;
 
 	fpinfo = (HDFSFdwRelationInfo *) joinrel->fdw_private;
@@ -1446,6 +2459,16 @@ hdfs_foreign_join_ok(PlannerInfo *root, RelOptInfo *joinrel,
 	if (fpinfo_o->local_conds || fpinfo_i->local_conds)
 		return false;
 
+	/*
+	 * The columns of the inner side of a semi or anti join can only be
+	 * referenced in the ON clause on the remote side, both for a LEFT SEMI
+	 * JOIN and for the null-extended rows of an anti join.  Those are not
+	 * needed above the join normally, but check the target list anyway.
+	 */
+	if ((jointype == JOIN_SEMI || jointype == JOIN_ANTI) &&
+		!hdfs_semijoin_target_ok(joinrel, innerrel))
+		return false;
+
 	/*
 	 * Separate restrict list into join quals and pushed-down (other) quals.
 	 *
@@ -1466,9 +2489,9 @@ hdfs_foreign_join_ok(PlannerInfo *root, RelOptInfo *joinrel,
 	{
 		RestrictInfo *rinfo = lfirst_node(RestrictInfo, lc);
 		bool		is_remote_clause = hdfs_is_foreign_expr(root, joinrel,
-															rinfo->clause, true);
+															rinfo->clause);
 
-		if (IS_OUTER_JOIN(jointype) &&
+		if ((IS_OUTER_JOIN(jointype) || jointype == JOIN_SEMI) &&
 			!RINFO_IS_PUSHED_DOWN(rinfo, joinrel->relids))
 		{
 			if (!is_remote_clause)
@@ -1477,6 +2500,11 @@ hdfs_foreign_join_ok(PlannerInfo *root, RelOptInfo *joinrel,
 		}
 		else
 		{
+			/* See above about the inner side of a semi or anti join. */
+			if ((jointype == JOIN_SEMI || jointype == JOIN_ANTI) &&
+				bms_overlap(rinfo->clause_relids, innerrel->relids))
+				return false;
+
 			if (is_remote_clause)
 			{
 				/*
@@ -1498,6 +2526,13 @@ hdfs_foreign_join_ok(PlannerInfo *root, RelOptInfo *joinrel,
 		}
 	}
 
+	/*
+	 * A semi or anti join without a join clause is a one-time filter on the
+	 * outer rows, nothing is gained by sending it.
+	 */
+	if ((jointype == JOIN_SEMI || jointype == JOIN_ANTI) && joinclauses == NIL)
+		return false;
+
 	/*
 	 * hdfs_deparse_explicit_target_list() isn't smart enough to handle
 	 * anything other than a Var.  In particular, if there's some
@@ -1590,12 +2625,14 @@ hdfs_foreign_join_ok(PlannerInfo *root, RelOptInfo *joinrel,
 			break;
 
 		case JOIN_LEFT:
+		case JOIN_SEMI:
+		case JOIN_ANTI:
 			/* Check that clauses from the inner side are pushable or not. */
 			foreach(lc, fpinfo_i->remote_conds)
 			{
 				RestrictInfo *ri = (RestrictInfo *) lfirst(lc);
 
-				if (!hdfs_is_foreign_expr(root, joinrel, ri->clause, true))
+				if (!hdfs_is_foreign_expr(root, joinrel, ri->clause))
 					return false;
 			}
 
@@ -1605,6 +2642,38 @@ hdfs_foreign_join_ok(PlannerInfo *root, RelOptInfo *joinrel,
 
 			fpinfo->remote_conds = hdfs_list_concat(fpinfo->remote_conds,
 													fpinfo_o->remote_conds);
+
+			/*
+			 * Spark SQL has a LEFT ANTI JOIN, but Hive only has the LEFT
+			 * SEMI JOIN.  There, send the anti join as a LEFT JOIN keeping
+			 * the null-extended rows only, which requires a column of the
+			 * inner side that can't be NULL in a matched row.
+			 */
+			if (jointype == JOIN_ANTI && fpinfo->client_type != SPARKSERVER)
+			{
+				Var		   *key = hdfs_get_antijoin_key(fpinfo->joinclauses,
+														innerrel);
+				NullTest   *ntest;
+
+				if (key == NULL)
+					return false;
+
+				ntest = makeNode(NullTest);
+				ntest->arg = (Expr *) key;
+				ntest->nulltesttype = IS_NULL;
+				ntest->argisrow = false;
+				ntest->location = -1;
+
+#if PG_VERSION_NUM >= 140000
+				fpinfo->remote_conds =
+					lappend(fpinfo->remote_conds,
+							make_simple_restrictinfo(root, (Expr *) ntest));
+#else
+				fpinfo->remote_conds =
+					lappend(fpinfo->remote_conds,
+							make_simple_restrictinfo((Expr *) ntest));
+#endif
+			}
 			break;
 
 		case JOIN_RIGHT:
@@ -1613,7 +2682,7 @@ hdfs_foreign_join_ok(PlannerInfo *root, RelOptInfo *joinrel,
 			{
 				RestrictInfo *ri = (RestrictInfo *) lfirst(lc);
 
-				if (!hdfs_is_foreign_expr(root, joinrel, ri->clause, true))
+				if (!hdfs_is_foreign_expr(root, joinrel, ri->clause))
 					return false;
 			}
 
@@ -1691,6 +2760,72 @@ hdfs_foreign_join_ok(PlannerInfo *root, RelOptInfo *joinrel,
 	return true;
 }
 
+/*
+ * hdfs_semijoin_target_ok
+ * 		Check that the target list of a semi or anti join doesn't reference
+ * 		any column of its inner side.
+ */
+static bool
+hdfs_semijoin_target_ok(RelOptInfo *joinrel, RelOptInfo *innerrel)
+{
+	List	   *vars;
+	ListCell   *lc;
+
+	vars = pull_var_clause((Node *) joinrel->reltarget->exprs,
+						   PVC_RECURSE_PLACEHOLDERS);
+	foreach(lc, vars)
+	{
+		Var		   *var = (Var *) lfirst(lc);
+
+		if (IsA(var, Var) && bms_is_member(var->varno, innerrel->relids))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * hdfs_get_antijoin_key
+ * 		Find a column of the inner side of an anti join which is not NULL
+ * 		when an inner row matches, i.e. an argument of a strict operator
+ * 		of the join clauses.  Returns NULL if there is none.
+ */
+static Var *
+hdfs_get_antijoin_key(List *joinclauses, RelOptInfo *innerrel)
+{
+	ListCell   *lc;
+
+	foreach(lc, joinclauses)
+	{
+		RestrictInfo *rinfo = lfirst_node(RestrictInfo, lc);
+		OpExpr	   *op;
+		ListCell   *lc_arg;
+
+		if (!IsA(rinfo->clause, OpExpr))
+			continue;
+
+		op = (OpExpr *) rinfo->clause;
+		if (!op_strict(op->opno))
+			continue;
+
+		foreach(lc_arg, op->args)
+		{
+			Node	   *arg = lfirst(lc_arg);
+
+			while (IsA(arg, RelabelType))
+				arg = (Node *) ((RelabelType *) arg)->arg;
+
+			if (IsA(arg, Var) &&
+				((Var *) arg)->varattno > 0 &&
+				((Var *) arg)->varlevelsup == 0 &&
+				bms_is_member(((Var *) arg)->varno, innerrel->relids))
+				return (Var *) copyObject(arg);
+		}
+	}
+
+	return NULL;
+}
+
 /*
  * hdfsRecheckForeignScan
  *		Execute a local join execution plan for a foreign join
@@ -2144,9 +3279,35 @@ hdfs_foreign_grouping_ok(PlannerInfo *root, RelOptInfo *grouped_rel,
 	int			i;
 	List	   *tlist = NIL;
 
-	/* Grouping Sets are not pushable */
+	/*
+	 * Hive needs the grouping columns in a GROUP BY list before the grouping
+	 * sets, and computes a set appearing more than once only once.  The empty
+	 * set of a ROLLUP, a CUBE or () returns a row even for an empty input on
+	 * PostgreSQL, but none on hive/spark.
+	 */
 	if (query->groupingSets)
-		return false;
+	{
+		List	   *sets;
+
+		if (!query->groupClause)
+			return false;
+
+		sets = hdfs_get_grouping_sets(query);
+		foreach(lc, sets)
+		{
+			ListCell   *lc2;
+
+			if (lfirst(lc) == NIL)
+				return false;
+
+			for_each_cell(lc2, sets, lnext(sets, lc))
+			{
+				if (list_difference_int(lfirst(lc), lfirst(lc2)) == NIL &&
+					list_difference_int(lfirst(lc2), lfirst(lc)) == NIL)
+					return false;
+			}
+		}
+	}
 
 	/* Get the fpinfo of the underlying scan relation. */
 	ofpinfo = (HDFSFdwRelationInfo *) fpinfo->outerrel->fdw_private;
@@ -2182,7 +3343,7 @@ hdfs_foreign_grouping_ok(PlannerInfo *root, RelOptInfo *grouped_rel,
 			 * If any of the GROUP BY expression is not shippable we can not
 			 * push down aggregation to the foreign server.
 			 */
-			if (!hdfs_is_foreign_expr(root, grouped_rel, expr, true))
+			if (!hdfs_is_foreign_expr(root, grouped_rel, expr))
 				return false;
 
 			/*
@@ -2207,7 +3368,7 @@ hdfs_foreign_grouping_ok(PlannerInfo *root, RelOptInfo *grouped_rel,
 		else
 		{
 			/* Check entire expression whether it is pushable or not */
-			if (hdfs_is_foreign_expr(root, grouped_rel, expr, true) &&
+			if (hdfs_is_foreign_expr(root, grouped_rel, expr) &&
 				!hdfs_is_foreign_param(root, grouped_rel, expr))
 			{
 				/* Pushable, add to tlist */
@@ -2227,7 +3388,7 @@ hdfs_foreign_grouping_ok(PlannerInfo *root, RelOptInfo *grouped_rel,
 				 * don't have to check is_foreign_param, since that certainly
 				 * won't return true for any such expression.)
 				 */
-				if (!hdfs_is_foreign_expr(root, grouped_rel, (Expr *) aggvars, true))
+				if (!hdfs_is_foreign_expr(root, grouped_rel, (Expr *) aggvars))
 					return false;
 
 				/*
@@ -2302,7 +3463,7 @@ hdfs_foreign_grouping_ok(PlannerInfo *root, RelOptInfo *grouped_rel,
 									  NULL);
 #endif
 
-			if (!hdfs_is_foreign_expr(root, grouped_rel, expr, true))
+			if (!hdfs_is_foreign_expr(root, grouped_rel, expr))
 				fpinfo->local_conds = lappend(fpinfo->local_conds, rinfo);
 			else
 				fpinfo->remote_conds = lappend(fpinfo->remote_conds, rinfo);
@@ -2339,7 +3500,7 @@ hdfs_foreign_grouping_ok(PlannerInfo *root, RelOptInfo *grouped_rel,
 			 */
 			if (IsA(expr, Aggref))
 			{
-				if (!hdfs_is_foreign_expr(root, grouped_rel, expr, true))
+				if (!hdfs_is_foreign_expr(root, grouped_rel, expr))
 					return false;
 
 				tlist = add_to_flat_tlist(tlist, list_make1(expr));
@@ -2358,7 +3519,9 @@ hdfs_foreign_grouping_ok(PlannerInfo *root, RelOptInfo *grouped_rel,
 	 * output of corresponding ForeignScan.
 	 */
 	fpinfo->relation_name = makeStringInfo();
-	appendStringInfo(fpinfo->relation_name, "Aggregate on (%s)",
+	appendStringInfo(fpinfo->relation_name, "%s on (%s)",
+					 fpinfo->stage == UPPERREL_PARTIAL_GROUP_AGG ?
+					 "Partial Aggregate" : "Aggregate",
 					 ofpinfo->relation_name->data);
 
 	return true;
@@ -2385,8 +3548,9 @@ hdfsGetForeignUpperPaths(PlannerInfo *root, UpperRelationKind stage,
 		return;
 
 	/* Ignore stages we don't support; and skip any duplicate calls. */
-	if ((stage != UPPERREL_GROUP_AGG && stage != UPPERREL_ORDERED &&
-		 stage != UPPERREL_FINAL) ||
+	if ((stage != UPPERREL_GROUP_AGG && stage != UPPERREL_PARTIAL_GROUP_AGG &&
+		 stage != UPPERREL_WINDOW && stage != UPPERREL_DISTINCT &&
+		 stage != UPPERREL_ORDERED && stage != UPPERREL_FINAL) ||
 		output_rel->fdw_private)
 		return;
 
@@ -2398,9 +3562,16 @@ hdfsGetForeignUpperPaths(PlannerInfo *root, UpperRelationKind stage,
 	switch (stage)
 	{
 		case UPPERREL_GROUP_AGG:
+		case UPPERREL_PARTIAL_GROUP_AGG:
 			hdfs_add_foreign_grouping_paths(root, input_rel, output_rel,
 											(GroupPathExtraData *) extra);
 			break;
+		case UPPERREL_WINDOW:
+			hdfs_add_foreign_window_paths(root, input_rel, output_rel);
+			break;
+		case UPPERREL_DISTINCT:
+			hdfs_add_foreign_distinct_paths(root, input_rel, output_rel);
+			break;
 		case UPPERREL_ORDERED:
 			hdfs_add_foreign_ordered_paths(root, input_rel, output_rel);
 			break;
@@ -2420,6 +3591,10 @@ hdfsGetForeignUpperPaths(PlannerInfo *root, UpperRelationKind stage,
  *
  * Given input_rel represents the underlying scan.  The paths are added to the
  * given grouped_rel.
+ *
+ * With partitionwise aggregation, grouped_rel may be the partially grouped
+ * relation of a partition, whose target holds partial aggregates.  Their
+ * results are combined and HAVING is applied locally.
  */
 static void
 hdfs_add_foreign_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
@@ -2449,16 +3624,25 @@ hdfs_add_foreign_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
 	if (!enable_aggregate_pushdown || !fpinfo->enable_aggregate_pushdown)
 		return;
 
+	fpinfo->allow_approximate_aggregates =
+		((HDFSFdwRelationInfo *) input_rel->fdw_private)->allow_approximate_aggregates;
+
+	fpinfo->client_type =
+		((HDFSFdwRelationInfo *) input_rel->fdw_private)->client_type;
+	fpinfo->dialect = ((HDFSFdwRelationInfo *) input_rel->fdw_private)->dialect;
+
 	/* Assess if it is safe to push down aggregation and grouping. */
-	if (!hdfs_foreign_grouping_ok(root, grouped_rel, extra->havingQual))
+	if (!hdfs_foreign_grouping_ok(root, grouped_rel,
+								  fpinfo->stage == UPPERREL_PARTIAL_GROUP_AGG ?
+								  NULL : extra->havingQual))
 		return;
 
+	/* The aggregates may not even need the remote query to run. */
+	fpinfo->metadata_aggs = hdfs_plan_metadata_aggs(root, grouped_rel);
+
 	fpinfo->enable_order_by_pushdown =
 		((HDFSFdwRelationInfo *) input_rel->fdw_private)->enable_order_by_pushdown;
 
-	fpinfo->client_type =
-		((HDFSFdwRelationInfo *) input_rel->fdw_private)->client_type;
-
 	/*
 	 * TODO: Put accurate estimates here.
 	 *
@@ -2468,19 +3652,58 @@ hdfs_add_foreign_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
 	startup_cost = 15;
 	total_cost = 10 + startup_cost;
 
-	/* Estimate output tuples which should be same as number of groups */
+	/*
+	 * Estimate output tuples which should be same as number of groups, summed
+	 * over the grouping sets if any.
+	 */
+	if (parse->groupingSets)
+	{
+		ListCell   *lc;
+
+		num_groups = 0;
+		foreach(lc, hdfs_get_grouping_sets(parse))
+		{
+			List	   *set = (List *) lfirst(lc);
+			List	   *group_exprs = NIL;
+			ListCell   *lc2;
+
+			foreach(lc2, set)
+			{
+				TargetEntry *tle = get_sortgroupref_tle(lfirst_int(lc2),
+														fpinfo->grouped_tlist);
+
+				group_exprs = lappend(group_exprs, tle->expr);
+			}
+
 #if PG_VERSION_NUM >= 140000
-	num_groups = estimate_num_groups(root,
-									 get_sortgrouplist_exprs(root->parse->groupClause,
-															 fpinfo->grouped_tlist),
-									 input_rel->rows, NULL, NULL);
+			num_groups += estimate_num_groups(root, group_exprs,
+											  input_rel->rows, NULL, NULL);
 #else
-	num_groups = estimate_num_groups(root,
-									 get_sortgrouplist_exprs(root->parse->groupClause,
-															 fpinfo->grouped_tlist),
-									 input_rel->rows, NULL);
+			num_groups += estimate_num_groups(root, group_exprs,
+											  input_rel->rows, NULL);
+#endif
+		}
+	}
+	else
+#if PG_VERSION_NUM >= 140000
+		num_groups = estimate_num_groups(root,
+										 get_sortgrouplist_exprs(root->parse->groupClause,
+																 fpinfo->grouped_tlist),
+										 input_rel->rows, NULL, NULL);
+#else
+		num_groups = estimate_num_groups(root,
+										 get_sortgrouplist_exprs(root->parse->groupClause,
+																 fpinfo->grouped_tlist),
+										 input_rel->rows, NULL);
 #endif
 
+	/* Remember the costs of the grouping to cost a sort made on top of it. */
+	fpinfo->rows = num_groups;
+	fpinfo->startup_cost = startup_cost;
+	fpinfo->total_cost = total_cost;
+	fpinfo->fdw_tuple_cost =
+		((HDFSFdwRelationInfo *) input_rel->fdw_private)->fdw_tuple_cost;
+
 	/* Create and add foreign path to the grouping relation. */
 #if PG_VERSION_NUM >= 180000
 	grouppath = create_foreign_upper_path(root,
@@ -2521,6 +3744,193 @@ hdfs_add_foreign_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
 	add_path(grouped_rel, (Path *) grouppath);
 }
 
+/*
+ * hdfs_foreign_upper_target_ok
+ * 		Assess whether the given target of a window or distinct relation can
+ * 		be computed by the foreign server, directly over the scan or join of
+ * 		input_rel.  As a side effect, set up the HDFSFdwRelationInfo of the
+ * 		upper relation.
+ */
+static bool
+hdfs_foreign_upper_target_ok(PlannerInfo *root, RelOptInfo *input_rel,
+							 RelOptInfo *upper_rel, PathTarget *target)
+{
+	HDFSFdwRelationInfo *ifpinfo = (HDFSFdwRelationInfo *) input_rel->fdw_private;
+	HDFSFdwRelationInfo *fpinfo = (HDFSFdwRelationInfo *) upper_rel->fdw_private;
+	const char *operation;
+	ListCell   *lc;
+
+	/* Only directly over a scan or join, which is not deparsed as subquery */
+	if (input_rel->reloptkind != RELOPT_BASEREL &&
+		input_rel->reloptkind != RELOPT_JOINREL)
+		return false;
+
+	/* Same flag as for aggregation, as both are computed by a reduce phase */
+	if (!enable_aggregate_pushdown || !ifpinfo->enable_aggregate_pushdown)
+		return false;
+
+	/* We don't support cases where there are any SRFs in the targetlist */
+	if (root->parse->hasTargetSRFs)
+		return false;
+
+	/* The conditions must be applied before */
+	if (ifpinfo->local_conds)
+		return false;
+
+	fpinfo->outerrel = input_rel;
+	fpinfo->client_type = ifpinfo->client_type;
+	fpinfo->dialect = ifpinfo->dialect;
+
+	/*
+	 * Build the targetlist, checking the expressions are pushable.  A
+	 * repeated expression changes neither the distinct rows nor the window
+	 * functions, so it is fetched once.
+	 */
+	fpinfo->grouped_tlist = NIL;
+	foreach(lc, target->exprs)
+	{
+		Expr	   *expr = (Expr *) lfirst(lc);
+
+		if (!hdfs_is_foreign_expr(root, upper_rel, expr) ||
+			hdfs_is_foreign_param(root, upper_rel, expr))
+			return false;
+
+		fpinfo->grouped_tlist = add_to_flat_tlist(fpinfo->grouped_tlist,
+												  list_make1(expr));
+	}
+
+	/* Safe to pushdown */
+	fpinfo->pushdown_safe = true;
+	fpinfo->enable_aggregate_pushdown = ifpinfo->enable_aggregate_pushdown;
+	fpinfo->enable_order_by_pushdown = ifpinfo->enable_order_by_pushdown;
+
+	/*
+	 * Set the string describing this relation to be used in EXPLAIN output
+	 * of corresponding ForeignScan.
+	 */
+	operation = fpinfo->stage == UPPERREL_WINDOW ? "Window" : "Distinct";
+	fpinfo->relation_name = makeStringInfo();
+	appendStringInfo(fpinfo->relation_name, "%s on (%s)", operation,
+					 ifpinfo->relation_name->data);
+
+	return true;
+}
+
+/*
+ * hdfs_add_foreign_distinct_paths
+ *		Add foreign path for SELECT DISTINCT.
+ */
+static void
+hdfs_add_foreign_distinct_paths(PlannerInfo *root, RelOptInfo *input_rel,
+								RelOptInfo *distinct_rel)
+{
+	Query	   *parse = root->parse;
+	PathTarget *target = root->upper_targets[UPPERREL_DISTINCT];
+	double		rows;
+
+	/* DISTINCT ON has no counterpart in HiveQL */
+	if (parse->hasDistinctOn)
+		return;
+
+	if (!hdfs_foreign_upper_target_ok(root, input_rel, distinct_rel, target))
+		return;
+
+#if PG_VERSION_NUM >= 140000
+	rows = estimate_num_groups(root, target->exprs, input_rel->rows, NULL,
+							   NULL);
+#else
+	rows = estimate_num_groups(root, target->exprs, input_rel->rows, NULL);
+#endif
+
+	hdfs_add_foreign_upper_path(root, input_rel, distinct_rel, target, rows);
+}
+
+/*
+ * hdfs_add_foreign_window_paths
+ *		Add foreign path for computing window functions.
+ *
+ * Which window functions and window clauses are pushable is checked by
+ * hdfs_is_foreign_expr.
+ */
+static void
+hdfs_add_foreign_window_paths(PlannerInfo *root, RelOptInfo *input_rel,
+							  RelOptInfo *window_rel)
+{
+	PathTarget *target = root->upper_targets[UPPERREL_WINDOW];
+
+#if PG_VERSION_NUM >= 180000
+	/*
+	 * EXPLAIN shows a window function by the name of its window, which it
+	 * looks up in the WindowAgg node computing it, and fails without one.
+	 */
+	return;
+#endif
+
+	if (!hdfs_foreign_upper_target_ok(root, input_rel, window_rel, target))
+		return;
+
+	hdfs_add_foreign_upper_path(root, input_rel, window_rel, target,
+								input_rel->rows);
+}
+
+/*
+ * hdfs_add_foreign_upper_path
+ *		Add a foreign path computing the target of a window or distinct
+ *		relation.
+ *
+ * The remote query has to read all of input_rel before returning a row, and
+ * then returns only the given number of rows.
+ */
+static void
+hdfs_add_foreign_upper_path(PlannerInfo *root, RelOptInfo *input_rel,
+							RelOptInfo *upper_rel, PathTarget *target,
+							double rows)
+{
+	ForeignPath *upper_path;
+	Cost		startup_cost;
+	Cost		total_cost;
+
+	startup_cost = input_rel->cheapest_total_path->total_cost;
+	total_cost = startup_cost + cpu_tuple_cost * rows;
+
+#if PG_VERSION_NUM >= 180000
+	upper_path = create_foreign_upper_path(root,
+										   upper_rel,
+										   target,
+										   rows,
+										   0,
+										   startup_cost,
+										   total_cost,
+										   NIL, /* no pathkeys */
+										   NULL,
+										   NIL, /* no fdw_restrictinfo list */
+										   NIL);	/* no fdw_private */
+#elif PG_VERSION_NUM >= 170000
+	upper_path = create_foreign_upper_path(root,
+										   upper_rel,
+										   target,
+										   rows,
+										   startup_cost,
+										   total_cost,
+										   NIL, /* no pathkeys */
+										   NULL,
+										   NIL, /* no fdw_restrictinfo list */
+										   NIL);	/* no fdw_private */
+#else
+	upper_path = create_foreign_upper_path(root,
+										   upper_rel,
+										   target,
+										   rows,
+										   startup_cost,
+										   total_cost,
+										   NIL, /* no pathkeys */
+										   NULL,
+										   NIL);	/* no fdw_private */
+#endif
+
+	add_path(upper_rel, (Path *) upper_path);
+}
+
 /*
  * hdfs_get_useful_ecs_for_relation
  *		Determine which EquivalenceClasses might be involved in useful
@@ -2642,7 +4052,6 @@ hdfs_get_useful_pathkeys_for_relation(PlannerInfo *root, RelOptInfo *rel)
 {
 	List	   *useful_pathkeys_list = NIL;
 	List	   *useful_eclass_list;
-	HDFSFdwRelationInfo *fpinfo = (HDFSFdwRelationInfo *) rel->fdw_private;
 	EquivalenceClass *query_ec = NULL;
 	ListCell   *lc;
 
@@ -2650,7 +4059,6 @@ hdfs_get_useful_pathkeys_for_relation(PlannerInfo *root, RelOptInfo *rel)
 	 * Pushing the query_pathkeys to the remote server is always worth
 	 * considering, because it might let us avoid a local sort.
 	 */
-	fpinfo->qp_is_pushdown_safe = false;
 	if (root->query_pathkeys)
 	{
 		bool		query_pathkeys_ok = true;
@@ -2674,10 +4082,7 @@ hdfs_get_useful_pathkeys_for_relation(PlannerInfo *root, RelOptInfo *rel)
 		}
 
 		if (query_pathkeys_ok)
-		{
 			useful_pathkeys_list = list_make1(list_copy(root->query_pathkeys));
-			fpinfo->qp_is_pushdown_safe = true;
-		}
 	}
 
 	/* Get the list of interesting EquivalenceClasses. */
@@ -2735,6 +4140,54 @@ hdfs_get_useful_pathkeys_for_relation(PlannerInfo *root, RelOptInfo *rel)
 	return useful_pathkeys_list;
 }
 
+/*
+ * hdfs_estimate_sort_cost
+ *		Estimate the number of rows and the costs of sorting the result of the
+ *		given relation remotely, keeping only the first limit_tuples rows if
+ *		that's positive.
+ *
+ * The remote query has to read all the rows of the relation before returning
+ * the first one, but only the rows kept are transferred.  Without a limit,
+ * the single reducer of the global ORDER BY sorts all the rows; with one, each
+ * mapper only passes it the first limit_tuples rows it sees, kept in a bounded
+ * heap.
+ *
+ * Only the comparisons of the remote sort are costed, like those of a local
+ * sort.  The rows then arrive in order, which saves the local Sort its
+ * per-row cost and its spilling to disk beyond work_mem.  Both grow with the
+ * estimated row count, against which the sorted path is weighed with the
+ * other paths of the query, such as a merge join or sorted grouping.
+ */
+static void
+hdfs_estimate_sort_cost(HDFSFdwRelationInfo *ifpinfo, double limit_tuples,
+						double *p_rows, Cost *p_startup_cost,
+						Cost *p_total_cost)
+{
+	double		input_rows = Max(ifpinfo->rows, 1.0);
+	double		rows = input_rows;
+	Cost		comparison_cost = 2.0 * cpu_operator_cost;
+	Cost		run_cost = ifpinfo->total_cost - ifpinfo->startup_cost;
+	Cost		transfer_cost;
+	Cost		sort_cost;
+
+	/* Part of the run cost spent transferring the rows. */
+	transfer_cost = Min(run_cost, ifpinfo->fdw_tuple_cost * input_rows);
+
+	if (limit_tuples > 0 && limit_tuples < input_rows)
+	{
+		rows = limit_tuples;
+		sort_cost = comparison_cost * input_rows * LOG2(2.0 * limit_tuples);
+	}
+	else
+		sort_cost = comparison_cost * input_rows * LOG2(Max(input_rows, 2.0));
+
+	*p_startup_cost = ifpinfo->startup_cost + run_cost - transfer_cost +
+		sort_cost;
+	*p_total_cost = *p_startup_cost + transfer_cost * rows / input_rows;
+	if (p_rows)
+		*p_rows = rows;
+}
+
 /*
  * hdfs_add_paths_with_pathkeys
  *		 Add path with root->query_pathkeys if that's pushable.
@@ -2745,20 +4198,18 @@ hdfs_get_useful_pathkeys_for_relation(PlannerInfo *root, RelOptInfo *rel)
 #if PG_VERSION_NUM >= 170000
 static void
 hdfs_add_paths_with_pathkeys(PlannerInfo *root, RelOptInfo *rel,
-							 Path *epq_path, Cost base_startup_cost,
-							 Cost base_total_cost, List *restrictlist)
+							 Path *epq_path, List *restrictlist)
 #else
 static void
 hdfs_add_paths_with_pathkeys(PlannerInfo *root, RelOptInfo *rel,
-							 Path *epq_path, Cost base_startup_cost,
-							 Cost base_total_cost)
+							 Path *epq_path)
 #endif
 {
+	HDFSFdwRelationInfo *fpinfo = (HDFSFdwRelationInfo *) rel->fdw_private;
 	ListCell   *lc;
 	List	   *useful_pathkeys_list = NIL; /* List of all pathkeys */
 
-	if (!enable_order_by_pushdown ||
-		!((HDFSFdwRelationInfo *) rel->fdw_private)->enable_order_by_pushdown)
+	if (!enable_order_by_pushdown || !fpinfo->enable_order_by_pushdown)
 		return;
 
 	useful_pathkeys_list = hdfs_get_useful_pathkeys_for_relation(root, rel);
@@ -2771,9 +4222,8 @@ hdfs_add_paths_with_pathkeys(PlannerInfo *root, RelOptInfo *rel,
 		List	   *useful_pathkeys = lfirst(lc);
 		Path	   *sorted_epq_path;
 
-		/* TODO put accurate estimates. */
-		startup_cost = base_startup_cost * DEFAULT_HDFS_SORT_MULTIPLIER;
-		total_cost = base_total_cost * DEFAULT_HDFS_SORT_MULTIPLIER;
+		hdfs_estimate_sort_cost(fpinfo, -1.0, NULL, &startup_cost,
+								&total_cost);
 
 		/*
 		 * The EPQ path must be at least as well sorted as the path itself, in
@@ -2896,7 +4346,7 @@ hdfs_find_em_for_rel(PlannerInfo *root, EquivalenceClass *ec, RelOptInfo *rel)
 		 */
 		if (bms_is_subset(em->em_relids, rel->relids) &&
 			!bms_is_empty(em->em_relids) &&
-			hdfs_is_foreign_expr(root, rel, em->em_expr, true))
+			hdfs_is_foreign_expr(root, rel, em->em_expr))
 			return em;
 	}
 
@@ -2928,11 +4378,12 @@ hdfs_add_foreign_ordered_paths(PlannerInfo *root, RelOptInfo *input_rel,
 	fpinfo->enable_order_by_pushdown =
 		((HDFSFdwRelationInfo *) input_rel->fdw_private)->enable_order_by_pushdown;
 
-	if (!enable_order_by_pushdown || !fpinfo->enable_order_by_pushdown)
+	if (!fpinfo->enable_order_by_pushdown)
 		return;
 
 	fpinfo->client_type =
 		((HDFSFdwRelationInfo *) input_rel->fdw_private)->client_type;
+	fpinfo->dialect = ((HDFSFdwRelationInfo *) input_rel->fdw_private)->dialect;
 
 	/* Shouldn't get here unless the query has ORDER BY */
 	Assert(parse->sortClause);
@@ -2949,22 +4400,35 @@ hdfs_add_foreign_ordered_paths(PlannerInfo *root, RelOptInfo *input_rel,
 	 * considered pushing down the final sort to the remote server when
 	 * creating pre-sorted foreign paths for that relation, because the
 	 * query_pathkeys is set to the root->sort_pathkeys in that case (see
-	 * standard_qp_callback()).
+	 * standard_qp_callback()).  The sort is still marked as safe to push
+	 * down, so that hdfs_add_foreign_final_paths() can push it down along
+	 * with a LIMIT even when full sorts aren't.
 	 */
 	if (input_rel->reloptkind == RELOPT_BASEREL ||
 		input_rel->reloptkind == RELOPT_JOINREL)
 	{
 		Assert(root->query_pathkeys == root->sort_pathkeys);
 
-		/* Safe to push down if the query_pathkeys is safe to push down */
-		fpinfo->pushdown_safe = ifpinfo->qp_is_pushdown_safe;
+		foreach(lc, root->sort_pathkeys)
+		{
+			if (!hdfs_is_foreign_pathkey(root, input_rel,
+										 (PathKey *) lfirst(lc)))
+				return;
+		}
+
+		/* Safe to push down */
+		fpinfo->pushdown_safe = true;
 
 		return;
 	}
 
-	/* The input_rel should be a grouping relation */
-	Assert(input_rel->reloptkind == RELOPT_UPPER_REL &&
-		   ifpinfo->stage == UPPERREL_GROUP_AGG);
+	/*
+	 * Only the final sort of a grouping relation is pushed down; the targets
+	 * of a window or distinct relation aren't tracked for it.
+	 */
+	if (input_rel->reloptkind != RELOPT_UPPER_REL ||
+		ifpinfo->stage != UPPERREL_GROUP_AGG)
+		return;
 
 	/*
 	 * We try to create a path below by extending a simple foreign path for
@@ -2978,6 +4442,7 @@ hdfs_add_foreign_ordered_paths(PlannerInfo *root, RelOptInfo *input_rel,
 		PathKey    *pathkey = (PathKey *) lfirst(lc);
 		EquivalenceClass *pathkey_ec = pathkey->pk_eclass;
 		EquivalenceMember *em;
+		const char *sortby_dir;
 
 		/*
 		 * hdfs_is_foreign_expr would detect volatile expressions as well, but
@@ -2992,17 +4457,24 @@ hdfs_add_foreign_ordered_paths(PlannerInfo *root, RelOptInfo *input_rel,
 		 */
 		em = hdfs_find_em_for_rel_target(root, pathkey_ec, input_rel);
 
-		if (hdfs_get_sortby_direction_string(em, pathkey) == NULL)
+		sortby_dir = hdfs_get_sortby_direction_string(em, pathkey);
+		if (sortby_dir == NULL ||
+			!hdfs_is_nulls_order_pushable(ifpinfo->dialect, sortby_dir,
+										  pathkey->pk_nulls_first))
 			return;
 	}
 
 	/* Safe to push down */
 	fpinfo->pushdown_safe = true;
 
-	/* TODO: Put accurate estimates */
-	startup_cost = 15;
-	total_cost = 10 + startup_cost;
-	rows = 10;
+	/*
+	 * A full sort is pushed down only if enabled; a sort followed by a LIMIT
+	 * is considered by hdfs_add_foreign_final_paths() anyway.
+	 */
+	if (!enable_order_by_pushdown)
+		return;
+
+	hdfs_estimate_sort_cost(ifpinfo, -1.0, &rows, &startup_cost, &total_cost);
 
 	/*
 	 * Build the fdw_private list that will be used by hdfsGetForeignPlan.
@@ -3114,7 +4586,7 @@ hdfs_find_em_for_rel_target(PlannerInfo *root, EquivalenceClass *ec,
 				continue;
 
 			/* Check that expression (including relabels!) is shippable */
-			if (hdfs_is_foreign_expr(root, rel, em->em_expr, true))
+			if (hdfs_is_foreign_expr(root, rel, em->em_expr))
 				return em;
 		}
 
@@ -3282,8 +4754,11 @@ hdfs_add_foreign_final_paths(PlannerInfo *root, RelOptInfo *input_rel,
 	if (input_rel->reloptkind == RELOPT_UPPER_REL &&
 		ifpinfo->stage == UPPERREL_ORDERED)
 	{
-		/* Do not push down LIMIT if ORDER BY push down is disabled */
-		if (!enable_order_by_pushdown)
+		/*
+		 * Unless full sorts are pushed down, push down the sort only if it
+		 * keeps the first rows, which the reducer does with a bounded heap.
+		 */
+		if (!enable_order_by_pushdown && !parse->limitCount)
 			return;
 
 		input_rel = ifpinfo->outerrel;
@@ -3292,11 +4767,16 @@ hdfs_add_foreign_final_paths(PlannerInfo *root, RelOptInfo *input_rel,
 		pathkeys = root->sort_pathkeys;
 	}
 
-	/* The input_rel should be a base, join, or grouping relation */
+	/*
+	 * The input_rel should be a base, join, grouping, window or distinct
+	 * relation
+	 */
 	Assert(input_rel->reloptkind == RELOPT_BASEREL ||
 		   input_rel->reloptkind == RELOPT_JOINREL ||
 		   (input_rel->reloptkind == RELOPT_UPPER_REL &&
-			ifpinfo->stage == UPPERREL_GROUP_AGG));
+			(ifpinfo->stage == UPPERREL_GROUP_AGG ||
+			 ifpinfo->stage == UPPERREL_WINDOW ||
+			 ifpinfo->stage == UPPERREL_DISTINCT)));
 
 	/*
 	 * We try to create a path below by extending a simple foreign path for
@@ -3361,21 +4841,41 @@ hdfs_add_foreign_final_paths(PlannerInfo *root, RelOptInfo *input_rel,
 		}
 	}
 
+	/* OFFSET is only known by hive 2.0 and spark 3.4 on */
+	if (parse->limitOffset && !ifpinfo->dialect->limit_offset &&
+		!(IsA(parse->limitOffset, Const) &&
+		  ((Const *) parse->limitOffset)->constisnull))
+		return;
+
 	/*
 	 * Also, the LIMIT/OFFSET cannot be pushed down, if their expressions are
 	 * not safe to remote.
 	 */
-	if (!hdfs_is_foreign_expr(root, input_rel, (Expr *) parse->limitOffset, true) ||
-		!hdfs_is_foreign_expr(root, input_rel, (Expr *) parse->limitCount, true))
+	if (!hdfs_is_foreign_expr(root, input_rel, (Expr *) parse->limitOffset) ||
+		!hdfs_is_foreign_expr(root, input_rel, (Expr *) parse->limitCount))
 		return;
 
 	/* Safe to push down */
 	fpinfo->pushdown_safe = true;
 
-	/* TODO: Put accurate estimates */
-	startup_cost = 1;
-	total_cost = 1 + startup_cost;
-	rows = 1;
+	if (has_final_sort)
+	{
+		/*
+		 * The number of rows kept by the sort is only known when the LIMIT
+		 * and OFFSET are constants, otherwise it's costed as a full sort.
+		 */
+		hdfs_estimate_sort_cost(ifpinfo, extra->limit_tuples, &rows,
+								&startup_cost, &total_cost);
+		if (extra->offset_est > 0)
+			rows = clamp_row_est(rows - extra->offset_est);
+	}
+	else
+	{
+		/* TODO: Put accurate estimates */
+		startup_cost = 1;
+		total_cost = 1 + startup_cost;
+		rows = 1;
+	}
 
 	/*
 	 * Build the fdw_private list that will be used by hdfsGetForeignPlan.
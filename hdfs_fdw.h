@@ -14,6 +14,7 @@
 #ifndef HADOOP_FDW_H
 #define HADOOP_FDW_H
 
+#include "executor/tuptable.h"
 #include "foreign/foreign.h"
 #include "lib/stringinfo.h"
 #include "libhive/jdbc/hiveclient.h"
@@ -26,9 +27,40 @@
  */
 #define DEFAULT_DATABASE "default"
 
+/* Default CPU cost to start up a foreign query. */
+#define DEFAULT_FDW_STARTUP_COST    100000.0
+
+/* Default CPU cost to process 1 row  */
+#define DEFAULT_FDW_TUPLE_COST      1000.0
+
 /* Macro for list API backporting. */
 #define hdfs_list_concat(l1, l2) list_concat((l1), (l2))
 
+/*
+ * Capabilities of a remote server, depending on its kind and version, as
+ * given by hdfs_get_dialect().
+ */
+typedef struct hdfs_dialect
+{
+	CLIENT_TYPE client_type;
+	int			server_version; /* e.g. 30103 for 3.1.3, 0 if unknown */
+	bool		limit_offset;	/* OFFSET along with LIMIT */
+	bool		nulls_ordering; /* NULLS FIRST/LAST in ORDER BY */
+	bool		window_functions;
+	bool		grouping_function;	/* grouping() of GROUPING SETS */
+	bool		is_distinct_from;	/* IS DISTINCT FROM, otherwise <=> */
+	bool		interval_literals;	/* INTERVAL '...' DAY TO SECOND */
+	bool		analyze_returns_rows;	/* ANALYZE TABLE returns a result */
+} hdfs_dialect;
+
+/* Which sides of the joins sent to a server are hinted to be broadcast */
+typedef enum HDFS_JOIN_HINTS
+{
+	HDFS_JOIN_HINTS_AUTO,		/* those estimated small enough */
+	HDFS_JOIN_HINTS_FORCE,		/* the smaller side of every join */
+	HDFS_JOIN_HINTS_OFF
+} HDFS_JOIN_HINTS;
+
 /* Options structure to store the HDFS server information */
 typedef struct hdfs_opt
 {
@@ -53,6 +85,20 @@ typedef struct hdfs_opt
 	bool		useSystemTrustStore;
 	char	   *sslTrustStore;
 	char	   *trustStorePassword;
+	bool		use_observed_costs;
+	int			result_cache_ttl;	/* seconds, 0 disables the cache */
+	bool		result_cache_validate;
+	bool		allow_approximate_aggregates;
+	int			server_version; /* 0 if it is to be probed */
+	hdfs_dialect *dialect;
+	HDFS_JOIN_HINTS join_hints;
+	char	   *partition_predicate;	/* rows of the remote table read by a
+										 * partition, NULL for all */
+	double		row_estimate;	/* rows assumed without use_remote_estimate,
+								 * 0 for the default */
+	bool		trust_metastore_stats;
+	bool		staging;		/* may hdfs_fdw_stage() replace the remote
+								 * table? */
 } hdfs_opt;
 
 /*
@@ -63,7 +109,7 @@ typedef struct HDFSFdwRelationInfo
 {
 	/*
 	 * True means that the relation can be pushed down. Always true for simple
-	 * foreign scan.
+	 * foreign scan, unless it reads a local snapshot.
 	 */
 	bool		pushdown_safe;
 
@@ -74,9 +120,6 @@ typedef struct HDFSFdwRelationInfo
 	/* Bitmap of attr numbers we need to fetch from the remote server. */
 	Bitmapset  *attrs_used;
 
-	/* True means that the query_pathkeys is safe to push down */
-	bool		qp_is_pushdown_safe;
-
 	/* Cost and selectivity of local_conds. */
 	QualCost	local_conds_cost;
 	Selectivity local_conds_sel;
@@ -131,20 +174,50 @@ typedef struct HDFSFdwRelationInfo
 	/* Upper relation information */
 	UpperRelationKind stage;
 
+	/* True means that the relation is scanned from its local snapshot */
+	bool		use_snapshot;
+
+	/*
+	 * Partition columns of the remote table, if known and partitioned, the
+	 * remote conditions on constant values of these columns, and whether any
+	 * remote condition is on these columns.
+	 */
+	Bitmapset  *partition_attrs;
+	List	   *partition_conds;
+	bool		has_partition_filter;
+
+	/*
+	 * Aggregates of a grouping relation answered from the metadata of the
+	 * remote table, as planned by hdfs_plan_metadata_aggs(), or NIL.
+	 */
+	List	   *metadata_aggs;
+
 	/* Inherit required flags from hdfs_opt */
 	bool		enable_aggregate_pushdown;
 	bool		enable_order_by_pushdown;
+	bool		allow_approximate_aggregates;
 	CLIENT_TYPE client_type;
+	hdfs_dialect *dialect;
+	HDFS_JOIN_HINTS join_hints;
 } HDFSFdwRelationInfo;
 
 /* hdfs_option.c headers */
 extern hdfs_opt *hdfs_get_options(Oid foreigntableid);
+extern hdfs_opt *hdfs_get_server_options(Oid serverid);
 
 /* hdfs_connection.c headers */
 extern int	hdfs_get_connection(ForeignServer *server, hdfs_opt *opt);
 extern void hdfs_rel_connection(int con_index);
 
+/* hdfs_dialect.c headers */
+extern int	hdfs_parse_server_version(const char *str);
+extern void hdfs_probe_server_version(int con_index, ForeignServer *server,
+									  hdfs_opt *opt);
+extern hdfs_dialect *hdfs_get_dialect(Oid serverid, hdfs_opt *opt);
+
 /* hdfs_deparse.c headers */
+extern int	hdfs_join_hint_threshold;
+
 extern void hdfs_deparse_select_stmt_for_rel(StringInfo buf, PlannerInfo *root,
 											 RelOptInfo *rel, List *tlist,
 											 List *remote_conds,
@@ -158,10 +231,34 @@ extern void hdfs_classify_conditions(PlannerInfo *root, RelOptInfo *baserel,
 									 List *input_conds, List **remote_conds,
 									 List **local_conds);
 extern bool hdfs_is_foreign_expr(PlannerInfo *root, RelOptInfo *baserel,
-								 Expr *expr, bool is_remote_cond);
+								 Expr *expr);
 extern void hdfs_deparse_describe(StringInfo buf, Relation rel);
-extern void hdfs_deparse_explain(hdfs_opt *opt, StringInfo buf);
-extern void hdfs_deparse_analyze(StringInfo buf, Relation rel);
+extern void hdfs_deparse_describe_partition(StringInfo buf, Relation rel,
+											const char *partition);
+extern void hdfs_deparse_show_partitions(StringInfo buf, Relation rel);
+extern void hdfs_deparse_snapshot_select(StringInfo buf, Relation rel,
+										 const char *partition);
+extern void hdfs_deparse_drop_table(StringInfo buf, Relation rel);
+extern void hdfs_deparse_create_table(StringInfo buf, Relation rel);
+extern void hdfs_deparse_insert(StringInfo buf, Relation rel);
+extern void hdfs_deparse_values_row(StringInfo buf, Relation rel,
+									Datum *values, bool *nulls);
+extern void hdfs_deparse_column_ref(StringInfo buf, Oid relid, int attnum);
+extern int	hdfs_deparse_literal_list(StringInfo buf, Oid type, Datum *values,
+									  int nvalues);
+extern void hdfs_deparse_explain(hdfs_opt *opt, StringInfo buf,
+								 PlannerInfo *root, RelOptInfo *baserel,
+								 List *conds);
+extern char *hdfs_get_column_name(Oid relid, int attnum);
+extern void hdfs_deparse_partition_spec(StringInfo buf, const char *partition,
+										bool as_condition);
+extern char *hdfs_unescape_path_name(const char *str, int len);
+extern void hdfs_deparse_analyze(StringInfo buf, Relation rel,
+								 const char *partition);
+extern void hdfs_deparse_show_tables(StringInfo buf, const char *dbname);
+extern void hdfs_deparse_describe_table(StringInfo buf, const char *dbname,
+										const char *table_name,
+										bool formatted);
 extern bool hdfs_is_foreign_param(PlannerInfo *root, RelOptInfo *baserel,
 								  Expr *expr);
 extern bool hdfs_is_foreign_pathkey(PlannerInfo *root,
@@ -169,6 +266,9 @@ extern bool hdfs_is_foreign_pathkey(PlannerInfo *root,
 									PathKey *pathkey);
 extern char *hdfs_get_sortby_direction_string(EquivalenceMember *em,
 											  PathKey *pathkey);
+extern bool hdfs_is_nulls_order_pushable(hdfs_dialect *dialect,
+										 const char *sortby_dir,
+										 bool nulls_first);
 extern EquivalenceMember *hdfs_find_em_for_rel(PlannerInfo *root,
 											   EquivalenceClass *ec,
 											   RelOptInfo *rel);
@@ -176,14 +276,99 @@ extern EquivalenceMember *hdfs_find_em_for_rel_target(PlannerInfo *root,
 													  EquivalenceClass *ec,
 													  RelOptInfo *rel);
 extern bool hdfs_is_builtin(Oid objectId);
+extern List *hdfs_get_grouping_sets(Query *query);
 
 /* hdfs_query.c headers */
 extern double hdfs_rowcount(int con_index, hdfs_opt *opt, PlannerInfo *root,
 							RelOptInfo *baserel, HDFSFdwRelationInfo *fpinfo);
-extern double hdfs_describe(int con_index, hdfs_opt *opt, Relation rel);
-extern void hdfs_analyze(int con_index, hdfs_opt *opt, Relation rel);
+extern double hdfs_describe(int con_index, hdfs_opt *opt, Relation rel,
+							const char *partition);
+extern void hdfs_analyze(int con_index, hdfs_opt *opt, Relation rel,
+						 const char *partition);
+extern int64 hdfs_get_last_ddl_time(int con_index, hdfs_opt *opt,
+									Relation rel, const char *partition);
+extern List *hdfs_get_partition_columns(int con_index, hdfs_opt *opt,
+										Relation rel);
+extern List *hdfs_get_partitions(int con_index, hdfs_opt *opt, Relation rel);
+extern List *hdfs_get_remote_tables(int con_index, hdfs_opt *opt,
+									const char *dbname);
+extern void hdfs_get_remote_columns(int con_index, hdfs_opt *opt,
+									const char *dbname,
+									const char *table_name, List **names,
+									List **types);
+extern double hdfs_get_remote_row_count(int con_index, hdfs_opt *opt,
+										const char *dbname,
+										const char *table_name);
+extern double hdfs_get_row_count(int con_index, hdfs_opt *opt, Relation rel,
+								 const char *partition);
 extern const char *hdfs_get_jointype_name(JoinType jointype);
 
+/* hdfs_costs.c headers */
+extern void hdfs_record_remote_timing(Oid serverid, double startup_ms,
+									  double row_ms);
+extern bool hdfs_get_observed_costs(Oid serverid, Cost *startup_cost,
+									Cost *tuple_cost);
+
+/* hdfs_cache.c headers */
+typedef struct hdfsCacheFile hdfsCacheFile;
+
+extern int	hdfs_result_cache_size;
+
+extern char *hdfs_cache_key(Oid serverid, Oid userid, const char *username,
+							const char *query, TupleDesc tupdesc,
+							int nparams, Oid *param_types,
+							Datum *param_values, bool *param_nulls);
+extern hdfsCacheFile *hdfs_cache_lookup(const char *key, int ttl,
+										int64 *ddl_times, int nddl_times);
+extern bool hdfs_cache_read(hdfsCacheFile *cf, TupleTableSlot *slot);
+extern hdfsCacheFile *hdfs_cache_begin_write(const char *key,
+											 int64 *ddl_times,
+											 int nddl_times);
+extern bool hdfs_cache_write(hdfsCacheFile *cf, TupleTableSlot *slot);
+extern void hdfs_cache_finish_write(hdfsCacheFile *cf);
+extern void hdfs_cache_close(hdfsCacheFile *cf);
+extern bool hdfs_write_row(FILE *file, TupleTableSlot *slot, uint32 *len);
+extern bool hdfs_read_row(FILE *file, const char *path, TupleTableSlot *slot);
+
+/* hdfs_import.c headers */
+extern List *hdfs_import_foreign_schema(ImportForeignSchemaStmt *stmt,
+										Oid serverOid);
+
+/* hdfs_snapshot.c headers */
+typedef struct hdfsSnapshotScan hdfsSnapshotScan;
+
+extern bool hdfs_snapshot_exists(Relation rel, hdfs_opt *opt, double *rows);
+extern hdfsSnapshotScan *hdfs_snapshot_begin_scan(Relation rel,
+												  hdfs_opt *opt);
+extern bool hdfs_snapshot_read(hdfsSnapshotScan *scan, TupleTableSlot *slot);
+extern void hdfs_snapshot_rescan(hdfsSnapshotScan *scan);
+extern void hdfs_snapshot_end_scan(hdfsSnapshotScan *scan);
+extern void hdfs_check_owned_relation(Relation rel);
+
+/* hdfs_filter.c headers */
+extern int	hdfs_runtime_filter_max_keys;
+
+extern List *hdfs_plan_runtime_filter(PlannerInfo *root, RelOptInfo *baserel,
+									  bool has_where);
+extern char *hdfs_apply_runtime_filter(const char *query, List *filter,
+									   int64 *nkeys);
+extern char *hdfs_explain_runtime_filter(List *filter);
+
+/* hdfs_partition.c headers */
+extern void hdfs_plan_partition_conds(PlannerInfo *root, RelOptInfo *baserel,
+									  Relation rel, hdfs_opt *opt,
+									  int con_index);
+extern List *hdfs_get_unfiltered_partitioned_rels(RelOptInfo *foreignrel);
+extern double hdfs_analyze_partition(int con_index, hdfs_opt *opt,
+									 Relation rel);
+
+/* hdfs_metadata.c headers */
+extern List *hdfs_plan_metadata_aggs(PlannerInfo *root,
+									 RelOptInfo *grouped_rel);
+extern bool hdfs_get_metadata_aggs(int con_index, hdfs_opt *opt, Oid relid,
+								   List *metadata_aggs,
+								   TupleTableSlot *slot);
+
 /* hdfs_client.c headers */
 extern int	hdfs_get_column_count(int con_index);
 extern int	hdfs_fetch(int con_index);
@@ -198,8 +383,10 @@ extern bool hdfs_query_execute_utility(int con_index, hdfs_opt *opt,
 extern void hdfs_close_result_set(int con_index);
 extern bool hdfs_bind_var(int con_index, int param_index, Oid type,
 						  Datum value, bool *isnull);
+extern bool hdfs_is_bindable_type(Oid type);
 
 /* hdfs_fdw.c headers */
+extern bool hdfs_is_hdfs_relation(Relation rel);
 extern List *hdfs_adjust_whole_row_ref(PlannerInfo *root,
 									   List *scan_var_list,
 									   List **whole_row_lists,
@@ -0,0 +1,390 @@
+/*-------------------------------------------------------------------------
+ *
+ * hdfs_filter.c
+ * 		Runtime join filters restricting the scan of a remote table to the
+ * 		join keys of a small local table.
+ *
+ * When a foreign table is joined on an equality with a local table expected
+ * to return only a few rows, the distinct join keys of that local table are
+ * read when the scan starts, and added to the remote query as an IN list.
+ * Hive then only returns the rows of the remote table that can match, and
+ * can skip the partitions having none of the keys.
+ *
+ * Portions Copyright (c) 2012-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 2004-2025, EnterpriseDB Corporation.
+ *
+ * IDENTIFICATION
+ * 		hdfs_filter.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "catalog/pg_class.h"
+#include "catalog/pg_collation.h"
+#include "catalog/pg_type.h"
+#include "executor/spi.h"
+#include "hdfs_fdw.h"
+#include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/optimizer.h"
+#include "optimizer/pathnode.h"
+#if PG_VERSION_NUM >= 160000
+#include "parser/parse_relation.h"
+#endif
+#include "rewrite/rewriteManip.h"
+#include "utils/builtins.h"
+#include "utils/lsyscache.h"
+#include "utils/ruleutils.h"
+
+/* Maximum number of keys of a runtime filter, 0 disables runtime filters. */
+int			hdfs_runtime_filter_max_keys = 1000;
+
+/*
+ * Indexes of the items of a runtime filter, as planned by
+ * hdfs_plan_runtime_filter() and kept in the fdw_private list of the scan.
+ */
+enum hdfsRuntimeFilterIndex
+{
+	/* Local query returning the distinct keys (as a String node) */
+	hdfsRuntimeFilterLocalSql,
+
+	/* Remote column compared with the keys (as a String node) */
+	hdfsRuntimeFilterColumn,
+
+	/* Does the remote query have a WHERE clause? (as an Integer node) */
+	hdfsRuntimeFilterHasWhere
+};
+
+static bool hdfs_is_filter_key_type(Oid type, Oid collation);
+static bool hdfs_is_checked_as_current_user(PlannerInfo *root,
+											RangeTblEntry *rte);
+static char *hdfs_build_filter_query(PlannerInfo *root, RelOptInfo *rel,
+									 Var *key);
+static bool hdfs_contains_outer_reference(Node *node, void *context);
+
+/*
+ * hdfs_plan_runtime_filter
+ * 		Look for a local table joined with the given foreign table that is
+ * 		small enough to filter its remote scan, and return the runtime filter
+ * 		to apply, or NIL if there is none.
+ *
+ * Only the equalities of equivalence classes are considered: any row of the
+ * foreign table not matching a row of the local table is then removed by the
+ * join.  The equality of an outer join clause is not, as the rows of the
+ * preserved side must be kept.  has_where tells whether the remote query has
+ * a WHERE clause already.
+ *
+ * The keys are read by the current user, so a local table whose privileges
+ * are checked as another user, like the owner of a view, isn't considered.
+ */
+List *
+hdfs_plan_runtime_filter(PlannerInfo *root, RelOptInfo *baserel,
+						 bool has_where)
+{
+	RelOptInfo *best_rel = NULL;
+	Var		   *best_key = NULL;
+	Var		   *best_column = NULL;
+	StringInfoData column;
+	ListCell   *lc;
+
+	if (hdfs_runtime_filter_max_keys <= 0)
+		return NIL;
+
+	/*
+	 * The local query evaluates all the conditions of the local table in any
+	 * order, which security barrier conditions forbid.
+	 */
+	if (root->qual_security_level > 0)
+		return NIL;
+
+	foreach(lc, root->eq_classes)
+	{
+		EquivalenceClass *ec = (EquivalenceClass *) lfirst(lc);
+		Var		   *column_var = NULL;
+		ListCell   *lc_em;
+
+		if (ec->ec_has_const || ec->ec_has_volatile || ec->ec_broken ||
+			!bms_is_subset(baserel->relids, ec->ec_relids))
+			continue;
+
+		/* Find the column of the foreign table first. */
+		foreach(lc_em, ec->ec_members)
+		{
+			EquivalenceMember *em = (EquivalenceMember *) lfirst(lc_em);
+
+			if (!em->em_is_child && bms_equal(em->em_relids, baserel->relids) &&
+				IsA(em->em_expr, Var) && ((Var *) em->em_expr)->varattno > 0)
+			{
+				column_var = (Var *) em->em_expr;
+				break;
+			}
+		}
+
+		if (column_var == NULL ||
+			!hdfs_is_filter_key_type(column_var->vartype, ec->ec_collation))
+			continue;
+
+		/* Then the column of the smallest local table. */
+		foreach(lc_em, ec->ec_members)
+		{
+			EquivalenceMember *em = (EquivalenceMember *) lfirst(lc_em);
+			Var		   *key = (Var *) em->em_expr;
+			RelOptInfo *rel;
+			RangeTblEntry *rte;
+			int			relid;
+			char		relkind;
+
+			if (em->em_is_child || !IsA(key, Var) || key->varattno <= 0 ||
+				key->vartype != column_var->vartype ||
+				!bms_get_singleton_member(em->em_relids, &relid) ||
+				relid >= root->simple_rel_array_size)
+				continue;
+
+			rel = root->simple_rel_array[relid];
+			if (rel == NULL || rel->reloptkind != RELOPT_BASEREL ||
+				rel == baserel)
+				continue;
+
+			rte = planner_rt_fetch(relid, root);
+			if (rte->rtekind != RTE_RELATION ||
+				!hdfs_is_checked_as_current_user(root, rte))
+				continue;
+
+			relkind = get_rel_relkind(rte->relid);
+			if (relkind != RELKIND_RELATION && relkind != RELKIND_MATVIEW &&
+				relkind != RELKIND_PARTITIONED_TABLE)
+				continue;
+
+			if (rel->rows > hdfs_runtime_filter_max_keys ||
+				(best_rel && rel->rows >= best_rel->rows))
+				continue;
+
+			best_rel = rel;
+			best_key = key;
+			best_column = column_var;
+		}
+	}
+
+	if (best_rel == NULL)
+		return NIL;
+
+	initStringInfo(&column);
+	hdfs_deparse_column_ref(&column,
+							planner_rt_fetch(baserel->relid, root)->relid,
+							best_column->varattno);
+
+	return list_make3(makeString(hdfs_build_filter_query(root, best_rel,
+														 best_key)),
+					  makeString(column.data),
+					  makeInteger(has_where));
+}
+
+/*
+ * hdfs_is_filter_key_type
+ * 		Check that the values of the given type are compared the same way by
+ * 		PostgreSQL and hive, and can be written as hive literals.
+ *
+ * Strings compare the same way only with a deterministic collation.
+ */
+static bool
+hdfs_is_filter_key_type(Oid type, Oid collation)
+{
+	switch (type)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case NUMERICOID:
+		case DATEOID:
+		case TIMESTAMPOID:
+			return true;
+		case TEXTOID:
+		case VARCHAROID:
+			return OidIsValid(collation) &&
+				get_collation_isdeterministic(collation);
+		default:
+			return false;
+	}
+}
+
+/*
+ * hdfs_is_checked_as_current_user
+ * 		Check that the privileges on the given relation are checked as the
+ * 		current user, who reads the keys of the filter.
+ */
+static bool
+hdfs_is_checked_as_current_user(PlannerInfo *root, RangeTblEntry *rte)
+{
+	Oid			checkAsUser;
+
+#if PG_VERSION_NUM >= 160000
+	if (rte->perminfoindex == 0)
+		return false;
+	checkAsUser = getRTEPermissionInfo(root->parse->rteperminfos,
+									   rte)->checkAsUser;
+#else
+	checkAsUser = rte->checkAsUser;
+#endif
+
+	return !OidIsValid(checkAsUser) || checkAsUser == GetUserId();
+}
+
+/*
+ * hdfs_build_filter_query
+ * 		Build the local query returning the distinct non-NULL keys of the
+ * 		given local table, restricted by its conditions.
+ *
+ * A condition whose value changes from one evaluation to the next, or which
+ * depends on the outer rows, is left out.  The query then returns more keys
+ * than needed, which doesn't change the result of the join.
+ */
+static char *
+hdfs_build_filter_query(PlannerInfo *root, RelOptInfo *rel, Var *key)
+{
+	RangeTblEntry *rte = planner_rt_fetch(rel->relid, root);
+	List	   *dpcontext;
+	StringInfoData sql;
+	Node	   *node;
+	ListCell   *lc;
+
+	/* Deparse the Vars of the table with the alias given below. */
+	dpcontext = deparse_context_for("r", rte->relid);
+
+	node = (Node *) copyObject(key);
+	ChangeVarNodes(node, rel->relid, 1, 0);
+
+	initStringInfo(&sql);
+	appendStringInfo(&sql, "SELECT DISTINCT %s FROM %s%s r WHERE %s IS NOT NULL",
+					 deparse_expression(node, dpcontext, true, false),
+					 rte->inh ? "" : "ONLY ",
+					 quote_qualified_identifier(get_namespace_name(get_rel_namespace(rte->relid)),
+												get_rel_name(rte->relid)),
+					 deparse_expression(node, dpcontext, true, false));
+
+	foreach(lc, rel->baserestrictinfo)
+	{
+		RestrictInfo *rinfo = lfirst_node(RestrictInfo, lc);
+
+		if (rinfo->pseudoconstant ||
+			contain_volatile_functions((Node *) rinfo->clause) ||
+			hdfs_contains_outer_reference((Node *) rinfo->clause, NULL))
+			continue;
+
+		node = (Node *) copyObject(rinfo->clause);
+		ChangeVarNodes(node, rel->relid, 1, 0);
+		appendStringInfo(&sql, " AND (%s)",
+						 deparse_expression(node, dpcontext, true, false));
+	}
+
+	return sql.data;
+}
+
+/*
+ * hdfs_contains_outer_reference
+ * 		Expression tree walker returning true if the condition refers to
+ * 		something the local query can't evaluate on its own, like the
+ * 		parameters set by a nested loop or a sub-select.
+ */
+static bool
+hdfs_contains_outer_reference(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Param) || IsA(node, SubLink) || IsA(node, SubPlan) ||
+		IsA(node, AlternativeSubPlan) || IsA(node, PlaceHolderVar))
+		return true;
+
+	return expression_tree_walker(node, hdfs_contains_outer_reference, context);
+}
+
+/*
+ * hdfs_apply_runtime_filter
+ * 		Read the keys of the runtime filter, and return the remote query with
+ * 		the condition they make.
+ *
+ * The query is returned unchanged if there are more keys than
+ * hdfs_fdw.runtime_filter_max_keys, in which case -1 is returned to *nkeys.
+ * Otherwise the number of keys is.
+ */
+char *
+hdfs_apply_runtime_filter(const char *query, List *filter, int64 *nkeys)
+{
+	char	   *local_sql = strVal(list_nth(filter, hdfsRuntimeFilterLocalSql));
+	char	   *column = strVal(list_nth(filter, hdfsRuntimeFilterColumn));
+	bool		has_where = intVal(list_nth(filter, hdfsRuntimeFilterHasWhere));
+	MemoryContext cxt = CurrentMemoryContext;
+	MemoryContext oldcxt;
+	StringInfoData sql;
+	StringInfoData list;
+	Datum	   *keys;
+	Oid			type;
+	uint64		i;
+	int			ret;
+
+	if (hdfs_runtime_filter_max_keys <= 0)
+	{
+		*nkeys = -1;
+		return pstrdup(query);
+	}
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "SPI_connect failed");
+
+	ret = SPI_execute(psprintf("%s LIMIT %d", local_sql,
+							   hdfs_runtime_filter_max_keys + 1),
+					  true, 0);
+	if (ret != SPI_OK_SELECT)
+		elog(ERROR, "SPI_execute failed: %s", SPI_result_code_string(ret));
+
+	oldcxt = MemoryContextSwitchTo(cxt);
+
+	initStringInfo(&sql);
+	appendStringInfoString(&sql, query);
+
+	if (SPI_processed > (uint64) hdfs_runtime_filter_max_keys)
+		*nkeys = -1;
+	else
+	{
+		appendStringInfoString(&sql, has_where ? " AND " : " WHERE ");
+
+		type = SPI_gettypeid(SPI_tuptable->tupdesc, 1);
+		keys = (Datum *) palloc(sizeof(Datum) * Max(SPI_processed, 1));
+		for (i = 0; i < SPI_processed; i++)
+		{
+			bool		isnull;
+
+			keys[i] = SPI_getbinval(SPI_tuptable->vals[i],
+									SPI_tuptable->tupdesc, 1, &isnull);
+		}
+
+		initStringInfo(&list);
+		*nkeys = hdfs_deparse_literal_list(&list, type, keys,
+										   (int) SPI_processed);
+
+		/* Without any key, no row can match. */
+		if (*nkeys > 0)
+			appendStringInfo(&sql, "(%s IN (%s))", column, list.data);
+		else
+			appendStringInfoString(&sql, "(FALSE)");
+	}
+
+	MemoryContextSwitchTo(oldcxt);
+	SPI_finish();
+
+	return sql.data;
+}
+
+/*
+ * hdfs_explain_runtime_filter
+ * 		Describe the runtime filter for EXPLAIN.
+ */
+char *
+hdfs_explain_runtime_filter(List *filter)
+{
+	return psprintf("%s IN (%s)",
+					strVal(list_nth(filter, hdfsRuntimeFilterColumn)),
+					strVal(list_nth(filter, hdfsRuntimeFilterLocalSql)));
+}
@@ -0,0 +1,268 @@
+/*-------------------------------------------------------------------------
+ *
+ * hdfs_import.c
+ * 		IMPORT FOREIGN SCHEMA for the databases of Hive/Spark servers.
+ *
+ * The tables of the remote database are listed with SHOW TABLES, and the
+ * columns of each one with DESCRIBE, all over the same connection.  Each
+ * HiveQL type is mapped to the PostgreSQL type holding the same values, so
+ * that the conditions on the columns can be pushed down and their values
+ * needn't be converted through text: decimal(p,s) to numeric(p,s),
+ * varchar(n) to varchar(n), and the complex types to jsonb.
+ *
+ * Portions Copyright (c) 2012-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 2004-2025, EnterpriseDB Corporation.
+ *
+ * IDENTIFICATION
+ * 		hdfs_import.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <ctype.h>
+
+#include "commands/defrem.h"
+#include "foreign/foreign.h"
+#include "hdfs_fdw.h"
+#include "utils/builtins.h"
+
+static bool hdfs_is_imported_table(ImportForeignSchemaStmt *stmt,
+								   const char *table_name);
+static const char *hdfs_map_type(const char *hive_type);
+static bool hdfs_is_type_modifier(const char *str);
+static bool hdfs_has_json_map_keys(const char *hive_type);
+
+/*
+ * hdfs_import_foreign_schema
+ * 		Build the CREATE FOREIGN TABLE statements of the tables of the remote
+ * 		database named by the statement.
+ *
+ * With the import_statistics option, the row count recorded by the metastore
+ * for each table becomes its row_estimate option, so that the new foreign
+ * tables are planned with their actual sizes without use_remote_estimate.
+ */
+List *
+hdfs_import_foreign_schema(ImportForeignSchemaStmt *stmt, Oid serverOid)
+{
+	ForeignServer *server = GetForeignServer(serverOid);
+	hdfs_opt   *opt = hdfs_get_server_options(serverOid);
+	bool		import_statistics = false;
+	List	   *commands = NIL;
+	List	   *tables;
+	int			con_index;
+	ListCell   *lc;
+
+	foreach(lc, stmt->options)
+	{
+		DefElem    *def = (DefElem *) lfirst(lc);
+
+		if (strcmp(def->defname, "import_statistics") == 0)
+			import_statistics = defGetBoolean(def);
+		else
+			ereport(ERROR,
+					(errcode(ERRCODE_FDW_INVALID_OPTION_NAME),
+					 errmsg("invalid option \"%s\"", def->defname),
+					 errhint("Valid options in this context are: import_statistics.")));
+	}
+
+	/* The connection is opened on the database to import from. */
+	opt->dbname = stmt->remote_schema;
+	con_index = hdfs_get_connection(server, opt);
+
+	tables = hdfs_get_remote_tables(con_index, opt, stmt->remote_schema);
+
+	foreach(lc, tables)
+	{
+		char	   *table_name = (char *) lfirst(lc);
+		List	   *names;
+		List	   *types;
+		ListCell   *lc_name;
+		ListCell   *lc_type;
+		bool		first = true;
+		StringInfoData buf;
+
+		if (!hdfs_is_imported_table(stmt, table_name))
+			continue;
+
+		hdfs_get_remote_columns(con_index, opt, stmt->remote_schema,
+								table_name, &names, &types);
+
+		initStringInfo(&buf);
+		appendStringInfo(&buf, "CREATE FOREIGN TABLE %s (",
+						 quote_identifier(table_name));
+
+		forboth(lc_name, names, lc_type, types)
+		{
+			if (!first)
+				appendStringInfoChar(&buf, ',');
+			first = false;
+			appendStringInfo(&buf, "\n  %s %s",
+							 quote_identifier((char *) lfirst(lc_name)),
+							 hdfs_map_type((char *) lfirst(lc_type)));
+		}
+
+		appendStringInfo(&buf, "\n) SERVER %s\nOPTIONS (dbname %s, table_name %s",
+						 quote_identifier(server->servername),
+						 quote_literal_cstr(stmt->remote_schema),
+						 quote_literal_cstr(table_name));
+
+		if (import_statistics)
+		{
+			double		rows = hdfs_get_remote_row_count(con_index, opt,
+														 stmt->remote_schema,
+														 table_name);
+
+			if (rows > 0)
+				appendStringInfo(&buf, ", row_estimate '%.0f'", rows);
+		}
+
+		appendStringInfoString(&buf, ");");
+
+		commands = lappend(commands, buf.data);
+	}
+
+	hdfs_rel_connection(con_index);
+
+	return commands;
+}
+
+/*
+ * hdfs_is_imported_table
+ * 		Check that the given remote table is to be imported, according to the
+ * 		LIMIT TO or EXCEPT clause of the statement.
+ *
+ * The core code filters the statements again, but this saves describing the
+ * tables which aren't imported.
+ */
+static bool
+hdfs_is_imported_table(ImportForeignSchemaStmt *stmt, const char *table_name)
+{
+	ListCell   *lc;
+
+	if (stmt->list_type == FDW_IMPORT_SCHEMA_ALL)
+		return true;
+
+	foreach(lc, stmt->table_list)
+	{
+		RangeVar   *rv = (RangeVar *) lfirst(lc);
+
+		if (strcmp(rv->relname, table_name) == 0)
+			return (stmt->list_type == FDW_IMPORT_SCHEMA_LIMIT_TO);
+	}
+
+	return (stmt->list_type == FDW_IMPORT_SCHEMA_EXCEPT);
+}
+
+/*
+ * hdfs_map_type
+ * 		Get the PostgreSQL type of a column of the given HiveQL type.
+ *
+ * Hive has no one-byte integer, so tinyint is mapped to smallint.  The
+ * complex types are returned by the remote server in JSON, and are mapped to
+ * jsonb, unless they have maps whose keys aren't strings, as the keys are
+ * then written without quotes.  Other types are mapped to text.
+ */
+static const char *
+hdfs_map_type(const char *hive_type)
+{
+	char	   *type = pstrdup(hive_type);
+	char	   *p;
+
+	for (p = type; *p; p++)
+		*p = pg_tolower((unsigned char) *p);
+
+	if (strncmp(type, "array<", 6) == 0 ||
+		strncmp(type, "map<", 4) == 0 ||
+		strncmp(type, "struct<", 7) == 0)
+		return hdfs_has_json_map_keys(type) ? "jsonb" : "text";
+
+	if (strcmp(type, "tinyint") == 0 || strcmp(type, "smallint") == 0)
+		return "smallint";
+	if (strcmp(type, "int") == 0 || strcmp(type, "integer") == 0)
+		return "integer";
+	if (strcmp(type, "bigint") == 0)
+		return "bigint";
+	if (strcmp(type, "float") == 0)
+		return "real";
+	if (strcmp(type, "double") == 0 || strcmp(type, "double precision") == 0)
+		return "double precision";
+	if (strcmp(type, "boolean") == 0)
+		return "boolean";
+	if (strcmp(type, "binary") == 0)
+		return "bytea";
+	if (strcmp(type, "date") == 0)
+		return "date";
+	if (strcmp(type, "timestamp") == 0 || strcmp(type, "timestamp_ntz") == 0)
+		return "timestamp";
+	if (strcmp(type, "timestamp with local time zone") == 0 ||
+		strcmp(type, "timestamp_ltz") == 0)
+		return "timestamptz";
+
+	/* A decimal without precision and scale is a decimal(10,0) for Hive. */
+	if (strcmp(type, "decimal") == 0 || strcmp(type, "numeric") == 0)
+		return "numeric(10,0)";
+	if (strncmp(type, "decimal(", 8) == 0 && hdfs_is_type_modifier(type + 7))
+		return psprintf("numeric%s", type + 7);
+	if (strncmp(type, "numeric(", 8) == 0 && hdfs_is_type_modifier(type + 7))
+		return psprintf("numeric%s", type + 7);
+	if (strncmp(type, "varchar(", 8) == 0 && hdfs_is_type_modifier(type + 7))
+		return psprintf("varchar%s", type + 7);
+	if (strncmp(type, "char(", 5) == 0 && hdfs_is_type_modifier(type + 4))
+		return psprintf("char%s", type + 4);
+
+	return "text";
+}
+
+/*
+ * hdfs_is_type_modifier
+ * 		Check that the given string is a type modifier like "(10)" or
+ * 		"(10,2)", as it's copied into the statement.
+ */
+static bool
+hdfs_is_type_modifier(const char *str)
+{
+	int			ndigits = 0;
+	bool		comma = false;
+
+	if (*str++ != '(')
+		return false;
+
+	for (; *str && *str != ')'; str++)
+	{
+		if (isdigit((unsigned char) *str))
+			ndigits++;
+		else if (*str == ',' && ndigits > 0 && !comma)
+		{
+			comma = true;
+			ndigits = 0;
+		}
+		else if (*str != ' ')
+			return false;
+	}
+
+	return (*str == ')' && str[1] == '\0' && ndigits > 0);
+}
+
+/*
+ * hdfs_has_json_map_keys
+ * 		Check that all the maps of the given complex type have keys written
+ * 		as JSON strings.
+ */
+static bool
+hdfs_has_json_map_keys(const char *hive_type)
+{
+	const char *pos = hive_type;
+
+	while ((pos = strstr(pos, "map<")) != NULL)
+	{
+		pos += 4;
+		if (strncmp(pos, "string,", 7) != 0 &&
+			strncmp(pos, "varchar(", 8) != 0 &&
+			strncmp(pos, "char(", 5) != 0)
+			return false;
+	}
+
+	return true;
+}
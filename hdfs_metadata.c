@@ -0,0 +1,385 @@
+/*-------------------------------------------------------------------------
+ *
+ * hdfs_metadata.c
+ * 		Aggregates answered from the metadata of the remote tables.
+ *
+ * count(*) over a whole table, and the min or max of a partition column, are
+ * known to the metastore: the number of rows of the table, or of each of its
+ * partitions, and the values of the partition columns, listed by SHOW
+ * PARTITIONS.  Asking for them takes a few metadata lookups where the remote
+ * query scans the whole table.  The foreign table must be declared to have
+ * trustworthy statistics with its trust_metastore_stats option, as nothing
+ * tells whether they were gathered since the last change of the table by
+ * other means than Hive.  The remote query is run after all if some of the
+ * statistics are missing.
+ *
+ * Portions Copyright (c) 2012-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 2004-2025, EnterpriseDB Corporation.
+ *
+ * IDENTIFICATION
+ * 		hdfs_metadata.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/table.h"
+#include "executor/tuptable.h"
+#include "hdfs_fdw.h"
+#include "nodes/makefuncs.h"
+#include "optimizer/optimizer.h"
+#include "utils/lsyscache.h"
+#include "utils/typcache.h"
+
+/* Aggregates answered from the metadata */
+typedef enum HDFS_METADATA_AGG
+{
+	HDFS_METADATA_COUNT,		/* count(*) */
+	HDFS_METADATA_MIN,			/* min of a partition column */
+	HDFS_METADATA_MAX			/* max of a partition column */
+} HDFS_METADATA_AGG;
+
+static double hdfs_metadata_count(int con_index, hdfs_opt *opt, Relation rel,
+								  List **partitions, bool *listed);
+static int	hdfs_metadata_min_max(int con_index, hdfs_opt *opt, Relation rel,
+								  List *partitions, const char *column,
+								  bool is_max, Form_pg_attribute attr,
+								  Datum *result);
+static char *hdfs_partition_value(const char *partition, const char *column);
+
+/*
+ * hdfs_plan_metadata_aggs
+ * 		Check whether all the aggregates of the given grouping relation can be
+ * 		answered from the metadata of the remote table, and return them if so,
+ * 		or NIL.
+ *
+ * This is only the case for a whole foreign table, without any condition,
+ * grouping or HAVING, whose aggregates are count(*) or the min or max of its
+ * partition columns.  The result is a list with one item per column of the
+ * grouped target list, each one a list of the kind of aggregate (as an
+ * integer Value node) and the remote name of the column it's computed on (as
+ * a String node).
+ */
+List *
+hdfs_plan_metadata_aggs(PlannerInfo *root, RelOptInfo *grouped_rel)
+{
+	Query	   *parse = root->parse;
+	HDFSFdwRelationInfo *fpinfo = (HDFSFdwRelationInfo *) grouped_rel->fdw_private;
+	RelOptInfo *baserel = fpinfo->outerrel;
+	HDFSFdwRelationInfo *ifpinfo = (HDFSFdwRelationInfo *) baserel->fdw_private;
+	RangeTblEntry *rte;
+	List	   *aggs = NIL;
+	ListCell   *lc;
+
+	if (fpinfo->stage != UPPERREL_GROUP_AGG ||
+		baserel->reloptkind != RELOPT_BASEREL)
+		return NIL;
+
+	if (!ifpinfo->options->trust_metastore_stats ||
+		ifpinfo->options->partition_predicate || ifpinfo->use_snapshot)
+		return NIL;
+
+	/* The rows themselves would be needed for any of these. */
+	if (baserel->baserestrictinfo != NIL || parse->groupClause ||
+		parse->groupingSets || parse->havingQual)
+		return NIL;
+
+	rte = planner_rt_fetch(baserel->relid, root);
+
+	foreach(lc, fpinfo->grouped_tlist)
+	{
+		TargetEntry *tle = lfirst_node(TargetEntry, lc);
+		Aggref	   *aggref = (Aggref *) tle->expr;
+		char	   *aggname;
+		Var		   *var;
+
+		if (!IsA(aggref, Aggref) || aggref->aggfilter || aggref->aggorder ||
+			aggref->aggsplit != AGGSPLIT_SIMPLE ||
+			!hdfs_is_builtin(aggref->aggfnoid))
+			return NIL;
+
+		aggname = get_func_name(aggref->aggfnoid);
+
+		if (strcmp(aggname, "count") == 0 && aggref->aggstar)
+		{
+			aggs = lappend(aggs, list_make2(makeInteger(HDFS_METADATA_COUNT),
+											makeString("")));
+			continue;
+		}
+
+		if ((strcmp(aggname, "min") != 0 && strcmp(aggname, "max") != 0) ||
+			list_length(aggref->args) != 1)
+			return NIL;
+
+		/* The values are compared like min() and max() do. */
+		var = (Var *) ((TargetEntry *) linitial(aggref->args))->expr;
+		if (!IsA(var, Var) || var->varno != baserel->relid ||
+			var->varlevelsup != 0 ||
+			!bms_is_member(var->varattno, ifpinfo->partition_attrs) ||
+			!OidIsValid(lookup_type_cache(var->vartype,
+										  TYPECACHE_CMP_PROC)->cmp_proc))
+			return NIL;
+
+		aggs = lappend(aggs,
+					   list_make2(makeInteger(strcmp(aggname, "min") == 0 ?
+											  HDFS_METADATA_MIN :
+											  HDFS_METADATA_MAX),
+								  makeString(hdfs_get_column_name(rte->relid,
+																  var->varattno))));
+	}
+
+	return aggs;
+}
+
+/*
+ * hdfs_get_metadata_aggs
+ * 		Compute the aggregates planned by hdfs_plan_metadata_aggs() from the
+ * 		metadata of the remote table of the given foreign table, and store
+ * 		them in the given slot.
+ *
+ * Returns false if some of the statistics needed are missing.
+ */
+bool
+hdfs_get_metadata_aggs(int con_index, hdfs_opt *opt, Oid relid,
+					   List *metadata_aggs, TupleTableSlot *slot)
+{
+	Relation	rel = table_open(relid, NoLock);
+	TupleDesc	tupdesc = slot->tts_tupleDescriptor;
+	List	   *partitions = NIL;
+	bool		listed = false;
+	bool		found = true;
+	ListCell   *lc;
+
+	foreach(lc, metadata_aggs)
+	{
+		List	   *agg = (List *) lfirst(lc);
+		int			attnum = foreach_current_index(lc);
+		int			rc;
+
+		if (intVal(linitial(agg)) == HDFS_METADATA_COUNT)
+		{
+			double		rows = hdfs_metadata_count(con_index, opt, rel,
+												   &partitions, &listed);
+
+			if (rows < 0)
+			{
+				found = false;
+				break;
+			}
+
+			slot->tts_values[attnum] = Int64GetDatum((int64) rows);
+			slot->tts_isnull[attnum] = false;
+			continue;
+		}
+
+		if (!listed)
+		{
+			partitions = hdfs_get_partitions(con_index, opt, rel);
+			listed = true;
+		}
+
+		rc = hdfs_metadata_min_max(con_index, opt, rel, partitions,
+								   strVal(lsecond(agg)),
+								   intVal(linitial(agg)) == HDFS_METADATA_MAX,
+								   TupleDescAttr(tupdesc, attnum),
+								   &slot->tts_values[attnum]);
+		if (rc < 0)
+		{
+			found = false;
+			break;
+		}
+
+		slot->tts_isnull[attnum] = (rc == 0);
+	}
+
+	table_close(rel, NoLock);
+
+	if (found)
+		ExecStoreVirtualTuple(slot);
+
+	return found;
+}
+
+/*
+ * hdfs_metadata_count
+ * 		Get the number of rows of the remote table, or -1 if it's unknown.
+ *
+ * Hive keeps the statistics of a partitioned table per partition, which are
+ * summed unless the table has some of its own.  The partitions are listed
+ * into *partitions unless *listed is set already.
+ */
+static double
+hdfs_metadata_count(int con_index, hdfs_opt *opt, Relation rel,
+					List **partitions, bool *listed)
+{
+	double		rows = hdfs_get_row_count(con_index, opt, rel, NULL);
+	ListCell   *lc;
+
+	if (rows >= 0)
+		return rows;
+
+	if (!*listed)
+	{
+		if (hdfs_get_partition_columns(con_index, opt, rel) == NIL)
+			return -1;
+
+		*partitions = hdfs_get_partitions(con_index, opt, rel);
+		*listed = true;
+	}
+
+	rows = 0;
+	foreach(lc, *partitions)
+	{
+		double		part_rows = hdfs_get_row_count(con_index, opt, rel,
+												   (char *) lfirst(lc));
+
+		if (part_rows < 0)
+			return -1;
+
+		rows += part_rows;
+	}
+
+	return rows;
+}
+
+/*
+ * hdfs_metadata_min_max
+ * 		Get the min, or the max, of the given partition column over the
+ * 		given partitions which have rows.
+ *
+ * The values are converted to the type of the aggregate and compared with the
+ * default ordering of the type, like min() and max() do.  Only the partitions
+ * with the best value are asked for their number of rows, to skip them if
+ * they are empty.  Returns 1 and sets *result if found, 0 if there are no
+ * such values, or -1 if some number of rows is unknown.
+ */
+static int
+hdfs_metadata_min_max(int con_index, hdfs_opt *opt, Relation rel,
+					  List *partitions, const char *column, bool is_max,
+					  Form_pg_attribute attr, Datum *result)
+{
+	TypeCacheEntry *typentry;
+	int			nparts = list_length(partitions);
+	Datum	   *values;
+	bool	   *candidates;
+	Oid			typinput;
+	Oid			typioparam;
+	ListCell   *lc;
+
+	typentry = lookup_type_cache(attr->atttypid, TYPECACHE_CMP_PROC_FINFO);
+	getTypeInputInfo(attr->atttypid, &typinput, &typioparam);
+
+	values = (Datum *) palloc(sizeof(Datum) * Max(nparts, 1));
+	candidates = (bool *) palloc(sizeof(bool) * Max(nparts, 1));
+
+	/* NULL values, in __HIVE_DEFAULT_PARTITION__, are ignored. */
+	foreach(lc, partitions)
+	{
+		int			i = foreach_current_index(lc);
+		char	   *value = hdfs_partition_value((char *) lfirst(lc), column);
+
+		candidates[i] = (value != NULL);
+		if (value)
+			values[i] = OidInputFunctionCall(typinput, value, typioparam,
+											 attr->atttypmod);
+	}
+
+	for (;;)
+	{
+		Datum		best;
+		int			best_index = -1;
+		bool		has_rows = false;
+		int			i;
+
+		for (i = 0; i < nparts; i++)
+		{
+			int			cmp;
+
+			if (!candidates[i])
+				continue;
+
+			if (best_index < 0)
+			{
+				best_index = i;
+				continue;
+			}
+
+			cmp = DatumGetInt32(FunctionCall2Coll(&typentry->cmp_proc_finfo,
+												  attr->attcollation,
+												  values[i],
+												  values[best_index]));
+			if (is_max ? cmp > 0 : cmp < 0)
+				best_index = i;
+		}
+
+		if (best_index < 0)
+			return 0;
+
+		/* Several partitions have this value with multi-level partitioning. */
+		best = values[best_index];
+		for (i = 0; i < nparts; i++)
+		{
+			double		rows;
+
+			if (!candidates[i] ||
+				DatumGetInt32(FunctionCall2Coll(&typentry->cmp_proc_finfo,
+												attr->attcollation,
+												values[i], best)) != 0)
+				continue;
+
+			candidates[i] = false;
+			if (has_rows)
+				continue;
+
+			rows = hdfs_get_row_count(con_index, opt, rel,
+									  (char *) list_nth(partitions, i));
+			if (rows < 0)
+				return -1;
+
+			has_rows = (rows > 0);
+		}
+
+		if (has_rows)
+		{
+			*result = best;
+			return 1;
+		}
+	}
+}
+
+/*
+ * hdfs_partition_value
+ * 		Get the value of the given column in a partition listed by SHOW
+ * 		PARTITIONS, e.g. "year=2024/month=01", or NULL if it's NULL.
+ */
+static char *
+hdfs_partition_value(const char *partition, const char *column)
+{
+	const char *pos = partition;
+
+	while (*pos)
+	{
+		const char *end = strchr(pos, '/');
+		const char *eq;
+
+		if (end == NULL)
+			end = pos + strlen(pos);
+
+		eq = memchr(pos, '=', end - pos);
+		if (eq && pg_strcasecmp(hdfs_unescape_path_name(pos, eq - pos),
+								column) == 0)
+		{
+			char	   *value = hdfs_unescape_path_name(eq + 1, end - eq - 1);
+
+			if (strcmp(value, "__HIVE_DEFAULT_PARTITION__") == 0)
+				return NULL;
+
+			return value;
+		}
+
+		pos = (*end == '/') ? end + 1 : end;
+	}
+
+	return NULL;
+}
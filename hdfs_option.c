@@ -21,6 +21,7 @@
 #include "commands/defrem.h"
 #include "hdfs_fdw.h"
 #include "miscadmin.h"
+#include "utils/guc.h"
 #include "utils/lsyscache.h"
 
 /* Default connection parameters */
@@ -66,11 +67,25 @@ static struct HDFSFdwOption valid_options[] =
 	{"usesystemtruststore", ForeignServerRelationId},
 	{"ssltruststore", ForeignServerRelationId},
 	{"truststorepassword", ForeignServerRelationId},
+	{"use_observed_costs", ForeignServerRelationId},
+	{"result_cache_ttl", ForeignServerRelationId},
+	{"result_cache_ttl", ForeignTableRelationId},
+	{"result_cache_validate", ForeignServerRelationId},
+	{"result_cache_validate", ForeignTableRelationId},
+	{"allow_approximate_aggregates", ForeignServerRelationId},
+	{"allow_approximate_aggregates", ForeignTableRelationId},
+	{"server_version", ForeignServerRelationId},
+	{"join_hints", ForeignServerRelationId},
+	{"partition_predicate", ForeignTableRelationId},
+	{"row_estimate", ForeignTableRelationId},
+	{"trust_metastore_stats", ForeignTableRelationId},
+	{"staging", ForeignTableRelationId},
 	{NULL, InvalidOid}
 };
 
 
 static bool hdfs_is_valid_option(const char *option, Oid context);
+static hdfs_opt *hdfs_get_options_internal(Oid serverid, Oid foreigntableid);
 
 
 /*
@@ -122,8 +137,55 @@ hdfs_fdw_validator(PG_FUNCTION_ARGS)
 
 		if (strcmp(def->defname, "enable_join_pushdown") == 0 ||
 			strcmp(def->defname, "enable_aggregate_pushdown") == 0 ||
-			strcmp(def->defname, "enable_order_by_pushdown") == 0)
+			strcmp(def->defname, "enable_order_by_pushdown") == 0 ||
+			strcmp(def->defname, "use_observed_costs") == 0 ||
+			strcmp(def->defname, "result_cache_validate") == 0 ||
+			strcmp(def->defname, "allow_approximate_aggregates") == 0 ||
+			strcmp(def->defname, "trust_metastore_stats") == 0 ||
+			strcmp(def->defname, "staging") == 0)
 			(void) defGetBoolean(def);
+
+		if (strcmp(def->defname, "result_cache_ttl") == 0)
+		{
+			int			ttl;
+
+			if (!parse_int(defGetString(def), &ttl, 0, NULL) || ttl < 0)
+				ereport(ERROR,
+						(errcode(ERRCODE_FDW_INVALID_OPTION_NAME),
+						 errmsg("invalid result cache ttl \"%s\"",
+								defGetString(def)),
+						 errhint("Valid values are non-negative integers, in seconds.")));
+		}
+
+		if (strcmp(def->defname, "server_version") == 0 &&
+			hdfs_parse_server_version(defGetString(def)) == 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_FDW_INVALID_OPTION_NAME),
+					 errmsg("invalid server version \"%s\"",
+							defGetString(def)),
+					 errhint("Valid values are versions like \"3.1.3\".")));
+
+		if (strcmp(def->defname, "join_hints") == 0 &&
+			strcasecmp(defGetString(def), "auto") != 0 &&
+			strcasecmp(defGetString(def), "force") != 0 &&
+			strcasecmp(defGetString(def), "off") != 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_FDW_INVALID_OPTION_NAME),
+					 errmsg("invalid join hints \"%s\"", defGetString(def)),
+					 errhint("Valid join_hints values are auto, force and off.")));
+
+		if (strcmp(def->defname, "row_estimate") == 0)
+		{
+			char	   *endp;
+			double		rows = strtod(defGetString(def), &endp);
+
+			if (*endp != '\0' || endp == defGetString(def) || rows < 0)
+				ereport(ERROR,
+						(errcode(ERRCODE_FDW_INVALID_OPTION_NAME),
+						 errmsg("invalid row estimate \"%s\"",
+								defGetString(def)),
+						 errhint("Valid values are non-negative numbers.")));
+		}
 	}
 
 	PG_RETURN_VOID();
@@ -154,7 +216,27 @@ hdfs_is_valid_option(const char *option, Oid context)
 hdfs_opt *
 hdfs_get_options(Oid foreigntableid)
 {
-	ForeignTable *f_table;
+	return hdfs_get_options_internal(GetForeignTable(foreigntableid)->serverid,
+									 foreigntableid);
+}
+
+/*
+ * Fetch the options for a hdfs_fdw foreign server, as needed to connect to it
+ * without any foreign table.
+ */
+hdfs_opt *
+hdfs_get_server_options(Oid serverid)
+{
+	return hdfs_get_options_internal(serverid, InvalidOid);
+}
+
+/*
+ * Fetch the options of the given server, and of the given foreign table
+ * unless it's InvalidOid.
+ */
+static hdfs_opt *
+hdfs_get_options_internal(Oid serverid, Oid foreigntableid)
+{
 	ForeignServer *f_server;
 	UserMapping *f_mapping;
 	List	   *options;
@@ -178,15 +260,26 @@ hdfs_get_options(Oid foreigntableid)
 	opt->useSystemTrustStore = false;
 	opt->sslTrustStore = NULL;
 	opt->trustStorePassword = NULL;
+	opt->use_observed_costs = false;
+	opt->result_cache_ttl = 0;
+	opt->result_cache_validate = true;
+	opt->allow_approximate_aggregates = false;
+	opt->server_version = 0;
+	opt->join_hints = HDFS_JOIN_HINTS_AUTO;
+	opt->partition_predicate = NULL;
+	opt->row_estimate = 0;
+	opt->trust_metastore_stats = false;
+	opt->staging = false;
 
 	/* Extract options from FDW objects. */
-	f_table = GetForeignTable(foreigntableid);
-	f_server = GetForeignServer(f_table->serverid);
-	f_mapping = GetUserMapping(GetUserId(), f_table->serverid);
+	f_server = GetForeignServer(serverid);
+	f_mapping = GetUserMapping(GetUserId(), serverid);
 
 	options = NIL;
 	options = list_concat(options, f_server->options);
-	options = list_concat(options, f_table->options);
+	if (OidIsValid(foreigntableid))
+		options = list_concat(options,
+							  GetForeignTable(foreigntableid)->options);
 	options = list_concat(options, f_mapping->options);
 
 	/* Set default client type to HiverServer2 and auth type to unspecified. */
@@ -302,14 +395,53 @@ hdfs_get_options(Oid foreigntableid)
 
 		if (strcmp(def->defname, "truststorepassword") == 0)
 			opt->trustStorePassword = defGetString(def);
+
+		if (strcmp(def->defname, "use_observed_costs") == 0)
+			opt->use_observed_costs = defGetBoolean(def);
+
+		if (strcmp(def->defname, "result_cache_ttl") == 0)
+			opt->result_cache_ttl = atoi(defGetString(def));
+
+		if (strcmp(def->defname, "result_cache_validate") == 0)
+			opt->result_cache_validate = defGetBoolean(def);
+
+		if (strcmp(def->defname, "allow_approximate_aggregates") == 0)
+			opt->allow_approximate_aggregates = defGetBoolean(def);
+
+		if (strcmp(def->defname, "server_version") == 0)
+			opt->server_version = hdfs_parse_server_version(defGetString(def));
+
+		if (strcmp(def->defname, "partition_predicate") == 0)
+			opt->partition_predicate = defGetString(def);
+
+		if (strcmp(def->defname, "row_estimate") == 0)
+			opt->row_estimate = strtod(defGetString(def), NULL);
+
+		if (strcmp(def->defname, "trust_metastore_stats") == 0)
+			opt->trust_metastore_stats = defGetBoolean(def);
+
+		if (strcmp(def->defname, "staging") == 0)
+			opt->staging = defGetBoolean(def);
+
+		if (strcmp(def->defname, "join_hints") == 0)
+		{
+			if (strcasecmp(defGetString(def), "force") == 0)
+				opt->join_hints = HDFS_JOIN_HINTS_FORCE;
+			else if (strcasecmp(defGetString(def), "off") == 0)
+				opt->join_hints = HDFS_JOIN_HINTS_OFF;
+			else
+				opt->join_hints = HDFS_JOIN_HINTS_AUTO;
+		}
 	}
 
 	/*
 	 * If the table name is not provided, we assume it to be same as foreign
 	 * table name.
 	 */
-	if (!opt->table_name)
+	if (!opt->table_name && OidIsValid(foreigntableid))
 		opt->table_name = get_rel_name(foreigntableid);
 
+	opt->dialect = hdfs_get_dialect(f_server->serverid, opt);
+
 	return opt;
 }
@@ -0,0 +1,812 @@
+/*-------------------------------------------------------------------------
+ *
+ * hdfs_partition.c
+ * 		Partition columns of the remote tables, and the planning depending
+ * 		on them.
+ *
+ * The partition columns of a remote table are read from DESCRIBE FORMATTED
+ * the first time the table is planned with use_remote_estimate, and
+ * remembered by this backend until the foreign table or its server is
+ * altered.  The conditions on these columns are the ones Hive prunes
+ * partitions with, so they are sent to the server even when they compare with
+ * a value only known at execution, like current_date, and the row estimate
+ * only counts the rows of the partitions they select.
+ *
+ * hdfs_fdw_partition() also mirrors the partitions of a remote table as the
+ * partitions of a local partitioned table, each one a foreign table reading
+ * its own partition only.  The planner then prunes them itself, and each
+ * one has its own statistics.
+ *
+ * Portions Copyright (c) 2012-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 2004-2025, EnterpriseDB Corporation.
+ *
+ * IDENTIFICATION
+ * 		hdfs_partition.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <ctype.h>
+
+#include "access/sysattr.h"
+#include "access/table.h"
+#include "catalog/namespace.h"
+#include "catalog/pg_inherits.h"
+#include "commands/defrem.h"
+#include "executor/spi.h"
+#include "fmgr.h"
+#include "foreign/foreign.h"
+#include "hdfs_fdw.h"
+#include "mb/pg_wchar.h"
+#include "nodes/makefuncs.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/optimizer.h"
+#include "utils/builtins.h"
+#include "utils/hsearch.h"
+#include "utils/inval.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/partcache.h"
+#include "utils/rel.h"
+#include "utils/syscache.h"
+#include "utils/varlena.h"
+
+PG_FUNCTION_INFO_V1(hdfs_fdw_partition);
+
+/* Partition columns of a remote table, NIL if it isn't partitioned. */
+typedef struct hdfsPartitionEntry
+{
+	Oid			relid;			/* hash key, must be first */
+	List	   *columns;		/* remote names, in CacheMemoryContext */
+} hdfsPartitionEntry;
+
+static HTAB *hdfs_partition_cache = NULL;
+
+static void hdfs_init_partition_cache(void);
+static void hdfs_invalidate_partitions(Datum arg, int cacheid,
+									   uint32 hashvalue);
+static bool hdfs_get_partition_attrs(int con_index, hdfs_opt *opt,
+									 Relation rel, Bitmapset **attrs);
+static bool hdfs_is_partition_param_cond(PlannerInfo *root,
+										 RelOptInfo *baserel,
+										 Bitmapset *attrs, Expr *clause);
+static bool hdfs_refers_to_attrs(Expr *clause, Index relid, Bitmapset *attrs,
+								 bool only);
+static bool hdfs_contains_param(Node *node, void *context);
+static Oid	hdfs_make_partitioned_table(RangeVar *rv, Relation rel,
+										Form_pg_attribute keyattr);
+static void hdfs_check_partitioned_table(Oid parentid,
+										 Form_pg_attribute keyattr);
+static List *hdfs_get_partition_predicates(Oid parentid);
+static char *hdfs_partition_name(Oid parentid, const char *value);
+static void hdfs_create_partition(Relation rel, hdfs_opt *opt, Oid parentid,
+								  const char *name, const char *value,
+								  const char *predicate);
+static void hdfs_append_options(StringInfo buf, List *options);
+
+/*
+ * hdfs_init_partition_cache
+ * 		Create the cache of the partition columns, which is reset when any
+ * 		foreign table or server changes, as the remote table it stands for
+ * 		may have.
+ */
+static void
+hdfs_init_partition_cache(void)
+{
+	HASHCTL		ctl;
+
+	ctl.keysize = sizeof(Oid);
+	ctl.entrysize = sizeof(hdfsPartitionEntry);
+	hdfs_partition_cache = hash_create("hdfs_fdw partition columns", 64, &ctl,
+									   HASH_ELEM | HASH_BLOBS);
+
+	CacheRegisterSyscacheCallback(FOREIGNTABLEREL, hdfs_invalidate_partitions,
+								  (Datum) 0);
+	CacheRegisterSyscacheCallback(FOREIGNSERVEROID, hdfs_invalidate_partitions,
+								  (Datum) 0);
+}
+
+/*
+ * hdfs_invalidate_partitions
+ * 		Forget the partition columns of all the remote tables.
+ */
+static void
+hdfs_invalidate_partitions(Datum arg, int cacheid, uint32 hashvalue)
+{
+	HASH_SEQ_STATUS status;
+	hdfsPartitionEntry *entry;
+
+	hash_seq_init(&status, hdfs_partition_cache);
+	while ((entry = (hdfsPartitionEntry *) hash_seq_search(&status)) != NULL)
+	{
+		list_free_deep(entry->columns);
+		hash_search(hdfs_partition_cache, &entry->relid, HASH_REMOVE, NULL);
+	}
+}
+
+/*
+ * hdfs_get_partition_attrs
+ * 		Get the attribute numbers of the columns of the foreign table which
+ * 		are partition columns of the remote table, or NULL if it isn't
+ * 		partitioned.
+ *
+ * The remote server is only asked with con_index >= 0.  Returns false if the
+ * partition columns are unknown.
+ */
+static bool
+hdfs_get_partition_attrs(int con_index, hdfs_opt *opt, Relation rel,
+						 Bitmapset **attrs)
+{
+	Oid			relid = RelationGetRelid(rel);
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	hdfsPartitionEntry *entry;
+	bool		found;
+	int			i;
+
+	*attrs = NULL;
+
+	if (hdfs_partition_cache == NULL)
+		hdfs_init_partition_cache();
+
+	entry = (hdfsPartitionEntry *) hash_search(hdfs_partition_cache, &relid,
+											   HASH_FIND, NULL);
+	if (entry == NULL)
+	{
+		List	   *columns;
+		MemoryContext oldcxt;
+		ListCell   *lc;
+
+		if (con_index < 0)
+			return false;
+
+		columns = hdfs_get_partition_columns(con_index, opt, rel);
+
+		/* Fill the entry only once the remote server answered. */
+		entry = (hdfsPartitionEntry *) hash_search(hdfs_partition_cache,
+												   &relid, HASH_ENTER,
+												   &found);
+		entry->columns = NIL;
+		oldcxt = MemoryContextSwitchTo(CacheMemoryContext);
+		foreach(lc, columns)
+			entry->columns = lappend(entry->columns,
+									 pstrdup((char *) lfirst(lc)));
+		MemoryContextSwitchTo(oldcxt);
+	}
+
+	/* Hive has case-insensitive column names. */
+	for (i = 0; i < tupdesc->natts && entry->columns != NIL; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+		char	   *colname;
+		ListCell   *lc;
+
+		if (attr->attisdropped)
+			continue;
+
+		colname = hdfs_get_column_name(relid, attr->attnum);
+		foreach(lc, entry->columns)
+		{
+			if (pg_strcasecmp(colname, (char *) lfirst(lc)) == 0)
+			{
+				*attrs = bms_add_member(*attrs, attr->attnum);
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+/*
+ * hdfs_plan_partition_conds
+ * 		Find the partition columns of the given foreign table, and move the
+ * 		conditions on them which can be sent with a parameter from the local
+ * 		conditions to the remote ones.
+ *
+ * Also sets in fpinfo the partition columns, the conditions the remote row
+ * count is to be estimated with, and whether any remote condition filters
+ * the partitions.
+ */
+void
+hdfs_plan_partition_conds(PlannerInfo *root, RelOptInfo *baserel,
+						  Relation rel, hdfs_opt *opt, int con_index)
+{
+	HDFSFdwRelationInfo *fpinfo = (HDFSFdwRelationInfo *) baserel->fdw_private;
+	List	   *local_conds = NIL;
+	ListCell   *lc;
+
+	/* A foreign table standing for a partition reads that partition only. */
+	fpinfo->has_partition_filter = (opt->partition_predicate != NULL);
+
+	if (!hdfs_get_partition_attrs(con_index, opt, rel,
+								  &fpinfo->partition_attrs) ||
+		fpinfo->partition_attrs == NULL)
+		return;
+
+	foreach(lc, fpinfo->local_conds)
+	{
+		RestrictInfo *rinfo = lfirst_node(RestrictInfo, lc);
+
+		if (hdfs_is_partition_param_cond(root, baserel,
+										 fpinfo->partition_attrs,
+										 rinfo->clause))
+			fpinfo->remote_conds = lappend(fpinfo->remote_conds, rinfo);
+		else
+			local_conds = lappend(local_conds, rinfo);
+	}
+	fpinfo->local_conds = local_conds;
+
+	/*
+	 * Only the conditions on constants can be sent for the row estimate, the
+	 * parameters being unknown yet.
+	 */
+	foreach(lc, fpinfo->remote_conds)
+	{
+		RestrictInfo *rinfo = lfirst_node(RestrictInfo, lc);
+
+		if (!hdfs_refers_to_attrs(rinfo->clause, baserel->relid,
+								  fpinfo->partition_attrs, false))
+			continue;
+
+		fpinfo->has_partition_filter = true;
+
+		if (hdfs_refers_to_attrs(rinfo->clause, baserel->relid,
+								 fpinfo->partition_attrs, true) &&
+			!contain_mutable_functions((Node *) rinfo->clause) &&
+			!hdfs_contains_param((Node *) rinfo->clause, NULL))
+			fpinfo->partition_conds = lappend(fpinfo->partition_conds,
+											  rinfo);
+	}
+}
+
+/*
+ * hdfs_is_partition_param_cond
+ * 		Check that the given condition compares a partition column with an
+ * 		expression not depending on the rows, which can be sent as a
+ * 		parameter evaluated when the scan starts.
+ *
+ * The expression mustn't be volatile, to have the same value for all the
+ * rows, and must have a type the parameters are bound with.  Numerics are
+ * not, as they would be bound as float8.  The condition must be pushable once
+ * the expression is replaced with a parameter.
+ */
+static bool
+hdfs_is_partition_param_cond(PlannerInfo *root, RelOptInfo *baserel,
+							 Bitmapset *attrs, Expr *clause)
+{
+	OpExpr	   *op;
+	Node	   *left;
+	Node	   *right;
+	Node	   *value;
+	Var		   *var;
+	Param	   *param;
+	OpExpr	   *param_op;
+
+	if (!IsA(clause, OpExpr) || list_length(((OpExpr *) clause)->args) != 2)
+		return false;
+
+	op = (OpExpr *) clause;
+	left = linitial(op->args);
+	right = lsecond(op->args);
+
+	if (IsA(left, Var))
+	{
+		var = (Var *) left;
+		value = right;
+	}
+	else if (IsA(right, Var))
+	{
+		var = (Var *) right;
+		value = left;
+	}
+	else
+		return false;
+
+	if (var->varno != baserel->relid || var->varlevelsup != 0 ||
+		!bms_is_member(var->varattno, attrs))
+		return false;
+
+	if (contain_var_clause(value) || contain_volatile_functions(value) ||
+		contain_subplans(value) ||
+		exprType(value) == NUMERICOID || !hdfs_is_bindable_type(exprType(value)))
+		return false;
+
+	param = makeNode(Param);
+	param->paramkind = PARAM_EXTERN;
+	param->paramid = 1;
+	param->paramtype = exprType(value);
+	param->paramtypmod = exprTypmod(value);
+	param->paramcollid = exprCollation(value);
+	param->location = -1;
+
+	param_op = (OpExpr *) copyObject(op);
+	if (value == right)
+		lsecond(param_op->args) = param;
+	else
+		linitial(param_op->args) = param;
+
+	return hdfs_is_foreign_expr(root, baserel, (Expr *) param_op);
+}
+
+/*
+ * hdfs_refers_to_attrs
+ * 		Check that the given condition refers to some of the given columns of
+ * 		the relation, or only to them if only is true.
+ */
+static bool
+hdfs_refers_to_attrs(Expr *clause, Index relid, Bitmapset *attrs, bool only)
+{
+	Bitmapset  *clause_attrs = NULL;
+	Bitmapset  *offset_attrs = NULL;
+	int			attno = -1;
+
+	pull_varattnos((Node *) clause, relid, &clause_attrs);
+
+	while ((attno = bms_next_member(attrs, attno)) >= 0)
+		offset_attrs = bms_add_member(offset_attrs,
+									  attno - FirstLowInvalidHeapAttributeNumber);
+
+	if (only)
+		return clause_attrs != NULL && bms_is_subset(clause_attrs, offset_attrs);
+
+	return bms_overlap(clause_attrs, offset_attrs);
+}
+
+/*
+ * hdfs_contains_param
+ * 		Expression tree walker returning true if the expression has Params.
+ */
+static bool
+hdfs_contains_param(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Param))
+		return true;
+
+	return expression_tree_walker(node, hdfs_contains_param, context);
+}
+
+/*
+ * hdfs_get_unfiltered_partitioned_rels
+ * 		Get the names of the partitioned tables read by the scan of the given
+ * 		relation without any condition on their partition columns, which
+ * 		makes the remote server read all their partitions.
+ */
+List *
+hdfs_get_unfiltered_partitioned_rels(RelOptInfo *foreignrel)
+{
+	HDFSFdwRelationInfo *fpinfo = (HDFSFdwRelationInfo *) foreignrel->fdw_private;
+
+	if (IS_UPPER_REL(foreignrel))
+		return hdfs_get_unfiltered_partitioned_rels(fpinfo->outerrel);
+
+	if (IS_JOIN_REL(foreignrel))
+		return list_concat(hdfs_get_unfiltered_partitioned_rels(fpinfo->outerrel),
+						   hdfs_get_unfiltered_partitioned_rels(fpinfo->innerrel));
+
+	if (fpinfo->partition_attrs == NULL || fpinfo->has_partition_filter ||
+		fpinfo->use_snapshot)
+		return NIL;
+
+	return list_make1(makeString(fpinfo->relation_name->data));
+}
+
+/*
+ * hdfs_analyze_partition
+ * 		Compute the statistics of the remote partitions read by the given
+ * 		foreign table standing for a partition, and return their total size.
+ *
+ * These are the partitions whose first-level partition has the
+ * partition_predicate of the table, as set by hdfs_fdw_partition(), which
+ * are analyzed at once and described one by one.  A predicate set by other
+ * means matches none of them, and nothing is analyzed.
+ */
+double
+hdfs_analyze_partition(int con_index, hdfs_opt *opt, Relation rel)
+{
+	char	   *first_level = NULL;
+	double		totalsize = 0;
+	List	   *matches = NIL;
+	ListCell   *lc;
+
+	if (hdfs_get_partition_columns(con_index, opt, rel) == NIL)
+		return 0;
+
+	foreach(lc, hdfs_get_partitions(con_index, opt, rel))
+	{
+		char	   *partition = (char *) lfirst(lc);
+		char	   *level = pstrdup(partition);
+		char	   *end = strchr(level, '/');
+		StringInfoData predicate;
+
+		if (end)
+			*end = '\0';
+
+		initStringInfo(&predicate);
+		hdfs_deparse_partition_spec(&predicate, level, true);
+		if (strcmp(predicate.data, opt->partition_predicate) != 0)
+			continue;
+
+		first_level = level;
+		matches = lappend(matches, partition);
+	}
+
+	if (first_level == NULL)
+		return 0;
+
+	hdfs_analyze(con_index, opt, rel, first_level);
+
+	foreach(lc, matches)
+		totalsize += hdfs_describe(con_index, opt, rel, (char *) lfirst(lc));
+
+	return totalsize;
+}
+
+/*
+ * hdfs_fdw_partition
+ * 		Create a foreign table partition of the given partitioned table for
+ * 		each partition of the remote table of the given foreign table it has
+ * 		none for yet, and return the number of partitions created.
+ *
+ * The partitioned table is created with the columns of the foreign table
+ * unless it exists, and is partitioned by list on the first partition column
+ * of the remote table.  Each of its partitions thus reads the first-level
+ * partition of the remote table holding one value of that column.  Calling
+ * the function again adds the partitions added to the remote table since.
+ */
+Datum
+hdfs_fdw_partition(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	RangeVar   *rv;
+	Relation	rel;
+	TupleDesc	tupdesc;
+	hdfs_opt   *opt;
+	int			con_index;
+	List	   *columns;
+	List	   *partitions;
+	List	   *predicates;
+	Form_pg_attribute keyattr = NULL;
+	Oid			parentid;
+	int32		created = 0;
+	ListCell   *lc;
+	int			i;
+
+	rv = makeRangeVarFromNameList(textToQualifiedNameList(PG_GETARG_TEXT_PP(1)));
+
+	rel = table_open(relid, AccessShareLock);
+	hdfs_check_owned_relation(rel);
+
+	opt = hdfs_get_options(relid);
+	if (opt->partition_predicate)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("foreign table \"%s\" already reads a single partition",
+						RelationGetRelationName(rel))));
+
+	con_index = hdfs_get_connection(GetForeignServer(GetForeignTable(relid)->serverid),
+									opt);
+
+	columns = hdfs_get_partition_columns(con_index, opt, rel);
+	if (columns == NIL)
+		ereport(ERROR,
+				(errcode(ERRCODE_FDW_ERROR),
+				 errmsg("remote table of foreign table \"%s\" is not partitioned",
+						RelationGetRelationName(rel))));
+
+	/* Hive has case-insensitive column names. */
+	tupdesc = RelationGetDescr(rel);
+	for (i = 0; i < tupdesc->natts && keyattr == NULL; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+
+		if (!attr->attisdropped &&
+			pg_strcasecmp(hdfs_get_column_name(relid, attr->attnum),
+						  (char *) linitial(columns)) == 0)
+			keyattr = attr;
+	}
+
+	if (keyattr == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_COLUMN),
+				 errmsg("foreign table \"%s\" has no column for partition column \"%s\" of the remote table",
+						RelationGetRelationName(rel),
+						(char *) linitial(columns))));
+
+	partitions = hdfs_get_partitions(con_index, opt, rel);
+
+	hdfs_rel_connection(con_index);
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "SPI_connect failed");
+
+	/* Concurrent calls for the same table wait for each other. */
+	parentid = RangeVarGetRelid(rv, ShareRowExclusiveLock, true);
+	if (OidIsValid(parentid))
+		hdfs_check_partitioned_table(parentid, keyattr);
+	else
+		parentid = hdfs_make_partitioned_table(rv, rel, keyattr);
+
+	predicates = hdfs_get_partition_predicates(parentid);
+
+	foreach(lc, partitions)
+	{
+		char	   *partition = (char *) lfirst(lc);
+		char	   *end = strchr(partition, '/');
+		char	   *value;
+		StringInfoData predicate;
+
+		/* Only the first level, e.g. "year=2024" of "year=2024/month=01" */
+		if (end)
+			*end = '\0';
+
+		initStringInfo(&predicate);
+		hdfs_deparse_partition_spec(&predicate, partition, true);
+
+		if (list_member(predicates, makeString(predicate.data)))
+			continue;
+		predicates = lappend(predicates, makeString(predicate.data));
+
+		value = strchr(partition, '=') + 1;
+		value = hdfs_unescape_path_name(value, strlen(value));
+
+		if (strcmp(value, "__HIVE_DEFAULT_PARTITION__") == 0)
+			hdfs_create_partition(rel, opt, parentid,
+								  hdfs_partition_name(parentid, "null"),
+								  NULL, predicate.data);
+		else
+			hdfs_create_partition(rel, opt, parentid,
+								  hdfs_partition_name(parentid, value),
+								  value, predicate.data);
+		created++;
+	}
+
+	SPI_finish();
+
+	table_close(rel, NoLock);
+
+	PG_RETURN_INT32(created);
+}
+
+/*
+ * hdfs_make_partitioned_table
+ * 		Create the partitioned table of the given name, with the columns of
+ * 		the given foreign table, partitioned by list on the given column.
+ */
+static Oid
+hdfs_make_partitioned_table(RangeVar *rv, Relation rel,
+							Form_pg_attribute keyattr)
+{
+	StringInfoData sql;
+	int			ret;
+
+	initStringInfo(&sql);
+	appendStringInfo(&sql, "CREATE TABLE %s (LIKE %s) PARTITION BY LIST (%s)",
+					 quote_qualified_identifier(rv->schemaname, rv->relname),
+					 quote_qualified_identifier(get_namespace_name(RelationGetNamespace(rel)),
+												RelationGetRelationName(rel)),
+					 quote_identifier(NameStr(keyattr->attname)));
+
+	ret = SPI_execute(sql.data, false, 0);
+	if (ret != SPI_OK_UTILITY)
+		elog(ERROR, "SPI_execute failed: %s", SPI_result_code_string(ret));
+
+	return RangeVarGetRelid(rv, NoLock, false);
+}
+
+/*
+ * hdfs_check_partitioned_table
+ * 		Check that an existing table is partitioned by list on the column of
+ * 		the given name alone.
+ */
+static void
+hdfs_check_partitioned_table(Oid parentid, Form_pg_attribute keyattr)
+{
+	Relation	parent = table_open(parentid, NoLock);
+	PartitionKey key;
+
+	if (parent->rd_rel->relkind != RELKIND_PARTITIONED_TABLE)
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("\"%s\" is not a partitioned table",
+						RelationGetRelationName(parent))));
+
+	key = RelationGetPartitionKey(parent);
+	if (key->strategy != PARTITION_STRATEGY_LIST || key->partnatts != 1 ||
+		key->partattrs[0] == 0 ||
+		strcmp(get_attname(parentid, key->partattrs[0], false),
+			   NameStr(keyattr->attname)) != 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("table \"%s\" is not partitioned by list on column \"%s\"",
+						RelationGetRelationName(parent),
+						NameStr(keyattr->attname))));
+
+	table_close(parent, NoLock);
+}
+
+/*
+ * hdfs_get_partition_predicates
+ * 		Get the partition_predicate options of the foreign table partitions
+ * 		of the given table, as String nodes.
+ */
+static List *
+hdfs_get_partition_predicates(Oid parentid)
+{
+	List	   *predicates = NIL;
+	ListCell   *lc;
+
+	foreach(lc, find_inheritance_children(parentid, NoLock))
+	{
+		Oid			childid = lfirst_oid(lc);
+		ListCell   *lc2;
+
+		if (get_rel_relkind(childid) != RELKIND_FOREIGN_TABLE)
+			continue;
+
+		foreach(lc2, GetForeignTable(childid)->options)
+		{
+			DefElem    *def = (DefElem *) lfirst(lc2);
+
+			if (strcmp(def->defname, "partition_predicate") == 0)
+				predicates = lappend(predicates,
+									 makeString(defGetString(def)));
+		}
+	}
+
+	return predicates;
+}
+
+/*
+ * hdfs_partition_name
+ * 		Make a name unused in its schema for the partition of the given table
+ * 		holding the given value.
+ *
+ * That is the name of the table followed by the value in lower case, with
+ * the characters other than letters and digits replaced by underscores,
+ * and a number if needed to be unique.
+ */
+static char *
+hdfs_partition_name(Oid parentid, const char *value)
+{
+	Oid			nspid = get_rel_namespace(parentid);
+	StringInfoData base;
+	const char *p;
+	int			suffix = 0;
+
+	initStringInfo(&base);
+	appendStringInfo(&base, "%s_", get_rel_name(parentid));
+	for (p = value; *p; p++)
+		appendStringInfoChar(&base, isalnum((unsigned char) *p) ?
+							 pg_tolower((unsigned char) *p) : '_');
+
+	for (;;)
+	{
+		char		suffix_str[16] = "";
+		char	   *name;
+		int			len;
+
+		if (suffix > 0)
+			snprintf(suffix_str, sizeof(suffix_str), "_%d", suffix);
+
+		len = pg_mbcliplen(base.data, base.len,
+						   NAMEDATALEN - 1 - strlen(suffix_str));
+		name = psprintf("%.*s%s", len, base.data, suffix_str);
+
+		if (!OidIsValid(get_relname_relid(name, nspid)))
+			return name;
+
+		suffix++;
+	}
+}
+
+/*
+ * hdfs_create_partition
+ * 		Create the foreign table partition of the given table holding the
+ * 		given value of its partition key, or its NULLs if value is NULL, and
+ * 		reading the rows of the remote table the predicate selects.
+ *
+ * The partition gets the options of the given foreign table, and its columns
+ * the options of the columns of the same name.
+ */
+static void
+hdfs_create_partition(Relation rel, hdfs_opt *opt, Oid parentid,
+					  const char *name, const char *value,
+					  const char *predicate)
+{
+	Oid			relid = RelationGetRelid(rel);
+	ForeignTable *table = GetForeignTable(relid);
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	char	   *nspname = get_namespace_name(get_rel_namespace(parentid));
+	char	   *qualname = quote_qualified_identifier(nspname, name);
+	List	   *options = NIL;
+	StringInfoData sql;
+	ListCell   *lc;
+	int			ret;
+	int			i;
+
+	/*
+	 * The partition's own name mustn't be taken for the remote one, and the
+	 * rows of the whole table aren't those of the partition.
+	 */
+	foreach(lc, table->options)
+	{
+		DefElem    *def = (DefElem *) lfirst(lc);
+
+		if (strcmp(def->defname, "dbname") != 0 &&
+			strcmp(def->defname, "table_name") != 0 &&
+			strcmp(def->defname, "row_estimate") != 0)
+			options = lappend(options, def);
+	}
+	options = lappend(options, makeDefElem("dbname",
+										   (Node *) makeString(opt->dbname),
+										   -1));
+	options = lappend(options, makeDefElem("table_name",
+										   (Node *) makeString(opt->table_name),
+										   -1));
+	options = lappend(options, makeDefElem("partition_predicate",
+										   (Node *) makeString(pstrdup(predicate)),
+										   -1));
+
+	initStringInfo(&sql);
+	appendStringInfo(&sql,
+					 "CREATE FOREIGN TABLE %s PARTITION OF %s FOR VALUES IN (%s) SERVER %s",
+					 qualname,
+					 quote_qualified_identifier(nspname, get_rel_name(parentid)),
+					 value ? quote_literal_cstr(value) : "NULL",
+					 quote_identifier(GetForeignServer(table->serverid)->servername));
+	hdfs_append_options(&sql, options);
+
+	ret = SPI_execute(sql.data, false, 0);
+	if (ret != SPI_OK_UTILITY)
+		elog(ERROR, "SPI_execute failed: %s", SPI_result_code_string(ret));
+
+	for (i = 0; i < tupdesc->natts; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+		List	   *coloptions;
+
+		if (attr->attisdropped)
+			continue;
+
+		coloptions = GetForeignColumnOptions(relid, attr->attnum);
+		if (coloptions == NIL ||
+			get_attnum(parentid, NameStr(attr->attname)) == InvalidAttrNumber)
+			continue;
+
+		resetStringInfo(&sql);
+		appendStringInfo(&sql, "ALTER FOREIGN TABLE %s ALTER COLUMN %s",
+						 qualname, quote_identifier(NameStr(attr->attname)));
+		hdfs_append_options(&sql, coloptions);
+
+		ret = SPI_execute(sql.data, false, 0);
+		if (ret != SPI_OK_UTILITY)
+			elog(ERROR, "SPI_execute failed: %s", SPI_result_code_string(ret));
+	}
+}
+
+/*
+ * hdfs_append_options
+ * 		Append an OPTIONS clause with the given options to buf.
+ */
+static void
+hdfs_append_options(StringInfo buf, List *options)
+{
+	ListCell   *lc;
+
+	appendStringInfoString(buf, " OPTIONS (");
+	foreach(lc, options)
+	{
+		DefElem    *def = (DefElem *) lfirst(lc);
+
+		if (foreach_current_index(lc) > 0)
+			appendStringInfoString(buf, ", ");
+		appendStringInfo(buf, "%s %s", quote_identifier(def->defname),
+						 quote_literal_cstr(defGetString(def)));
+	}
+	appendStringInfoChar(buf, ')');
+}
@@ -18,6 +18,8 @@
 #include "libhive/jdbc/hiveclient.h"
 
 static double hdfs_find_row_count(char *src);
+static char *hdfs_trim(char *str);
+static double hdfs_read_row_count(int con_index);
 
 /*
  * In order to get number of rows in a hive table we use
@@ -52,6 +54,7 @@ static double hdfs_find_row_count(char *src);
  * such keyword it is rejected. Otherwise the characters from the line are
  * picked right after the keyword and till a space is encountered. The
  * characters are then converted to a float, and is used as row count.
+ * Returns -1 if the line has no row count.
  */
 double
 hdfs_find_row_count(char *src)
@@ -61,12 +64,12 @@ hdfs_find_row_count(char *src)
 	char	   *pos;
 
 	if (src == NULL || strlen(src) < 80)
-		return 0;
+		return -1;
 
 	/* Does the passed line of explain output contain the keyword? */
 	pos = strstr(src, statistics_str);
 	if (pos == NULL)
-		return 0;
+		return -1;
 
 	/* Copy characters after the keyword in the line */
 	strncpy(row_count, pos + strlen(statistics_str), 50);
@@ -81,6 +84,9 @@ hdfs_find_row_count(char *src)
  * hdfs_rowcount
  * 		Retrieves the number of rows from remote server. Refer the comments
  * 		above function hdfs_find_row_count() for how it is done.
+ *
+ * For a partitioned table, the TableScan statistics are the ones of the
+ * partitions selected by the conditions on the partition columns.
  */
 double
 hdfs_rowcount(int con_index, hdfs_opt *opt, PlannerInfo *root,
@@ -88,10 +94,10 @@ hdfs_rowcount(int con_index, hdfs_opt *opt, PlannerInfo *root,
 {
 	bool		is_null;
 	StringInfoData sql;
-	double		rc = 0;
+	double		rc = -1;
 
 	initStringInfo(&sql);
-	hdfs_deparse_explain(opt, &sql);
+	hdfs_deparse_explain(opt, &sql, root, baserel, fpinfo->partition_conds);
 	hdfs_query_execute(con_index, opt, sql.data);
 
 	while (hdfs_fetch(con_index) == 0)
@@ -104,7 +110,7 @@ hdfs_rowcount(int con_index, hdfs_opt *opt, PlannerInfo *root,
 		{
 			rc = hdfs_find_row_count(value);
 
-			if (rc != 0.0)
+			if (rc >= 0)
 				break;
 		}
 	}
@@ -112,26 +118,32 @@ hdfs_rowcount(int con_index, hdfs_opt *opt, PlannerInfo *root,
 	hdfs_close_result_set(con_index);
 
 	/*
-	 * Any value below 1000 is going to cause materialization step to be
-	 * skipped from the plan, which is very crucial to avoid requery in
-	 * rescan.
+	 * Fall back to the default estimate used without use_remote_estimate
+	 * only if the remote server didn't report any row count; an empty table
+	 * is estimated as such.  Rescans don't need an inflated estimate to be
+	 * protected by a Materialize node, because the scan spools its rows
+	 * itself.
 	 */
-	return (rc > 1000) ? rc : 1000;
+	return (rc >= 0) ? rc : 1000;
 }
 
 /*
  * hdfs_analyze
  * 		Sends analyze query to remote server to compute the statistics.
+ *
+ * If partition is not NULL, only the given partitions of the table are
+ * analyzed, see hdfs_deparse_analyze().
  */
 void
-hdfs_analyze(int con_index, hdfs_opt *opt, Relation rel)
+hdfs_analyze(int con_index, hdfs_opt *opt, Relation rel,
+			 const char *partition)
 {
 	StringInfoData sql;
 
 	initStringInfo(&sql);
-	hdfs_deparse_analyze(&sql, rel);
+	hdfs_deparse_analyze(&sql, rel, partition);
 
-	if (opt->client_type == SPARKSERVER)
+	if (opt->dialect->analyze_returns_rows)
 		hdfs_query_execute(con_index, opt, sql.data);
 	else
 		hdfs_query_execute_utility(con_index, opt, sql.data);
@@ -143,15 +155,22 @@ hdfs_analyze(int con_index, hdfs_opt *opt, Relation rel)
  * hdfs_describe
  * 		This function sends describe query to the remote server and retrieves
  * 		the total size of the data in remote table.
+ *
+ * If partition is not NULL, get the one of the given partition of the table
+ * instead, as listed by SHOW PARTITIONS.
  */
 double
-hdfs_describe(int con_index, hdfs_opt *opt, Relation rel)
+hdfs_describe(int con_index, hdfs_opt *opt, Relation rel,
+			  const char *partition)
 {
 	double		row_count = 0;
 	StringInfoData sql;
 
 	initStringInfo(&sql);
-	hdfs_deparse_describe(&sql, rel);
+	if (partition)
+		hdfs_deparse_describe_partition(&sql, rel, partition);
+	else
+		hdfs_deparse_describe(&sql, rel);
 	hdfs_query_execute(con_index, opt, sql.data);
 
 	/*
@@ -187,3 +206,371 @@ hdfs_describe(int con_index, hdfs_opt *opt, Relation rel)
 	hdfs_close_result_set(con_index);
 	return row_count;
 }
+
+/*
+ * hdfs_get_last_ddl_time
+ * 		Get the transient_lastDdlTime of the remote table, which Hive updates
+ * 		whenever the table or its data is changed.
+ *
+ * If partition is not NULL, get the one of the given partition of the table
+ * instead, as listed by SHOW PARTITIONS.  Returns 0 if the remote server
+ * doesn't report it.
+ */
+int64
+hdfs_get_last_ddl_time(int con_index, hdfs_opt *opt, Relation rel,
+					   const char *partition)
+{
+	int64		ddl_time = 0;
+	StringInfoData sql;
+
+	initStringInfo(&sql);
+	if (partition)
+		hdfs_deparse_describe_partition(&sql, rel, partition);
+	else
+		hdfs_deparse_describe(&sql, rel);
+	hdfs_query_execute(con_index, opt, sql.data);
+
+	/*
+	 * Like totalSize in hdfs_describe(), the transient_lastDdlTime is one of
+	 * the table (or partition) parameters, with its name in the 2nd column
+	 * and its value in the 3rd one.
+	 */
+	while (hdfs_fetch(con_index) == 0)
+	{
+		char	   *value;
+		bool		is_null;
+
+		value = hdfs_get_field_as_cstring(con_index, 1, &is_null);
+
+		if (is_null)
+			continue;
+
+		if (strstr(value, "transient_lastDdlTime") != 0)
+		{
+			char	   *str;
+
+			str = hdfs_get_field_as_cstring(con_index, 2, &is_null);
+			if (!is_null)
+				ddl_time = strtoll(str, NULL, 10);
+
+			break;
+		}
+	}
+
+	hdfs_close_result_set(con_index);
+	return ddl_time;
+}
+
+/*
+ * hdfs_get_partition_columns
+ * 		Get the names of the partition columns of the remote table, or NIL if
+ * 		the table isn't partitioned.
+ */
+List *
+hdfs_get_partition_columns(int con_index, hdfs_opt *opt, Relation rel)
+{
+	List	   *columns = NIL;
+	bool		in_section = false;
+	StringInfoData sql;
+
+	initStringInfo(&sql);
+	hdfs_deparse_describe(&sql, rel);
+	hdfs_query_execute(con_index, opt, sql.data);
+
+	/*
+	 * The output of DESCRIBE FORMATTED lists the partition columns in a
+	 * section of its own, after the regular columns:
+	 *
+	 *	# Partition Information
+	 *	# col_name		data_type		comment
+	 *
+	 *	year			int
+	 *
+	 *	# Detailed Table Information
+	 *
+	 * The section ends with the first empty row or heading following the
+	 * columns.  We have to read the whole output anyway before closing the
+	 * result set.
+	 */
+	while (hdfs_fetch(con_index) == 0)
+	{
+		char	   *value;
+		bool		is_null;
+
+		value = hdfs_get_field_as_cstring(con_index, 0, &is_null);
+		value = is_null ? "" : hdfs_trim(pstrdup(value));
+
+		if (!in_section)
+		{
+			if (columns == NIL &&
+				strncmp(value, "# Partition Information", 23) == 0)
+				in_section = true;
+			continue;
+		}
+
+		if (value[0] == '\0' || value[0] == '#')
+		{
+			if (columns != NIL || strncmp(value, "# Detailed", 10) == 0)
+				in_section = false;
+			continue;
+		}
+
+		columns = lappend(columns, value);
+	}
+
+	hdfs_close_result_set(con_index);
+	return columns;
+}
+
+/*
+ * hdfs_get_partitions
+ * 		Get the partitions of the remote table, as listed by SHOW PARTITIONS,
+ * 		e.g. "year=2024/month=01".
+ */
+List *
+hdfs_get_partitions(int con_index, hdfs_opt *opt, Relation rel)
+{
+	List	   *partitions = NIL;
+	StringInfoData sql;
+
+	initStringInfo(&sql);
+	hdfs_deparse_show_partitions(&sql, rel);
+	hdfs_query_execute(con_index, opt, sql.data);
+
+	while (hdfs_fetch(con_index) == 0)
+	{
+		char	   *value;
+		bool		is_null;
+
+		value = hdfs_get_field_as_cstring(con_index, 0, &is_null);
+		if (is_null)
+			continue;
+
+		value = hdfs_trim(pstrdup(value));
+		if (value[0] != '\0')
+			partitions = lappend(partitions, value);
+	}
+
+	hdfs_close_result_set(con_index);
+	return partitions;
+}
+
+/*
+ * hdfs_get_remote_tables
+ * 		Get the names of the tables and views of the given remote database.
+ *
+ * Spark lists the database of each table first, and its temporary views,
+ * which aren't in the database, along with the tables.
+ */
+List *
+hdfs_get_remote_tables(int con_index, hdfs_opt *opt, const char *dbname)
+{
+	List	   *tables = NIL;
+	int			idx = (opt->client_type == SPARKSERVER) ? 1 : 0;
+	StringInfoData sql;
+
+	initStringInfo(&sql);
+	hdfs_deparse_show_tables(&sql, dbname);
+	hdfs_query_execute(con_index, opt, sql.data);
+
+	while (hdfs_fetch(con_index) == 0)
+	{
+		char	   *value;
+		bool		is_null;
+
+		if (opt->client_type == SPARKSERVER)
+		{
+			value = hdfs_get_field_as_cstring(con_index, 2, &is_null);
+			if (!is_null && strcmp(hdfs_trim(pstrdup(value)), "true") == 0)
+				continue;
+		}
+
+		value = hdfs_get_field_as_cstring(con_index, idx, &is_null);
+		if (is_null)
+			continue;
+
+		value = hdfs_trim(pstrdup(value));
+		if (value[0] != '\0')
+			tables = lappend(tables, value);
+	}
+
+	hdfs_close_result_set(con_index);
+	return tables;
+}
+
+/*
+ * hdfs_get_remote_columns
+ * 		Get the names and the types of the columns of the given remote table,
+ * 		partition columns included, as listed by DESCRIBE.
+ *
+ * The types are the ones of HiveQL, like "decimal(10,2)" or "array<int>".
+ */
+void
+hdfs_get_remote_columns(int con_index, hdfs_opt *opt, const char *dbname,
+						const char *table_name, List **names, List **types)
+{
+	bool		done = false;
+	StringInfoData sql;
+
+	*names = NIL;
+	*types = NIL;
+
+	initStringInfo(&sql);
+	hdfs_deparse_describe_table(&sql, dbname, table_name, false);
+	hdfs_query_execute(con_index, opt, sql.data);
+
+	/*
+	 * The columns come first.  The partition columns are listed again after
+	 * them, following an empty row and a "# Partition Information" heading,
+	 * and are skipped there.  We have to read the whole output anyway before
+	 * closing the result set.
+	 */
+	while (hdfs_fetch(con_index) == 0)
+	{
+		char	   *name;
+		char	   *type;
+		bool		is_null;
+
+		name = hdfs_get_field_as_cstring(con_index, 0, &is_null);
+		name = is_null ? "" : hdfs_trim(pstrdup(name));
+
+		if (done || name[0] == '\0' || name[0] == '#')
+		{
+			done = true;
+			continue;
+		}
+
+		type = hdfs_get_field_as_cstring(con_index, 1, &is_null);
+		type = is_null ? "" : hdfs_trim(pstrdup(type));
+
+		*names = lappend(*names, name);
+		*types = lappend(*types, type);
+	}
+
+	hdfs_close_result_set(con_index);
+}
+
+/*
+ * hdfs_get_remote_row_count
+ * 		Get the number of rows of the given remote table as recorded by the
+ * 		metastore, or -1 if it has none.
+ */
+double
+hdfs_get_remote_row_count(int con_index, hdfs_opt *opt, const char *dbname,
+						  const char *table_name)
+{
+	StringInfoData sql;
+
+	initStringInfo(&sql);
+	hdfs_deparse_describe_table(&sql, dbname, table_name, true);
+	hdfs_query_execute(con_index, opt, sql.data);
+
+	return hdfs_read_row_count(con_index);
+}
+
+/*
+ * hdfs_get_row_count
+ * 		Get the number of rows of the remote table of the given foreign table
+ * 		as recorded by the metastore, or -1 if it has none or Hive doesn't
+ * 		deem it accurate.
+ *
+ * If partition is not NULL, get the one of the given partition of the table
+ * instead, as listed by SHOW PARTITIONS.
+ */
+double
+hdfs_get_row_count(int con_index, hdfs_opt *opt, Relation rel,
+				   const char *partition)
+{
+	StringInfoData sql;
+
+	initStringInfo(&sql);
+	if (partition)
+		hdfs_deparse_describe_partition(&sql, rel, partition);
+	else
+		hdfs_deparse_describe(&sql, rel);
+	hdfs_query_execute(con_index, opt, sql.data);
+
+	return hdfs_read_row_count(con_index);
+}
+
+/*
+ * hdfs_read_row_count
+ * 		Read the number of rows from the output of DESCRIBE FORMATTED, and
+ * 		close it.  Returns -1 if it's not there.
+ *
+ * Hive lists numRows among the table parameters, with its name in the 2nd
+ * column and its value in the 3rd one, and reports -1 when it doesn't know.
+ * Its COLUMN_STATS_ACCURATE parameter tells whether numRows is up to date,
+ * when it's listed.  Spark has a Statistics row instead, or a Partition
+ * Statistics row for a partition, like "1024 bytes, 100 rows".  The
+ * metastore only has such statistics once ANALYZE TABLE was run, or for
+ * tables filled by INSERT with hive.stats.autogather.
+ */
+static double
+hdfs_read_row_count(int con_index)
+{
+	double		row_count = -1;
+	bool		accurate = true;
+
+	while (hdfs_fetch(con_index) == 0)
+	{
+		char	   *name;
+		char	   *value;
+		bool		is_null;
+
+		name = hdfs_get_field_as_cstring(con_index, 0, &is_null);
+		name = is_null ? "" : hdfs_trim(pstrdup(name));
+
+		if (strcmp(name, "Statistics") == 0 ||
+			strcmp(name, "Partition Statistics") == 0)
+		{
+			char	   *pos;
+
+			value = hdfs_get_field_as_cstring(con_index, 1, &is_null);
+			pos = is_null ? NULL : strstr(value, ", ");
+			if (pos && strstr(pos, " rows"))
+				row_count = strtod(pos + 2, NULL);
+			continue;
+		}
+
+		value = hdfs_get_field_as_cstring(con_index, 1, &is_null);
+		if (is_null)
+			continue;
+		name = hdfs_trim(pstrdup(value));
+
+		value = hdfs_get_field_as_cstring(con_index, 2, &is_null);
+		if (is_null)
+			continue;
+
+		if (strcmp(name, "numRows") == 0)
+			row_count = strtod(value, NULL);
+		else if (strcmp(name, "COLUMN_STATS_ACCURATE") == 0)
+			accurate = (strstr(value, "\"BASIC_STATS\":\"true\"") != NULL);
+	}
+
+	hdfs_close_result_set(con_index);
+
+	return accurate ? Max(row_count, -1) : -1;
+}
+
+/*
+ * hdfs_trim
+ * 		Strip the leading and trailing white space Hive pads DESCRIBE output
+ * 		with.  The string is modified in place.
+ */
+static char *
+hdfs_trim(char *str)
+{
+	char	   *end;
+
+	while (*str == ' ' || *str == '\t')
+		str++;
+
+	end = str + strlen(str);
+	while (end > str && (end[-1] == ' ' || end[-1] == '\t' ||
+						 end[-1] == '\n' || end[-1] == '\r'))
+		end--;
+	*end = '\0';
+
+	return str;
+}
@@ -0,0 +1,894 @@
+/*-------------------------------------------------------------------------
+ *
+ * hdfs_snapshot.c
+ * 		Local snapshots of remote Hive/Spark tables.
+ *
+ * A snapshot keeps a local copy of all the rows of a remote table, one file
+ * per remote partition, in the data directory.  Scans of the foreign table
+ * read the snapshot instead of running a remote query, and a refresh pulls
+ * only the partitions changed since the previous one.
+ *
+ * Portions Copyright (c) 2012-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 2004-2025, EnterpriseDB Corporation.
+ *
+ * IDENTIFICATION
+ * 		hdfs_snapshot.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <unistd.h>
+
+#include "access/table.h"
+#include "catalog/objectaddress.h"
+#include "catalog/pg_class.h"
+#include "executor/tuptable.h"
+#include "fmgr.h"
+#include "foreign/foreign.h"
+#include "hdfs_fdw.h"
+#include "miscadmin.h"
+#include "storage/fd.h"
+#include "storage/lmgr.h"
+#include "utils/acl.h"
+#include "utils/inval.h"
+#include "utils/memutils.h"
+
+/*
+ * Directory holding the snapshots, relative to the data directory.  The
+ * snapshot of a foreign table is kept in <database oid>/<table oid> below it.
+ */
+#define HDFS_SNAPSHOT_DIR			"hdfs_fdw_snapshot"
+
+/* File describing the snapshot, see hdfs_snapshot_write_manifest(). */
+#define HDFS_SNAPSHOT_MANIFEST		"manifest"
+#define HDFS_SNAPSHOT_HEADER		"hdfs_fdw snapshot 1"
+
+/*
+ * Files being written are named with this prefix until they are complete.
+ * Such files, and the other files left behind by a refresh which failed
+ * before switching to its manifest, are removed by the next refresh.
+ */
+#define HDFS_SNAPSHOT_TMP_PREFIX	"tmp."
+
+/* Rows of one remote partition, or of the whole unpartitioned table. */
+typedef struct hdfsSnapshotPart
+{
+	char	   *partition;		/* as listed by SHOW PARTITIONS, "" if the
+								 * table isn't partitioned */
+	int64		ddl_time;		/* transient_lastDdlTime, 0 if unknown */
+	int64		rows;			/* number of rows in the file */
+	char	   *file;			/* name of the file holding the rows */
+} hdfsSnapshotPart;
+
+typedef struct hdfsSnapshotManifest
+{
+	char	   *identity;		/* server and remote table copied */
+	char	   *columns;		/* types of the attributes of the rows */
+	int64		generation;		/* number of refreshes so far */
+	int64		rows;			/* total number of rows */
+	List	   *parts;			/* hdfsSnapshotPart of each partition */
+} hdfsSnapshotManifest;
+
+struct hdfsSnapshotScan
+{
+	char	  **paths;			/* files to read, in order */
+	int			npaths;
+	int			next;			/* index of the file being read */
+	FILE	   *file;			/* NULL if no file is open */
+};
+
+PG_FUNCTION_INFO_V1(hdfs_fdw_snapshot);
+PG_FUNCTION_INFO_V1(hdfs_fdw_drop_snapshot);
+
+static char *hdfs_snapshot_dir(Oid relid);
+static void hdfs_snapshot_make_dir(Oid relid);
+static void hdfs_snapshot_remove_files(const char *dir,
+									   hdfsSnapshotManifest *keep);
+static char *hdfs_snapshot_identity(Relation rel, hdfs_opt *opt);
+static char *hdfs_snapshot_columns(TupleDesc tupdesc);
+static bool hdfs_snapshot_read_manifest(const char *dir,
+										hdfsSnapshotManifest *manifest);
+static bool hdfs_snapshot_manifest_matches(hdfsSnapshotManifest *manifest,
+										   Relation rel, hdfs_opt *opt);
+static void hdfs_snapshot_write_manifest(const char *dir,
+										 hdfsSnapshotManifest *manifest);
+static bool hdfs_snapshot_read_line(FILE *file, StringInfo buf);
+static hdfsSnapshotPart *hdfs_snapshot_find_part(hdfsSnapshotManifest *manifest,
+												 const char *partition);
+static bool hdfs_snapshot_find_file(hdfsSnapshotManifest *manifest,
+									const char *file);
+static int64 hdfs_snapshot_pull(int con_index, hdfs_opt *opt, Relation rel,
+								const char *partition, const char *dir,
+								const char *name);
+
+/*
+ * hdfs_fdw_snapshot
+ * 		Create or refresh the local snapshot of the given foreign table, and
+ * 		return the number of rows in it.
+ *
+ * The rows of a remote partition are pulled again only if its
+ * transient_lastDdlTime changed since the previous refresh.  An
+ * unpartitioned table is pulled again as a whole if it changed.  The rows are
+ * read with the user mapping of the current user, the owner of the table, and
+ * are then returned to whoever may read the foreign table.
+ *
+ * The rows are pulled into files named after the new generation, which no
+ * scan reads, under a SHARE UPDATE EXCLUSIVE lock, so that scans of the
+ * previous snapshot go on meanwhile.  The lock is only upgraded to ACCESS
+ * EXCLUSIVE to switch to the new manifest, which waits for these scans, and
+ * makes those starting later wait for the end of the transaction.  The
+ * files of the previous generation can then be removed right away.  The
+ * switch isn't undone if the transaction is rolled back.
+ */
+Datum
+hdfs_fdw_snapshot(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	Relation	rel;
+	hdfs_opt   *opt;
+	char	   *dir;
+	hdfsSnapshotManifest old;
+	hdfsSnapshotManifest new;
+	bool		reuse;
+	bool		partitioned;
+	List	   *partitions;
+	int			con_index;
+	int			nparts = 0;
+	ListCell   *lc;
+
+	/* Concurrent refreshes wait for the refresh to complete, scans don't. */
+	rel = table_open(relid, ShareUpdateExclusiveLock);
+	hdfs_check_owned_relation(rel);
+
+	opt = hdfs_get_options(relid);
+	if (opt->partition_predicate)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot take a snapshot of foreign table \"%s\" with a partition_predicate",
+						RelationGetRelationName(rel))));
+	dir = hdfs_snapshot_dir(relid);
+	hdfs_snapshot_make_dir(relid);
+
+	/*
+	 * Nothing of the previous snapshot can be reused if it was taken from
+	 * another remote table, or with other columns.  Its files are removed
+	 * all the same, once the new snapshot is complete.  Files no manifest
+	 * refers to can go right away, no scan reads them.
+	 */
+	if (hdfs_snapshot_read_manifest(dir, &old))
+	{
+		hdfs_snapshot_remove_files(dir, &old);
+		reuse = hdfs_snapshot_manifest_matches(&old, rel, opt);
+	}
+	else
+	{
+		hdfs_snapshot_remove_files(dir, NULL);
+		reuse = false;
+	}
+
+	memset(&new, 0, sizeof(new));
+	new.identity = hdfs_snapshot_identity(rel, opt);
+	new.columns = hdfs_snapshot_columns(RelationGetDescr(rel));
+	new.generation = old.generation + 1;
+
+	con_index = hdfs_get_connection(GetForeignServer(GetForeignTable(relid)->serverid),
+									opt);
+
+	partitioned = (hdfs_get_partition_columns(con_index, opt, rel) != NIL);
+	if (partitioned)
+		partitions = hdfs_get_partitions(con_index, opt, rel);
+	else
+		partitions = list_make1(pstrdup(""));
+
+	foreach(lc, partitions)
+	{
+		char	   *partition = (char *) lfirst(lc);
+		hdfsSnapshotPart *part;
+		hdfsSnapshotPart *oldpart = NULL;
+
+		part = (hdfsSnapshotPart *) palloc0(sizeof(hdfsSnapshotPart));
+		part->partition = partition;
+		part->ddl_time = hdfs_get_last_ddl_time(con_index, opt, rel,
+												partitioned ? partition : NULL);
+
+		if (reuse)
+			oldpart = hdfs_snapshot_find_part(&old, partition);
+
+		if (oldpart && part->ddl_time != 0 &&
+			part->ddl_time == oldpart->ddl_time)
+		{
+			/* Unchanged since the previous refresh, keep its file. */
+			part->rows = oldpart->rows;
+			part->file = oldpart->file;
+			oldpart->file = NULL;
+		}
+		else
+		{
+			part->file = psprintf(INT64_FORMAT ".%d", new.generation, nparts);
+			part->rows = hdfs_snapshot_pull(con_index, opt, rel,
+											partitioned ? partition : NULL,
+											dir, part->file);
+		}
+
+		nparts++;
+		new.rows += part->rows;
+		new.parts = lappend(new.parts, part);
+	}
+
+	hdfs_rel_connection(con_index);
+
+	/*
+	 * This deadlocks if another transaction which read the table waits to
+	 * refresh it too, in which case one of the two refreshes is cancelled.
+	 */
+	LockRelationOid(relid, AccessExclusiveLock);
+
+	/* The files of the partitions pulled again go away. */
+	hdfs_snapshot_write_manifest(dir, &new);
+
+	foreach(lc, old.parts)
+	{
+		hdfsSnapshotPart *oldpart = (hdfsSnapshotPart *) lfirst(lc);
+
+		if (oldpart->file)
+		{
+			char	   *path = psprintf("%s/%s", dir, oldpart->file);
+
+			if (unlink(path) != 0 && errno != ENOENT)
+				ereport(WARNING,
+						(errcode_for_file_access(),
+						 errmsg("could not remove file \"%s\": %m", path)));
+			pfree(path);
+		}
+	}
+
+	/* Make other sessions plan their scans of the table again. */
+	CacheInvalidateRelcache(rel);
+
+	table_close(rel, NoLock);
+
+	PG_RETURN_INT64(new.rows);
+}
+
+/*
+ * hdfs_fdw_drop_snapshot
+ * 		Remove the local snapshot of the given foreign table, so that it's
+ * 		scanned remotely again.
+ *
+ * Returns false if the table had no snapshot.
+ */
+Datum
+hdfs_fdw_drop_snapshot(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	Relation	rel;
+	char	   *dir;
+	char	   *path;
+	bool		found;
+
+	/* Wait for the scans reading the snapshot. */
+	rel = table_open(relid, AccessExclusiveLock);
+	hdfs_check_owned_relation(rel);
+
+	dir = hdfs_snapshot_dir(relid);
+
+	/* Without its manifest, the snapshot is gone already. */
+	path = psprintf("%s/%s", dir, HDFS_SNAPSHOT_MANIFEST);
+	found = (unlink(path) == 0);
+	if (!found && errno != ENOENT)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not remove file \"%s\": %m", path)));
+
+	hdfs_snapshot_remove_files(dir, NULL);
+	if (rmdir(dir) != 0 && errno != ENOENT)
+		ereport(WARNING,
+				(errcode_for_file_access(),
+				 errmsg("could not remove directory \"%s\": %m", dir)));
+
+	CacheInvalidateRelcache(rel);
+
+	table_close(rel, NoLock);
+
+	PG_RETURN_BOOL(found);
+}
+
+/*
+ * hdfs_snapshot_exists
+ * 		Check if the given foreign table has a usable snapshot, and if so,
+ * 		return the number of rows in it to *rows.
+ */
+bool
+hdfs_snapshot_exists(Relation rel, hdfs_opt *opt, double *rows)
+{
+	hdfsSnapshotManifest manifest;
+
+	if (!hdfs_snapshot_read_manifest(hdfs_snapshot_dir(RelationGetRelid(rel)),
+									 &manifest) ||
+		!hdfs_snapshot_manifest_matches(&manifest, rel, opt))
+		return false;
+
+	*rows = (double) manifest.rows;
+	return true;
+}
+
+/*
+ * hdfs_snapshot_begin_scan
+ * 		Start reading the snapshot of the given foreign table.
+ *
+ * Returns NULL if the table has no usable snapshot.  The files read are not
+ * removed before the end of the scan, as long as the caller holds a lock on
+ * the table.
+ */
+hdfsSnapshotScan *
+hdfs_snapshot_begin_scan(Relation rel, hdfs_opt *opt)
+{
+	hdfsSnapshotScan *scan;
+	hdfsSnapshotManifest manifest;
+	char	   *dir = hdfs_snapshot_dir(RelationGetRelid(rel));
+	ListCell   *lc;
+
+	if (!hdfs_snapshot_read_manifest(dir, &manifest) ||
+		!hdfs_snapshot_manifest_matches(&manifest, rel, opt))
+		return NULL;
+
+	scan = (hdfsSnapshotScan *) palloc0(sizeof(hdfsSnapshotScan));
+	scan->paths = (char **) palloc(sizeof(char *) *
+								   Max(list_length(manifest.parts), 1));
+	foreach(lc, manifest.parts)
+	{
+		hdfsSnapshotPart *part = (hdfsSnapshotPart *) lfirst(lc);
+
+		scan->paths[scan->npaths++] = psprintf("%s/%s", dir, part->file);
+	}
+
+	return scan;
+}
+
+/*
+ * hdfs_snapshot_read
+ * 		Store the next row of the snapshot in the given slot, which must be
+ * 		able to hold a minimal tuple.
+ *
+ * Returns false at the end of the snapshot.
+ */
+bool
+hdfs_snapshot_read(hdfsSnapshotScan *scan, TupleTableSlot *slot)
+{
+	for (;;)
+	{
+		if (scan->file == NULL)
+		{
+			if (scan->next >= scan->npaths)
+				return false;
+
+			scan->file = AllocateFile(scan->paths[scan->next], PG_BINARY_R);
+			if (scan->file == NULL)
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not open file \"%s\": %m",
+								scan->paths[scan->next])));
+		}
+
+		if (hdfs_read_row(scan->file, scan->paths[scan->next], slot))
+			return true;
+
+		FreeFile(scan->file);
+		scan->file = NULL;
+		scan->next++;
+	}
+}
+
+/*
+ * hdfs_snapshot_rescan
+ * 		Restart reading the snapshot from its first row.
+ */
+void
+hdfs_snapshot_rescan(hdfsSnapshotScan *scan)
+{
+	if (scan->file)
+		FreeFile(scan->file);
+	scan->file = NULL;
+	scan->next = 0;
+}
+
+/*
+ * hdfs_snapshot_end_scan
+ * 		Stop reading the snapshot.
+ */
+void
+hdfs_snapshot_end_scan(hdfsSnapshotScan *scan)
+{
+	hdfs_snapshot_rescan(scan);
+}
+
+/*
+ * hdfs_check_owned_relation
+ * 		Check that the given relation is a foreign table of hdfs_fdw owned by
+ * 		the current user, who may thus take its snapshot or stage its rows.
+ */
+void
+hdfs_check_owned_relation(Relation rel)
+{
+	if (!hdfs_is_hdfs_relation(rel))
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("\"%s\" is not a foreign table of hdfs_fdw",
+						RelationGetRelationName(rel))));
+
+#if PG_VERSION_NUM >= 160000
+	if (!object_ownercheck(RelationRelationId, RelationGetRelid(rel),
+						   GetUserId()))
+#else
+	if (!pg_class_ownercheck(RelationGetRelid(rel), GetUserId()))
+#endif
+		aclcheck_error(ACLCHECK_NOT_OWNER,
+					   get_relkind_objtype(rel->rd_rel->relkind),
+					   RelationGetRelationName(rel));
+}
+
+/*
+ * hdfs_snapshot_dir
+ * 		Path of the directory holding the snapshot of the given table.
+ */
+static char *
+hdfs_snapshot_dir(Oid relid)
+{
+	return psprintf("%s/%u/%u", HDFS_SNAPSHOT_DIR, MyDatabaseId, relid);
+}
+
+/*
+ * hdfs_snapshot_make_dir
+ * 		Create the directory holding the snapshot of the given table, unless
+ * 		it exists already.
+ */
+static void
+hdfs_snapshot_make_dir(Oid relid)
+{
+	char	   *paths[3];
+	int			i;
+
+	paths[0] = HDFS_SNAPSHOT_DIR;
+	paths[1] = psprintf("%s/%u", HDFS_SNAPSHOT_DIR, MyDatabaseId);
+	paths[2] = hdfs_snapshot_dir(relid);
+
+	for (i = 0; i < lengthof(paths); i++)
+	{
+		if (MakePGDirectory(paths[i]) < 0 && errno != EEXIST)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not create directory \"%s\": %m",
+							paths[i])));
+	}
+}
+
+/*
+ * hdfs_snapshot_remove_files
+ * 		Remove the files of the given snapshot directory, except the manifest
+ * 		and the files it refers to, if given.
+ */
+static void
+hdfs_snapshot_remove_files(const char *dir, hdfsSnapshotManifest *keep)
+{
+	DIR		   *dirdesc;
+	struct dirent *de;
+
+	dirdesc = AllocateDir(dir);
+	if (dirdesc == NULL && errno == ENOENT)
+		return;
+
+	while ((de = ReadDir(dirdesc, dir)) != NULL)
+	{
+		char	   *path;
+
+		if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+			continue;
+
+		if (keep &&
+			(strcmp(de->d_name, HDFS_SNAPSHOT_MANIFEST) == 0 ||
+			 hdfs_snapshot_find_file(keep, de->d_name)))
+			continue;
+
+		path = psprintf("%s/%s", dir, de->d_name);
+		if (unlink(path) != 0 && errno != ENOENT)
+			ereport(WARNING,
+					(errcode_for_file_access(),
+					 errmsg("could not remove file \"%s\": %m", path)));
+		pfree(path);
+	}
+	FreeDir(dirdesc);
+}
+
+/*
+ * hdfs_snapshot_identity
+ * 		Describe the remote table a snapshot of the given foreign table is
+ * 		taken from.
+ */
+static char *
+hdfs_snapshot_identity(Relation rel, hdfs_opt *opt)
+{
+	return psprintf("%u %s.%s",
+					GetForeignTable(RelationGetRelid(rel))->serverid,
+					opt->dbname, opt->table_name);
+}
+
+/*
+ * hdfs_snapshot_columns
+ * 		Describe the types of the attributes, which determine the format of
+ * 		the rows stored in the snapshot.
+ */
+static char *
+hdfs_snapshot_columns(TupleDesc tupdesc)
+{
+	StringInfoData buf;
+	int			i;
+
+	initStringInfo(&buf);
+	for (i = 0; i < tupdesc->natts; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+
+		if (i > 0)
+			appendStringInfoChar(&buf, ',');
+
+		if (attr->attisdropped)
+			appendStringInfoChar(&buf, '-');
+		else
+			appendStringInfo(&buf, "%u:%d", attr->atttypid, attr->atttypmod);
+	}
+
+	return buf.data;
+}
+
+/*
+ * hdfs_snapshot_read_manifest
+ * 		Read the manifest of the snapshot kept in the given directory.
+ *
+ * Returns false if there is no snapshot, or if its manifest can't be read.
+ * manifest is zeroed in that case.
+ */
+static bool
+hdfs_snapshot_read_manifest(const char *dir, hdfsSnapshotManifest *manifest)
+{
+	char	   *path;
+	FILE	   *file;
+	StringInfoData line;
+	bool		valid = false;
+
+	memset(manifest, 0, sizeof(hdfsSnapshotManifest));
+
+	path = psprintf("%s/%s", dir, HDFS_SNAPSHOT_MANIFEST);
+	file = AllocateFile(path, "r");
+	if (file == NULL)
+	{
+		if (errno != ENOENT)
+			ereport(WARNING,
+					(errcode_for_file_access(),
+					 errmsg("could not open file \"%s\": %m", path)));
+		pfree(path);
+		return false;
+	}
+
+	initStringInfo(&line);
+	if (hdfs_snapshot_read_line(file, &line) &&
+		strcmp(line.data, HDFS_SNAPSHOT_HEADER) == 0)
+	{
+		valid = true;
+
+		while (valid && hdfs_snapshot_read_line(file, &line))
+		{
+			char	   *value = strchr(line.data, ' ');
+
+			if (value == NULL)
+			{
+				valid = false;
+				break;
+			}
+			*value++ = '\0';
+
+			if (strcmp(line.data, "identity") == 0)
+				manifest->identity = pstrdup(value);
+			else if (strcmp(line.data, "columns") == 0)
+				manifest->columns = pstrdup(value);
+			else if (strcmp(line.data, "generation") == 0)
+				manifest->generation = strtoll(value, NULL, 10);
+			else if (strcmp(line.data, "rows") == 0)
+				manifest->rows = strtoll(value, NULL, 10);
+			else if (strcmp(line.data, "part") == 0)
+			{
+				/* ddl_time, rows, file and partition, separated by tabs */
+				char	   *fields[4];
+				int			nfields = 0;
+				char	   *pos = value;
+				hdfsSnapshotPart *part;
+
+				fields[nfields++] = pos;
+				while (nfields < lengthof(fields) &&
+					   (pos = strchr(pos, '\t')) != NULL)
+				{
+					*pos++ = '\0';
+					fields[nfields++] = pos;
+				}
+
+				if (nfields != lengthof(fields))
+				{
+					valid = false;
+					break;
+				}
+
+				part = (hdfsSnapshotPart *) palloc0(sizeof(hdfsSnapshotPart));
+				part->ddl_time = strtoll(fields[0], NULL, 10);
+				part->rows = strtoll(fields[1], NULL, 10);
+				part->file = pstrdup(fields[2]);
+				part->partition = pstrdup(fields[3]);
+				manifest->parts = lappend(manifest->parts, part);
+			}
+			else
+				valid = false;
+		}
+	}
+
+	FreeFile(file);
+	pfree(line.data);
+	pfree(path);
+
+	if (!valid || manifest->identity == NULL || manifest->columns == NULL)
+	{
+		memset(manifest, 0, sizeof(hdfsSnapshotManifest));
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * hdfs_snapshot_manifest_matches
+ * 		Check if the snapshot described by the given manifest can be read as
+ * 		the rows of the given foreign table.
+ *
+ * The table must still refer to the same remote table, and its attributes
+ * must be of the same types as when the snapshot was taken.
+ */
+static bool
+hdfs_snapshot_manifest_matches(hdfsSnapshotManifest *manifest, Relation rel,
+							   hdfs_opt *opt)
+{
+	return strcmp(manifest->identity, hdfs_snapshot_identity(rel, opt)) == 0 &&
+		strcmp(manifest->columns,
+			   hdfs_snapshot_columns(RelationGetDescr(rel))) == 0;
+}
+
+/*
+ * hdfs_snapshot_write_manifest
+ * 		Replace the manifest of the snapshot kept in the given directory.
+ *
+ * The manifest is a text file, listing the files holding the rows of each
+ * partition:
+ *
+ *	hdfs_fdw snapshot 1
+ *	identity <server oid> <database>.<table>
+ *	columns <type oid>:<typmod>,...
+ *	generation <number of refreshes>
+ *	rows <total number of rows>
+ *	part <ddl time>\t<rows>\t<file>\t<partition>
+ *	...
+ *
+ * It is replaced atomically, so that the previous snapshot stays usable if
+ * the refresh fails.
+ */
+static void
+hdfs_snapshot_write_manifest(const char *dir, hdfsSnapshotManifest *manifest)
+{
+	char	   *path;
+	char	   *tmppath;
+	StringInfoData buf;
+	FILE	   *file;
+	ListCell   *lc;
+
+	initStringInfo(&buf);
+	appendStringInfo(&buf, "%s\n", HDFS_SNAPSHOT_HEADER);
+	appendStringInfo(&buf, "identity %s\n", manifest->identity);
+	appendStringInfo(&buf, "columns %s\n", manifest->columns);
+	appendStringInfo(&buf, "generation " INT64_FORMAT "\n",
+					 manifest->generation);
+	appendStringInfo(&buf, "rows " INT64_FORMAT "\n", manifest->rows);
+
+	foreach(lc, manifest->parts)
+	{
+		hdfsSnapshotPart *part = (hdfsSnapshotPart *) lfirst(lc);
+
+		appendStringInfo(&buf, "part " INT64_FORMAT "\t" INT64_FORMAT "\t%s\t%s\n",
+						 part->ddl_time, part->rows, part->file,
+						 part->partition);
+	}
+
+	path = psprintf("%s/%s", dir, HDFS_SNAPSHOT_MANIFEST);
+	tmppath = psprintf("%s/%s%d.%s", dir, HDFS_SNAPSHOT_TMP_PREFIX, MyProcPid,
+					   HDFS_SNAPSHOT_MANIFEST);
+
+	file = AllocateFile(tmppath, "w");
+	if (file == NULL)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not create file \"%s\": %m", tmppath)));
+
+	if (fwrite(buf.data, 1, buf.len, file) != buf.len)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write file \"%s\": %m", tmppath)));
+
+	if (FreeFile(file) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not close file \"%s\": %m", tmppath)));
+
+	durable_rename(tmppath, path, ERROR);
+
+	pfree(buf.data);
+	pfree(path);
+	pfree(tmppath);
+}
+
+/*
+ * hdfs_snapshot_read_line
+ * 		Read the next line of the given file into buf, without its newline.
+ *
+ * Returns false at the end of the file, or if the last line is incomplete.
+ */
+static bool
+hdfs_snapshot_read_line(FILE *file, StringInfo buf)
+{
+	char		chunk[1024];
+
+	resetStringInfo(buf);
+	while (fgets(chunk, sizeof(chunk), file) != NULL)
+	{
+		appendStringInfoString(buf, chunk);
+		if (buf->len > 0 && buf->data[buf->len - 1] == '\n')
+		{
+			buf->data[--buf->len] = '\0';
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * hdfs_snapshot_find_part
+ * 		Find the given partition in the manifest, NULL if it's not there.
+ */
+static hdfsSnapshotPart *
+hdfs_snapshot_find_part(hdfsSnapshotManifest *manifest, const char *partition)
+{
+	ListCell   *lc;
+
+	foreach(lc, manifest->parts)
+	{
+		hdfsSnapshotPart *part = (hdfsSnapshotPart *) lfirst(lc);
+
+		if (part->file && strcmp(part->partition, partition) == 0)
+			return part;
+	}
+
+	return NULL;
+}
+
+/*
+ * hdfs_snapshot_find_file
+ * 		Check if the manifest refers to the given file.
+ */
+static bool
+hdfs_snapshot_find_file(hdfsSnapshotManifest *manifest, const char *file)
+{
+	ListCell   *lc;
+
+	foreach(lc, manifest->parts)
+	{
+		hdfsSnapshotPart *part = (hdfsSnapshotPart *) lfirst(lc);
+
+		if (strcmp(part->file, file) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * hdfs_snapshot_pull
+ * 		Copy the rows of the given partition of the remote table, or of the
+ * 		whole table if partition is NULL, into a new file of the snapshot.
+ *
+ * Returns the number of rows copied.
+ */
+static int64
+hdfs_snapshot_pull(int con_index, hdfs_opt *opt, Relation rel,
+				   const char *partition, const char *dir, const char *name)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	TupleTableSlot *slot;
+	MemoryContext row_cxt;
+	MemoryContext oldcontext;
+	StringInfoData sql;
+	char	   *path;
+	char	   *tmppath;
+	FILE	   *file;
+	int64		rows = 0;
+
+	path = psprintf("%s/%s", dir, name);
+	tmppath = psprintf("%s/%s%d.%s", dir, HDFS_SNAPSHOT_TMP_PREFIX, MyProcPid,
+					   name);
+
+	file = AllocateFile(tmppath, PG_BINARY_W);
+	if (file == NULL)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not create file \"%s\": %m", tmppath)));
+
+	slot = MakeSingleTupleTableSlot(tupdesc, &TTSOpsVirtual);
+	row_cxt = AllocSetContextCreate(CurrentMemoryContext,
+									"hdfs_fdw snapshot row",
+									ALLOCSET_DEFAULT_SIZES);
+
+	initStringInfo(&sql);
+	hdfs_deparse_snapshot_select(&sql, rel, partition);
+	hdfs_query_execute(con_index, opt, sql.data);
+
+	while (hdfs_fetch(con_index) == 0)
+	{
+		int			attid = 0;
+		int			i;
+
+		CHECK_FOR_INTERRUPTS();
+
+		ExecClearTuple(slot);
+		MemoryContextReset(row_cxt);
+		oldcontext = MemoryContextSwitchTo(row_cxt);
+
+		for (i = 0; i < tupdesc->natts; i++)
+		{
+			Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+			bool		isnull = true;
+
+			slot->tts_values[i] = (Datum) 0;
+			if (!attr->attisdropped)
+				slot->tts_values[i] = hdfs_get_value(con_index, opt,
+													 attr->atttypid,
+													 attr->atttypmod,
+													 attid++, &isnull);
+			slot->tts_isnull[i] = isnull;
+		}
+		ExecStoreVirtualTuple(slot);
+
+		if (!hdfs_write_row(file, slot, NULL))
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not write file \"%s\": %m", tmppath)));
+
+		MemoryContextSwitchTo(oldcontext);
+		rows++;
+	}
+
+	hdfs_close_result_set(con_index);
+
+	if (!hdfs_write_row(file, NULL, NULL))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write file \"%s\": %m", tmppath)));
+
+	if (FreeFile(file) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not close file \"%s\": %m", tmppath)));
+
+	durable_rename(tmppath, path, ERROR);
+
+	ExecDropSingleTupleTableSlot(slot);
+	MemoryContextDelete(row_cxt);
+	pfree(path);
+	pfree(tmppath);
+
+	return rows;
+}
@@ -0,0 +1,232 @@
+/*-------------------------------------------------------------------------
+ *
+ * hdfs_stage.c
+ * 		Staging of local rows into a remote Hive/Spark table.
+ *
+ * A join between a large remote table and a small local relation otherwise
+ * fetches the whole remote table.  Once the local rows are staged into the
+ * remote table of another foreign table, the join is between two foreign
+ * tables and is pushed down, so that only the matching rows come back.
+ *
+ * Portions Copyright (c) 2012-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 2004-2025, EnterpriseDB Corporation.
+ *
+ * IDENTIFICATION
+ * 		hdfs_stage.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "access/table.h"
+#include "executor/spi.h"
+#include "fmgr.h"
+#include "foreign/foreign.h"
+#include "hdfs_fdw.h"
+#include "utils/builtins.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+
+PG_FUNCTION_INFO_V1(hdfs_fdw_stage);
+
+static void hdfs_stage_check_columns(Relation rel, TupleDesc tupdesc,
+									 int *attmap);
+
+/*
+ * hdfs_fdw_stage
+ * 		Replace the remote table of the given foreign table by a new one
+ * 		holding the rows of the given query, and return the number of rows
+ * 		staged.
+ *
+ * The columns of the remote table are those of the foreign table, and the
+ * query must return a column of the same type for each of them, in order.
+ * The rows are sent in INSERT statements of batch_size rows each.
+ *
+ * Only foreign tables with the staging option may have their remote table
+ * replaced.  The query and the definition of the remote table are checked
+ * before the remote table is dropped, so that a wrong query leaves it as it
+ * was.
+ */
+Datum
+hdfs_fdw_stage(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	char	   *query = text_to_cstring(PG_GETARG_TEXT_PP(1));
+	int32		batch_size = PG_GETARG_INT32(2);
+	Relation	rel;
+	hdfs_opt   *opt;
+	int			con_index;
+	SPIPlanPtr	plan;
+	Portal		portal;
+	StringInfoData sql;
+	StringInfoData create_sql;
+	MemoryContext batch_cxt;
+	MemoryContext oldcxt;
+	Datum	   *values;
+	bool	   *nulls;
+	int		   *attmap;
+	int			natts;
+	int64		rows = 0;
+
+	if (batch_size <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("batch_size must be greater than zero")));
+
+	/* Concurrent stagings into the same table wait for each other. */
+	rel = table_open(relid, ShareUpdateExclusiveLock);
+	hdfs_check_owned_relation(rel);
+
+	natts = RelationGetDescr(rel)->natts;
+	values = (Datum *) palloc0(sizeof(Datum) * Max(natts, 1));
+	nulls = (bool *) palloc(sizeof(bool) * Max(natts, 1));
+	memset(nulls, true, sizeof(bool) * Max(natts, 1));
+
+	opt = hdfs_get_options(relid);
+
+	/* The remote table is dropped, it must be one meant for staging. */
+	if (!opt->staging)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("foreign table \"%s\" is not a staging table",
+						RelationGetRelationName(rel)),
+				 errhint("Set the staging option of the foreign table to allow replacing its remote table.")));
+
+	/* The remote table holds the rows of other partitions too. */
+	if (opt->partition_predicate)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot stage rows into foreign table \"%s\" with a partition_predicate",
+						RelationGetRelationName(rel))));
+
+	/* Check the query and the remote table definition before dropping it. */
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "SPI_connect failed");
+
+	plan = SPI_prepare(query, 0, NULL);
+	if (plan == NULL)
+		elog(ERROR, "SPI_prepare failed: %s",
+			 SPI_result_code_string(SPI_result));
+
+	portal = SPI_cursor_open(NULL, plan, NULL, NULL, true);
+
+	attmap = (int *) palloc(sizeof(int) * Max(natts, 1));
+	hdfs_stage_check_columns(rel, portal->tupDesc, attmap);
+
+	initStringInfo(&create_sql);
+	hdfs_deparse_create_table(&create_sql, rel);
+
+	con_index = hdfs_get_connection(GetForeignServer(GetForeignTable(relid)->serverid),
+									opt);
+
+	initStringInfo(&sql);
+	hdfs_deparse_drop_table(&sql, rel);
+	hdfs_query_execute_utility(con_index, opt, sql.data);
+
+	hdfs_query_execute_utility(con_index, opt, create_sql.data);
+
+	batch_cxt = AllocSetContextCreate(CurrentMemoryContext,
+									  "hdfs_fdw stage batch",
+									  ALLOCSET_DEFAULT_SIZES);
+
+	for (;;)
+	{
+		uint64		i;
+
+		SPI_cursor_fetch(portal, true, batch_size);
+		if (SPI_processed == 0)
+			break;
+
+		oldcxt = MemoryContextSwitchTo(batch_cxt);
+
+		resetStringInfo(&sql);
+		hdfs_deparse_insert(&sql, rel);
+
+		for (i = 0; i < SPI_processed; i++)
+		{
+			HeapTuple	tuple = SPI_tuptable->vals[i];
+			int			attnum;
+
+			for (attnum = 0; attnum < natts; attnum++)
+			{
+				if (attmap[attnum] == 0)
+					continue;
+
+				values[attnum] = SPI_getbinval(tuple, SPI_tuptable->tupdesc,
+											   attmap[attnum],
+											   &nulls[attnum]);
+			}
+
+			if (i > 0)
+				appendStringInfoString(&sql, ", ");
+			hdfs_deparse_values_row(&sql, rel, values, nulls);
+		}
+
+		hdfs_query_execute_utility(con_index, opt, sql.data);
+		rows += SPI_processed;
+
+		MemoryContextSwitchTo(oldcxt);
+		MemoryContextReset(batch_cxt);
+		SPI_freetuptable(SPI_tuptable);
+	}
+
+	SPI_cursor_close(portal);
+	SPI_finish();
+
+	hdfs_rel_connection(con_index);
+
+	table_close(rel, NoLock);
+
+	PG_RETURN_INT64(rows);
+}
+
+/*
+ * hdfs_stage_check_columns
+ * 		Check that the columns returned by the query match the attributes of
+ * 		the foreign table, and map each attribute to its column number in the
+ * 		query result.  Dropped attributes are mapped to 0.
+ */
+static void
+hdfs_stage_check_columns(Relation rel, TupleDesc tupdesc, int *attmap)
+{
+	TupleDesc	reldesc = RelationGetDescr(rel);
+	int			column = 0;
+	int			i;
+
+	for (i = 0; i < reldesc->natts; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(reldesc, i);
+		Oid			coltype;
+
+		if (attr->attisdropped)
+		{
+			attmap[i] = 0;
+			continue;
+		}
+
+		if (++column > tupdesc->natts)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATATYPE_MISMATCH),
+					 errmsg("query returns fewer columns than foreign table \"%s\" has",
+							RelationGetRelationName(rel))));
+
+		coltype = SPI_gettypeid(tupdesc, column);
+		if (coltype != attr->atttypid)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATATYPE_MISMATCH),
+					 errmsg("column %d of the query has type %s, but column \"%s\" has type %s",
+							column, format_type_be(coltype),
+							NameStr(attr->attname),
+							format_type_be(attr->atttypid))));
+
+		attmap[i] = column;
+	}
+
+	if (column < tupdesc->natts)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATATYPE_MISMATCH),
+				 errmsg("query returns more columns than foreign table \"%s\" has",
+						RelationGetRelationName(rel))));
+}
@@ -31,6 +31,7 @@ import java.sql.Statement;
 import java.sql.PreparedStatement;
 import java.sql.ResultSetMetaData;
 import java.sql.Date;
+import java.sql.Types;
 
 public class HiveJdbcClient
 {
@@ -483,7 +484,7 @@ public class HiveJdbcClient
 					m_preparedStatement[index].setString(paramIndex, paramToBind.getString());
 					break;
 				case 8:
-					m_preparedStatement[index].setDate(1, paramToBind.getDate());
+					m_preparedStatement[index].setDate(paramIndex, paramToBind.getDate());
 					break;
 				case 9:
 					m_preparedStatement[index].setTime(paramIndex, paramToBind.getTime());
@@ -491,6 +492,9 @@ public class HiveJdbcClient
 				case 10:
 					m_preparedStatement[index].setTimestamp(paramIndex, paramToBind.getStamp());
 					break;
+				case 11:
+					m_preparedStatement[index].setNull(paramIndex, Types.NULL);
+					break;
 			}
 		}
 		catch (SQLException e)
@@ -939,4 +943,40 @@ public class HiveJdbcClient
 
 		return (val.length());
 	}
+
+	/* singature will be (ILMsgBuf;LMsgBuf;)I */
+	public int DBGetServerVersion(int index, MsgBuf verBuf, MsgBuf errBuf)
+	{
+		String ver;
+
+		if (m_isDebug)
+			System.out.println("HiveJdbcClient::DBGetServerVersion");
+
+		if (m_hdfsConnection[index] == null)
+		{
+			errBuf.catVal("Database is not connected");
+			return (-1);
+		}
+
+		/* The connection stays usable if the driver can't tell */
+		try
+		{
+			ver = m_hdfsConnection[index].getMetaData().getDatabaseProductVersion();
+		}
+		catch (Exception e)
+		{
+			errBuf.catVal(e.getMessage());
+			return (-2);
+		}
+
+		if (ver == null)
+		{
+			errBuf.catVal("Server version is null");
+			return (-3);
+		}
+
+		verBuf.catVal(ver);
+
+		return (0);
+	}
 }
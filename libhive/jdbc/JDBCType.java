@@ -32,6 +32,7 @@ public class JDBCType
 	private static final int	m_dateType = 8;
 	private static final int	m_timeType = 9;
 	private static final int	m_stampType = 10;
+	private static final int	m_nullType = 11;
 
 	private int			m_jdbcType;
 
@@ -55,7 +56,7 @@ public class JDBCType
 
 	public int getType()
 	{
-		if (m_jdbcType < m_boolType || m_jdbcType > m_stampType)
+		if (m_jdbcType < m_boolType || m_jdbcType > m_nullType)
 			return -1;
 		return m_jdbcType;
 	}
@@ -123,6 +124,11 @@ public class JDBCType
 		m_jdbcType = m_stampType;
 	}
 
+	public void setNull()
+	{
+		m_jdbcType = m_nullType;
+	}
+
 
 	public boolean getBool()
 	{
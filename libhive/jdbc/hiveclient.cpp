@@ -62,6 +62,7 @@ static jmethodID g_DBCloseResultSet = NULL;
 static jmethodID g_DBFetch = NULL;
 static jmethodID g_DBGetColumnCount = NULL;
 static jmethodID g_DBGetFieldAsCString = NULL;
+static jmethodID g_DBGetServerVersion = NULL;
 static jmethodID g_consJDBCType = NULL;
 static jmethodID g_setBool = NULL;
 static jmethodID g_setShort = NULL;
@@ -73,6 +74,7 @@ static jmethodID g_setString = NULL;
 static jmethodID g_setDate = NULL;
 static jmethodID g_setTime = NULL;
 static jmethodID g_setStamp = NULL;
+static jmethodID g_setNull = NULL;
 
 typedef jint ((*_JNI_CreateJavaVM_PTR)(JavaVM **p_vm, JNIEnv **p_env, void *vm_args));
 _JNI_CreateJavaVM_PTR _JNI_CreateJavaVM;
@@ -310,6 +312,14 @@ int Initialize()
 		return(-46);
 	}
 
+	g_DBGetServerVersion = g_jni->GetMethodID(g_clsJdbcClient, "DBGetServerVersion", "(ILMsgBuf;LMsgBuf;)I");
+	if (g_DBGetServerVersion == NULL)
+	{
+		g_jvm->DestroyJavaVM();
+		g_jvm = NULL;
+		return(-70);
+	}
+
 	g_setBool = g_jni->GetMethodID(g_clsJDBCType, "setBool", "(Z)V");
 	if (g_setBool == NULL)
 	{
@@ -390,6 +400,14 @@ int Initialize()
 		return(-66);
 	}
 
+	g_setNull = g_jni->GetMethodID(g_clsJDBCType, "setNull", "()V");
+	if (g_setNull == NULL)
+	{
+		g_jvm->DestroyJavaVM();
+		g_jvm = NULL;
+		return(-68);
+	}
+
 	return(ver);
 }
 
@@ -473,11 +491,8 @@ int DBBindVar(int con_index, int param_index, Oid type,
 	}
 
 	if (*isnull)
-	{
-
-	}
-
-	switch(type)
+		g_jni->CallVoidMethod(objJDBCType, g_setNull);
+	else switch(type)
 	{
 		case INT2OID:
 		{
@@ -795,3 +810,34 @@ int DBGetFieldAsCString(int con_index, int columnIdx, char **buffer, char **errB
 
 	return(strlen(*buffer));
 }
+
+int DBGetServerVersion(int con_index, char **version, char **errBuf)
+{
+	int rc;
+	jstring rv;
+	jboolean isCopy = JNI_FALSE;
+
+	if (g_jni == NULL || g_objJdbcClient == NULL || g_DBGetServerVersion == NULL ||
+		g_objMsgBuf == NULL || g_resetVal == NULL || g_getVal == NULL ||
+		g_objValBuf == NULL || con_index < 0)
+		return(-10);
+
+	g_jni->CallVoidMethod(g_objMsgBuf, g_resetVal);
+
+	g_jni->CallVoidMethod(g_objValBuf, g_resetVal);
+
+	rc = g_jni->CallIntMethod(g_objJdbcClient, g_DBGetServerVersion,
+							con_index, g_objValBuf, g_objMsgBuf);
+
+	if (rc < 0)
+	{
+		rv = (jstring)g_jni->CallObjectMethod(g_objMsgBuf, g_getVal);
+		*errBuf = (char *)g_jni->GetStringUTFChars(rv, &isCopy);
+		return(rc);
+	}
+
+	rv = (jstring)g_jni->CallObjectMethod(g_objValBuf, g_getVal);
+	*version = (char *)g_jni->GetStringUTFChars(rv, &isCopy);
+
+	return(0);
+}
@@ -301,6 +301,25 @@ int DBGetFieldAsCString(int con_index, int columnIdx, char **buffer, char **errB
  */
 int DBBindVar(int con_index, int param_index, Oid type, void *value, bool *isnull, char **errBuf);
 
+/**
+ * @brief Get the version of the database server.
+ *
+ * Reads out the product version of the server of a connection, as reported by
+ * the JDBC DatabaseMetaData.
+ *
+ * @param index          Index of the connection object to use.
+ * @param version        Pointer to a buffer that will receive the version.
+ *                       It receives a copy of the pointer to the already allocated
+ *                       memory that the caller does not need to worry about.
+ * @param errBuf         Buffer to receive an error message if any.
+ *                       It receives a copy of the pointer to the already allocated
+ *                       memory that the caller does not need to worry about.
+ *
+ * @return Any negative value indicates an error, 0 means success.
+ *         Error messages will be stored in errBuf.
+ */
+int DBGetServerVersion(int con_index, char **version, char **errBuf);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif // __cpluscplus
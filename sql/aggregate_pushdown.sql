@@ -148,11 +148,30 @@ EXPLAIN (VERBOSE, COSTS OFF)
 SELECT sum(sal%3), sum(DISTINCT sal%3 ORDER BY sal%3) filter (WHERE sal%3 < 2), empno FROM emp WHERE empno = 7654 GROUP BY empno;
 SELECT sum(sal%3), sum(DISTINCT sal%3 ORDER BY sal%3) filter (WHERE sal%3 < 2), empno FROM emp WHERE empno = 7654 GROUP BY empno;
 
--- FILTER within aggregate, not pushed
+-- FILTER within aggregate, pushed down as a CASE expression
 EXPLAIN (VERBOSE, COSTS OFF)
 SELECT sum(sal) filter (WHERE sal < 2000 and empno > 1000) FROM emp GROUP BY empno ORDER BY 1 nulls last;
 SELECT sum(sal) filter (WHERE sal < 2000 and empno > 1000) FROM emp GROUP BY empno ORDER BY 1 nulls last;
 
+-- count(*) with FILTER counts the rows kept by the CASE expression
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT deptno, count(*) filter (WHERE sal > 1500) FROM emp GROUP BY deptno ORDER BY 1;
+SELECT deptno, count(*) filter (WHERE sal > 1500) FROM emp GROUP BY deptno ORDER BY 1;
+
+-- sort_array() orders the strings as the C collation does
+CREATE FOREIGN TABLE emp_c (
+    ename           TEXT COLLATE "C",
+    sal             INTEGER,
+    deptno          INTEGER
+)
+SERVER hdfs_server OPTIONS (dbname 'fdw_db', table_name 'emp');
+
+-- string_agg() ordered by its value, and percentile_cont() of an integer,
+-- are pushed down
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT deptno, string_agg(ename, ',' ORDER BY ename), percentile_cont(0.5) WITHIN GROUP (ORDER BY sal) FROM emp_c GROUP BY deptno ORDER BY 1;
+SELECT deptno, string_agg(ename, ',' ORDER BY ename), percentile_cont(0.5) WITHIN GROUP (ORDER BY sal) FROM emp_c GROUP BY deptno ORDER BY 1;
+
 -- Outer query is aggregation query
 EXPLAIN (VERBOSE, COSTS OFF)
 SELECT DISTINCT (SELECT count(*) filter (WHERE t2.deptno = 20 and t1.empno < 8000) FROM emp t1 WHERE t1.empno = 7654) FROM dept t2 ORDER BY 1;
@@ -194,8 +213,8 @@ EXPLAIN (VERBOSE, COSTS OFF)
 SELECT q.b, count(emp.deptno), sum(q.a) FROM emp left join (SELECT min(13), avg(emp.deptno), sum(dept.deptno) FROM emp right join dept ON (emp.deptno = dept.deptno) WHERE emp.deptno = 20) q(a, b, c) ON (emp.deptno = q.b) WHERE emp.deptno between 10 and 30 GROUP BY q.b ORDER BY 1 nulls last, 2;
 SELECT q.b, count(emp.deptno), sum(q.a) FROM emp left join (SELECT min(13), avg(emp.deptno), sum(dept.deptno) FROM emp right join dept ON (emp.deptno = dept.deptno) WHERE emp.deptno = 20) q(a, b, c) ON (emp.deptno = q.b) WHERE emp.deptno between 10 and 30 GROUP BY q.b ORDER BY 1 nulls last, 2;
 
--- Not supported cases
--- Grouping sets
+-- Grouping sets with an empty set, as for ROLLUP and CUBE, not pushed down as
+-- hive returns no row for it over an empty input
 EXPLAIN (VERBOSE, COSTS OFF)
 SELECT sal, sum(empno) FROM emp WHERE sal > 1000 GROUP BY rollup(sal) ORDER BY 1 nulls last;
 SELECT sal, sum(empno) FROM emp WHERE sal > 1000 GROUP BY rollup(sal) ORDER BY 1 nulls last;
@@ -204,14 +223,28 @@ EXPLAIN (VERBOSE, COSTS OFF)
 SELECT sal, sum(empno) FROM emp WHERE sal > 1000 GROUP BY cube(sal) ORDER BY 1 nulls last;
 SELECT sal, sum(empno) FROM emp WHERE sal > 1000 GROUP BY cube(sal) ORDER BY 1 nulls last;
 
+-- Grouping sets without an empty set are pushed down
 EXPLAIN (VERBOSE, COSTS OFF)
 SELECT sal, ename, sum(empno) FROM emp WHERE sal > 1000 GROUP BY grouping sets(sal, ename) ORDER BY 1 nulls last, 2 nulls last;
 SELECT sal, ename, sum(empno) FROM emp WHERE sal > 1000 GROUP BY grouping sets(sal, ename) ORDER BY 1 nulls last, 2 nulls last;
 
+-- GROUPING() without grouping sets, not pushed down
 EXPLAIN (VERBOSE, COSTS OFF)
 SELECT sal, sum(empno), grouping(sal) FROM emp WHERE sal > 1000 GROUP BY sal ORDER BY 1 nulls last;
 SELECT sal, sum(empno), grouping(sal) FROM emp WHERE sal > 1000 GROUP BY sal ORDER BY 1 nulls last;
 
+-- A CUBE over an empty input returns the row of its empty set
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT deptno, count(*) FROM emp WHERE sal > 10000 GROUP BY cube(deptno) ORDER BY 1 nulls last;
+SELECT deptno, count(*) FROM emp WHERE sal > 10000 GROUP BY cube(deptno) ORDER BY 1 nulls last;
+
+-- GROUPING() needs hive 2.3 or later, as known from the server version
+ALTER SERVER hdfs_server OPTIONS (ADD server_version '3.1.3');
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT deptno, job, sum(sal), grouping(deptno, job) FROM emp WHERE sal > 1000 GROUP BY grouping sets((deptno, job), (deptno)) ORDER BY 1, 2 nulls last;
+SELECT deptno, job, sum(sal), grouping(deptno, job) FROM emp WHERE sal > 1000 GROUP BY grouping sets((deptno, job), (deptno)) ORDER BY 1, 2 nulls last;
+ALTER SERVER hdfs_server OPTIONS (DROP server_version);
+
 -- DISTINCT itself is not pushed down, whereas underneath aggregate is pushed
 EXPLAIN (VERBOSE, COSTS OFF)
 SELECT DISTINCT sum(empno) s FROM emp WHERE sal > 1000 GROUP BY sal ORDER BY 1;
@@ -230,6 +263,39 @@ EXPLAIN (VERBOSE, COSTS OFF)
 SELECT sal, array_agg(sal) over (partition by sal ORDER BY sal range between current row and unbounded following) FROM emp WHERE sal > 1000 GROUP BY sal ORDER BY 1;
 SELECT sal, array_agg(sal) over (partition by sal ORDER BY sal range between current row and unbounded following) FROM emp WHERE sal > 1000 GROUP BY sal ORDER BY 1;
 
+-- DISTINCT directly over a scan is pushed down
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT DISTINCT deptno, job FROM emp WHERE sal > 1000 ORDER BY 1, 2;
+SELECT DISTINCT deptno, job FROM emp WHERE sal > 1000 ORDER BY 1, 2;
+
+-- DISTINCT ON, not pushed down
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT DISTINCT ON (deptno) deptno, ename FROM emp ORDER BY deptno, ename;
+SELECT DISTINCT ON (deptno) deptno, ename FROM emp ORDER BY deptno, ename;
+
+-- Window functions directly over a scan are pushed down, but for
+-- PostgreSQL 18 and later, whose EXPLAIN needs a WindowAgg node to show them
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT deptno, empno, row_number() OVER (PARTITION BY deptno ORDER BY empno) FROM emp ORDER BY 1, 2;
+SELECT deptno, empno, row_number() OVER (PARTITION BY deptno ORDER BY empno) FROM emp ORDER BY 1, 2;
+
+-- Windowed avg over an integer, not pushed down as hive returns a double
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT deptno, avg(sal) OVER (PARTITION BY deptno) FROM emp ORDER BY 1;
+SELECT deptno, avg(sal) OVER (PARTITION BY deptno) FROM emp ORDER BY 1;
+
+-- Statistical aggregates over double precision values, and boolean
+-- aggregates, are pushed down
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT deptno, stddev(sal::float8), var_pop(sal::float8), bool_and(sal > 1000), bool_or(comm > 0) FROM emp GROUP BY deptno;
+SELECT deptno, round(stddev(sal::float8)::numeric, 2), round(var_pop(sal::float8)::numeric, 2), bool_and(sal > 1000), bool_or(comm > 0) FROM emp GROUP BY deptno ORDER BY 1;
+
+-- Over integers, stddev() returns a numeric computed exactly, and is not
+-- pushed down
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT deptno, stddev(sal) FROM emp GROUP BY deptno;
+SELECT deptno, stddev(sal) FROM emp GROUP BY deptno ORDER BY 1;
+
 -- User defined function for user defined aggregate, VARIADIC
 CREATE FUNCTION least_accum(anyelement, variadic anyarray)
 returns anyelement language sql AS
@@ -267,11 +333,18 @@ EXPLAIN (VERBOSE, COSTS OFF)
 SELECT c1, count(t1) FROM fprt1 t1 GROUP BY c1 HAVING avg(c2) < 22 ORDER BY 1;
 SELECT c1, count(t1) FROM fprt1 t1 GROUP BY c1 HAVING avg(c2) < 22 ORDER BY 1;
 
--- When GROUP BY clause does not match with PARTITION KEY.
+-- When GROUP BY clause does not match with PARTITION KEY, the partial
+-- aggregates of each partition are pushed down and combined locally.
 EXPLAIN (VERBOSE, COSTS OFF)
 SELECT c2, avg(c1), max(c1), count(*) FROM fprt1 GROUP BY c2 HAVING sum(c1) < 700 ORDER BY 1;
 SELECT c2, avg(c1), max(c1), count(*) FROM fprt1 GROUP BY c2 HAVING sum(c1) < 700 ORDER BY 1;
 
+-- The transition state of a partial avg() over double precision values
+-- also has the sum of squared deviations
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT c2, avg(c1::float8) FROM fprt1 GROUP BY c2 ORDER BY 1;
+SELECT c2, avg(c1::float8) FROM fprt1 GROUP BY c2 ORDER BY 1;
+
 SET enable_partitionwise_aggregate TO off;
 
 -- FDW-557: Support enable_aggregate_pushdown option at server, table and
@@ -378,6 +451,7 @@ DROP FUNCTION least_accum(anyelement, variadic anyarray);
 DROP FOREIGN TABLE emp;
 DROP FOREIGN TABLE dept;
 DROP FOREIGN TABLE jobhist;
+DROP FOREIGN TABLE emp_c;
 DROP FOREIGN TABLE ftprt1_p1;
 DROP FOREIGN TABLE ftprt1_p2;
 DROP TABLE IF EXISTS fprt1;
@@ -0,0 +1,54 @@
+-- Connection Settings.
+\set HIVE_SERVER         `echo \'"$HIVE_SERVER"\'`
+\set HIVE_CLIENT_TYPE    `echo \'"$CLIENT_TYPE"\'`
+\set HIVE_PORT           `echo \'"$HIVE_PORT"\'`
+\set HIVE_USER           `echo \'"$HIVE_USER"\'`
+\set HIVE_PASSWORD       `echo \'"$HIVE_PASSWORD"\'`
+\set AUTH_TYPE           `echo \'"$AUTH_TYPE"\'`
+
+\c contrib_regression
+CREATE EXTENSION hdfs_fdw;
+
+-- Create Hadoop FDW Server. log_remote_sql 'true' is required to setup logging
+-- for Remote SQL Sent to Hive Server.
+CREATE SERVER hdfs_server FOREIGN DATA WRAPPER hdfs_fdw
+  OPTIONS(host :HIVE_SERVER, port :HIVE_PORT, client_type :HIVE_CLIENT_TYPE, log_remote_sql 'true', auth_type :AUTH_TYPE);
+
+-- Create Hadoop USER MAPPING.
+CREATE USER MAPPING FOR public SERVER hdfs_server
+  OPTIONS (username :HIVE_USER, password :HIVE_PASSWORD);
+
+CREATE SCHEMA import_dest;
+
+-- Invalid options
+IMPORT FOREIGN SCHEMA fdw_db LIMIT TO (emp) FROM SERVER hdfs_server
+  INTO import_dest OPTIONS (import_statistics 'maybe');
+IMPORT FOREIGN SCHEMA fdw_db LIMIT TO (emp) FROM SERVER hdfs_server
+  INTO import_dest OPTIONS (row_estimate '100');
+
+-- Each column gets the type holding the values of its Hive type, the
+-- partition columns included
+IMPORT FOREIGN SCHEMA fdw_db
+  LIMIT TO (array_data, binary_data, bool_test, dept_dt_mp, dept_dt_mp1, emp_dt_mp1, emp_dt_mp2, emp_part, jobhist)
+  FROM SERVER hdfs_server INTO import_dest;
+SELECT c.relname, a.attname, format_type(a.atttypid, a.atttypmod)
+  FROM pg_class c JOIN pg_attribute a ON (a.attrelid = c.oid)
+  WHERE c.relnamespace = 'import_dest'::regnamespace AND a.attnum > 0
+  ORDER BY c.relname, a.attnum;
+SELECT c.relname, ft.ftoptions
+  FROM pg_class c JOIN pg_foreign_table ft ON (ft.ftrelid = c.oid)
+  WHERE c.relnamespace = 'import_dest'::regnamespace
+  ORDER BY c.relname;
+
+-- The conditions on the imported columns are pushed down
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT empno, sal FROM import_dest.jobhist WHERE sal > 2000.00;
+SELECT empno, sal FROM import_dest.jobhist WHERE sal > 2000.00 ORDER BY empno;
+
+-- Cleanup
+SET client_min_messages TO WARNING;
+DROP SCHEMA import_dest CASCADE;
+RESET client_min_messages;
+DROP USER MAPPING FOR public SERVER hdfs_server;
+DROP SERVER hdfs_server;
+DROP EXTENSION hdfs_fdw;
@@ -125,6 +125,18 @@ SELECT e.empno, e.ename, d.dname
   FROM emp e LEFT JOIN dept d ON (e.deptno = d.deptno)
   ORDER BY e.empno;
 
+-- With the join_hints option set to force, the inner side of a LEFT JOIN
+-- is hinted to be broadcast whatever its estimated size.
+ALTER SERVER hdfs_server OPTIONS (ADD join_hints 'always');
+ALTER SERVER hdfs_server OPTIONS (ADD join_hints 'force');
+EXPLAIN (COSTS FALSE, VERBOSE)
+SELECT e.empno, e.ename, d.dname
+  FROM emp e LEFT JOIN dept d ON (e.deptno = d.deptno);
+SELECT e.empno, e.ename, d.dname
+  FROM emp e LEFT JOIN dept d ON (e.deptno = d.deptno)
+  ORDER BY e.empno;
+ALTER SERVER hdfs_server OPTIONS (DROP join_hints);
+
 -- Test RIGHT OUTER JOIN push-down
 EXPLAIN (COSTS FALSE, VERBOSE)
 SELECT e.empno, e.ename, d.dname
@@ -303,6 +315,9 @@ WITH t (c1, c2, c3) AS (
 
 -- Test JOIN between a foreign table and a local table, should not be pushed
 -- down.
+-- The local table isn't analyzed, which leaves the runtime filter, tested in
+-- runtime_filter.sql, to its row estimate.
+SET hdfs_fdw.runtime_filter_max_keys TO 0;
 EXPLAIN (COSTS FALSE, VERBOSE)
 SELECT e.empno, e.ename, d.dname
   FROM emp e JOIN local_dept d ON (e.deptno = d.deptno)
@@ -311,6 +326,36 @@ SELECT e.empno, e.ename, d.dname
   FROM emp e JOIN local_dept d ON (e.deptno = d.deptno)
   ORDER BY e.empno;
 
+-- The foreign table is scanned for each row of a small local table, with
+-- the join key bound as a parameter of the remote query.  A NULL key is
+-- bound as a NULL, which matches no row.
+CREATE TABLE local_null_dept (deptno INTEGER);
+INSERT INTO local_null_dept VALUES (NULL);
+ANALYZE local_null_dept;
+EXPLAIN (COSTS FALSE, VERBOSE)
+SELECT l.deptno, e.ename
+  FROM local_null_dept l LEFT JOIN emp e ON (l.deptno = e.deptno);
+SELECT l.deptno, e.ename
+  FROM local_null_dept l LEFT JOIN emp e ON (l.deptno = e.deptno);
+DROP TABLE local_null_dept;
+
+-- Without Materialize, the foreign table on the inner side of a nested
+-- loop is rescanned for each outer row.  The rows of the first scan are
+-- spooled and replayed by the rescans, which have the same parameters.
+CREATE TABLE local_two (x INTEGER);
+INSERT INTO local_two VALUES (1), (2);
+ANALYZE local_two;
+SET enable_material TO off;
+EXPLAIN (COSTS FALSE, VERBOSE)
+SELECT l.x, d.dname
+  FROM local_two l LEFT JOIN dept d ON true;
+SELECT l.x, d.dname
+  FROM local_two l LEFT JOIN dept d ON true
+  ORDER BY 1, 2;
+RESET enable_material;
+DROP TABLE local_two;
+RESET hdfs_fdw.runtime_filter_max_keys;
+
 -- Test whole-row reference
 EXPLAIN (COSTS FALSE, VERBOSE)
 SELECT e, d
@@ -328,7 +373,7 @@ SELECT e, d, e.ename
   FROM emp e FULL JOIN dept d ON (e.deptno = d.deptno)
   ORDER BY e.empno;
 
--- SEMI JOIN, not pushed down
+-- SEMI JOIN, pushed down as a LEFT SEMI JOIN
 EXPLAIN (COSTS false, VERBOSE)
 SELECT e.empno
   FROM emp e WHERE EXISTS (SELECT 1 FROM dept d WHERE e.deptno = d.deptno)
@@ -337,7 +382,9 @@ SELECT e.empno
   FROM emp e WHERE EXISTS (SELECT 1 FROM dept d WHERE e.deptno = d.deptno)
   ORDER BY 1;
 
--- ANTI JOIN, not pushed down
+-- ANTI JOIN, pushed down.  Hive has no anti join, it gets a LEFT JOIN keeping
+-- the rows without a match, found by a NULL column of the subquery which the
+-- join clause compares.
 EXPLAIN (COSTS false, VERBOSE)
 SELECT e.empno
   FROM emp e WHERE NOT EXISTS (SELECT 1 FROM dept d WHERE e.deptno = d.deptno)
@@ -346,6 +393,27 @@ SELECT e.empno
   FROM emp e WHERE NOT EXISTS (SELECT 1 FROM dept d WHERE e.deptno = d.deptno)
   ORDER BY 1;
 
+EXPLAIN (COSTS false, VERBOSE)
+SELECT e.empno
+  FROM emp e WHERE NOT EXISTS (SELECT 1 FROM dept d
+                               WHERE e.deptno = d.deptno AND d.deptno > 10)
+  ORDER BY 1;
+SELECT e.empno
+  FROM emp e WHERE NOT EXISTS (SELECT 1 FROM dept d
+                               WHERE e.deptno = d.deptno AND d.deptno > 10)
+  ORDER BY 1;
+
+-- ANTI JOIN without such a column, not pushed down to Hive
+EXPLAIN (COSTS false, VERBOSE)
+SELECT e.empno
+  FROM emp e WHERE NOT EXISTS (SELECT 1 FROM dept d
+                               WHERE e.deptno = d.deptno OR d.deptno IS NULL)
+  ORDER BY 1;
+SELECT e.empno
+  FROM emp e WHERE NOT EXISTS (SELECT 1 FROM dept d
+                               WHERE e.deptno = d.deptno OR d.deptno IS NULL)
+  ORDER BY 1;
+
 -- CROSS JOIN can be pushed down
 EXPLAIN (COSTS false, VERBOSE)
 SELECT e.empno, d.deptno
@@ -366,6 +434,25 @@ SELECT e.ename, d.deptno, ld.dname
   FROM emp e CROSS JOIN dept d CROSS JOIN local_dept ld
   ORDER BY 1, 2 LIMIT 10;
 
+-- With hdfs_fdw.enable_order_by_pushdown off, a sort followed by a LIMIT is
+-- still pushed down along with it, but a full sort is done locally.
+SET hdfs_fdw.enable_order_by_pushdown TO off;
+EXPLAIN (COSTS false, VERBOSE)
+SELECT e.empno, e.ename, d.dname
+  FROM emp e JOIN dept d ON (e.deptno = d.deptno)
+  ORDER BY e.ename LIMIT 5;
+SELECT e.empno, e.ename, d.dname
+  FROM emp e JOIN dept d ON (e.deptno = d.deptno)
+  ORDER BY e.ename LIMIT 5;
+EXPLAIN (COSTS false, VERBOSE)
+SELECT e.empno, e.ename, d.dname
+  FROM emp e JOIN dept d ON (e.deptno = d.deptno)
+  ORDER BY e.ename;
+SELECT e.empno, e.ename, d.dname
+  FROM emp e JOIN dept d ON (e.deptno = d.deptno)
+  ORDER BY e.ename;
+RESET hdfs_fdw.enable_order_by_pushdown;
+
 -- Join two tables from two different foreign servers
 EXPLAIN (COSTS false, VERBOSE)
 SELECT e.deptno, d.deptno
@@ -0,0 +1,65 @@
+-- Connection Settings.
+\set HIVE_SERVER         `echo \'"$HIVE_SERVER"\'`
+\set HIVE_CLIENT_TYPE    `echo \'"$CLIENT_TYPE"\'`
+\set HIVE_PORT           `echo \'"$HIVE_PORT"\'`
+\set HIVE_USER           `echo \'"$HIVE_USER"\'`
+\set HIVE_PASSWORD       `echo \'"$HIVE_PASSWORD"\'`
+\set AUTH_TYPE           `echo \'"$AUTH_TYPE"\'`
+
+\c contrib_regression
+CREATE EXTENSION hdfs_fdw;
+
+-- Create Hadoop FDW Server. log_remote_sql 'true' is required to setup logging
+-- for Remote SQL Sent to Hive Server.
+CREATE SERVER hdfs_server FOREIGN DATA WRAPPER hdfs_fdw
+  OPTIONS(host :HIVE_SERVER, port :HIVE_PORT, client_type :HIVE_CLIENT_TYPE, log_remote_sql 'true', auth_type :AUTH_TYPE);
+
+-- Create Hadoop USER MAPPING.
+CREATE USER MAPPING FOR public SERVER hdfs_server
+  OPTIONS (username :HIVE_USER, password :HIVE_PASSWORD);
+
+-- Create Foreign Tables.  The remote table is partitioned by deptno, and has
+-- statistics for each partition.
+CREATE FOREIGN TABLE emp_part (
+    empno           INTEGER,
+    ename           VARCHAR(10),
+    job             VARCHAR(9),
+    mgr             INTEGER,
+    hiredate        pg_catalog.DATE,
+    sal             INTEGER,
+    comm            INTEGER,
+    deptno          INTEGER
+)
+SERVER hdfs_server OPTIONS (dbname 'fdw_db', table_name 'emp_part');
+
+-- Invalid option value
+ALTER FOREIGN TABLE emp_part OPTIONS (ADD trust_metastore_stats 'maybe');
+ALTER FOREIGN TABLE emp_part OPTIONS (ADD trust_metastore_stats 'true');
+
+-- count(*) and the min and max of the partition column are answered from the
+-- metastore
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT count(*), min(deptno), max(deptno) FROM emp_part;
+SELECT count(*), min(deptno), max(deptno) FROM emp_part;
+
+-- Not the other aggregates
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT count(*), max(sal) FROM emp_part;
+SELECT count(*), max(sal) FROM emp_part;
+
+-- Nor the ones over some rows only
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT count(*) FROM emp_part WHERE deptno = 20;
+SELECT count(*) FROM emp_part WHERE deptno = 20;
+
+-- The remote query is run without trust_metastore_stats
+ALTER FOREIGN TABLE emp_part OPTIONS (SET trust_metastore_stats 'false');
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT count(*), min(deptno), max(deptno) FROM emp_part;
+SELECT count(*), min(deptno), max(deptno) FROM emp_part;
+
+-- Cleanup
+DROP FOREIGN TABLE emp_part;
+DROP USER MAPPING FOR public SERVER hdfs_server;
+DROP SERVER hdfs_server;
+DROP EXTENSION hdfs_fdw;
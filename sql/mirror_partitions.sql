@@ -0,0 +1,87 @@
+-- Connection Settings.
+\set HIVE_SERVER         `echo \'"$HIVE_SERVER"\'`
+\set HIVE_CLIENT_TYPE    `echo \'"$CLIENT_TYPE"\'`
+\set HIVE_PORT           `echo \'"$HIVE_PORT"\'`
+\set HIVE_USER           `echo \'"$HIVE_USER"\'`
+\set HIVE_PASSWORD       `echo \'"$HIVE_PASSWORD"\'`
+\set AUTH_TYPE           `echo \'"$AUTH_TYPE"\'`
+
+\c contrib_regression
+CREATE EXTENSION hdfs_fdw;
+
+-- Create Hadoop FDW Server. log_remote_sql 'true' is required to setup logging
+-- for Remote SQL Sent to Hive Server.
+CREATE SERVER hdfs_server FOREIGN DATA WRAPPER hdfs_fdw
+  OPTIONS(host :HIVE_SERVER, port :HIVE_PORT, client_type :HIVE_CLIENT_TYPE, log_remote_sql 'true', auth_type :AUTH_TYPE);
+
+-- Create Hadoop USER MAPPING.
+CREATE USER MAPPING FOR public SERVER hdfs_server
+  OPTIONS (username :HIVE_USER, password :HIVE_PASSWORD);
+
+-- Create Foreign Tables.  The remote table of emp_part is partitioned by
+-- deptno, the one of emp isn't.
+CREATE FOREIGN TABLE emp (
+    empno           INTEGER,
+    ename           VARCHAR(10),
+    job             VARCHAR(9),
+    mgr             INTEGER,
+    hiredate        pg_catalog.DATE,
+    sal             INTEGER,
+    comm            INTEGER,
+    deptno          INTEGER
+)
+SERVER hdfs_server OPTIONS (dbname 'fdw_db', table_name 'emp');
+
+CREATE FOREIGN TABLE emp_part (
+    empno           INTEGER,
+    ename           VARCHAR(10),
+    job             VARCHAR(9),
+    mgr             INTEGER,
+    hiredate        pg_catalog.DATE,
+    sal             INTEGER,
+    comm            INTEGER,
+    deptno          INTEGER
+)
+SERVER hdfs_server OPTIONS (dbname 'fdw_db', table_name 'emp_part');
+
+CREATE FOREIGN TABLE emp_part_nodept (
+    empno           INTEGER,
+    ename           VARCHAR(10)
+)
+SERVER hdfs_server OPTIONS (dbname 'fdw_db', table_name 'emp_part');
+
+-- Error cases
+SELECT hdfs_fdw_partition('emp', 'emp_all');
+SELECT hdfs_fdw_partition('emp_part_nodept', 'emp_all');
+SELECT hdfs_fdw_partition('emp_part', 'emp');
+CREATE TABLE emp_sal (LIKE emp_part) PARTITION BY LIST (sal);
+SELECT hdfs_fdw_partition('emp_part', 'emp_sal');
+
+-- Create a partitioned table with one foreign table per remote partition
+SELECT hdfs_fdw_partition('emp_part', 'emp_all');
+-- The partitions created already are left alone
+SELECT hdfs_fdw_partition('emp_part', 'emp_all');
+SELECT c.relname, pg_get_expr(c.relpartbound, c.oid) AS partbound,
+       ft.ftoptions
+  FROM pg_class c JOIN pg_foreign_table ft ON (ft.ftrelid = c.oid)
+  WHERE c.relispartition AND c.relname LIKE 'emp_all%'
+  ORDER BY c.relname;
+SELECT hdfs_fdw_partition('emp_all_10', 'emp_all_10');
+
+-- Only the partitions selected are read, each one reading its own remote
+-- partition
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT empno, ename FROM emp_all WHERE deptno = 20;
+SELECT empno, ename FROM emp_all WHERE deptno = 20 ORDER BY empno;
+ANALYZE emp_all_20;
+SELECT deptno, count(*) FROM emp_all GROUP BY deptno ORDER BY deptno;
+
+-- Cleanup
+DROP TABLE emp_all;
+DROP TABLE emp_sal;
+DROP FOREIGN TABLE emp;
+DROP FOREIGN TABLE emp_part;
+DROP FOREIGN TABLE emp_part_nodept;
+DROP USER MAPPING FOR public SERVER hdfs_server;
+DROP SERVER hdfs_server;
+DROP EXTENSION hdfs_fdw;
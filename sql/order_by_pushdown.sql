@@ -308,7 +308,7 @@ SELECT sum(DISTINCT (t1.sal)) FROM emp t1 join dept t2 ON (t1.deptno = t2.deptno
 EXPLAIN (VERBOSE, COSTS OFF)
 SELECT sum(sal%3), sum(DISTINCT sal%3 ORDER BY sal%3) filter (WHERE sal%3 < 2), empno FROM emp WHERE empno = 7654 GROUP BY empno;
 
--- FILTER within aggregate, not pushed
+-- FILTER within aggregate, pushed down as a CASE expression
 EXPLAIN (VERBOSE, COSTS OFF)
 SELECT sum(sal) filter (WHERE sal < 2000 and empno > 1000) FROM emp GROUP BY empno ORDER BY 1 nulls last;
 
@@ -345,17 +345,19 @@ SELECT sum(sal) * (random() <= 1)::int AS sum FROM emp ORDER BY 1;
 EXPLAIN (VERBOSE, COSTS OFF)
 SELECT q.b, count(emp.deptno), sum(q.a) FROM emp left join (SELECT min(13), avg(emp.deptno), sum(dept.deptno) FROM emp right join dept ON (emp.deptno = dept.deptno) WHERE emp.deptno = 20) q(a, b, c) ON (emp.deptno = q.b) WHERE emp.deptno between 10 and 30 GROUP BY q.b ORDER BY 1 nulls last, 2;
 
--- Not supported cases
--- Grouping sets
+-- Grouping sets with an empty set, as for ROLLUP and CUBE, not pushed down as
+-- hive returns no row for it over an empty input
 EXPLAIN (VERBOSE, COSTS OFF)
 SELECT sal, sum(empno) FROM emp WHERE sal > 1000 GROUP BY rollup(sal) ORDER BY 1 nulls last;
 
 EXPLAIN (VERBOSE, COSTS OFF)
 SELECT sal, sum(empno) FROM emp WHERE sal > 1000 GROUP BY cube(sal) ORDER BY 1 nulls last;
 
+-- Grouping sets without an empty set are pushed down
 EXPLAIN (VERBOSE, COSTS OFF)
 SELECT sal, ename, sum(empno) FROM emp WHERE sal > 1000 GROUP BY grouping sets(sal, ename) ORDER BY 1 nulls last, 2 nulls last;
 
+-- GROUPING() without grouping sets, not pushed down
 EXPLAIN (VERBOSE, COSTS OFF)
 SELECT sal, sum(empno), grouping(sal) FROM emp WHERE sal > 1000 GROUP BY sal ORDER BY 1 nulls last;
 
@@ -568,18 +570,33 @@ SELECT e, d, e.ename
   FROM emp e FULL JOIN dept d ON (e.deptno = d.deptno)
   ORDER BY e.empno;
 
--- SEMI JOIN, not pushed down
+-- SEMI JOIN, pushed down as a LEFT SEMI JOIN
 EXPLAIN (COSTS false, VERBOSE)
 SELECT e.empno
   FROM emp e WHERE EXISTS (SELECT 1 FROM dept d WHERE e.deptno = d.deptno)
   ORDER BY 1;
 
--- ANTI JOIN, not pushed down
+-- ANTI JOIN, pushed down.  Hive has no anti join, it gets a LEFT JOIN keeping
+-- the rows without a match, found by a NULL column of the subquery which the
+-- join clause compares.
 EXPLAIN (COSTS false, VERBOSE)
 SELECT e.empno
   FROM emp e WHERE NOT EXISTS (SELECT 1 FROM dept d WHERE e.deptno = d.deptno)
   ORDER BY 1;
 
+EXPLAIN (COSTS false, VERBOSE)
+SELECT e.empno
+  FROM emp e WHERE NOT EXISTS (SELECT 1 FROM dept d
+                               WHERE e.deptno = d.deptno AND d.deptno > 10)
+  ORDER BY 1;
+
+-- ANTI JOIN without such a column, not pushed down to Hive
+EXPLAIN (COSTS false, VERBOSE)
+SELECT e.empno
+  FROM emp e WHERE NOT EXISTS (SELECT 1 FROM dept d
+                               WHERE e.deptno = d.deptno OR d.deptno IS NULL)
+  ORDER BY 1;
+
 -- CROSS JOIN can be pushed down
 EXPLAIN (COSTS false, VERBOSE)
 SELECT e.empno, d.deptno
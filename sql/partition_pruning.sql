@@ -0,0 +1,63 @@
+-- Connection Settings.
+\set HIVE_SERVER         `echo \'"$HIVE_SERVER"\'`
+\set HIVE_CLIENT_TYPE    `echo \'"$CLIENT_TYPE"\'`
+\set HIVE_PORT           `echo \'"$HIVE_PORT"\'`
+\set HIVE_USER           `echo \'"$HIVE_USER"\'`
+\set HIVE_PASSWORD       `echo \'"$HIVE_PASSWORD"\'`
+\set AUTH_TYPE           `echo \'"$AUTH_TYPE"\'`
+
+\c contrib_regression
+CREATE EXTENSION hdfs_fdw;
+
+-- Create Hadoop FDW Server. log_remote_sql 'true' is required to setup logging
+-- for Remote SQL Sent to Hive Server.
+CREATE SERVER hdfs_server FOREIGN DATA WRAPPER hdfs_fdw
+  OPTIONS(host :HIVE_SERVER, port :HIVE_PORT, client_type :HIVE_CLIENT_TYPE, log_remote_sql 'true', use_remote_estimate 'true', auth_type :AUTH_TYPE);
+
+-- Create Hadoop USER MAPPING.
+CREATE USER MAPPING FOR public SERVER hdfs_server
+  OPTIONS (username :HIVE_USER, password :HIVE_PASSWORD);
+
+-- Create Foreign Tables.  The remote table is partitioned by deptno.
+CREATE FOREIGN TABLE emp_part (
+    empno           INTEGER,
+    ename           VARCHAR(10),
+    job             VARCHAR(9),
+    mgr             INTEGER,
+    hiredate        pg_catalog.DATE,
+    sal             INTEGER,
+    comm            INTEGER,
+    deptno          INTEGER
+)
+SERVER hdfs_server OPTIONS (dbname 'fdw_db', table_name 'emp_part');
+
+-- All the partitions are read without any condition on deptno
+EXPLAIN (COSTS OFF)
+SELECT empno, ename FROM emp_part;
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT empno, ename FROM emp_part;
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT empno, ename FROM emp_part WHERE sal > 2000;
+SELECT empno, ename FROM emp_part WHERE sal > 2000 ORDER BY empno;
+
+-- A condition on deptno prunes the partitions
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT empno, ename FROM emp_part WHERE deptno = 20;
+SELECT empno, ename FROM emp_part WHERE deptno = 20 ORDER BY empno;
+
+-- Even when it compares with a value only known at execution, which is sent
+-- as a parameter
+SET test.deptno TO 10;
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT empno, ename FROM emp_part
+  WHERE deptno = current_setting('test.deptno')::integer;
+SELECT empno, ename FROM emp_part
+  WHERE deptno = current_setting('test.deptno')::integer
+  ORDER BY empno;
+RESET test.deptno;
+
+-- Cleanup
+DROP FOREIGN TABLE emp_part;
+DROP USER MAPPING FOR public SERVER hdfs_server;
+DROP SERVER hdfs_server;
+DROP EXTENSION hdfs_fdw;
@@ -0,0 +1,71 @@
+-- Connection Settings.
+\set HIVE_SERVER         `echo \'"$HIVE_SERVER"\'`
+\set HIVE_CLIENT_TYPE    `echo \'"$CLIENT_TYPE"\'`
+\set HIVE_PORT           `echo \'"$HIVE_PORT"\'`
+\set HIVE_USER           `echo \'"$HIVE_USER"\'`
+\set HIVE_PASSWORD       `echo \'"$HIVE_PASSWORD"\'`
+\set AUTH_TYPE           `echo \'"$AUTH_TYPE"\'`
+
+\c contrib_regression
+CREATE EXTENSION hdfs_fdw;
+
+-- Create Hadoop FDW Server. log_remote_sql 'true' is required to setup logging
+-- for Remote SQL Sent to Hive Server.
+CREATE SERVER hdfs_server FOREIGN DATA WRAPPER hdfs_fdw
+  OPTIONS(host :HIVE_SERVER, port :HIVE_PORT, client_type :HIVE_CLIENT_TYPE, log_remote_sql 'true', auth_type :AUTH_TYPE);
+
+-- Create Hadoop USER MAPPING.
+CREATE USER MAPPING FOR public SERVER hdfs_server
+  OPTIONS (username :HIVE_USER, password :HIVE_PASSWORD);
+
+-- Create Foreign Table.  Its results are cached for an hour, and aren't
+-- validated against the remote table, so that a cached result is used.
+CREATE FOREIGN TABLE emp (
+    empno           INTEGER,
+    ename           VARCHAR(10),
+    job             VARCHAR(9),
+    mgr             INTEGER,
+    hiredate        pg_catalog.DATE,
+    sal             INTEGER,
+    comm            INTEGER,
+    deptno          INTEGER
+)
+SERVER hdfs_server OPTIONS (dbname 'fdw_db', table_name 'emp', result_cache_ttl '3600', result_cache_validate 'false');
+
+-- Number of times the scan of the given query was served from the cache.
+CREATE FUNCTION result_cache_hits(query text) RETURNS integer AS $$
+DECLARE
+  plan json;
+BEGIN
+  EXECUTE 'EXPLAIN (ANALYZE, FORMAT JSON) ' || query INTO plan;
+  RETURN coalesce((plan->0->'Plan'->>'Result Cache Hits')::integer, 0);
+END;
+$$ LANGUAGE plpgsql;
+
+-- Invalid option values
+ALTER FOREIGN TABLE emp OPTIONS (SET result_cache_ttl '-1');
+ALTER FOREIGN TABLE emp OPTIONS (SET result_cache_ttl 'hour');
+ALTER SERVER hdfs_server OPTIONS (ADD result_cache_ttl '-1');
+ALTER FOREIGN TABLE emp OPTIONS (SET result_cache_validate 'maybe');
+
+-- The remote query is the same whether its result is cached or not
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT empno, ename FROM emp WHERE deptno = 10;
+SELECT empno, ename FROM emp WHERE deptno = 10 ORDER BY empno;
+
+-- The same remote query is now served from the cache
+SELECT result_cache_hits('SELECT empno, ename FROM emp WHERE deptno = 10');
+
+-- The rows served from the cache are those of the remote query
+SELECT empno, ename FROM emp WHERE deptno = 10 ORDER BY empno;
+
+-- Nothing is served from the cache once it's disabled
+ALTER FOREIGN TABLE emp OPTIONS (SET result_cache_ttl '0');
+SELECT result_cache_hits('SELECT empno, ename FROM emp WHERE deptno = 10');
+
+-- Cleanup
+DROP FUNCTION result_cache_hits(text);
+DROP FOREIGN TABLE emp;
+DROP USER MAPPING FOR public SERVER hdfs_server;
+DROP SERVER hdfs_server;
+DROP EXTENSION hdfs_fdw;
@@ -0,0 +1,89 @@
+-- Connection Settings.
+\set HIVE_SERVER         `echo \'"$HIVE_SERVER"\'`
+\set HIVE_CLIENT_TYPE    `echo \'"$CLIENT_TYPE"\'`
+\set HIVE_PORT           `echo \'"$HIVE_PORT"\'`
+\set HIVE_USER           `echo \'"$HIVE_USER"\'`
+\set HIVE_PASSWORD       `echo \'"$HIVE_PASSWORD"\'`
+\set AUTH_TYPE           `echo \'"$AUTH_TYPE"\'`
+
+\c contrib_regression
+CREATE EXTENSION hdfs_fdw;
+
+-- Create Hadoop FDW Server. log_remote_sql 'true' is required to setup logging
+-- for Remote SQL Sent to Hive Server.
+CREATE SERVER hdfs_server FOREIGN DATA WRAPPER hdfs_fdw
+  OPTIONS(host :HIVE_SERVER, port :HIVE_PORT, client_type :HIVE_CLIENT_TYPE, log_remote_sql 'true', auth_type :AUTH_TYPE);
+
+-- Create Hadoop USER MAPPING.
+CREATE USER MAPPING FOR public SERVER hdfs_server
+  OPTIONS (username :HIVE_USER, password :HIVE_PASSWORD);
+
+-- Create Foreign Tables.
+CREATE FOREIGN TABLE emp (
+    empno           INTEGER,
+    ename           VARCHAR(10),
+    job             VARCHAR(9),
+    mgr             INTEGER,
+    hiredate        pg_catalog.DATE,
+    sal             INTEGER,
+    comm            INTEGER,
+    deptno          INTEGER
+)
+SERVER hdfs_server OPTIONS (dbname 'fdw_db', table_name 'emp');
+
+-- Create a small local table holding the join keys.
+CREATE TABLE local_keys (deptno INTEGER);
+INSERT INTO local_keys VALUES (10), (20);
+ANALYZE local_keys;
+
+SET enable_nestloop TO off;
+SET enable_mergejoin TO off;
+
+-- The scan of the foreign table only fetches the rows matching the keys of
+-- the local table
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT e.empno, e.ename
+  FROM emp e JOIN local_keys k ON (e.deptno = k.deptno);
+SELECT e.empno, e.ename
+  FROM emp e JOIN local_keys k ON (e.deptno = k.deptno)
+  ORDER BY e.empno;
+
+-- The conditions of the local table restrict the keys
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT e.empno, e.ename
+  FROM emp e JOIN local_keys k ON (e.deptno = k.deptno)
+  WHERE k.deptno <> 20;
+SELECT e.empno, e.ename
+  FROM emp e JOIN local_keys k ON (e.deptno = k.deptno)
+  WHERE k.deptno <> 20
+  ORDER BY e.empno;
+
+-- No filter when the local table has more rows than
+-- hdfs_fdw.runtime_filter_max_keys
+SET hdfs_fdw.runtime_filter_max_keys TO 1;
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT e.empno, e.ename
+  FROM emp e JOIN local_keys k ON (e.deptno = k.deptno);
+RESET hdfs_fdw.runtime_filter_max_keys;
+
+-- No filter either when the local table is read as another user, like the
+-- owner of a view
+CREATE ROLE regress_filter_owner SUPERUSER;
+CREATE VIEW v_keys AS
+SELECT e.empno, e.ename
+  FROM emp e JOIN local_keys k ON (e.deptno = k.deptno);
+ALTER VIEW v_keys OWNER TO regress_filter_owner;
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT * FROM v_keys;
+SELECT * FROM v_keys ORDER BY empno;
+
+-- Cleanup
+DROP VIEW v_keys;
+DROP ROLE regress_filter_owner;
+DROP TABLE local_keys;
+RESET enable_nestloop;
+RESET enable_mergejoin;
+DROP FOREIGN TABLE emp;
+DROP USER MAPPING FOR public SERVER hdfs_server;
+DROP SERVER hdfs_server;
+DROP EXTENSION hdfs_fdw;
@@ -0,0 +1,76 @@
+-- Connection Settings.
+\set HIVE_SERVER         `echo \'"$HIVE_SERVER"\'`
+\set HIVE_CLIENT_TYPE    `echo \'"$CLIENT_TYPE"\'`
+\set HIVE_PORT           `echo \'"$HIVE_PORT"\'`
+\set HIVE_USER           `echo \'"$HIVE_USER"\'`
+\set HIVE_PASSWORD       `echo \'"$HIVE_PASSWORD"\'`
+\set AUTH_TYPE           `echo \'"$AUTH_TYPE"\'`
+
+\c contrib_regression
+CREATE EXTENSION hdfs_fdw;
+
+-- Create Hadoop FDW Server. log_remote_sql 'true' is required to setup logging
+-- for Remote SQL Sent to Hive Server.
+CREATE SERVER hdfs_server FOREIGN DATA WRAPPER hdfs_fdw
+  OPTIONS(host :HIVE_SERVER, port :HIVE_PORT, client_type :HIVE_CLIENT_TYPE, log_remote_sql 'true', auth_type :AUTH_TYPE);
+
+-- Create Hadoop USER MAPPING.
+CREATE USER MAPPING FOR public SERVER hdfs_server
+  OPTIONS (username :HIVE_USER, password :HIVE_PASSWORD);
+
+-- Create Foreign Table.
+CREATE FOREIGN TABLE emp (
+    empno           INTEGER,
+    ename           VARCHAR(10),
+    job             VARCHAR(9),
+    mgr             INTEGER,
+    hiredate        pg_catalog.DATE,
+    sal             INTEGER,
+    comm            INTEGER,
+    deptno          INTEGER
+)
+SERVER hdfs_server OPTIONS (dbname 'fdw_db', table_name 'emp');
+
+-- Take the snapshot of the remote table, which is then scanned instead of the
+-- remote table, with the conditions evaluated locally
+SELECT hdfs_fdw_snapshot('emp');
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT empno, ename FROM emp WHERE deptno = 10;
+SELECT empno, ename FROM emp WHERE deptno = 10 ORDER BY empno;
+
+-- The rows are pulled again under a lock which doesn't block the scans, and
+-- the lock is only upgraded to switch to the new snapshot
+BEGIN;
+SELECT hdfs_fdw_snapshot('emp');
+SELECT mode FROM pg_locks
+  WHERE locktype = 'relation' AND relation = 'emp'::regclass AND pid = pg_backend_pid()
+  ORDER BY mode;
+COMMIT;
+SELECT empno, ename FROM emp WHERE deptno = 10 ORDER BY empno;
+
+-- Only the owner of a foreign table of hdfs_fdw can take its snapshot
+CREATE ROLE regress_snapshot_user;
+GRANT SELECT ON emp TO regress_snapshot_user;
+SET ROLE regress_snapshot_user;
+SELECT hdfs_fdw_snapshot('emp');
+RESET ROLE;
+SELECT hdfs_fdw_snapshot('pg_class');
+
+-- Drop the snapshot, the table is then scanned remotely again
+SELECT hdfs_fdw_drop_snapshot('emp');
+SELECT hdfs_fdw_drop_snapshot('emp');
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT empno, ename FROM emp WHERE deptno = 10;
+SELECT empno, ename FROM emp WHERE deptno = 10 ORDER BY empno;
+
+-- A foreign table reading a single partition can't have a snapshot
+ALTER FOREIGN TABLE emp OPTIONS (ADD partition_predicate '`deptno` = 10');
+SELECT hdfs_fdw_snapshot('emp');
+
+-- Cleanup
+REVOKE SELECT ON emp FROM regress_snapshot_user;
+DROP ROLE regress_snapshot_user;
+DROP FOREIGN TABLE emp;
+DROP USER MAPPING FOR public SERVER hdfs_server;
+DROP SERVER hdfs_server;
+DROP EXTENSION hdfs_fdw;
@@ -0,0 +1,86 @@
+-- Connection Settings.
+\set HIVE_SERVER         `echo \'"$HIVE_SERVER"\'`
+\set HIVE_CLIENT_TYPE    `echo \'"$CLIENT_TYPE"\'`
+\set HIVE_PORT           `echo \'"$HIVE_PORT"\'`
+\set HIVE_USER           `echo \'"$HIVE_USER"\'`
+\set HIVE_PASSWORD       `echo \'"$HIVE_PASSWORD"\'`
+\set AUTH_TYPE           `echo \'"$AUTH_TYPE"\'`
+
+\c contrib_regression
+CREATE EXTENSION hdfs_fdw;
+
+-- Create Hadoop FDW Server. log_remote_sql 'true' is required to setup logging
+-- for Remote SQL Sent to Hive Server.
+CREATE SERVER hdfs_server FOREIGN DATA WRAPPER hdfs_fdw
+  OPTIONS(host :HIVE_SERVER, port :HIVE_PORT, client_type :HIVE_CLIENT_TYPE, log_remote_sql 'true', auth_type :AUTH_TYPE);
+
+-- Create Hadoop USER MAPPING.
+CREATE USER MAPPING FOR public SERVER hdfs_server
+  OPTIONS (username :HIVE_USER, password :HIVE_PASSWORD);
+
+-- Create Foreign Tables.
+CREATE FOREIGN TABLE emp (
+    empno           INTEGER,
+    ename           VARCHAR(10),
+    job             VARCHAR(9),
+    mgr             INTEGER,
+    hiredate        pg_catalog.DATE,
+    sal             INTEGER,
+    comm            INTEGER,
+    deptno          INTEGER
+)
+SERVER hdfs_server OPTIONS (dbname 'fdw_db', table_name 'emp');
+
+CREATE FOREIGN TABLE emp_stage (
+    empno           INTEGER,
+    ename           VARCHAR(10),
+    deptno          INTEGER
+)
+SERVER hdfs_server OPTIONS (dbname 'fdw_db', table_name 'emp_stage');
+
+-- Create a local table holding the rows to stage.
+CREATE TABLE local_emp (
+    empno           INTEGER,
+    ename           VARCHAR(10),
+    deptno          INTEGER
+);
+INSERT INTO local_emp VALUES (7369, 'SMITH', 20), (7499, 'ALLEN', 30), (7839, 'KING', 10);
+
+-- Invalid option value
+ALTER FOREIGN TABLE emp_stage OPTIONS (ADD staging 'maybe');
+
+-- The remote table is only replaced with the staging option
+SELECT hdfs_fdw_stage('emp_stage', 'SELECT empno, ename, deptno FROM local_emp');
+ALTER FOREIGN TABLE emp_stage OPTIONS (ADD staging 'true');
+SELECT hdfs_fdw_stage('emp_stage', 'SELECT empno, ename, deptno FROM local_emp', 0);
+
+-- Stage the rows in batches of two rows
+SELECT hdfs_fdw_stage('emp_stage', 'SELECT empno, ename, deptno FROM local_emp', 2);
+SELECT * FROM emp_stage ORDER BY empno;
+
+-- The join with the staged rows is pushed down
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT e.empno, e.ename, e.sal
+  FROM emp e JOIN emp_stage s ON (e.empno = s.empno);
+SELECT e.empno, e.ename, e.sal
+  FROM emp e JOIN emp_stage s ON (e.empno = s.empno)
+  ORDER BY e.empno;
+
+-- The query must return the columns of the foreign table.  The remote table
+-- is left as it was when it doesn't.
+SELECT hdfs_fdw_stage('emp_stage', 'SELECT empno, ename FROM local_emp');
+SELECT hdfs_fdw_stage('emp_stage', 'SELECT empno, ename, deptno, 1 FROM local_emp');
+SELECT hdfs_fdw_stage('emp_stage', 'SELECT empno, ename::text, deptno FROM local_emp');
+SELECT * FROM emp_stage ORDER BY empno;
+
+-- A foreign table reading a single partition can't be staged into
+ALTER FOREIGN TABLE emp_stage OPTIONS (ADD partition_predicate '`deptno` = 10');
+SELECT hdfs_fdw_stage('emp_stage', 'SELECT empno, ename, deptno FROM local_emp');
+
+-- Cleanup
+DROP TABLE local_emp;
+DROP FOREIGN TABLE emp;
+DROP FOREIGN TABLE emp_stage;
+DROP USER MAPPING FOR public SERVER hdfs_server;
+DROP SERVER hdfs_server;
+DROP EXTENSION hdfs_fdw;
@@ -166,7 +166,8 @@ EXPLAIN (VERBOSE, COSTS OFF)
 SELECT empno FROM emp e ORDER BY empno for share;
 SELECT empno FROM emp e ORDER BY empno for share;
 
--- Test LIMIT/OFFSET with ORDER BY disabled
+-- Test LIMIT/OFFSET with ORDER BY disabled, the sort is still pushed down
+-- along with the LIMIT
 SET hdfs_fdw.enable_order_by_pushdown TO OFF;
 EXPLAIN (VERBOSE, COSTS OFF)
 SELECT empno FROM emp e ORDER BY empno LIMIT 5 OFFSET 2;
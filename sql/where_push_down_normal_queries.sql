@@ -29,7 +29,7 @@ SERVER hdfs_server OPTIONS (dbname 'fdw_db', table_name 'emp');
 
 -- Execute the query and the normal WHERE clause will be pushed as shown here.
 -- The condition will be shown in the plan.
--- Remote SQL: SELECT empno, ename, sal, deptno FROM fdw_db.emp WHERE (sal  IN (800,2450))
+-- Remote SQL: SELECT empno, ename, sal, deptno FROM fdw_db.emp WHERE (sal IN (800,2450))
 EXPLAIN (COSTS FALSE, VERBOSE TRUE) SELECT empno, ename, sal as "salary", deptno
  FROM emp e
  WHERE sal IN (800,2450)
@@ -170,6 +170,269 @@ EXPLAIN (COSTS FALSE, VERBOSE TRUE) SELECT bol1,bol2
 
 DROP FOREIGN TABLE bool_test;
 
+-- Functions are pushed down as their hive equivalents.
+CREATE FOREIGN TABLE emp (
+    empno           INTEGER,
+    ename           VARCHAR(10),
+    job             VARCHAR(9),
+    mgr             INTEGER,
+    hiredate        pg_catalog.DATE,
+    sal             INTEGER,
+    comm            INTEGER,
+    deptno          INTEGER
+)
+SERVER hdfs_server OPTIONS (dbname 'fdw_db', table_name 'emp');
+
+-- strpos() becomes instr(), which takes the string first too.
+EXPLAIN (COSTS FALSE, VERBOSE TRUE) SELECT empno, ename
+ FROM emp e
+ WHERE strpos(ename, 'AR') = 2
+ ORDER BY empno;
+SELECT empno, ename
+ FROM emp e
+ WHERE strpos(ename, 'AR') = 2
+ ORDER BY empno;
+
+-- Hive numbers the days of the week from 1 for Sunday.
+EXPLAIN (COSTS FALSE, VERBOSE TRUE) SELECT empno, ename
+ FROM emp e
+ WHERE date_part('dow', hiredate::timestamp) = 0
+ ORDER BY empno;
+SELECT empno, ename
+ FROM emp e
+ WHERE date_part('dow', hiredate::timestamp) = 0
+ ORDER BY empno;
+
+-- Hive truncates a timestamp to a month with trunc(), returning a string.
+EXPLAIN (COSTS FALSE, VERBOSE TRUE) SELECT empno, ename
+ FROM emp e
+ WHERE date_trunc('month', hiredate::timestamp) = '1981-12-01'
+ ORDER BY empno;
+SELECT empno, ename
+ FROM emp e
+ WHERE date_trunc('month', hiredate::timestamp) = '1981-12-01'
+ ORDER BY empno;
+
+DROP FOREIGN TABLE emp;
+
+-- Conditional expressions are pushed down.
+CREATE FOREIGN TABLE emp (
+    empno           INTEGER,
+    ename           VARCHAR(10),
+    job             VARCHAR(9),
+    mgr             INTEGER,
+    hiredate        pg_catalog.DATE,
+    sal             INTEGER,
+    comm            INTEGER,
+    deptno          INTEGER
+)
+SERVER hdfs_server OPTIONS (dbname 'fdw_db', table_name 'emp');
+
+-- CASE, in its simple form.
+EXPLAIN (COSTS FALSE, VERBOSE TRUE) SELECT empno, ename
+ FROM emp e
+ WHERE CASE deptno WHEN 10 THEN sal ELSE comm END > 1000
+ ORDER BY empno;
+SELECT empno, ename
+ FROM emp e
+ WHERE CASE deptno WHEN 10 THEN sal ELSE comm END > 1000
+ ORDER BY empno;
+
+-- COALESCE.
+EXPLAIN (COSTS FALSE, VERBOSE TRUE) SELECT empno, ename
+ FROM emp e
+ WHERE COALESCE(comm, 0) > 0
+ ORDER BY empno;
+SELECT empno, ename
+ FROM emp e
+ WHERE COALESCE(comm, 0) > 0
+ ORDER BY empno;
+
+-- NULLIF is spelled out with CASE for the older hive releases.
+EXPLAIN (COSTS FALSE, VERBOSE TRUE) SELECT empno, ename
+ FROM emp e
+ WHERE NULLIF(deptno, 10) IS NULL
+ ORDER BY empno;
+SELECT empno, ename
+ FROM emp e
+ WHERE NULLIF(deptno, 10) IS NULL
+ ORDER BY empno;
+
+-- Hive's greatest() returns NULL as soon as an argument is, so the NULL
+-- arguments are replaced by the other ones.
+EXPLAIN (COSTS FALSE, VERBOSE TRUE) SELECT empno, ename
+ FROM emp e
+ WHERE GREATEST(sal, comm) > 1500
+ ORDER BY empno;
+SELECT empno, ename
+ FROM emp e
+ WHERE GREATEST(sal, comm) > 1500
+ ORDER BY empno;
+
+DROP FOREIGN TABLE emp;
+
+-- Pattern matching operators are pushed down as LIKE or RLIKE.
+CREATE FOREIGN TABLE emp (
+    empno           INTEGER,
+    ename           VARCHAR(10),
+    job             VARCHAR(9),
+    mgr             INTEGER,
+    hiredate        pg_catalog.DATE,
+    sal             INTEGER,
+    comm            INTEGER,
+    deptno          INTEGER
+)
+SERVER hdfs_server OPTIONS (dbname 'fdw_db', table_name 'emp');
+
+-- LIKE.
+EXPLAIN (COSTS FALSE, VERBOSE TRUE) SELECT empno, ename
+ FROM emp e
+ WHERE ename LIKE '%AR%'
+ ORDER BY empno;
+SELECT empno, ename
+ FROM emp e
+ WHERE ename LIKE '%AR%'
+ ORDER BY empno;
+
+-- ILIKE compares both operands in lowercase.
+EXPLAIN (COSTS FALSE, VERBOSE TRUE) SELECT empno, ename
+ FROM emp e
+ WHERE ename ILIKE '%ar%'
+ ORDER BY empno;
+SELECT empno, ename
+ FROM emp e
+ WHERE ename ILIKE '%ar%'
+ ORDER BY empno;
+
+-- The regular expressions are run by RLIKE in DOTALL mode.
+EXPLAIN (COSTS FALSE, VERBOSE TRUE) SELECT empno, ename
+ FROM emp e
+ WHERE ename ~ '^J'
+ ORDER BY empno;
+SELECT empno, ename
+ FROM emp e
+ WHERE ename ~ '^J'
+ ORDER BY empno;
+
+-- With ~*, they are case insensitive, and "$" only matches the end of the
+-- string.
+EXPLAIN (COSTS FALSE, VERBOSE TRUE) SELECT empno, ename
+ FROM emp e
+ WHERE ename ~* 'n$'
+ ORDER BY empno;
+SELECT empno, ename
+ FROM emp e
+ WHERE ename ~* 'n$'
+ ORDER BY empno;
+
+-- A regular expression using a feature java lacks, like the word
+-- boundaries, is evaluated locally.
+EXPLAIN (COSTS FALSE, VERBOSE TRUE) SELECT empno, ename
+ FROM emp e
+ WHERE ename ~ '\yKING\y'
+ ORDER BY empno;
+SELECT empno, ename
+ FROM emp e
+ WHERE ename ~ '\yKING\y'
+ ORDER BY empno;
+
+DROP FOREIGN TABLE emp;
+
+-- Operators are pushed down as their hive equivalents.
+CREATE FOREIGN TABLE emp (
+    empno           INTEGER,
+    ename           VARCHAR(10),
+    job             VARCHAR(9),
+    mgr             INTEGER,
+    hiredate        pg_catalog.DATE,
+    sal             INTEGER,
+    comm            INTEGER,
+    deptno          INTEGER
+)
+SERVER hdfs_server OPTIONS (dbname 'fdw_db', table_name 'emp');
+
+-- Hive's / always returns a double, DIV divides integers.
+EXPLAIN (COSTS FALSE, VERBOSE TRUE) SELECT empno, ename
+ FROM emp e
+ WHERE sal / 1000 = 2
+ ORDER BY empno;
+SELECT empno, ename
+ FROM emp e
+ WHERE sal / 1000 = 2
+ ORDER BY empno;
+
+-- || becomes concat().
+EXPLAIN (COSTS FALSE, VERBOSE TRUE) SELECT empno, ename
+ FROM emp e
+ WHERE job || '-' || ename LIKE 'ANALYST-%'
+ ORDER BY empno;
+SELECT empno, ename
+ FROM emp e
+ WHERE job || '-' || ename LIKE 'ANALYST-%'
+ ORDER BY empno;
+
+-- <> ALL becomes NOT IN.
+EXPLAIN (COSTS FALSE, VERBOSE TRUE) SELECT empno, ename
+ FROM emp e
+ WHERE deptno NOT IN (10, 20)
+ ORDER BY empno;
+SELECT empno, ename
+ FROM emp e
+ WHERE deptno NOT IN (10, 20)
+ ORDER BY empno;
+
+DROP FOREIGN TABLE emp;
+
+-- The SQL sent depends on the version of the server, given by the
+-- server_version option or else asked to the server.
+CREATE FOREIGN TABLE emp (
+    empno           INTEGER,
+    ename           VARCHAR(10),
+    job             VARCHAR(9),
+    mgr             INTEGER,
+    hiredate        pg_catalog.DATE,
+    sal             INTEGER,
+    comm            INTEGER,
+    deptno          INTEGER
+)
+SERVER hdfs_server OPTIONS (dbname 'fdw_db', table_name 'emp');
+ALTER SERVER hdfs_server OPTIONS (ADD server_version 'unknown');
+
+-- Hive 1.2 knows neither IS DISTINCT FROM nor NULLS FIRST/LAST, and puts
+-- the NULLs first in ascending order.
+ALTER SERVER hdfs_server OPTIONS (ADD server_version '1.2.1');
+EXPLAIN (COSTS FALSE, VERBOSE TRUE) SELECT empno, ename
+ FROM emp e
+ WHERE comm IS DISTINCT FROM 0 AND deptno = 30
+ ORDER BY empno;
+SELECT empno, ename
+ FROM emp e
+ WHERE comm IS DISTINCT FROM 0 AND deptno = 30
+ ORDER BY empno;
+
+EXPLAIN (COSTS FALSE, VERBOSE TRUE) SELECT empno, ename
+ FROM emp e
+ WHERE comm IS DISTINCT FROM 0 AND deptno = 30
+ ORDER BY empno NULLS FIRST;
+SELECT empno, ename
+ FROM emp e
+ WHERE comm IS DISTINCT FROM 0 AND deptno = 30
+ ORDER BY empno NULLS FIRST;
+
+-- Hive 3 knows both.
+ALTER SERVER hdfs_server OPTIONS (SET server_version '3.1.3');
+EXPLAIN (COSTS FALSE, VERBOSE TRUE) SELECT empno, ename
+ FROM emp e
+ WHERE comm IS DISTINCT FROM 0 AND deptno = 30
+ ORDER BY empno;
+SELECT empno, ename
+ FROM emp e
+ WHERE comm IS DISTINCT FROM 0 AND deptno = 30
+ ORDER BY empno;
+
+ALTER SERVER hdfs_server OPTIONS (DROP server_version);
+DROP FOREIGN TABLE emp;
+
 --Cleanup
 SET hdfs_fdw.enable_order_by_pushdown TO OFF;
 DROP USER MAPPING FOR public SERVER hdfs_server;
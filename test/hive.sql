@@ -225,6 +225,18 @@ CREATE TABLE test4 (
 )
 row format delimited fields terminated by ',';
 
+CREATE TABLE emp_part (
+    empno           INT,
+    ename           VARCHAR(10),
+    job                 VARCHAR(9),
+    mgr               INT,
+    hiredate        DATE,
+    sal                INT,
+    comm           INT
+)
+PARTITIONED BY (deptno INT)
+row format delimited fields terminated by ',';
+
 --Load data in the Tables.
 
 LOAD DATA INPATH 'emp_table.txt' OVERWRITE INTO TABLE emp;
@@ -257,3 +269,8 @@ LOAD DATA INPATH 'test1.txt' OVERWRITE INTO TABLE test1;
 LOAD DATA INPATH 'test2.txt' OVERWRITE INTO TABLE test2;
 LOAD DATA INPATH 'test3.txt' OVERWRITE INTO TABLE test3;
 LOAD DATA INPATH 'test4.txt' OVERWRITE INTO TABLE test4;
+--Partitioned table, filled from emp.
+SET hive.exec.dynamic.partition.mode=nonstrict;
+INSERT OVERWRITE TABLE emp_part PARTITION (deptno)
+  SELECT empno, ename, job, mgr, hiredate, sal, comm, deptno FROM emp;
+ANALYZE TABLE emp_part PARTITION (deptno) COMPUTE STATISTICS;